@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    core_rcu Read-copy-update
+ * @ingroup     core_sync
+ * @brief       Epoch based read-copy-update for read-mostly data
+ *
+ * Readers enter a read-side critical section with rcu_read_lock() and leave it
+ * with rcu_read_unlock(). Both never block and only disable interrupts for a
+ * few instructions, so they may also be used from interrupt context. Read-side
+ * critical sections may be nested, but must not block.
+ *
+ * Writers still need to serialize among each other (e.g. with a @ref mutex_t),
+ * but never exclude readers. Instead, they
+ *
+ * 1. unpublish data, e.g. by unlinking it from a list or marking a table slot
+ *    as unused,
+ * 2. wait for all readers that might still see it to leave their read-side
+ *    critical sections with rcu_synchronize(), or let rcu_call() defer this,
+ * 3. reuse or free the data.
+ *
+ * Every read-side critical section is counted in one of two epochs. Since
+ * RIOT threads can be preempted anywhere, a grace period does not end with a
+ * context switch: it ends once the readers of the previous epoch are gone.
+ * The epoch is only flipped when a writer waits for a grace period.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Read-copy-update API
+ */
+
+#ifndef RCU_H
+#define RCU_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Makes sure stores before it are not reordered after it
+ *
+ * RIOT only runs on single core systems, so a compiler barrier is sufficient.
+ */
+#define RCU_BARRIER()               __asm__ volatile ("" : : : "memory")
+
+/**
+ * @brief   Publishes @p val to an RCU protected pointer @p ptr
+ *
+ * All initialization of the data @p val points to happens before readers can
+ * see the pointer.
+ */
+#define rcu_assign_pointer(ptr, val) \
+    do { \
+        RCU_BARRIER(); \
+        (ptr) = (val); \
+    } while (0)
+
+/**
+ * @brief   Reads an RCU protected pointer @p ptr within a read-side critical
+ *          section
+ */
+#define rcu_dereference(ptr)        (*((__typeof__(ptr) volatile *)&(ptr)))
+
+/**
+ * @brief   Callback entry for deferred reclamation
+ *
+ * Embed it into the structure to reclaim and use `container_of()` in the
+ * callback to get the structure back.
+ */
+typedef struct rcu_head {
+    struct rcu_head *next;                  /**< next pending callback */
+    void (*func)(struct rcu_head *head);    /**< reclamation callback */
+} rcu_head_t;
+
+/**
+ * @brief   Enters a read-side critical section
+ *
+ * @return  the epoch of the read-side critical section, to be handed to
+ *          rcu_read_unlock()
+ */
+unsigned rcu_read_lock(void);
+
+/**
+ * @brief   Leaves a read-side critical section
+ *
+ * If this was the last reader a writer waited for, pending callbacks of
+ * rcu_call() are called from this context.
+ *
+ * @param[in] epoch the return value of the matching rcu_read_lock()
+ */
+void rcu_read_unlock(unsigned epoch);
+
+/**
+ * @brief   Calls @p func once all current read-side critical sections were
+ *          left
+ *
+ * @p func is called directly if there are no readers, otherwise from
+ * rcu_read_unlock() of the last reader. It may thus run in interrupt context
+ * and must not block.
+ *
+ * @param[in] head  callback entry, must stay valid until @p func is called
+ * @param[in] func  the callback
+ */
+void rcu_call(rcu_head_t *head, void (*func)(rcu_head_t *head));
+
+/**
+ * @brief   Blocks until all current read-side critical sections were left
+ *
+ * @pre     Must not be called from interrupt context or within a read-side
+ *          critical section.
+ */
+void rcu_synchronize(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RCU_H */
+/** @} */
@@ -31,6 +31,7 @@
 #include "thread_flags.h"
 #endif
 #include "irq.h"
+#include "bitarithm.h"
 #include "cib.h"
 
 #define ENABLE_DEBUG    (0)
@@ -41,15 +42,20 @@ static int _msg_send(msg_t *m, kernel_pid_t target_pid, bool block, unsigned sta
 
 static int queue_msg(thread_t *target, const msg_t *m)
 {
-    int n = cib_put(&(target->msg_queue));
-    if (n < 0) {
+    cib_t *queue = &target->msg_queue;
+
+    if (cib_full(queue)) {
         DEBUG("queue_msg(): message queue is full (or there is none)\n");
         return 0;
     }
 
     DEBUG("queue_msg(): queuing message\n");
-    msg_t *dest = &target->msg_array[n];
+    /* fill the slot before publishing it, so the owner can take it out of
+     * the queue without disabling interrupts (see _msg_dequeue()) */
+    msg_t *dest = &target->msg_array[queue->write_count & queue->mask];
     *dest = *m;
+    __asm__ volatile ("" : : : "memory");
+    queue->write_count++;
 #if MODULE_CORE_THREAD_FLAGS
     target->flags |= THREAD_FLAG_MSG_WAITING;
     thread_flags_wake(target);
@@ -57,6 +63,41 @@ static int queue_msg(thread_t *target, const msg_t *m)
     return 1;
 }
 
+/**
+ * @brief   Takes the oldest message out of the calling thread's queue
+ *          without disabling interrupts
+ *
+ * A thread's message queue has exactly one consumer (the thread itself)
+ * and producers only modify cib_t::write_count (with interrupts disabled)
+ * after the slot was written. So as long as no sender is blocked waiting
+ * for a free slot, the queue head can be copied out and released lock-free.
+ * This requires cib_t::read_count to be updated atomically, so the fast
+ * path is restricted to 32-bit platforms.
+ *
+ * @return  1, if a message was taken from the queue
+ * @return  0, if the slow path needs to be taken
+ */
+static inline int _msg_dequeue(thread_t *me, msg_t *m)
+{
+#if ARCH_32_BIT
+    volatile cib_t *queue = &me->msg_queue;
+
+    if ((me->msg_array == NULL) || (me->msg_waiters.next != NULL) ||
+        (queue->write_count == queue->read_count)) {
+        return 0;
+    }
+    *m = me->msg_array[queue->read_count & queue->mask];
+    /* release the slot only after the message was copied out */
+    __asm__ volatile ("" : : : "memory");
+    queue->read_count++;
+    return 1;
+#else
+    (void)me;
+    (void)m;
+    return 0;
+#endif
+}
+
 int msg_send(msg_t *m, kernel_pid_t target_pid)
 {
     if (irq_is_in()) {
@@ -288,12 +329,18 @@ int msg_receive(msg_t *m)
 
 static int _msg_receive(msg_t *m, int block)
 {
+    thread_t *me = (thread_t*) sched_active_thread;
+
+    if (_msg_dequeue(me, m)) {
+        DEBUG("_msg_receive: %" PRIkernel_pid ": _msg_receive(): Lock-free "
+              "dequeue.\n", me->pid);
+        return 1;
+    }
+
     unsigned state = irq_disable();
     DEBUG("_msg_receive: %" PRIkernel_pid ": _msg_receive.\n",
           sched_active_thread->pid);
 
-    thread_t *me = (thread_t*) sched_threads[sched_active_pid];
-
     int queue_index = -1;
 
     if (me->msg_array) {
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     core_rcu
+ * @{
+ *
+ * @file
+ * @brief       Epoch based read-copy-update implementation
+ *
+ * New readers are counted in the current epoch. Callbacks queued with
+ * rcu_call() go to the current epoch as well and have to wait for the readers
+ * of both epochs. Once the previous epoch has no readers left, the epochs are
+ * flipped: the current epoch becomes the previous one and its callbacks are
+ * called as soon as its last reader leaves.
+ *
+ * @}
+ */
+
+#include "irq.h"
+#include "rcu.h"
+#include "sched.h"
+#include "thread.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+static unsigned _epoch;
+static unsigned _readers[2];
+static rcu_head_t *_callbacks[2];
+
+typedef struct {
+    rcu_head_t head;
+    kernel_pid_t pid;
+    volatile int done;
+} _sync_t;
+
+/* flips the epochs as long as the previous one is drained and callbacks are
+ * pending. Returns the callbacks that can be called now.
+ * Must be called with interrupts disabled. */
+static rcu_head_t *_advance(void)
+{
+    rcu_head_t *ready = NULL;
+
+    while (_readers[_epoch ^ 1] == 0) {
+        rcu_head_t *cbs = _callbacks[_epoch ^ 1];
+
+        _callbacks[_epoch ^ 1] = NULL;
+        while (cbs) {
+            rcu_head_t *next = cbs->next;
+            cbs->next = ready;
+            ready = cbs;
+            cbs = next;
+        }
+        if (_callbacks[_epoch] == NULL) {
+            break;
+        }
+        _epoch ^= 1;
+        DEBUG("rcu: flipped to epoch %u, %u readers left\n", _epoch,
+              _readers[_epoch ^ 1]);
+    }
+    return ready;
+}
+
+static void _run(rcu_head_t *cbs)
+{
+    while (cbs) {
+        rcu_head_t *next = cbs->next;
+        cbs->func(cbs);
+        cbs = next;
+    }
+}
+
+unsigned rcu_read_lock(void)
+{
+    unsigned state = irq_disable();
+    unsigned epoch = _epoch;
+
+    _readers[epoch]++;
+    irq_restore(state);
+    return epoch;
+}
+
+void rcu_read_unlock(unsigned epoch)
+{
+    unsigned state = irq_disable();
+    rcu_head_t *ready = NULL;
+
+    if ((--_readers[epoch] == 0) && (epoch != _epoch)) {
+        /* the previous epoch just drained */
+        ready = _advance();
+    }
+    irq_restore(state);
+    _run(ready);
+}
+
+void rcu_call(rcu_head_t *head, void (*func)(rcu_head_t *head))
+{
+    unsigned state = irq_disable();
+    rcu_head_t *ready;
+
+    head->func = func;
+    head->next = _callbacks[_epoch];
+    _callbacks[_epoch] = head;
+    /* without any readers, head is returned right away */
+    ready = _advance();
+    irq_restore(state);
+    _run(ready);
+}
+
+static void _sync_cb(rcu_head_t *head)
+{
+    _sync_t *sync = (_sync_t *)head;
+
+    sync->done = 1;
+    thread_wakeup(sync->pid);
+}
+
+void rcu_synchronize(void)
+{
+    _sync_t sync = { .pid = sched_active_pid, .done = 0 };
+
+    rcu_call(&sync.head, _sync_cb);
+    while (1) {
+        unsigned state = irq_disable();
+
+        if (sync.done) {
+            irq_restore(state);
+            break;
+        }
+        sched_set_status((thread_t *)sched_active_thread, STATUS_SLEEPING);
+        irq_restore(state);
+        thread_yield_higher();
+    }
+}
@@ -26,10 +26,18 @@ extern "C" {
 
 #include "mtd.h"
 
-/** mtd native descriptor */
+/**
+ * @brief   mtd native descriptor
+ *
+ * The emulation file is mapped into memory on init, so reads and writes are
+ * served from the mapping. Modified sectors are tracked and written back to
+ * the file on mtd_flush() or when powering the device down.
+ */
 typedef struct mtd_native_dev {
     mtd_dev_t dev;      /**< mtd generic device */
     const char *fname;  /**< filename to use for memory emulation */
+    uint8_t *mem;       /**< memory mapping of the file, NULL before init */
+    uint8_t *dirty;     /**< bitmap of modified sectors */
 } mtd_native_dev_t;
 
 /**
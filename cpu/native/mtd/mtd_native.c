@@ -16,9 +16,14 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include <inttypes.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "mtd.h"
 #include "mtd_native.h"
@@ -28,27 +33,70 @@
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
+static inline size_t _mtd_size(const mtd_dev_t *dev)
+{
+    return dev->sector_count * dev->pages_per_sector * dev->page_size;
+}
+
+static inline size_t _sector_size(const mtd_dev_t *dev)
+{
+    return dev->pages_per_sector * dev->page_size;
+}
+
+static void _mark_dirty(mtd_native_dev_t *_dev, uint32_t addr, uint32_t size)
+{
+    size_t sector_size = _sector_size(&_dev->dev);
+
+    for (uint32_t s = addr / sector_size; s <= (addr + size - 1) / sector_size; s++) {
+        _dev->dirty[s / 8] |= (1 << (s % 8));
+    }
+}
+
 static int _init(mtd_dev_t *dev)
 {
     mtd_native_dev_t *_dev = (mtd_native_dev_t*) dev;
+    size_t size = _mtd_size(dev);
+    struct stat st;
 
     DEBUG("mtd_native: init, filename=%s\n", _dev->fname);
 
-    FILE *f = real_fopen(_dev->fname, "r");
+    if (_dev->mem) {
+        return 0;
+    }
+
+    int fd = real_open(_dev->fname, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return -EIO;
+    }
+    if (fstat(fd, &st) < 0) {
+        real_close(fd);
+        return -EIO;
+    }
+    if (((size_t)st.st_size < size) && (ftruncate(fd, size) < 0)) {
+        real_close(fd);
+        return -EIO;
+    }
 
-    if (!f) {
-        DEBUG("mtd_native: init: creating file %s\n", _dev->fname);
-        f = real_fopen(_dev->fname, "w+");
-        if (!f) {
-            return -EIO;
-        }
-        size_t size = dev->sector_count * dev->pages_per_sector * dev->page_size;
-        for (size_t i = 0; i < size; i++) {
-            real_fputc(0xff, f);
-        }
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    /* the mapping stays valid after the file is closed */
+    real_close(fd);
+    if (mem == MAP_FAILED) {
+        return -EIO;
+    }
+
+    _dev->dirty = real_calloc((dev->sector_count + 7) / 8, 1);
+    if (!_dev->dirty) {
+        munmap(mem, size);
+        return -ENOMEM;
     }
+    _dev->mem = mem;
 
-    real_fclose(f);
+    if ((size_t)st.st_size < size) {
+        DEBUG("mtd_native: init: erasing %u new bytes of %s\n",
+              (unsigned)(size - st.st_size), _dev->fname);
+        memset(_dev->mem + st.st_size, 0xff, size - st.st_size);
+        _mark_dirty(_dev, st.st_size, size - st.st_size);
+    }
 
     return 0;
 }
@@ -56,21 +104,16 @@ static int _init(mtd_dev_t *dev)
 static int _read(mtd_dev_t *dev, void *buff, uint32_t addr, uint32_t size)
 {
     mtd_native_dev_t *_dev = (mtd_native_dev_t*) dev;
-    size_t mtd_size = dev->sector_count * dev->pages_per_sector * dev->page_size;
 
     DEBUG("mtd_native: read from page %" PRIu32 " count %" PRIu32 "\n", addr, size);
 
-    if (addr + size > mtd_size) {
+    if (addr + size > _mtd_size(dev)) {
         return -EOVERFLOW;
     }
-
-    FILE *f = real_fopen(_dev->fname, "r");
-    if (!f) {
+    if (!_dev->mem) {
         return -EIO;
     }
-    real_fseek(f, addr, SEEK_SET);
-    size = real_fread(buff, 1, size, f);
-    real_fclose(f);
+    memcpy(buff, _dev->mem + addr, size);
 
     return size;
 }
@@ -78,29 +121,27 @@ static int _read(mtd_dev_t *dev, void *buff, uint32_t addr, uint32_t size)
 static int _write(mtd_dev_t *dev, const void *buff, uint32_t addr, uint32_t size)
 {
     mtd_native_dev_t *_dev = (mtd_native_dev_t*) dev;
-    size_t mtd_size = dev->sector_count * dev->pages_per_sector * dev->page_size;
-    size_t sector_size = dev->pages_per_sector * dev->page_size;
+    size_t sector_size = _sector_size(dev);
 
     DEBUG("mtd_native: write from page %" PRIu32 " count %" PRIu32 "\n", addr, size);
 
-    if (addr + size > mtd_size) {
+    if (addr + size > _mtd_size(dev)) {
         return -EOVERFLOW;
     }
     if (((addr % sector_size) + size) > sector_size) {
         return -EOVERFLOW;
     }
-
-    FILE *f = real_fopen(_dev->fname, "r+");
-    if (!f) {
+    if (!_dev->mem) {
         return -EIO;
     }
-    real_fseek(f, addr, SEEK_SET);
+    if (size == 0) {
+        return 0;
+    }
+    /* like NOR flash, programming can only clear bits */
     for (size_t i = 0; i < size; i++) {
-        uint8_t c = real_fgetc(f);
-        real_fseek(f, -1, SEEK_CUR);
-        real_fputc(c & ((uint8_t*)buff)[i], f);
+        _dev->mem[addr + i] &= ((const uint8_t*)buff)[i];
     }
-    real_fclose(f);
+    _mark_dirty(_dev, addr, size);
 
     return size;
 }
@@ -108,39 +149,73 @@ static int _write(mtd_dev_t *dev, const void *buff, uint32_t addr, uint32_t size
 static int _erase(mtd_dev_t *dev, uint32_t addr, uint32_t size)
 {
     mtd_native_dev_t *_dev = (mtd_native_dev_t*) dev;
-    size_t mtd_size = dev->sector_count * dev->pages_per_sector * dev->page_size;
-    size_t sector_size = dev->pages_per_sector * dev->page_size;
+    size_t sector_size = _sector_size(dev);
 
     DEBUG("mtd_native: erase from sector %" PRIu32 " count %" PRIu32 "\n", addr, size);
 
-    if (addr + size > mtd_size) {
+    if (addr + size > _mtd_size(dev)) {
         return -EOVERFLOW;
     }
     if (((addr % sector_size) != 0) || ((size % sector_size) != 0)) {
         return -EOVERFLOW;
     }
-
-    FILE *f = real_fopen(_dev->fname, "r+");
-    if (!f) {
+    if (!_dev->mem) {
         return -EIO;
     }
-    real_fseek(f, addr, SEEK_SET);
-    for (size_t i = 0; i < size; i++) {
-        real_fputc(0xff, f);
+    if (size == 0) {
+        return 0;
     }
-    real_fclose(f);
+    memset(_dev->mem + addr, 0xff, size);
+    _mark_dirty(_dev, addr, size);
 
     return 0;
 }
 
-static int _power(mtd_dev_t *dev, enum mtd_power_state power)
+static int _flush(mtd_dev_t *dev)
 {
-    (void) dev;
-    (void) power;
+    mtd_native_dev_t *_dev = (mtd_native_dev_t*) dev;
+    size_t sector_size = _sector_size(dev);
+    uintptr_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+    uint32_t s = 0;
+
+    if (!_dev->mem) {
+        return 0;
+    }
+
+    while (s < dev->sector_count) {
+        if (!(_dev->dirty[s / 8] & (1 << (s % 8)))) {
+            s++;
+            continue;
+        }
+        /* write back consecutive dirty sectors at once */
+        uint32_t first = s;
+        while ((s < dev->sector_count) && (_dev->dirty[s / 8] & (1 << (s % 8)))) {
+            _dev->dirty[s / 8] &= ~(1 << (s % 8));
+            s++;
+        }
+        uintptr_t start = (uintptr_t)(_dev->mem + (first * sector_size));
+        uintptr_t end = (uintptr_t)(_dev->mem + (s * sector_size));
+
+        DEBUG("mtd_native: flush sectors %" PRIu32 " to %" PRIu32 "\n",
+              first, s - 1);
+        /* msync() requires page aligned addresses */
+        if (msync((void *)(start & ~page_mask), end - (start & ~page_mask),
+                  MS_SYNC) < 0) {
+            return -EIO;
+        }
+    }
 
-    return -ENOTSUP;
+    return 0;
 }
 
+static int _power(mtd_dev_t *dev, enum mtd_power_state power)
+{
+    if (power == MTD_POWER_DOWN) {
+        return _flush(dev);
+    }
+
+    return 0;
+}
 
 const mtd_desc_t native_flash_driver = {
     .read = _read,
@@ -148,6 +223,7 @@ const mtd_desc_t native_flash_driver = {
     .write = _write,
     .erase = _erase,
     .init = _init,
+    .flush = _flush,
 };
 
 /** @} */
@@ -215,6 +215,15 @@ void thread_yield_higher(void)
             warnx("thread_yield_higher: interrupts are disabled - this should not be");
         }
         irq_disable();
+        /* Switching to the ISR context costs several sigprocmask() calls.
+         * Skip it if there are no pending signals and the scheduler keeps
+         * the current thread, e.g. after waking up a lower priority thread. */
+        if ((_native_sigpend == 0) && (sched_run() == 0)) {
+            DEBUG("thread_yield_higher: no context switch needed\n");
+            _native_in_isr = 0;
+            irq_enable();
+            return;
+        }
         native_isr_context.uc_stack.ss_sp = __isr_stack;
         native_isr_context.uc_stack.ss_size = SIGSTKSZ;
         native_isr_context.uc_stack.ss_flags = 0;
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2017 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+"""Generates the nanocoap resource table and its perfect hash index.
+
+The hash functions must match the ones in
+sys/net/application_layer/nanocoap/resources.c.
+"""
+
+import os
+import re
+import sys
+
+METHODS = {"GET": 0x1, "POST": 0x2, "PUT": 0x4, "DELETE": 0x8}
+IDENTIFIER = re.compile(r"^[A-Za-z_][A-Za-z0-9_]*$")
+
+# average number of paths per bucket
+BUCKET_LOAD = 4
+MAX_DISP = 0xffff
+URL_MAX = 64
+
+
+def fnv1a(path):
+    h = 2166136261
+    for c in path:
+        h = ((h ^ c) * 16777619) & 0xffffffff
+    return h
+
+
+def djb2(path):
+    h = 5381
+    for c in path:
+        h = ((h * 33) & 0xffffffff) ^ c
+    return h
+
+
+def mix(x):
+    x &= 0xffffffff
+    x ^= x >> 16
+    x = (x * 0x7feb352d) & 0xffffffff
+    x ^= x >> 15
+    x = (x * 0x846ca68b) & 0xffffffff
+    x ^= x >> 16
+    return x
+
+
+def parse(filename):
+    resources = []
+    with open(filename) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            where = "%s:%d" % (filename, lineno)
+            fields = line.split()
+            if len(fields) != 3:
+                raise ValueError("%s: expected <path> <methods> <handler>" % where)
+            path, methods, handler = fields
+            if not path.startswith("/") or len(path) >= URL_MAX:
+                raise ValueError("%s: invalid path %s" % (where, path))
+            flags = 0
+            for method in methods.split("|"):
+                if method not in METHODS:
+                    raise ValueError("%s: unknown method %s" % (where, method))
+                flags |= METHODS[method]
+            if not IDENTIFIER.match(handler):
+                raise ValueError("%s: invalid handler %s" % (where, handler))
+            resources.append((path.encode(), flags, handler, where))
+
+    if not resources:
+        raise ValueError("%s: no resources defined" % filename)
+
+    # coap_handle_req() relies on entries with the same path being adjacent
+    resources.sort(key=lambda r: r[0])
+    for prev, cur in zip(resources, resources[1:]):
+        if prev[0] == cur[0] and prev[1] & cur[1]:
+            raise ValueError("%s: %s conflicts with %s" %
+                             (cur[3], cur[0].decode(), prev[3]))
+    return resources
+
+
+def build_index(paths):
+    slots = len(paths)
+    buckets = max(1, (slots + BUCKET_LOAD - 1) // BUCKET_LOAD)
+    by_bucket = [[] for _ in range(buckets)]
+    for path in paths:
+        by_bucket[fnv1a(path) % buckets].append(path)
+
+    disp = [0] * buckets
+    taken = [None] * slots
+    # place the largest buckets first, while most slots are still free
+    for bucket in sorted(range(buckets), key=lambda b: -len(by_bucket[b])):
+        keys = by_bucket[bucket]
+        if not keys:
+            break
+        hashes = [djb2(path) for path in keys]
+        for d in range(MAX_DISP + 1):
+            pos = [mix(h + d) % slots for h in hashes]
+            if len(set(pos)) == len(pos) and all(taken[p] is None for p in pos):
+                break
+        else:
+            raise ValueError("unable to build perfect hash, bucket %d" % bucket)
+        disp[bucket] = d
+        for path, p in zip(keys, pos):
+            taken[p] = path
+    return disp, taken
+
+
+def c_array(ctype, name, values):
+    lines = ["static const %s %s[] = {" % (ctype, name)]
+    for i in range(0, len(values), 8):
+        lines.append("    " + ", ".join(str(v) for v in values[i:i + 8]) + ",")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def generate(filename):
+    resources = parse(filename)
+    first = {}
+    for i, res in enumerate(resources):
+        first.setdefault(res[0], i)
+    disp, taken = build_index(list(first))
+
+    out = ["/* This file was automatically generated by gen_resources.py from",
+           " * %s, do not edit. */" % os.path.basename(filename),
+           "#include \"net/nanocoap.h\"",
+           ""]
+    for handler in sorted(set(r[2] for r in resources)):
+        out.append("extern ssize_t %s(coap_pkt_t *pkt, uint8_t *buf, size_t len);"
+                   % handler)
+    out.append("")
+    out.append("const coap_resource_t coap_resources[] = {")
+    for path, flags, handler, _ in resources:
+        methods = " | ".join("COAP_" + m for m, f in sorted(METHODS.items(),
+                                                             key=lambda m: m[1])
+                             if flags & f)
+        out.append("    { \"%s\", %s, %s }," % (path.decode(), methods, handler))
+    out.append("};")
+    out.append("")
+    out.append("const unsigned coap_resources_numof = %d;" % len(resources))
+    out.append("")
+    out.append(c_array("uint16_t", "_disp", disp))
+    out.append("")
+    out.append(c_array("uint16_t", "_first", [first[p] for p in taken]))
+    out.append("")
+    out.append("const coap_resource_index_t coap_resource_index = {")
+    out.append("    .disp = _disp,")
+    out.append("    .first = _first,")
+    out.append("    .buckets = %d," % len(disp))
+    out.append("    .slots = %d," % len(taken))
+    out.append("};")
+    return "\n".join(out) + "\n"
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        print("usage: gen_resources.py <resources> <output.c>", file=sys.stderr)
+        sys.exit(1)
+
+    try:
+        code = generate(sys.argv[1])
+    except (OSError, ValueError) as e:
+        print("gen_resources.py: %s" % e, file=sys.stderr)
+        sys.exit(1)
+
+    # only touch the output if it changed, to avoid needless rebuilds
+    try:
+        with open(sys.argv[2]) as f:
+            if f.read() == code:
+                sys.exit(0)
+    except OSError:
+        pass
+    with open(sys.argv[2], "w") as f:
+        f.write(code)
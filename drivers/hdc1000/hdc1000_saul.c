@@ -18,10 +18,12 @@
  * @}
  */
 
+#include <stdbool.h>
 #include <string.h>
 
 #include "saul.h"
 #include "hdc1000.h"
+#include "xtimer.h"
 
 static int read_temp(const void *dev, phydat_t *res)
 {
@@ -47,14 +49,60 @@ static int read_hum(const void *dev, phydat_t *res)
     return 1;
 }
 
+/* triggers all conversions before waiting for them once
+ *
+ * Unlike read_temp() and read_hum(), this always returns fresh results:
+ * hdc1000_read_cached() keeps a single cache for all devices, which can't
+ * hold the results of several of them. As the return value covers the whole
+ * run, a bus error on any device fails all of them, including those that
+ * were read already. */
+static int read_multi(const void *const *devs, phydat_t *res, unsigned num,
+                      bool temp)
+{
+    for (unsigned i = 0; i < num; i++) {
+        if (hdc1000_trigger_conversion((const hdc1000_t *)devs[i]) != HDC1000_OK) {
+            return -ECANCELED;
+        }
+    }
+    xtimer_usleep(HDC1000_CONVERSION_TIME);
+    for (unsigned i = 0; i < num; i++) {
+        int16_t *val = &(res[i].val[0]);
+
+        if (hdc1000_get_results((const hdc1000_t *)devs[i],
+                                temp ? val : NULL,
+                                temp ? NULL : val) != HDC1000_OK) {
+            return -ECANCELED;
+        }
+        memset(&(res[i].val[1]), 0, 2 * sizeof(int16_t));
+        res[i].unit = temp ? UNIT_TEMP_C : UNIT_PERCENT;
+        res[i].scale = -2;
+    }
+
+    return 1;
+}
+
+static int read_temp_multi(const void *const *devs, phydat_t *res,
+                           unsigned num)
+{
+    return read_multi(devs, res, num, true);
+}
+
+static int read_hum_multi(const void *const *devs, phydat_t *res,
+                          unsigned num)
+{
+    return read_multi(devs, res, num, false);
+}
+
 const saul_driver_t hdc1000_saul_temp_driver = {
     .read = read_temp,
     .write = saul_notsup,
     .type = SAUL_SENSE_TEMP,
+    .read_multi = read_temp_multi,
 };
 
 const saul_driver_t hdc1000_saul_hum_driver = {
     .read = read_hum,
     .write = saul_notsup,
     .type = SAUL_SENSE_HUM,
+    .read_multi = read_hum_multi,
 };
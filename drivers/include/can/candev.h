@@ -154,6 +154,9 @@ typedef struct candev_driver {
     /**
      * @brief   Set a receive @p filter
      *
+     * May be NULL if the device has no hardware filters, frames are then
+     * filtered in software by the CAN router only.
+     *
      * @param[in] dev       CAN device descriptor
      * @param[in] filter    filter to set
      *
@@ -165,6 +168,8 @@ typedef struct candev_driver {
     /**
      * @brief  Remove a @p filter
      *
+     * May be NULL if @ref candev_driver_t::set_filter is NULL.
+     *
      * @param[in] dev       CAN device descriptor
      * @param[in] filter    filter to remove
      *
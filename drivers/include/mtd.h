@@ -146,6 +146,18 @@ struct mtd_desc {
      * @return < 0 value on error
      */
     int (*power)(mtd_dev_t *dev, enum mtd_power_state power);
+
+    /**
+     * @brief   Write back data buffered by the driver
+     *
+     * Optional, may be NULL for drivers that write through.
+     *
+     * @param[in] dev       Pointer to the selected driver
+     *
+     * @return 0 on success
+     * @return < 0 value on error
+     */
+    int (*flush)(mtd_dev_t *dev);
 };
 
 /**
@@ -229,6 +241,20 @@ int mtd_erase(mtd_dev_t *mtd, uint32_t addr, uint32_t count);
  */
 int mtd_power(mtd_dev_t *mtd, enum mtd_power_state power);
 
+/**
+ * @brief   mtd_flush Write back all data buffered for a MTD device
+ *
+ * Returns immediately if the driver does not buffer any data.
+ *
+ * @param      mtd   the device to flush
+ *
+ * @return 0 if all buffered data was written back
+ * @return < 0 if an error occured
+ * @return -ENODEV if @p mtd is not a valid device
+ * @return -EIO if I/O error occured
+ */
+int mtd_flush(mtd_dev_t *mtd);
+
 #if defined(MODULE_VFS) || defined(DOXYGEN)
 /**
  * @brief   MTD driver for VFS
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    drivers_mtd_cache MTD block cache
+ * @ingroup     drivers_storage
+ * @brief       Write-back LRU page cache for any MTD device
+ *
+ * The cache is an MTD device itself, wrapping a parent MTD device. File
+ * systems mounted on top of it are served from RAM for pages they access
+ * repeatedly, e.g. directory and metadata blocks. Pages are the unit of
+ * caching, so @ref MTD_CACHE_LINE_SIZE needs to be at least the page size of
+ * the parent device, otherwise mtd_init() fails with -EINVAL. The default
+ * covers the 512 byte blocks of SD cards and the smaller pages of SPI NOR
+ * flashes.
+ *
+ * Writes are buffered in the cache and only written to the parent device on
+ * eviction, mtd_flush() and when powering the device down. Buffered writes
+ * overwrite the cached data, which equals flash programming semantics as long
+ * as bits are only cleared between two erases, as file systems do.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~ {.c}
+ * static mtd_cache_t cache;
+ *
+ * mtd_cache_setup(&cache, MTD_0);
+ * littlefs_desc.dev = (mtd_dev_t *)&cache;
+ * ~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * @{
+ *
+ * @file
+ * @brief       Interface definition for the MTD block cache
+ */
+
+#ifndef MTD_CACHE_H
+#define MTD_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mtd.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief   Number of pages kept in the cache
+ */
+#ifndef MTD_CACHE_LINES
+#define MTD_CACHE_LINES         (8)
+#endif
+
+/**
+ * @brief   Maximum page size of the parent device
+ *
+ * The cache takes @ref MTD_CACHE_LINES times this many bytes of RAM, so set
+ * it to the page size of the parent device if that is smaller.
+ */
+#ifndef MTD_CACHE_LINE_SIZE
+#define MTD_CACHE_LINE_SIZE     (512)
+#endif
+
+/**
+ * @brief   Cache statistics
+ */
+typedef struct {
+    uint32_t hits;          /**< page accesses served from the cache */
+    uint32_t misses;        /**< page accesses forwarded to the parent */
+    uint32_t writebacks;    /**< dirty pages written to the parent */
+} mtd_cache_stats_t;
+
+/**
+ * @brief   State of one cached page
+ */
+typedef struct {
+    uint32_t addr;          /**< address of the page on the parent device */
+    uint32_t last_use;      /**< LRU time stamp, 0 if the line is unused */
+    bool dirty;             /**< page was modified and not written back */
+} mtd_cache_line_t;
+
+/**
+ * @brief   Device descriptor for mtd_cache devices
+ *
+ * This is an extension of the @c mtd_dev_t struct
+ */
+typedef struct {
+    mtd_dev_t base;                                     /**< inherit from mtd_dev_t object */
+    mtd_dev_t *parent;                                  /**< cached device */
+    uint32_t clock;                                     /**< LRU clock */
+    mtd_cache_line_t lines[MTD_CACHE_LINES];            /**< state of cached pages */
+    uint8_t data[MTD_CACHE_LINES][MTD_CACHE_LINE_SIZE]; /**< cached pages */
+    mtd_cache_stats_t stats;                            /**< cache statistics */
+} mtd_cache_t;
+
+/**
+ * @brief   mtd_cache device operations table for mtd
+ */
+extern const mtd_desc_t mtd_cache_driver;
+
+/**
+ * @brief   Set up a cache for @p parent
+ *
+ * Copies the geometry of @p parent, so the cache can be handed to a file
+ * system before mtd_init() was called. Any previous content of the cache is
+ * discarded.
+ *
+ * @param[out] dev      cache device descriptor
+ * @param[in]  parent   device to cache
+ */
+void mtd_cache_setup(mtd_cache_t *dev, mtd_dev_t *parent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MTD_CACHE_H */
+/** @} */
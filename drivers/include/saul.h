@@ -136,6 +136,28 @@ typedef int(*saul_read_t)(const void *dev, phydat_t *res);
  */
 typedef int(*saul_write_t)(const void *dev, phydat_t *data);
 
+/**
+ * @brief   Read values from several devices of the same driver at once
+ *
+ * Drivers can implement this to issue their bus transactions back to back,
+ * e.g. to trigger the measurements of all devices before waiting for the
+ * conversion once, instead of once per device.
+ *
+ * The result may differ from calling saul_read_t for each device: drivers
+ * can bypass caches used by their single device read function, and an error
+ * returned here applies to all devices of the call.
+ *
+ * @param[in] devs      device descriptors of the target devices
+ * @param[out] res      data read from the devices, one entry per device
+ * @param[in] num       number of devices
+ *
+ * @return  number of values written into each result data structure [1-3]
+ * @return  -ENOTSUP if the devices do not support this operation
+ * @return  -ECANCELED on other errors
+ */
+typedef int(*saul_read_multi_t)(const void *const *devs, phydat_t *res,
+                                unsigned num);
+
 /**
  * @brief   Definition of the RIOT actuator/sensor interface
  */
@@ -143,6 +165,8 @@ typedef struct {
     saul_read_t read;       /**< read function pointer */
     saul_write_t write;     /**< write function pointer */
     uint8_t type;           /**< device class the device belongs to */
+    saul_read_multi_t read_multi;   /**< read several devices at once,
+                                     *   may be NULL */
 } saul_driver_t;
 
 /**
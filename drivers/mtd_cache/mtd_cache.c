@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     drivers_mtd_cache
+ * @{
+ *
+ * @file
+ * @brief       Write-back LRU page cache for MTD devices
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "mtd.h"
+#include "mtd_cache.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+static inline uint32_t _mtd_size(const mtd_dev_t *dev)
+{
+    return dev->sector_count * dev->pages_per_sector * dev->page_size;
+}
+
+static inline uint8_t *_line_data(mtd_cache_t *dev, mtd_cache_line_t *line)
+{
+    return dev->data[line - dev->lines];
+}
+
+static void _touch(mtd_cache_t *dev, mtd_cache_line_t *line)
+{
+    if (++dev->clock == 0) {
+        /* clock wrapped: keep used lines valid, the order gets lost */
+        for (unsigned i = 0; i < MTD_CACHE_LINES; i++) {
+            if (dev->lines[i].last_use) {
+                dev->lines[i].last_use = 1;
+            }
+        }
+        dev->clock = 2;
+    }
+    line->last_use = dev->clock;
+}
+
+static mtd_cache_line_t *_lookup(mtd_cache_t *dev, uint32_t addr)
+{
+    for (unsigned i = 0; i < MTD_CACHE_LINES; i++) {
+        if (dev->lines[i].last_use && (dev->lines[i].addr == addr)) {
+            return &dev->lines[i];
+        }
+    }
+    return NULL;
+}
+
+static int _writeback(mtd_cache_t *dev, mtd_cache_line_t *line)
+{
+    if (!line->dirty) {
+        return 0;
+    }
+
+    DEBUG("mtd_cache: write back page at 0x%" PRIx32 "\n", line->addr);
+
+    int res = mtd_write(dev->parent, _line_data(dev, line), line->addr,
+                        dev->base.page_size);
+    if (res < 0) {
+        return res;
+    }
+    line->dirty = false;
+    dev->stats.writebacks++;
+
+    return 0;
+}
+
+/* evicts the least recently used line and optionally fills it from the
+ * parent device */
+static int _alloc(mtd_cache_t *dev, uint32_t addr, bool fill,
+                  mtd_cache_line_t **line)
+{
+    mtd_cache_line_t *victim = &dev->lines[0];
+
+    for (unsigned i = 1; (i < MTD_CACHE_LINES) && victim->last_use; i++) {
+        if (dev->lines[i].last_use < victim->last_use) {
+            victim = &dev->lines[i];
+        }
+    }
+
+    int res = _writeback(dev, victim);
+    if (res < 0) {
+        return res;
+    }
+    victim->last_use = 0;
+    if (fill) {
+        res = mtd_read(dev->parent, _line_data(dev, victim), addr,
+                       dev->base.page_size);
+        if (res < 0) {
+            return res;
+        }
+    }
+    victim->addr = addr;
+    victim->dirty = false;
+    _touch(dev, victim);
+    *line = victim;
+
+    return 0;
+}
+
+static int _init(mtd_dev_t *mtd)
+{
+    mtd_cache_t *dev = (mtd_cache_t *)mtd;
+
+    int res = mtd_init(dev->parent);
+    if (res < 0) {
+        return res;
+    }
+    if (dev->parent->page_size > MTD_CACHE_LINE_SIZE) {
+        DEBUG("mtd_cache: page size %" PRIu32 " exceeds MTD_CACHE_LINE_SIZE\n",
+              dev->parent->page_size);
+        return -EINVAL;
+    }
+    /* geometry might only be known after the parent was initialized */
+    mtd->sector_count = dev->parent->sector_count;
+    mtd->pages_per_sector = dev->parent->pages_per_sector;
+    mtd->page_size = dev->parent->page_size;
+
+    return 0;
+}
+
+static int _read(mtd_dev_t *mtd, void *dest, uint32_t addr, uint32_t size)
+{
+    mtd_cache_t *dev = (mtd_cache_t *)mtd;
+    uint32_t page_size = mtd->page_size;
+    uint8_t *buf = dest;
+
+    if (addr + size > _mtd_size(mtd)) {
+        return -EOVERFLOW;
+    }
+
+    for (uint32_t remaining = size; remaining > 0;) {
+        uint32_t off = addr % page_size;
+        uint32_t len = ((page_size - off) < remaining) ? (page_size - off)
+                                                        : remaining;
+        mtd_cache_line_t *line = _lookup(dev, addr - off);
+
+        if (line) {
+            dev->stats.hits++;
+            _touch(dev, line);
+            memcpy(buf, _line_data(dev, line) + off, len);
+        }
+        else if ((size > page_size) && (len == page_size)) {
+            /* don't let bulk reads thrash the cache */
+            dev->stats.misses++;
+            int res = mtd_read(dev->parent, buf, addr, len);
+            if (res < 0) {
+                return res;
+            }
+        }
+        else {
+            dev->stats.misses++;
+            int res = _alloc(dev, addr - off, true, &line);
+            if (res < 0) {
+                return res;
+            }
+            memcpy(buf, _line_data(dev, line) + off, len);
+        }
+        addr += len;
+        buf += len;
+        remaining -= len;
+    }
+
+    return size;
+}
+
+static int _write(mtd_dev_t *mtd, const void *src, uint32_t addr,
+                  uint32_t size)
+{
+    mtd_cache_t *dev = (mtd_cache_t *)mtd;
+    uint32_t page_size = mtd->page_size;
+    const uint8_t *buf = src;
+
+    if (addr + size > _mtd_size(mtd)) {
+        return -EOVERFLOW;
+    }
+
+    for (uint32_t remaining = size; remaining > 0;) {
+        uint32_t off = addr % page_size;
+        uint32_t len = ((page_size - off) < remaining) ? (page_size - off)
+                                                        : remaining;
+        mtd_cache_line_t *line = _lookup(dev, addr - off);
+
+        if (line) {
+            dev->stats.hits++;
+            _touch(dev, line);
+        }
+        else {
+            dev->stats.misses++;
+            /* a page that is overwritten completely needs not to be read */
+            int res = _alloc(dev, addr - off, len != page_size, &line);
+            if (res < 0) {
+                return res;
+            }
+        }
+        memcpy(_line_data(dev, line) + off, buf, len);
+        line->dirty = true;
+        addr += len;
+        buf += len;
+        remaining -= len;
+    }
+
+    return size;
+}
+
+static int _erase(mtd_dev_t *mtd, uint32_t addr, uint32_t size)
+{
+    mtd_cache_t *dev = (mtd_cache_t *)mtd;
+
+    int res = mtd_erase(dev->parent, addr, size);
+    if (res < 0) {
+        return res;
+    }
+    /* pending writes to the erased area are obsolete */
+    for (unsigned i = 0; i < MTD_CACHE_LINES; i++) {
+        mtd_cache_line_t *line = &dev->lines[i];
+
+        if (line->last_use && (line->addr >= addr) &&
+            (line->addr < (addr + size))) {
+            line->last_use = 0;
+            line->dirty = false;
+        }
+    }
+
+    return 0;
+}
+
+static int _flush(mtd_dev_t *mtd)
+{
+    mtd_cache_t *dev = (mtd_cache_t *)mtd;
+
+    for (unsigned i = 0; i < MTD_CACHE_LINES; i++) {
+        int res = _writeback(dev, &dev->lines[i]);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    return mtd_flush(dev->parent);
+}
+
+static int _power(mtd_dev_t *mtd, enum mtd_power_state power)
+{
+    mtd_cache_t *dev = (mtd_cache_t *)mtd;
+
+    if (power == MTD_POWER_DOWN) {
+        int res = _flush(mtd);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    return mtd_power(dev->parent, power);
+}
+
+const mtd_desc_t mtd_cache_driver = {
+    .init = _init,
+    .read = _read,
+    .write = _write,
+    .erase = _erase,
+    .power = _power,
+    .flush = _flush,
+};
+
+void mtd_cache_setup(mtd_cache_t *dev, mtd_dev_t *parent)
+{
+    memset(dev, 0, sizeof(mtd_cache_t));
+    dev->base.driver = &mtd_cache_driver;
+    dev->base.sector_count = parent->sector_count;
+    dev->base.pages_per_sector = parent->pages_per_sector;
+    dev->base.page_size = parent->page_size;
+    dev->parent = parent;
+}
@@ -167,7 +167,10 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
     switch (cmd) {
 #if (_FS_READONLY == 0)
         case CTRL_SYNC:
-            /* r/w is always finished within r/w-functions of mtd */
+            /* write back data the mtd device might have buffered */
+            if (mtd_flush(fatfs_mtd_devs[pdrv]) != 0) {
+                return RES_ERROR;
+            }
             return RES_OK;
 #endif
 
@@ -13,53 +13,60 @@
  * @file
  * @brief   Functions to encode and decode base64
  *
+ * Both directions work on groups of three bytes and four symbols, mapping
+ * symbols through lookup tables.
+ *
  * @author  Martin Landsmann <Martin.Landsmann@HAW-Hamburg.de>
  * @}
  *
  */
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "base64.h"
 
-#define BASE64_CAPITAL_UPPER_BOUND     (25)     /**< base64 'Z'           */
-#define BASE64_SMALL_UPPER_BOUND       (51)     /**< base64 'z'           */
-#define BASE64_NUMBER_UPPER_BOUND      (61)     /**< base64 '9'           */
-#define BASE64_PLUS                    (62)     /**< base64 '+'           */
-#define BASE64_SLASH                   (63)     /**< base64 '/'           */
 #define BASE64_EQUALS                  (0xFE)   /**< no base64 symbol '=' */
 #define BASE64_NOT_DEFINED             (0xFF)   /**< no base64 symbol     */
 
-/*
- * returns the corresponding ascii symbol value for the given base64 code
- */
-static char getsymbol(unsigned char code)
-{
-    if (code == BASE64_SLASH) {
-        return '/';
-    }
+/* codes with any of these bits set are no base64 symbols */
+#define BASE64_NO_SYMBOL_MASK          (0xC0)
 
-    if (code == BASE64_PLUS) {
-        return '+';
-    }
+static const char _alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-    if (code <= BASE64_CAPITAL_UPPER_BOUND) {
-        return (code + 'A');
-    }
+static const char _alphabet_url[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
 
-    if (code <= BASE64_SMALL_UPPER_BOUND) {
-        return (code + ('z' - BASE64_SMALL_UPPER_BOUND));
-    }
-
-    if (code <= BASE64_NUMBER_UPPER_BOUND) {
-        return (code + ('9' - BASE64_NUMBER_UPPER_BOUND));
-    }
-
-    return (char)BASE64_NOT_DEFINED;
-}
-
-int base64_encode(unsigned char *data_in, size_t data_in_size, \
+/*
+ * base64 code of every ASCII symbol. Symbols of both the standard and the
+ * URL-safe alphabet are accepted.
+ */
+static const uint8_t _codes[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0x3E, 0xFF, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0x3F,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+static int encode(const char *alphabet, bool pad,
+                  unsigned char *data_in, size_t data_in_size,
                   unsigned char *base64_out, size_t *base64_out_size)
 {
-    size_t required_size = 4 * ((data_in_size + 2) / 3);
+    size_t required_size = pad ? 4 * ((data_in_size + 2) / 3)
+                               : (4 * data_in_size + 2) / 3;
 
     if (data_in == NULL) {
         return BASE64_ERROR_DATA_IN;
@@ -78,85 +85,112 @@ int base64_encode(unsigned char *data_in, size_t data_in_size, \
         return BASE64_ERROR_BUFFER_OUT;
     }
 
-    int iterate_base64_buffer = 0;
-    unsigned char nNum = 0;
-    int nLst = 0;
-    int njump = 0;
+    const unsigned char *in = data_in;
+    const unsigned char *groups_end = in + (data_in_size - data_in_size % 3);
+    unsigned char *out = base64_out;
 
-    for (int i = 0; i < (int)(data_in_size); ++i) {
-        unsigned char tmpval;
-        njump++;
-        tmpval = *(data_in + i);
+    while (in < groups_end) {
+        uint32_t group = ((uint32_t)in[0] << 16) | (in[1] << 8) | in[2];
+
+        out[0] = alphabet[group >> 18];
+        out[1] = alphabet[(group >> 12) & 0x3F];
+        out[2] = alphabet[(group >> 6) & 0x3F];
+        out[3] = alphabet[group & 0x3F];
+        in += 3;
+        out += 4;
+    }
 
-        nNum = (tmpval >> (2 * njump));
+    /* the last group is incomplete */
+    if (data_in_size % 3) {
+        uint32_t group = (uint32_t)in[0] << 16;
 
-        if (njump == 4) {
-            nNum = nLst << (8 - 2 * njump);
-            njump = 0;
-            nLst = 0;
-            --i;
+        if (data_in_size % 3 == 2) {
+            group |= in[1] << 8;
         }
-        else {
-            nNum += nLst << (8 - 2 * njump);
-            nLst =  tmpval & ((1 << njump * 2) - 1);
+        *out++ = alphabet[group >> 18];
+        *out++ = alphabet[(group >> 12) & 0x3F];
+        if (data_in_size % 3 == 2) {
+            *out++ = alphabet[(group >> 6) & 0x3F];
+        }
+        while (pad && ((out - base64_out) % 4)) {
+            *out++ = '=';
         }
-
-        base64_out[iterate_base64_buffer++] = getsymbol(nNum);
     }
 
-    /* The last character is not finished yet */
-    njump++;
+    *base64_out_size = out - base64_out;
 
-    nNum = nLst << (8 - 2 * njump);
-    base64_out[iterate_base64_buffer++] = getsymbol(nNum);
-
-    /* if required we append '=' for the required dividability */
-    while (iterate_base64_buffer % 4) {
-        base64_out[iterate_base64_buffer++] = '=';
-    }
+    return BASE64_SUCCESS;
+}
 
-    *base64_out_size = iterate_base64_buffer;
+int base64_encode(unsigned char *data_in, size_t data_in_size, \
+                  unsigned char *base64_out, size_t *base64_out_size)
+{
+    return encode(_alphabet, true, data_in, data_in_size,
+                  base64_out, base64_out_size);
+}
 
-    return BASE64_SUCCESS;
+int base64url_encode(unsigned char *data_in, size_t data_in_size, \
+                     unsigned char *base64_out, size_t *base64_out_size)
+{
+    return encode(_alphabet_url, false, data_in, data_in_size,
+                  base64_out, base64_out_size);
 }
 
 /*
- *  returns the corresponding base64 code for the given ascii symbol
+ * Decodes whole groups of four symbols at once. Symbols that are not part of
+ * the alphabets, like line breaks, and padding are skipped. The output never
+ * overtakes the input, so both may share a buffer.
  */
-static int getcode(char symbol)
+static size_t decode(const unsigned char *in, size_t in_size,
+                     unsigned char *out)
 {
-    if (symbol == '/') {
-        return BASE64_SLASH;
-    }
-
-    if (symbol == '+') {
-        return BASE64_PLUS;
-    }
-
-    if (symbol == '=') {
-        /* indicates a padded base64 end */
-        return BASE64_EQUALS;
-    }
-
-    if (symbol < '0') {
-        /* indicates that the given symbol is not base64 and should be ignored */
-        return BASE64_NOT_DEFINED;
-    }
+    const unsigned char *end = in + in_size;
+    unsigned char *pos = out;
+    uint32_t group = 0;
+    unsigned symbols = 0;
+
+    while (in < end) {
+        if ((symbols == 0) && ((end - in) >= 4)) {
+            uint32_t a = _codes[in[0]];
+            uint32_t b = _codes[in[1]];
+            uint32_t c = _codes[in[2]];
+            uint32_t d = _codes[in[3]];
+
+            if (!((a | b | c | d) & BASE64_NO_SYMBOL_MASK)) {
+                group = (a << 18) | (b << 12) | (c << 6) | d;
+                pos[0] = group >> 16;
+                pos[1] = group >> 8;
+                pos[2] = group;
+                pos += 3;
+                in += 4;
+                continue;
+            }
+        }
 
-    if (symbol <= '9' && symbol >= '0') {
-        return (symbol + (BASE64_NUMBER_UPPER_BOUND - '9'));
+        uint8_t code = _codes[*in++];
+        if (code & BASE64_NO_SYMBOL_MASK) {
+            continue;
+        }
+        group = (group << 6) | code;
+        if (++symbols == 4) {
+            pos[0] = group >> 16;
+            pos[1] = group >> 8;
+            pos[2] = group;
+            pos += 3;
+            symbols = 0;
+        }
     }
 
-    if (symbol <= 'Z' && symbol >= 'A') {
-        return (symbol - 'A');
+    /* the last group is incomplete */
+    if (symbols == 2) {
+        *pos++ = group >> 4;
     }
-
-    if (symbol <= 'z' && symbol >= 'a') {
-        return (symbol + (BASE64_SMALL_UPPER_BOUND - 'z'));
+    else if (symbols == 3) {
+        *pos++ = group >> 10;
+        *pos++ = group >> 2;
     }
 
-    /* indicates that the given symbol is not base64 and should be ignored */
-    return BASE64_NOT_DEFINED;
+    return pos - out;
 }
 
 int base64_decode(unsigned char *base64_in, size_t base64_in_size, \
@@ -181,34 +215,35 @@ int base64_decode(unsigned char *base64_in, size_t base64_in_size, \
         return BASE64_ERROR_BUFFER_OUT;
     }
 
-    int iterate_data_buffer = 0;
-    unsigned char nNum = 0;
-    int nLst = getcode(base64_in[0]) << 2;
-    int code = 0;
-
-    int mask = 2;
+    *data_out_size = decode(base64_in, base64_in_size, data_out);
 
-    for (int i = 1; i < (int)(base64_in_size); i++) {
-        code = getcode(base64_in[i]);
+    return BASE64_SUCCESS;
+}
 
-        if (code == BASE64_NOT_DEFINED || code == BASE64_EQUALS) {
-            continue;
-        }
+int base64url_decode(unsigned char *base64_in, size_t base64_in_size, \
+                     unsigned char *data_out, size_t *data_out_size)
+{
+    /* padding is optional */
+    size_t required_size = ((base64_in_size * 3) / 4);
 
-        int nm = (0xFF << (2 * mask));
+    if (base64_in == NULL) {
+        return BASE64_ERROR_DATA_IN;
+    }
 
-        nNum = nLst + ((code & (0xFF & nm)) >> (2 * mask));
-        nLst = (code & (0xFF & ~nm)) << (8 - (2 * mask));
+    if (base64_in_size < 2) {
+        return BASE64_ERROR_DATA_IN_SIZE;
+    }
 
-        (mask != 3) ? data_out[iterate_data_buffer++] = nNum : nNum;
-        (mask == 0) ? mask = 3 : mask--;
+    if (*data_out_size < required_size) {
+        *data_out_size = required_size;
+        return BASE64_ERROR_BUFFER_OUT_SIZE;
     }
 
-    if (code == BASE64_EQUALS) {
-        /* add the last character to the data_out buffer */
-        data_out[iterate_data_buffer] = nNum;
+    if (data_out == NULL) {
+        return BASE64_ERROR_BUFFER_OUT;
     }
 
-    *data_out_size = iterate_data_buffer;
+    *data_out_size = decode(base64_in, base64_in_size, data_out);
+
     return BASE64_SUCCESS;
 }
@@ -306,6 +306,116 @@ int conn_can_isotp_recv(conn_can_isotp_t *conn, void *buf, size_t size, uint32_t
     return ret;
 }
 
+int conn_can_isotp_set_rx_ring(conn_can_isotp_t *conn, tsrb_t *ring)
+{
+    assert(conn != NULL);
+
+    if (conn->bound) {
+        return -EALREADY;
+    }
+
+    isotp_set_rx_ring(&conn->isotp, ring);
+
+    return 0;
+}
+
+/* reads from the rx ring, an error is only reported once the ring was read */
+static int _read_ring(conn_can_isotp_t *conn, msg_t *msg, void *buf, size_t size)
+{
+    int ret = tsrb_get(conn->isotp.rx_ring, buf, size);
+
+    if (msg->type == CAN_MSG_RX_ERROR) {
+        if (ret > 0) {
+            put_msg(conn, msg);
+        }
+        else {
+            isotp_rx_resume(&conn->isotp);
+            ret = -EIO;
+        }
+    }
+
+    return ret;
+}
+
+int conn_can_isotp_recv_stream(conn_can_isotp_t *conn, void *buf, size_t size, uint32_t timeout)
+{
+    assert(conn != NULL);
+    assert(buf != NULL);
+    assert(conn->isotp.rx_ring != NULL);
+
+    int ret;
+
+    if (!conn->bound) {
+        return -ENOTCONN;
+    }
+
+    ret = tsrb_get(conn->isotp.rx_ring, buf, size);
+    if (ret > 0) {
+        return ret;
+    }
+
+    xtimer_t timer;
+    if (timeout != 0) {
+        timer.callback = _rx_timeout;
+        timer.arg = conn;
+        xtimer_set(&timer, timeout);
+    }
+
+    msg_t msg;
+
+    while (1) {
+        get_msg(conn, &msg);
+        switch (msg.type) {
+        case CAN_MSG_ISOTP_RX_DATA:
+        case CAN_MSG_RX_ERROR:
+            DEBUG("conn_can_isotp_recv_stream: rx data, type=%x\n", msg.type);
+#ifdef MODULE_CONN_CAN_ISOTP_MULTI
+            if (msg.content.ptr != conn) {
+                mbox_put(&conn->master->mbox, &msg);
+                break;
+            }
+#endif
+            ret = _read_ring(conn, &msg, buf, size);
+            if (ret == 0) {
+                /* data was already read with a previous call */
+                break;
+            }
+            if (timeout != 0) {
+                xtimer_remove(&timer);
+            }
+            return ret;
+        case _TIMEOUT_RX_MSG_TYPE:
+            DEBUG("conn_can_isotp_recv_stream: _TIMEOUT_RX_MSG_TYPE\n");
+            if (msg.content.value == _TIMEOUT_MSG_VALUE) {
+                ret = -ETIMEDOUT;
+            }
+            else {
+                ret = -EINTR;
+            }
+            return ret;
+        case _CLOSE_CONN_MSG_TYPE:
+            DEBUG("conn_can_isotp_recv_stream: _CLOSE_CONN_MSG_TYPE\n");
+#ifdef MODULE_CONN_CAN_ISOTP_MULTI
+            if ((msg.content.ptr == conn) || (msg.content.ptr == conn->master)) {
+#endif
+                if (timeout != 0) {
+                    xtimer_remove(&timer);
+                }
+                return -ECONNABORTED;
+#ifdef MODULE_CONN_CAN_ISOTP_MULTI
+            }
+#endif
+            break;
+        default:
+            DEBUG("conn_can_isotp_recv_stream: unexpected msg %x\n", msg.type);
+            if (timeout != 0) {
+                xtimer_remove(&timer);
+            }
+            return -EINTR;
+        }
+    }
+}
+
 int conn_can_isotp_close(conn_can_isotp_t *conn)
 {
     assert(conn != NULL);
@@ -396,6 +506,24 @@ int conn_can_isotp_select(conn_can_isotp_slave_t **conn, conn_can_isotp_t *maste
         (*conn)->rx = rx;
         ret = 0;
         break;
+    case CAN_MSG_ISOTP_RX_DATA:
+        DEBUG("conn_can_isotp_select: CAN_MSG_ISOTP_RX_DATA\n");
+        *conn = msg.content.ptr;
+        ret = 0;
+        break;
+    case CAN_MSG_RX_ERROR:
+        DEBUG("conn_can_isotp_select: CAN_MSG_RX_ERROR\n");
+        *conn = msg.content.ptr;
+        if (tsrb_empty((*conn)->isotp.rx_ring)) {
+            isotp_rx_resume(&(*conn)->isotp);
+            ret = -EIO;
+        }
+        else {
+            /* report the error once the data before it was read */
+            mbox_put(&master->mbox, &msg);
+            ret = 0;
+        }
+        break;
     case _TIMEOUT_RX_MSG_TYPE:
         DEBUG("conn_can_isotp_select: _TIMEOUT_MSG_VALUE\n");
         if (msg.content.value == _TIMEOUT_MSG_VALUE) {
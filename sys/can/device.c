@@ -286,8 +286,10 @@ static void *_can_device_thread(void *args)
         case CAN_MSG_SET_FILTER:
             DEBUG("can device: CAN_MSG_SET_FILTER received\n");
             wake_up(candev_dev);
-            /* set filter for device driver */
-            res = dev->driver->set_filter(dev, msg.content.ptr);
+            /* set filter for device driver, without hardware filters the
+             * router filters in software only */
+            res = dev->driver->set_filter ?
+                  dev->driver->set_filter(dev, msg.content.ptr) : 0;
             /* send reply to calling thread */
             reply.type = CAN_MSG_ACK;
             reply.content.value = (uint32_t)res;
@@ -296,8 +298,9 @@ static void *_can_device_thread(void *args)
         case CAN_MSG_REMOVE_FILTER:
             DEBUG("can device: CAN_MSG_REMOVE_FILTER received\n");
             wake_up(candev_dev);
-            /* set filter for device driver */
-            res = dev->driver->remove_filter(dev, msg.content.ptr);
+            /* remove filter from device driver */
+            res = dev->driver->remove_filter ?
+                  dev->driver->remove_filter(dev, msg.content.ptr) : 0;
             /* send reply to calling thread */
             reply.type = CAN_MSG_ACK;
             reply.content.value = (uint32_t)res;
@@ -65,6 +65,11 @@
 #define CAN_ISOTP_TIMEOUT_N_Cr (1 * US_PER_SEC)
 #endif
 
+/* interval to check the rx ring for free space when streaming */
+#ifndef CAN_ISOTP_STREAM_POLL
+#define CAN_ISOTP_STREAM_POLL (10 * US_PER_MS)
+#endif
+
 enum {
     ISOTP_IDLE = 0,
     ISOTP_WAIT_FC,
@@ -74,6 +79,8 @@ enum {
     ISOTP_SENDING_CF,
     ISOTP_SENDING_FC,
     ISOTP_SENDING_NEXT_CF,
+    ISOTP_WAIT_SPACE,
+    ISOTP_RX_ERROR,
 };
 
 #define MAX_MSG_LENGTH 4095
@@ -88,6 +95,7 @@ enum {
 #define SF_PCI_SZ 1 /* size of SingleFrame PCI including 4 bit SF_DL */
 #define FF_PCI_SZ 2 /* size of FirstFrame PCI including 12 bit FF_DL */
 #define FC_CONTENT_SZ 3 /* flow control content size in byte (FS/BS/STmin) */
+#define STREAM_HDR_SZ 2 /* message length preceding each message in rx ring */
 
 /* Flow Status given in FC frame */
 #define ISOTP_FC_CTS    0  /* clear to send */
@@ -102,6 +110,7 @@ static mutex_t lock = MUTEX_INIT;
 
 static void _rx_timeout(void *arg);
 static int _isotp_send_fc(struct isotp *isotp, int ae, uint8_t status);
+static int _isotp_rx_cts(struct isotp *isotp, int ae);
 static int _isotp_tx_send(struct isotp *isotp, struct can_frame *frame);
 
 static int _send_msg(msg_t *msg, can_reg_entry_t *entry)
@@ -121,12 +130,88 @@ static int _send_msg(msg_t *msg, can_reg_entry_t *entry)
 #endif
 }
 
+static void _isotp_notify_rx(struct isotp *isotp, uint16_t type)
+{
+    msg_t msg;
+
+    msg.type = type;
+    msg.content.ptr = isotp->arg;
+
+    if (_send_msg(&msg, &isotp->entry) < 1) {
+        DEBUG("_isotp_notify_rx: msg lost\n");
+    }
+}
+
+/* prepares the reception of a message of len bytes, the first ones of which
+ * arrived with the current frame */
+static int _isotp_rx_alloc(struct isotp *isotp, unsigned len, unsigned first)
+{
+    isotp->rx.idx = 0;
+    isotp->rx.len = len;
+
+    if (isotp->rx_ring) {
+        return (tsrb_free(isotp->rx_ring) >= STREAM_HDR_SZ + first) ? 0 : -ENOMEM;
+    }
+
+    isotp->rx.snip = gnrc_pktbuf_add(NULL, NULL, len, GNRC_NETTYPE_UNDEF);
+
+    return isotp->rx.snip ? 0 : -ENOMEM;
+}
+
+static int _isotp_rx_append(struct isotp *isotp, const uint8_t *data, unsigned len)
+{
+    if (isotp->rx_ring) {
+        unsigned added = len;
+
+        if (isotp->rx.idx == 0) {
+            uint8_t hdr[STREAM_HDR_SZ] = { isotp->rx.len >> 8, isotp->rx.len & 0xFF };
+            tsrb_add(isotp->rx_ring, (const char *)hdr, sizeof(hdr));
+            added += sizeof(hdr);
+        }
+        if (tsrb_add(isotp->rx_ring, (const char *)data, len) < (int)len) {
+            /* sender did not respect the block size */
+            return -ENOSPC;
+        }
+        /* decided after adding: if everything that was in the ring before
+         * has been taken out meanwhile, the reader may be waiting */
+        if (tsrb_avail(isotp->rx_ring) <= added) {
+            _isotp_notify_rx(isotp, CAN_MSG_ISOTP_RX_DATA);
+        }
+    }
+    else {
+        memcpy((uint8_t *)isotp->rx.snip->data + isotp->rx.idx, data, len);
+    }
+    isotp->rx.idx += len;
+
+    return 0;
+}
+
+/* drops the message currently received */
+static void _isotp_rx_abort(struct isotp *isotp)
+{
+    if (isotp->rx_ring) {
+        /* the upper layer already got the first part of the message */
+        isotp->rx.state = ISOTP_RX_ERROR;
+        _isotp_notify_rx(isotp, CAN_MSG_RX_ERROR);
+        return;
+    }
+
+    gnrc_pktbuf_release(isotp->rx.snip);
+    isotp->rx.snip = NULL;
+    isotp->rx.state = ISOTP_IDLE;
+}
+
 static int _isotp_dispatch_rx(struct isotp *isotp)
 {
     msg_t msg;
     int ret = 0;
     can_rx_data_t *data;
 
+    if (isotp->rx_ring) {
+        /* the upper layer was notified while the data arrived */
+        return 0;
+    }
+
     msg.type = CAN_MSG_RX_INDICATION;
     data = can_pkt_alloc_rx_data(isotp->rx.snip,
                                  isotp->rx.snip->size + sizeof(*isotp->rx.snip),
@@ -268,7 +353,16 @@ static int _isotp_rcv_fc(struct isotp *isotp, struct can_frame *frame, int ae)
 
 static int _isotp_rcv_sf(struct isotp *isotp, struct can_frame *frame, int ae)
 {
+    if (isotp->rx.state == ISOTP_RX_ERROR) {
+        DEBUG("_isotp_rcv_sf: rx ring not resumed\n");
+        return 1;
+    }
+
     xtimer_remove(&isotp->rx_timer);
+    if (isotp->rx_ring && (isotp->rx.state != ISOTP_IDLE)) {
+        _isotp_rx_abort(isotp);
+        return 1;
+    }
     isotp->rx.state = ISOTP_IDLE;
 
     int len = (frame->data[ae] & 0x0F);
@@ -276,30 +370,39 @@ static int _isotp_rcv_sf(struct isotp *isotp, struct can_frame *frame, int ae)
         return 1;
     }
 
-    gnrc_pktsnip_t *snip = gnrc_pktbuf_add(NULL, NULL, len, GNRC_NETTYPE_UNDEF);
-    if (!snip) {
+    if (_isotp_rx_alloc(isotp, len, len) < 0) {
         return 1;
     }
-    isotp->rx.snip = snip;
-
-    isotp->rx.idx = 0;
-    for (size_t i = SF_PCI_SZ + ae; i < isotp->rx.snip->size + ae + SF_PCI_SZ; i++) {
-        ((uint8_t *)isotp->rx.snip->data)[isotp->rx.idx++] = frame->data[i];
-    }
+    _isotp_rx_append(isotp, &frame->data[SF_PCI_SZ + ae], len);
 
     return _isotp_dispatch_rx(isotp);
 }
 
 static int _isotp_rcv_ff(struct isotp *isotp, struct can_frame *frame, int ae)
 {
+    if (isotp->rx.state == ISOTP_RX_ERROR) {
+        DEBUG("_isotp_rcv_ff: rx ring not resumed\n");
+        return 1;
+    }
+
+    if (isotp->rx_ring && (isotp->rx.state != ISOTP_IDLE)) {
+        xtimer_remove(&isotp->rx_timer);
+        _isotp_rx_abort(isotp);
+        return 1;
+    }
     isotp->rx.state = ISOTP_IDLE;
 
     int len = (frame->data[ae] & 0x0F) << 8;
     len += frame->data[ae + 1];
+    unsigned first = 0;
+    if (frame->can_dlc > ae + FF_PCI_SZ) {
+        first = MIN(frame->can_dlc - (ae + FF_PCI_SZ), len);
+    }
 
     if (isotp->rx.snip) {
         DEBUG("_isotp_rcv_ff: freeing previous rx buf\n");
         gnrc_pktbuf_release(isotp->rx.snip);
+        isotp->rx.snip = NULL;
     }
 
     if (len > MAX_MSG_LENGTH) {
@@ -309,26 +412,22 @@ static int _isotp_rcv_ff(struct isotp *isotp, struct can_frame *frame, int ae)
         return 1;
     }
 
-    gnrc_pktsnip_t *snip = gnrc_pktbuf_add(NULL, NULL, len, GNRC_NETTYPE_UNDEF);
-    if (!snip) {
+    if (_isotp_rx_alloc(isotp, len, first) < 0) {
         if (!(isotp->opt.flags & CAN_ISOTP_LISTEN_MODE)) {
             _isotp_send_fc(isotp, ae, ISOTP_FC_OVFLW);
         }
         return 1;
     }
-    isotp->rx.snip = snip;
-
-    isotp->rx.idx = 0;
-    for (int i = ae + FF_PCI_SZ; i < frame->can_dlc; i++) {
-        ((uint8_t *)isotp->rx.snip->data)[isotp->rx.idx++] = frame->data[i];
-    }
+    _isotp_rx_append(isotp, &frame->data[ae + FF_PCI_SZ], first);
 
 #if ENABLE_DEBUG
-    DEBUG("_isotp_rcv_ff: rx.buf=");
-    for (unsigned i = 0; i < isotp->rx.idx; i++) {
-        DEBUG("%02hhx", ((uint8_t *)isotp->rx.snip->data)[i]);
+    if (isotp->rx.snip) {
+        DEBUG("_isotp_rcv_ff: rx.buf=");
+        for (unsigned i = 0; i < isotp->rx.idx; i++) {
+            DEBUG("%02hhx", ((uint8_t *)isotp->rx.snip->data)[i]);
+        }
+        DEBUG("\n");
     }
-    DEBUG("\n");
 #endif
 
     isotp->rx.sn = 1;
@@ -339,7 +438,7 @@ static int _isotp_rcv_ff(struct isotp *isotp, struct can_frame *frame, int ae)
     }
 
     isotp->rx.state = ISOTP_SENDING_FC;
-    _isotp_send_fc(isotp, ae, ISOTP_FC_CTS);
+    _isotp_rx_cts(isotp, ae);
 
     return 0;
 }
@@ -356,30 +455,32 @@ static int _isotp_rcv_cf(struct isotp *isotp, struct can_frame *frame, int ae)
 
     if ((frame->data[ae] & 0x0F) != isotp->rx.sn) {
         DEBUG("_isotp_rcv_cf: wrong seq number %d, expected %d\n", frame->data[ae] & 0x0F, isotp->rx.sn);
-        isotp->rx.state = ISOTP_IDLE;
-        gnrc_pktbuf_release(isotp->rx.snip);
-        isotp->rx.snip = NULL;
+        _isotp_rx_abort(isotp);
         return 1;
     }
     isotp->rx.sn++;
     isotp->rx.sn %= 16;
 
-    for (int i = ae + N_PCI_SZ; i < frame->can_dlc; i++) {
-        ((uint8_t *)isotp->rx.snip->data)[isotp->rx.idx++] = frame->data[i];
-        if (isotp->rx.idx >= isotp->rx.snip->size) {
-            break;
-        }
+    if ((frame->can_dlc > ae + N_PCI_SZ) &&
+        (_isotp_rx_append(isotp, &frame->data[ae + N_PCI_SZ],
+                          MIN((unsigned)(frame->can_dlc - (ae + N_PCI_SZ)),
+                              isotp->rx.len - isotp->rx.idx)) < 0)) {
+        DEBUG("_isotp_rcv_cf: rx ring overrun\n");
+        _isotp_rx_abort(isotp);
+        return 1;
     }
 
 #if ENABLE_DEBUG
-    DEBUG("_isotp_rcv_cf: rx.buf=");
-    for (unsigned i = 0; i < isotp->rx.idx; i++) {
-        DEBUG("%02hhx", ((uint8_t *)isotp->rx.snip->data)[i]);
+    if (isotp->rx.snip) {
+        DEBUG("_isotp_rcv_cf: rx.buf=");
+        for (unsigned i = 0; i < isotp->rx.idx; i++) {
+            DEBUG("%02hhx", ((uint8_t *)isotp->rx.snip->data)[i]);
+        }
+        DEBUG("\n");
     }
-    DEBUG("\n");
 #endif
 
-    if (isotp->rx.idx >= isotp->rx.snip->size) {
+    if (isotp->rx.idx >= isotp->rx.len) {
         isotp->rx.state = ISOTP_IDLE;
         return _isotp_dispatch_rx(isotp);
     }
@@ -395,7 +496,7 @@ static int _isotp_rcv_cf(struct isotp *isotp, struct can_frame *frame, int ae)
         return 0;
     }
 
-    return _isotp_send_fc(isotp, ae, ISOTP_FC_CTS);
+    return _isotp_rx_cts(isotp, ae);
 }
 
 static int _isotp_rcv(struct isotp *isotp, struct can_frame *frame)
@@ -480,6 +581,35 @@ static int _isotp_send_fc(struct isotp *isotp, int ae, uint8_t status)
     }
 }
 
+/* sends a clear to send flow control frame, when streaming the block size is
+ * derived from the free space of the rx ring */
+static int _isotp_rx_cts(struct isotp *isotp, int ae)
+{
+    if (isotp->rx_ring) {
+        unsigned cf_len = CAN_MAX_DLEN - N_PCI_SZ - ae;
+        unsigned left = isotp->rx.len - isotp->rx.idx;
+        unsigned space = tsrb_free(isotp->rx_ring);
+
+        if ((space < left) && (space < cf_len)) {
+            DEBUG("_isotp_rx_cts: rx ring full\n");
+            if (isotp->rx.state != ISOTP_WAIT_SPACE) {
+                isotp->rx.state = ISOTP_WAIT_SPACE;
+                isotp->rx.bs = 0;
+            }
+            xtimer_set(&isotp->rx_timer, CAN_ISOTP_STREAM_POLL);
+            return 0;
+        }
+        if (isotp->rx.state == ISOTP_WAIT_SPACE) {
+            isotp->rx.state = ISOTP_WAIT_CF;
+        }
+        /* no further flow control is needed if the rest fits */
+        isotp->rxfc.bs = (space >= left) ? 0 : MIN(space / cf_len, 0xFF);
+        isotp->rxfc.stmin = 0;
+    }
+
+    return _isotp_send_fc(isotp, ae, ISOTP_FC_CTS);
+}
+
 static void _isotp_create_ff(struct isotp *isotp, struct can_frame *frame, int ae)
 {
 
@@ -606,15 +736,21 @@ static void _isotp_tx_tx_conf(struct isotp *isotp)
 static void _isotp_rx_timeout_task(struct isotp *isotp)
 {
     switch (isotp->rx.state) {
+    case ISOTP_WAIT_SPACE:
+        if (++isotp->rx.bs < CAN_ISOTP_TIMEOUT_N_Bs / CAN_ISOTP_STREAM_POLL) {
+            _isotp_rx_cts(isotp, (isotp->opt.flags & CAN_ISOTP_EXTEND_ADDR) ? 1 : 0);
+            break;
+        }
+        DEBUG("_isotp_rx_timeout_task: rx ring not read on time\n");
+        _isotp_rx_abort(isotp);
+        break;
     case ISOTP_SENDING_FC:
         DEBUG("_isotp_rx_timeout_task: FC tx conf timeout\n");
         raw_can_abort(isotp->entry.ifnum, isotp->rx.tx_handle);
         /* Fall through */
     case ISOTP_WAIT_CF:
         DEBUG("_isotp_rx_timeout_task: free rx buf\n");
-        gnrc_pktbuf_release(isotp->rx.snip);
-        isotp->rx.snip = NULL;
-        isotp->rx.state = ISOTP_IDLE;
+        _isotp_rx_abort(isotp);
         /* TODO dispatch rx error ? */
         break;
     }
@@ -730,6 +866,13 @@ static void *_isotp_thread(void *args)
             DEBUG("_isotp_thread: TX_TIMEOUT arg=%p\n", (void *)isotp);
             _isotp_tx_timeout_task(isotp);
             break;
+        case CAN_MSG_ISOTP_RX_RESUME:
+            isotp = msg.content.ptr;
+            DEBUG("_isotp_thread: RX_RESUME arg=%p\n", (void *)isotp);
+            if (isotp->rx.state == ISOTP_RX_ERROR) {
+                isotp->rx.state = ISOTP_IDLE;
+            }
+            break;
         }
     }
 
@@ -854,6 +997,16 @@ int isotp_bind(struct isotp *isotp, can_reg_entry_t *entry, void *arg)
     return 0;
 }
 
+void isotp_rx_resume(struct isotp *isotp)
+{
+    assert(isotp != NULL);
+
+    msg_t msg;
+    msg.type = CAN_MSG_ISOTP_RX_RESUME;
+    msg.content.ptr = isotp;
+    msg_send(&msg, isotp_pid);
+}
+
 void isotp_free_rx(can_rx_data_t *rx)
 {
     DEBUG("isotp_free_rx: rx=%p\n", (void *)rx);
@@ -12,6 +12,11 @@
  * @file
  * @brief       Functions for routing RX can frames
  *
+ * Filters are grouped by their mask. Filters of a group are kept in a hash
+ * table indexed by their CAN ID, so a received frame only needs one look-up
+ * per group. Filters with a mask that did not get a group are kept in a
+ * plain list that is scanned for every frame.
+ *
  * @author      Toon Stegen <toon.stegen@altran.com>
  * @author      Vincent Dupont <vincent@otakeys.com>
  * @}
@@ -54,9 +59,19 @@ typedef struct filter_el {
 } filter_el_t;
 
 /**
- * This table contains @p CAN_ROUTER_APP_MAX lists of CAN IDs per interface
+ * Filters of one interface
  */
-static can_reg_entry_t *table[CAN_DLL_NUMOF];
+typedef struct {
+    can_reg_entry_t *buckets[CAN_ROUTER_HASH_SIZE]; /**< grouped filters */
+    canid_t masks[CAN_ROUTER_MASK_GROUPS];          /**< mask of each group */
+    uint16_t users[CAN_ROUTER_MASK_GROUPS];         /**< filters per group */
+    can_reg_entry_t *others;                        /**< ungrouped filters */
+} if_filters_t;
+
+/**
+ * This table contains the filters of each interface
+ */
+static if_filters_t table[CAN_DLL_NUMOF];
 
 
 static mutex_t lock = MUTEX_INIT;
@@ -68,16 +83,31 @@ static filter_el_t *_find_filter_el(can_reg_entry_t *list, can_reg_entry_t *entr
 static int _filter_is_used(unsigned int ifnum, canid_t can_id, canid_t mask);
 
 #if ENABLE_DEBUG
+static void _print_list(can_reg_entry_t *list)
+{
+    can_reg_entry_t *entry;
+    LL_FOREACH(list, entry) {
+        filter_el_t *el = container_of(entry, filter_el_t, entry);
+        DEBUG("App pid=%" PRIkernel_pid ", el=%p, can_id=0x%" PRIx32 ", mask=0x%" PRIx32 ", data=%p\n",
+              el->entry.target.pid, (void*)el, el->can_id, el->mask, el->data);
+    }
+}
+
 static void _print_filters(void)
 {
     for (int i = 0; i < (int)CAN_DLL_NUMOF; i++) {
         DEBUG("--- Ifnum: %d ---\n", i);
-        can_reg_entry_t *entry;
-        LL_FOREACH(table[i], entry) {
-            filter_el_t *el = container_of(entry, filter_el_t, entry);
-            DEBUG("App pid=%" PRIkernel_pid ", el=%p, can_id=0x%" PRIx32 ", mask=0x%" PRIx32 ", data=%p\n",
-                  el->entry.target.pid, (void*)el, el->can_id, el->mask, el->data);
+        for (unsigned g = 0; g < CAN_ROUTER_MASK_GROUPS; g++) {
+            if (table[i].users[g]) {
+                DEBUG("mask group 0x%" PRIx32 ": %u filters\n",
+                      table[i].masks[g], table[i].users[g]);
+            }
+        }
+        for (unsigned b = 0; b < CAN_ROUTER_HASH_SIZE; b++) {
+            _print_list(table[i].buckets[b]);
         }
+        DEBUG("ungrouped:\n");
+        _print_list(table[i].others);
     }
 }
 
@@ -86,6 +116,68 @@ static void _print_filters(void)
 #define PRINT_FILTERS()
 #endif
 
+static inline unsigned _hash(canid_t can_id, canid_t mask)
+{
+    /* Knuth's multiplicative hash */
+    return (((can_id ^ mask) * 2654435761U) >> 16) & (CAN_ROUTER_HASH_SIZE - 1);
+}
+
+static int _group(if_filters_t *filters, canid_t mask)
+{
+    for (unsigned g = 0; g < CAN_ROUTER_MASK_GROUPS; g++) {
+        if (filters->users[g] && (filters->masks[g] == mask)) {
+            return g;
+        }
+    }
+    return -1;
+}
+
+/* returns the list a new filter goes to, takes a new group if needed */
+static can_reg_entry_t **_add_to_group(if_filters_t *filters, canid_t can_id,
+                                       canid_t mask)
+{
+    int group = _group(filters, mask);
+
+    for (unsigned g = 0; (group < 0) && (g < CAN_ROUTER_MASK_GROUPS); g++) {
+        if (filters->users[g] == 0) {
+            filters->masks[g] = mask;
+            group = g;
+        }
+    }
+    if (group < 0) {
+        return &filters->others;
+    }
+    filters->users[group]++;
+    return &filters->buckets[_hash(can_id, mask)];
+}
+
+/* finds the list a registered filter is in */
+static can_reg_entry_t **_list(if_filters_t *filters, filter_el_t *el)
+{
+    can_reg_entry_t *entry;
+
+    if (_group(filters, el->mask) >= 0) {
+        can_reg_entry_t **bucket = &filters->buckets[_hash(el->can_id, el->mask)];
+        LL_FOREACH(*bucket, entry) {
+            if (entry == &el->entry) {
+                return bucket;
+            }
+        }
+    }
+    /* the filter was registered before its mask got a group */
+    return &filters->others;
+}
+
+static void _remove_from_group(if_filters_t *filters, filter_el_t *el)
+{
+    can_reg_entry_t **list = _list(filters, el);
+
+    LL_DELETE(*list, &el->entry);
+    if (list != &filters->others) {
+        filters->users[_group(filters, el->mask)]--;
+    }
+}
+
 static filter_el_t *_alloc_filter_el(canid_t can_id, canid_t mask, void *data)
 {
     filter_el_t *el;
@@ -177,9 +269,9 @@ static filter_el_t *_find_filter_el(can_reg_entry_t *list, can_reg_entry_t *entr
     return NULL;
 }
 
-static int _filter_is_used(unsigned int ifnum, canid_t can_id, canid_t mask)
+static int _filter_is_used_in(can_reg_entry_t *list, canid_t can_id, canid_t mask)
 {
-    filter_el_t *el = container_of(table[ifnum], filter_el_t, entry);
+    filter_el_t *el = container_of(list, filter_el_t, entry);
     if (!el) {
         DEBUG("_filter_is_used: empty list\n");
         return 0;
@@ -198,6 +290,15 @@ static int _filter_is_used(unsigned int ifnum, canid_t can_id, canid_t mask)
     return 0;
 }
 
+static int _filter_is_used(unsigned int ifnum, canid_t can_id, canid_t mask)
+{
+    if ((_group(&table[ifnum], mask) >= 0) &&
+        _filter_is_used_in(table[ifnum].buckets[_hash(can_id, mask)], can_id, mask)) {
+        return 1;
+    }
+    return _filter_is_used_in(table[ifnum].others, can_id, mask);
+}
+
 /* register interested users */
 int can_router_register(can_reg_entry_t *entry, canid_t can_id, canid_t mask, void *param)
 {
@@ -238,7 +339,7 @@ int can_router_register(can_reg_entry_t *entry, canid_t can_id, canid_t mask, vo
     filter->entry.target.pid = entry->target.pid;
 #endif
     filter->entry.ifnum = entry->ifnum;
-    _insert_to_list(&table[entry->ifnum], filter);
+    _insert_to_list(_add_to_group(&table[entry->ifnum], can_id, mask), filter);
     mutex_unlock(&lock);
 
     PRINT_FILTERS();
@@ -264,12 +365,19 @@ int can_router_unregister(can_reg_entry_t *entry, canid_t can_id,
 #endif
 
     mutex_lock(&lock);
-    el = _find_filter_el(table[entry->ifnum], entry, can_id, mask, param);
+    el = NULL;
+    if (_group(&table[entry->ifnum], mask) >= 0) {
+        el = _find_filter_el(table[entry->ifnum].buckets[_hash(can_id, mask)],
+                             entry, can_id, mask, param);
+    }
+    if (!el) {
+        el = _find_filter_el(table[entry->ifnum].others, entry, can_id, mask, param);
+    }
     if (!el) {
         mutex_unlock(&lock);
         return -EINVAL;
     }
-    LL_DELETE(table[entry->ifnum], &el->entry);
+    _remove_from_group(&table[entry->ifnum], el);
     _free_filter_el(el);
     ret = _filter_is_used(entry->ifnum, can_id, mask);
     mutex_unlock(&lock);
@@ -296,6 +404,25 @@ static int _send_msg(msg_t *msg, can_reg_entry_t *entry)
 #endif
 }
 
+/* sends an rx indication of pkt to the filter's user */
+static int _deliver(can_pkt_t *pkt, filter_el_t *el, msg_t *msg)
+{
+    DEBUG("can_router_dispatch_rx_indic: found el=%p, data=%p\n",
+          (void *)el, (void *)el->data);
+    DEBUG("can_router_dispatch_rx_indic: rx_ind to pid: %"
+          PRIkernel_pid "\n", el->entry.target.pid);
+    atomic_fetch_add(&pkt->ref_count, 1);
+    msg->content.ptr = can_pkt_alloc_rx_data(&pkt->frame, sizeof(pkt->frame), el->data);
+    if (!msg->content.ptr || (_send_msg(msg, &el->entry) <= 0)) {
+        can_pkt_free_rx_data(msg->content.ptr);
+        atomic_fetch_sub(&pkt->ref_count, 1);
+        DEBUG("can_router_dispatch_rx_indic: failed to send msg to "
+              "pid=%" PRIkernel_pid "\n", el->entry.target.pid);
+        return -EBUSY;
+    }
+    return 0;
+}
+
 /* send received pkt to all interested users */
 int can_router_dispatch_rx_indic(can_pkt_t *pkt)
 {
@@ -307,41 +434,38 @@ int can_router_dispatch_rx_indic(can_pkt_t *pkt)
     int res = 0;
     msg_t msg;
     msg.type = CAN_MSG_RX_INDICATION;
-#if ENABLE_DEBUG
-    int msg_cnt = 0;
-#endif
     DEBUG("can_router_dispatch_rx_indic: pkt=%p, ifnum=%d, can_id=%" PRIx32 "\n",
           (void *)pkt, pkt->entry.ifnum, pkt->frame.can_id);
 
     mutex_lock(&lock);
+    if_filters_t *filters = &table[pkt->entry.ifnum];
     can_reg_entry_t *entry;
     filter_el_t *el;
-    LL_FOREACH(table[pkt->entry.ifnum], entry) {
-        el = container_of(entry, filter_el_t, entry);
-        if ((pkt->frame.can_id & el->mask) == el->can_id) {
-            DEBUG("can_router_dispatch_rx_indic: found el=%p, data=%p\n",
-                  (void *)el, (void *)el->data);
-            DEBUG("can_router_dispatch_rx_indic: rx_ind to pid: %"
-                  PRIkernel_pid "\n", entry->target.pid);
-            atomic_fetch_add(&pkt->ref_count, 1);
-            msg.content.ptr = can_pkt_alloc_rx_data(&pkt->frame, sizeof(pkt->frame), el->data);
-#if ENABLE_DEBUG
-            msg_cnt++;
-#endif
-            if (!msg.content.ptr || (_send_msg(&msg, entry) <= 0)) {
-                can_pkt_free_rx_data(msg.content.ptr);
-                atomic_fetch_sub(&pkt->ref_count, 1);
-                DEBUG("can_router_dispatch_rx_indic: failed to send msg to "
-                      "pid=%" PRIkernel_pid "\n", entry->target.pid);
-                res = -EBUSY;
+    for (unsigned g = 0; (g < CAN_ROUTER_MASK_GROUPS) && (res == 0); g++) {
+        if (filters->users[g] == 0) {
+            continue;
+        }
+        canid_t mask = filters->masks[g];
+        canid_t can_id = pkt->frame.can_id & mask;
+        LL_FOREACH(filters->buckets[_hash(can_id, mask)], entry) {
+            el = container_of(entry, filter_el_t, entry);
+            /* the bucket is shared with other groups */
+            if ((el->mask == mask) && (el->can_id == can_id) &&
+                ((res = _deliver(pkt, el, &msg)) < 0)) {
+                break;
+            }
+        }
+    }
+    if (res == 0) {
+        LL_FOREACH(filters->others, entry) {
+            el = container_of(entry, filter_el_t, entry);
+            if (((pkt->frame.can_id & el->mask) == el->can_id) &&
+                ((res = _deliver(pkt, el, &msg)) < 0)) {
                 break;
             }
         }
     }
     mutex_unlock(&lock);
-#if ENABLE_DEBUG
-    DEBUG("can_router_dispatch_rx: msg send to %d threads\n", msg_cnt);
-#endif
     if (atomic_load(&pkt->ref_count) == 0) {
         can_pkt_free(pkt);
     }
@@ -15,8 +15,10 @@
 
 #include "cbor.h"
 
+#include "assert.h"
 #include "byteorder.h"
 
+#include <errno.h>
 #include <inttypes.h>
 #include <math.h>
 #include <stdint.h>
@@ -1084,3 +1086,387 @@ void cbor_stream_decode(cbor_stream_t *stream)
     puts("");
 }
 /* END: Printers */
+
+/* BEGIN: Streaming API */
+int cbor_reader_next(cbor_reader_t *reader, cbor_item_t *item)
+{
+    const uint8_t *in = reader->pos;
+
+    if (in == reader->end) {
+        return -ENODATA;
+    }
+
+    unsigned char type = *in & CBOR_TYPE_MASK;
+    unsigned char info = *in & CBOR_INFO_MASK;
+    uint64_t val = info;
+
+    in++;
+    item->indefinite = false;
+    item->size = 0;
+    item->data = NULL;
+
+    if (info == CBOR_VAR_FOLLOWS) {
+        if ((type == CBOR_UINT) || (type == CBOR_NEGINT) || (type == CBOR_TAG)) {
+            return -EBADMSG;
+        }
+        item->indefinite = true;
+        val = 0;
+    }
+    else if (info >= CBOR_BYTE_FOLLOWS) {
+        unsigned char bytes_follow = uint_bytes_follow(info);
+
+        if (!bytes_follow) {
+            /* reserved values 28-30 */
+            return -EBADMSG;
+        }
+        if (bytes_follow > (size_t)(reader->end - in)) {
+            return -EAGAIN;
+        }
+        val = 0;
+        for (unsigned i = 0; i < bytes_follow; i++) {
+            val = (val << 8) | *in++;
+        }
+        item->size = bytes_follow;
+    }
+    item->val.u = val;
+
+    switch (type) {
+        case CBOR_BYTES:
+        case CBOR_TEXT:
+            if (!item->indefinite) {
+                if (val > (uint64_t)(reader->end - in)) {
+                    return -EAGAIN;
+                }
+                item->data = in;
+                in += val;
+            }
+            break;
+
+        case CBOR_7:
+            if (info == CBOR_VAR_FOLLOWS) {
+                item->type = CBOR_ITEM_BREAK;
+                item->indefinite = false;
+            }
+            else if (info > CBOR_BYTE_FOLLOWS) {
+                item->type = CBOR_ITEM_FLOAT;
+            }
+            else {
+                item->type = CBOR_ITEM_SIMPLE;
+                item->size = 0;
+            }
+            reader->pos = in;
+            return 0;
+
+        default:
+            break;
+    }
+
+    /* item types 0-6 match the major types */
+    item->type = (cbor_item_type_t)(type >> 5);
+    item->size = 0;
+    reader->pos = in;
+
+    return 0;
+}
+
+static int _reader_skip(cbor_reader_t *reader, const cbor_item_t *item,
+                        unsigned depth)
+{
+    uint64_t items;
+
+    switch (item->type) {
+        case CBOR_ITEM_ARRAY:
+            items = item->val.u;
+            break;
+        case CBOR_ITEM_MAP:
+            if (item->val.u > (UINT64_MAX / 2)) {
+                return -EBADMSG;
+            }
+            items = item->val.u * 2;
+            break;
+        case CBOR_ITEM_TAG:
+            items = 1;
+            break;
+        case CBOR_ITEM_BYTES:
+        case CBOR_ITEM_TEXT:
+            /* chunks of an indefinite length string */
+            items = 0;
+            break;
+        default:
+            return 0;
+    }
+    if (!item->indefinite && !items) {
+        return 0;
+    }
+    if (depth >= CBOR_READER_DEPTH_MAX) {
+        return -EBADMSG;
+    }
+
+    while (item->indefinite || items--) {
+        cbor_item_t inner;
+        int res = cbor_reader_next(reader, &inner);
+
+        if (res < 0) {
+            return (res == -ENODATA) ? -EAGAIN : res;
+        }
+        if (inner.type == CBOR_ITEM_BREAK) {
+            return item->indefinite ? 0 : -EBADMSG;
+        }
+        res = _reader_skip(reader, &inner, depth + 1);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    return 0;
+}
+
+int cbor_reader_skip(cbor_reader_t *reader, const cbor_item_t *item)
+{
+    const uint8_t *start = reader->pos;
+    int res = _reader_skip(reader, item, 0);
+
+    if (res < 0) {
+        reader->pos = start;
+    }
+    return res;
+}
+
+int cbor_item_get_int(const cbor_item_t *item, int64_t *val)
+{
+    if ((item->type != CBOR_ITEM_UINT) && (item->type != CBOR_ITEM_NEGINT)) {
+        return -EINVAL;
+    }
+    if (item->val.u > INT64_MAX) {
+        return -ERANGE;
+    }
+    *val = (item->type == CBOR_ITEM_UINT) ? (int64_t)item->val.u
+                                          : -1 - (int64_t)item->val.u;
+    return 0;
+}
+
+#ifdef MODULE_CBOR_FLOAT
+int cbor_item_get_double(const cbor_item_t *item, double *val)
+{
+    switch (item->type) {
+        case CBOR_ITEM_UINT:
+            *val = item->val.u;
+            return 0;
+        case CBOR_ITEM_NEGINT:
+            *val = -1.0 - item->val.u;
+            return 0;
+        case CBOR_ITEM_FLOAT:
+            break;
+        default:
+            return -EINVAL;
+    }
+
+    switch (item->size) {
+        case 2: {
+            unsigned char half[2] = { item->val.bits >> 8, item->val.bits };
+            *val = decode_float_half(half);
+            break;
+        }
+        case 4: {
+            union {
+                float f;
+                uint32_t i;
+            } u = { .i = item->val.bits };
+            *val = u.f;
+            break;
+        }
+        default: {
+            union {
+                double d;
+                uint64_t i;
+            } u = { .i = item->val.bits };
+            *val = u.d;
+            break;
+        }
+    }
+
+    return 0;
+}
+#endif /* MODULE_CBOR_FLOAT */
+
+void cbor_writer_init(cbor_writer_t *writer, uint8_t *buf, size_t size,
+                      cbor_writer_flush_t flush, void *arg)
+{
+    /* the longest head is 9 bytes */
+    assert(size >= 9);
+
+    writer->buf = buf;
+    writer->size = size;
+    writer->pos = 0;
+    writer->flushed = 0;
+    writer->flush = flush;
+    writer->arg = arg;
+    writer->res = 0;
+}
+
+static int writer_flush(cbor_writer_t *w)
+{
+    if (!w->flush) {
+        return -ENOBUFS;
+    }
+
+    int res = w->flush(w->arg, w->buf, w->pos);
+    if (res < 0) {
+        return res;
+    }
+    w->flushed += w->pos;
+    w->pos = 0;
+
+    return 0;
+}
+
+static int writer_data(cbor_writer_t *w, const void *data, size_t len)
+{
+    if (w->res) {
+        return w->res;
+    }
+
+    if (w->pos + len > w->size) {
+        int res = writer_flush(w);
+        if (res < 0) {
+            return w->res = res;
+        }
+        if (len > w->size) {
+            /* hand large strings over without copying them */
+            res = w->flush(w->arg, data, len);
+            if (res < 0) {
+                return w->res = res;
+            }
+            w->flushed += len;
+            return 0;
+        }
+    }
+    memcpy(w->buf + w->pos, data, len);
+    w->pos += len;
+
+    return 0;
+}
+
+static int writer_head(cbor_writer_t *w, unsigned char major_type, uint64_t val)
+{
+    if (w->res) {
+        return w->res;
+    }
+    if (val < CBOR_UINT8_FOLLOWS) {
+        /* most heads are a single byte */
+        if (w->pos == w->size) {
+            int res = writer_flush(w);
+            if (res < 0) {
+                return w->res = res;
+            }
+        }
+        w->buf[w->pos++] = major_type | val;
+        return 0;
+    }
+
+    unsigned char additional_info = uint_additional_info(val);
+    unsigned char bytes_follow = uint_bytes_follow(additional_info);
+    uint8_t head[9];
+
+    head[0] = major_type | additional_info;
+    for (unsigned i = 1; i <= bytes_follow; i++) {
+        head[i] = (val >> (8 * (bytes_follow - i))) & 0xff;
+    }
+
+    return writer_data(w, head, bytes_follow + 1);
+}
+
+int cbor_writer_uint(cbor_writer_t *writer, uint64_t val)
+{
+    return writer_head(writer, CBOR_UINT, val);
+}
+
+int cbor_writer_int(cbor_writer_t *writer, int64_t val)
+{
+    if (val >= 0) {
+        return writer_head(writer, CBOR_UINT, val);
+    }
+    return writer_head(writer, CBOR_NEGINT, -1 - val);
+}
+
+int cbor_writer_bytes(cbor_writer_t *writer, const void *data, size_t len)
+{
+    writer_head(writer, CBOR_BYTES, len);
+    return writer_data(writer, data, len);
+}
+
+int cbor_writer_text(cbor_writer_t *writer, const char *str, size_t len)
+{
+    writer_head(writer, CBOR_TEXT, len);
+    return writer_data(writer, str, len);
+}
+
+int cbor_writer_array(cbor_writer_t *writer, size_t len)
+{
+    if (len == CBOR_INDEFINITE) {
+        uint8_t head = CBOR_ARRAY | CBOR_VAR_FOLLOWS;
+        return writer_data(writer, &head, 1);
+    }
+    return writer_head(writer, CBOR_ARRAY, len);
+}
+
+int cbor_writer_map(cbor_writer_t *writer, size_t len)
+{
+    if (len == CBOR_INDEFINITE) {
+        uint8_t head = CBOR_MAP | CBOR_VAR_FOLLOWS;
+        return writer_data(writer, &head, 1);
+    }
+    return writer_head(writer, CBOR_MAP, len);
+}
+
+int cbor_writer_tag(cbor_writer_t *writer, uint64_t tag)
+{
+    return writer_head(writer, CBOR_TAG, tag);
+}
+
+int cbor_writer_bool(cbor_writer_t *writer, bool val)
+{
+    uint8_t head = val ? CBOR_TRUE : CBOR_FALSE;
+    return writer_data(writer, &head, 1);
+}
+
+int cbor_writer_break(cbor_writer_t *writer)
+{
+    uint8_t head = CBOR_BREAK;
+    return writer_data(writer, &head, 1);
+}
+
+#ifdef MODULE_CBOR_FLOAT
+int cbor_writer_double(cbor_writer_t *writer, double val)
+{
+    uint8_t buf[9];
+
+    if (((double)(float)val == val) || isnan(val)) {
+        uint32_t encoded_val = htonf(val);
+        buf[0] = CBOR_FLOAT32;
+        memcpy(buf + 1, &encoded_val, 4);
+        return writer_data(writer, buf, 5);
+    }
+
+    uint64_t encoded_val = htond(val);
+    buf[0] = CBOR_FLOAT64;
+    memcpy(buf + 1, &encoded_val, 8);
+    return writer_data(writer, buf, 9);
+}
+#endif /* MODULE_CBOR_FLOAT */
+
+ssize_t cbor_writer_finish(cbor_writer_t *writer)
+{
+    if (writer->res) {
+        return writer->res;
+    }
+    if (writer->flush && writer->pos) {
+        int res = writer_flush(writer);
+        if (res < 0) {
+            return writer->res = res;
+        }
+    }
+
+    return writer->flushed + writer->pos;
+}
+/* END: Streaming API */
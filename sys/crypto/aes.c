@@ -37,6 +37,10 @@
 #include "crypto/aes.h"
 #include "crypto/ciphers.h"
 
+#ifdef __AES__
+#include <wmmintrin.h>
+#endif
+
 /**
  * Interface to the aes cipher
  */
@@ -45,10 +49,13 @@ static const cipher_interface_t aes_interface = {
     AES_KEY_SIZE,
     aes_init,
     aes_encrypt,
-    aes_decrypt
+    aes_decrypt,
+    aes_encrypt_blocks,
+    aes_decrypt_blocks
 };
 const cipher_id_t CIPHER_AES_128 = &aes_interface;
 
+#ifndef __AES__
 static const u32 Te0[256] = {
     0xc66363a5U, 0xf87c7c84U, 0xee777799U, 0xf67b7b8dU,
     0xfff2f20dU, 0xd66b6bbdU, 0xde6f6fb1U, 0x91c5c554U,
@@ -314,6 +321,7 @@ static const u32 Te3[256] = {
     0x4141c382U, 0x9999b029U, 0x2d2d775aU, 0x0f0f111eU,
     0xb0b0cb7bU, 0x5454fca8U, 0xbbbbd66dU, 0x16163a2cU,
 };
+#endif /* __AES__ */
 static const u32 Te4[256] = {
     0x63636363U, 0x7c7c7c7cU, 0x77777777U, 0x7b7b7b7bU,
     0xf2f2f2f2U, 0x6b6b6b6bU, 0x6f6f6f6fU, 0xc5c5c5c5U,
@@ -645,6 +653,7 @@ static const u32 Td3[256] = {
     0xa8017139U, 0x0cb3de08U, 0xb4e49cd8U, 0x56c19064U,
     0xcb84617bU, 0x32b670d5U, 0x6c5c7448U, 0xb85742d0U,
 };
+#ifndef __AES__
 static const u32 Td4[256] = {
     0x52525252U, 0x09090909U, 0x6a6a6a6aU, 0xd5d5d5d5U,
     0x30303030U, 0x36363636U, 0xa5a5a5a5U, 0x38383838U,
@@ -711,6 +720,7 @@ static const u32 Td4[256] = {
     0xe1e1e1e1U, 0x69696969U, 0x14141414U, 0x63636363U,
     0x55555555U, 0x21212121U, 0x0c0c0c0cU, 0x7d7d7d7dU,
 };
+#endif /* __AES__ */
 
 /* for 128-bit blocks, Rijndael never uses more than 10 rcon values */
 static const u32 rcon[] = {
@@ -720,28 +730,47 @@ static const u32 rcon[] = {
 };
 
 
+static int aes_set_encrypt_key(const unsigned char *userKey, const int bits,
+                               AES_KEY *key);
+static int aes_set_decrypt_key(const unsigned char *userKey, const int bits,
+                               AES_KEY *key);
+
 int aes_init(cipher_context_t *context, const uint8_t *key, uint8_t keySize)
 {
+    aes_context_t *ctx = (aes_context_t *)context->context;
+    uint8_t user_key[AES_KEY_SIZE];
+    AES_KEY aeskey;
     uint8_t i;
 
     // Make sure that context is large enough. If this is not the case,
-    // you should build with -DAES
-    if(CIPHER_MAX_CONTEXT_SIZE < AES_KEY_SIZE) {
+    // you should build with -DCRYPTO_AES
+    if (CIPHER_MAX_CONTEXT_SIZE < sizeof(aes_context_t)) {
         return CIPHER_ERR_BAD_CONTEXT_SIZE;
     }
 
-    //key must be at least CIPHERS_MAX_KEY_SIZE Bytes long
-    if (keySize < CIPHERS_MAX_KEY_SIZE) {
-        //fill up by concatenating key to as long as needed
-        for (i = 0; i < CIPHERS_MAX_KEY_SIZE; i++) {
-            context->context[i] = key[(i % keySize)];
-        }
+    //fill up by concatenating key to as long as needed
+    for (i = 0; i < AES_KEY_SIZE; i++) {
+        user_key[i] = key[(i % keySize)];
     }
-    else {
-        for (i = 0; i < CIPHERS_MAX_KEY_SIZE; i++) {
-            context->context[i] = key[i];
-        }
+
+    // expand the round keys once, so the block functions don't need to
+    if (aes_set_encrypt_key(user_key, AES_KEY_SIZE * 8, &aeskey) < 0) {
+        return CIPHER_ERR_INVALID_KEY_SIZE;
     }
+    memcpy(ctx->enc_key, aeskey.rd_key, sizeof(ctx->enc_key));
+
+    if (aes_set_decrypt_key(user_key, AES_KEY_SIZE * 8, &aeskey) < 0) {
+        return CIPHER_ERR_INVALID_KEY_SIZE;
+    }
+    memcpy(ctx->dec_key, aeskey.rd_key, sizeof(ctx->dec_key));
+
+#ifdef __AES__
+    // AES-NI expects the round keys as byte strings
+    for (i = 0; i < (4 * (AES_ROUNDS + 1)); i++) {
+        ctx->enc_key[i] = __builtin_bswap32(ctx->enc_key[i]);
+        ctx->dec_key[i] = __builtin_bswap32(ctx->dec_key[i]);
+    }
+#endif
 
     return CIPHER_INIT_SUCCESS;
 }
@@ -931,7 +960,131 @@ static int aes_set_decrypt_key(const unsigned char *userKey, const int bits,
     return 0;
 }
 
-#ifndef AES_ASM
+#if defined(__AES__)
+/*
+ * Block functions using the AES-NI instructions. Four independent blocks are
+ * processed at once to hide the latency of the AES instructions.
+ */
+static inline void _aesni_load_keys(__m128i *k, const uint32_t *rk)
+{
+    for (unsigned i = 0; i <= AES_ROUNDS; i++) {
+        k[i] = _mm_loadu_si128((const __m128i *)&rk[4 * i]);
+    }
+}
+
+int aes_encrypt_blocks(const cipher_context_t *context, const uint8_t *plain,
+                       uint8_t *cipher, size_t blocks)
+{
+    const aes_context_t *ctx = (const aes_context_t *)context->context;
+    __m128i k[AES_ROUNDS + 1];
+
+    _aesni_load_keys(k, ctx->enc_key);
+
+    for (; blocks >= 4; blocks -= 4) {
+        __m128i b0 = _mm_loadu_si128((const __m128i *)plain);
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(plain + 16));
+        __m128i b2 = _mm_loadu_si128((const __m128i *)(plain + 32));
+        __m128i b3 = _mm_loadu_si128((const __m128i *)(plain + 48));
+
+        b0 = _mm_xor_si128(b0, k[0]);
+        b1 = _mm_xor_si128(b1, k[0]);
+        b2 = _mm_xor_si128(b2, k[0]);
+        b3 = _mm_xor_si128(b3, k[0]);
+        for (unsigned r = 1; r < AES_ROUNDS; r++) {
+            b0 = _mm_aesenc_si128(b0, k[r]);
+            b1 = _mm_aesenc_si128(b1, k[r]);
+            b2 = _mm_aesenc_si128(b2, k[r]);
+            b3 = _mm_aesenc_si128(b3, k[r]);
+        }
+        _mm_storeu_si128((__m128i *)cipher,
+                         _mm_aesenclast_si128(b0, k[AES_ROUNDS]));
+        _mm_storeu_si128((__m128i *)(cipher + 16),
+                         _mm_aesenclast_si128(b1, k[AES_ROUNDS]));
+        _mm_storeu_si128((__m128i *)(cipher + 32),
+                         _mm_aesenclast_si128(b2, k[AES_ROUNDS]));
+        _mm_storeu_si128((__m128i *)(cipher + 48),
+                         _mm_aesenclast_si128(b3, k[AES_ROUNDS]));
+        plain += 4 * AES_BLOCK_SIZE;
+        cipher += 4 * AES_BLOCK_SIZE;
+    }
+
+    for (; blocks > 0; blocks--) {
+        __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *)plain), k[0]);
+
+        for (unsigned r = 1; r < AES_ROUNDS; r++) {
+            b = _mm_aesenc_si128(b, k[r]);
+        }
+        _mm_storeu_si128((__m128i *)cipher, _mm_aesenclast_si128(b, k[AES_ROUNDS]));
+        plain += AES_BLOCK_SIZE;
+        cipher += AES_BLOCK_SIZE;
+    }
+
+    return 1;
+}
+
+int aes_decrypt_blocks(const cipher_context_t *context, const uint8_t *cipher,
+                       uint8_t *plain, size_t blocks)
+{
+    const aes_context_t *ctx = (const aes_context_t *)context->context;
+    __m128i k[AES_ROUNDS + 1];
+
+    _aesni_load_keys(k, ctx->dec_key);
+
+    for (; blocks >= 4; blocks -= 4) {
+        __m128i b0 = _mm_loadu_si128((const __m128i *)cipher);
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(cipher + 16));
+        __m128i b2 = _mm_loadu_si128((const __m128i *)(cipher + 32));
+        __m128i b3 = _mm_loadu_si128((const __m128i *)(cipher + 48));
+
+        b0 = _mm_xor_si128(b0, k[0]);
+        b1 = _mm_xor_si128(b1, k[0]);
+        b2 = _mm_xor_si128(b2, k[0]);
+        b3 = _mm_xor_si128(b3, k[0]);
+        for (unsigned r = 1; r < AES_ROUNDS; r++) {
+            b0 = _mm_aesdec_si128(b0, k[r]);
+            b1 = _mm_aesdec_si128(b1, k[r]);
+            b2 = _mm_aesdec_si128(b2, k[r]);
+            b3 = _mm_aesdec_si128(b3, k[r]);
+        }
+        _mm_storeu_si128((__m128i *)plain,
+                         _mm_aesdeclast_si128(b0, k[AES_ROUNDS]));
+        _mm_storeu_si128((__m128i *)(plain + 16),
+                         _mm_aesdeclast_si128(b1, k[AES_ROUNDS]));
+        _mm_storeu_si128((__m128i *)(plain + 32),
+                         _mm_aesdeclast_si128(b2, k[AES_ROUNDS]));
+        _mm_storeu_si128((__m128i *)(plain + 48),
+                         _mm_aesdeclast_si128(b3, k[AES_ROUNDS]));
+        cipher += 4 * AES_BLOCK_SIZE;
+        plain += 4 * AES_BLOCK_SIZE;
+    }
+
+    for (; blocks > 0; blocks--) {
+        __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *)cipher), k[0]);
+
+        for (unsigned r = 1; r < AES_ROUNDS; r++) {
+            b = _mm_aesdec_si128(b, k[r]);
+        }
+        _mm_storeu_si128((__m128i *)plain, _mm_aesdeclast_si128(b, k[AES_ROUNDS]));
+        cipher += AES_BLOCK_SIZE;
+        plain += AES_BLOCK_SIZE;
+    }
+
+    return 1;
+}
+
+int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
+                uint8_t *cipherBlock)
+{
+    return aes_encrypt_blocks(context, plainBlock, cipherBlock, 1);
+}
+
+int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
+                uint8_t *plainBlock)
+{
+    return aes_decrypt_blocks(context, cipherBlock, plainBlock, 1);
+}
+
+#elif !defined(AES_ASM)
 /*
  * Encrypt a single block
  * in and out can overlap
@@ -939,23 +1092,14 @@ static int aes_set_decrypt_key(const unsigned char *userKey, const int bits,
 int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
                 uint8_t *cipherBlock)
 {
-    //setup AES_KEY
-    int res;
-    AES_KEY aeskey;
-    const AES_KEY *key = &aeskey;
-    res = aes_set_encrypt_key((unsigned char *)context->context,
-                                   AES_KEY_SIZE * 8, &aeskey);
-    if (res < 0) {
-        return res;
-    }
-
+    const aes_context_t *ctx = (const aes_context_t *)context->context;
     const u32 *rk;
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
 #ifndef FULL_UNROLL
     int r;
 #endif /* ?FULL_UNROLL */
 
-    rk = key->rd_key;
+    rk = ctx->enc_key;
 
     /*
      * map byte array block to cipher state
@@ -1048,7 +1192,7 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
     t3 = Te0[s3 >> 24] ^ Te1[(s0 >> 16) & 0xff] ^ Te2[(s1 >>  8) & 0xff] ^
          Te3[s2 & 0xff] ^ rk[39];
 
-    if (key->rounds > 10) {
+    if (AES_ROUNDS > 10) {
         /* round 10: */
         s0 = Te0[t0 >> 24] ^ Te1[(t1 >> 16) & 0xff] ^ Te2[(t2 >>  8) & 0xff] ^
              Te3[t3 & 0xff] ^ rk[40];
@@ -1068,7 +1212,7 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
         t3 = Te0[s3 >> 24] ^ Te1[(s0 >> 16) & 0xff] ^ Te2[(s1 >>  8) & 0xff] ^
              Te3[s2 & 0xff] ^ rk[47];
 
-        if (key->rounds > 12) {
+        if (AES_ROUNDS > 12) {
             /* round 12: */
             s0 = Te0[t0 >> 24] ^ Te1[(t1 >> 16) & 0xff] ^ Te2[(t2 >>  8) &
                     0xff] ^ Te3[t3 & 0xff] ^ rk[48];
@@ -1090,12 +1234,12 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
         }
     }
 
-    rk += key->rounds << 2;
+    rk += AES_ROUNDS << 2;
 #else  /* !FULL_UNROLL */
     /*
      * Nr - 1 full rounds:
      */
-    r = key->rounds >> 1;
+    r = AES_ROUNDS >> 1;
 
     while (1) {
         t0 =
@@ -1198,24 +1342,14 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
 int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
                 uint8_t *plainBlock)
 {
-    //setup AES_KEY
-    int res;
-    AES_KEY aeskey;
-    const AES_KEY *key = &aeskey;
-    res = aes_set_decrypt_key((unsigned char *)context->context,
-                              AES_KEY_SIZE * 8, &aeskey);
-
-    if (res < 0) {
-        return res;
-    }
-
+    const aes_context_t *ctx = (const aes_context_t *)context->context;
     const u32 *rk;
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
 #ifndef FULL_UNROLL
     int r;
 #endif /* ?FULL_UNROLL */
 
-    rk = key->rd_key;
+    rk = ctx->dec_key;
 
     /*
      * map byte array block to cipher state
@@ -1308,7 +1442,7 @@ int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
     t3 = Td0[s3 >> 24] ^ Td1[(s2 >> 16) & 0xff] ^ Td2[(s1 >>  8) & 0xff] ^
          Td3[s0 & 0xff] ^ rk[39];
 
-    if (key->rounds > 10) {
+    if (AES_ROUNDS > 10) {
         /* round 10: */
         s0 = Td0[t0 >> 24] ^ Td1[(t3 >> 16) & 0xff] ^ Td2[(t2 >>  8) & 0xff] ^
              Td3[t1 & 0xff] ^ rk[40];
@@ -1328,7 +1462,7 @@ int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
         t3 = Td0[s3 >> 24] ^ Td1[(s2 >> 16) & 0xff] ^ Td2[(s1 >>  8) & 0xff] ^
              Td3[s0 & 0xff] ^ rk[47];
 
-        if (key->rounds > 12) {
+        if (AES_ROUNDS > 12) {
             /* round 12: */
             s0 = Td0[t0 >> 24] ^ Td1[(t3 >> 16) & 0xff] ^ Td2[(t2 >>  8) & 0xff]
                  ^ Td3[t1 & 0xff] ^ rk[48];
@@ -1350,12 +1484,12 @@ int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
         }
     }
 
-    rk += key->rounds << 2;
+    rk += AES_ROUNDS << 2;
 #else  /* !FULL_UNROLL */
     /*
      * Nr - 1 full rounds:
      */
-    r = key->rounds >> 1;
+    r = AES_ROUNDS >> 1;
 
     while (1) {
         t0 =
@@ -1451,4 +1585,26 @@ int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
     return 1;
 }
 
+int aes_encrypt_blocks(const cipher_context_t *context, const uint8_t *plain,
+                       uint8_t *cipher, size_t blocks)
+{
+    for (; blocks > 0; blocks--) {
+        aes_encrypt(context, plain, cipher);
+        plain += AES_BLOCK_SIZE;
+        cipher += AES_BLOCK_SIZE;
+    }
+    return 1;
+}
+
+int aes_decrypt_blocks(const cipher_context_t *context, const uint8_t *cipher,
+                       uint8_t *plain, size_t blocks)
+{
+    for (; blocks > 0; blocks--) {
+        aes_decrypt(context, cipher, plain);
+        cipher += AES_BLOCK_SIZE;
+        plain += AES_BLOCK_SIZE;
+    }
+    return 1;
+}
+
 #endif /* AES_ASM */
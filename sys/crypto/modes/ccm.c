@@ -19,11 +19,12 @@
  */
 
 #include <string.h>
-#include "debug.h"
 #include "crypto/helper.h"
 #include "crypto/modes/ctr.h"
 #include "crypto/modes/ccm.h"
 
+#define CCM_BLOCK_SIZE  (16U)
+
 static inline int min(int a, int b)
 {
     if (a < b) {
@@ -34,223 +35,325 @@ static inline int min(int a, int b)
     }
 }
 
-int ccm_compute_cbc_mac(cipher_t* cipher, uint8_t iv[16],
-                        uint8_t* input, size_t length, uint8_t* mac)
+void cipher_cbc_mac_init(cipher_cbc_mac_t *ctx, const cipher_t *cipher,
+                         const uint8_t *iv)
 {
-    uint8_t offset, block_size, mac_enc[16] = {0};
+    ctx->cipher = cipher;
+    memcpy(ctx->mac, iv, cipher_get_block_size(cipher));
+    ctx->offset = 0;
+}
 
-    block_size = cipher_get_block_size(cipher);
-    memmove(mac, iv, 16);
-    offset = 0;
-    do {
-        uint8_t block_size_input = (length - offset > block_size) ?
-                                   block_size : length - offset;
+int cipher_cbc_mac_update(cipher_cbc_mac_t *ctx, const uint8_t *data,
+                          size_t len)
+{
+    uint8_t block_size = cipher_get_block_size(ctx->cipher);
 
+    for (size_t i = 0; i < len; i++) {
         /* CBC-Mode: XOR plaintext with ciphertext of (n-1)-th block */
-        for (int i = 0; i < block_size_input; ++i) {
-            mac[i] ^= input[offset + i];
+        ctx->mac[ctx->offset++] ^= data[i];
+        if (ctx->offset == block_size) {
+            if (cipher_encrypt(ctx->cipher, ctx->mac, ctx->mac) != 1) {
+                return CIPHER_ERR_ENC_FAILED;
+            }
+            ctx->offset = 0;
         }
+    }
+
+    return 0;
+}
 
-        if (cipher_encrypt(cipher, mac, mac_enc) != 1) {
+/* pads an incomplete block with zeros */
+static int _cbc_mac_pad(cipher_cbc_mac_t *ctx)
+{
+    if (ctx->offset > 0) {
+        if (cipher_encrypt(ctx->cipher, ctx->mac, ctx->mac) != 1) {
             return CIPHER_ERR_ENC_FAILED;
         }
+        ctx->offset = 0;
+    }
+    return 0;
+}
 
-        memcpy(mac, mac_enc, block_size);
-        offset += block_size_input;
-    } while (offset < length);
+int cipher_cbc_mac_final(cipher_cbc_mac_t *ctx, uint8_t *mac)
+{
+    int res = _cbc_mac_pad(ctx);
 
-    return offset;
+    if (res < 0) {
+        return res;
+    }
+    memcpy(mac, ctx->mac, cipher_get_block_size(ctx->cipher));
+    return 0;
 }
 
-
-int ccm_create_mac_iv(cipher_t* cipher, uint8_t auth_data_len, uint8_t M,
-                      uint8_t L, uint8_t* nonce, uint8_t nonce_len,
-                      size_t plaintext_len, uint8_t X1[16])
+int cipher_ccm_init(cipher_ccm_t *ctx, const cipher_t *cipher,
+                    uint8_t mac_length, uint8_t length_encoding,
+                    const uint8_t *nonce, size_t nonce_len,
+                    uint32_t auth_data_len, size_t input_len)
 {
-    uint8_t M_, L_;
+    uint8_t block[CCM_BLOCK_SIZE] = {0}, len_encoded[6], len_encoding;
+    size_t len = input_len;
+    int res;
 
-    /* ensure everything is set to zero */
-    memset(X1, 0, 16);
+    if (mac_length % 2 != 0  || mac_length < 4 || mac_length > 16) {
+        return CCM_ERR_INVALID_MAC_LENGTH;
+    }
+
+    if (length_encoding < 2 || length_encoding > 8 ||
+        cipher_get_block_size(cipher) != CCM_BLOCK_SIZE) {
+        return CCM_ERR_INVALID_LENGTH_ENCODING;
+    }
 
-    /* set flags in B[0] - bit format:
+    /* Create B0 - bit format of the flags in B0[0]:
             7        6     5..3  2..0
         Reserved   Adata    M_    L_    */
-    M_ = (M - 2) / 2;
-    L_ = L - 1;
-    X1[0] = 64 * (auth_data_len > 0) + 8 * M_ + L_;
+    block[0] = 64 * (auth_data_len > 0) + 8 * ((mac_length - 2) / 2) +
+               (length_encoding - 1);
 
     /* copy nonce to B[1..15-L] */
-    memcpy(&X1[1], nonce, min(nonce_len, 15 - L));
+    memcpy(&block[1], nonce, min(nonce_len, 15 - length_encoding));
+
+    /* write input_len to B[16-L..15] */
+    for (uint8_t i = 15; i > 15 - length_encoding; --i) {
+        block[i] = len & 0xff;
+        len >>= 8;
+    }
 
-    /* write plaintext_len to B[15..16-L] */
-    for (uint8_t i = 15; i > 16 - L; --i) {
-        X1[i] = plaintext_len & 0xff;
-        plaintext_len >>= 8;
+    /* if there is still data, input_len was too big */
+    if (len > 0) {
+        return CCM_ERR_INVALID_DATA_LENGTH;
     }
 
-    /* if there is still data, plaintext_len was too big */
-    if (plaintext_len > 0) {
-        return CIPHER_ERR_INVALID_LENGTH;
+    /* the MAC starts with the encrypted B0 */
+    memset(ctx->cbc_mac.mac, 0, sizeof(ctx->cbc_mac.mac));
+    ctx->cbc_mac.cipher = cipher;
+    ctx->cbc_mac.offset = 0;
+    res = cipher_cbc_mac_update(&ctx->cbc_mac, block, CCM_BLOCK_SIZE);
+    if (res < 0) {
+        return res;
     }
 
-    if (cipher_encrypt(cipher, X1, X1) != 1) {
+    /* prefix the additional data with its length */
+    if (auth_data_len > 0) {
+        if (auth_data_len < 0xff00) {
+            len_encoded[0] = (auth_data_len >> 8) & 0xff;
+            len_encoded[1] = auth_data_len & 0xff;
+            len_encoding = 2;
+        }
+        else {
+            len_encoded[0] = 0xff;
+            len_encoded[1] = 0xfe;
+            len_encoded[2] = (auth_data_len >> 24) & 0xff;
+            len_encoded[3] = (auth_data_len >> 16) & 0xff;
+            len_encoded[4] = (auth_data_len >> 8) & 0xff;
+            len_encoded[5] = auth_data_len & 0xff;
+            len_encoding = 6;
+        }
+        res = cipher_cbc_mac_update(&ctx->cbc_mac, len_encoded, len_encoding);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    /* A0 = flags | nonce | counter 0, its key stream encrypts the MAC */
+    memset(block, 0, sizeof(block));
+    block[0] = length_encoding - 1;
+    memcpy(&block[1], nonce, min(nonce_len, 15 - length_encoding));
+    if (cipher_encrypt(cipher, block, ctx->tag_stream) != 1) {
         return CIPHER_ERR_ENC_FAILED;
     }
+
+    /* the payload is encrypted starting with A1 */
+    crypto_block_inc_ctr(block, length_encoding);
+    cipher_ctr_init(&ctx->ctr, cipher, block, CCM_BLOCK_SIZE - length_encoding);
+
+    ctx->auth_data_len = auth_data_len;
+    ctx->input_len = input_len;
+    ctx->mac_length = mac_length;
+
     return 0;
 }
 
-int ccm_compute_adata_mac(cipher_t* cipher, uint8_t* auth_data,
-                          uint32_t auth_data_len, uint8_t X1[16])
+int cipher_ccm_update_auth_data(cipher_ccm_t *ctx, const uint8_t *auth_data,
+                                size_t len)
 {
-    if (auth_data_len > 0) {
-        int len;
-
-        /* 16 octet block size + max. 10 len encoding  */
-        uint8_t auth_data_encoded[26], len_encoding = 0;
-
-        if ( auth_data_len < (((uint32_t) 2) << 16)) {       /* length (0x0001 ... 0xFEFF)  */
-            len_encoding = 2;
+    int res;
 
-            auth_data_encoded[1] = auth_data_len & 0xFF;
-            auth_data_encoded[0] = (auth_data_len >> 8) & 0xFF;
-        } else {
-            DEBUG("UNSUPPORTED Adata length\n");
-            return -1;
-        }
+    if (len > ctx->auth_data_len) {
+        return CCM_ERR_INVALID_DATA_LENGTH;
+    }
 
-        memcpy(auth_data_encoded + len_encoding, auth_data, auth_data_len);
-        len = ccm_compute_cbc_mac(cipher, X1, auth_data_encoded, auth_data_len + len_encoding, X1);
-        if (len < 0) {
-            return -1;
-        }
+    res = cipher_cbc_mac_update(&ctx->cbc_mac, auth_data, len);
+    if (res < 0) {
+        return res;
     }
 
+    ctx->auth_data_len -= len;
+    if (ctx->auth_data_len == 0) {
+        /* the payload starts at a block boundary */
+        return _cbc_mac_pad(&ctx->cbc_mac);
+    }
     return 0;
 }
 
+static int _check_payload_len(cipher_ccm_t *ctx, size_t len)
+{
+    if ((ctx->auth_data_len > 0) || (len > ctx->input_len)) {
+        return CCM_ERR_INVALID_DATA_LENGTH;
+    }
+    ctx->input_len -= len;
+    return 0;
+}
 
-int cipher_encrypt_ccm(cipher_t* cipher, uint8_t* auth_data, uint32_t auth_data_len,
-                       uint8_t mac_length, uint8_t length_encoding,
-                       uint8_t* nonce, size_t nonce_len,
-                       uint8_t* input, size_t input_len,
-                       uint8_t* output)
+int cipher_ccm_encrypt_update(cipher_ccm_t *ctx, const uint8_t *input,
+                              size_t len, uint8_t *output)
 {
-    int len = -1;
-    uint32_t length_max;
-    uint8_t nonce_counter[16] = {0}, mac_iv[16] = {0}, mac[16] = {0},
-                                stream_block[16] = {0}, zero_block[16] = {0}, block_size;
+    int res = _check_payload_len(ctx, len);
 
-    if (mac_length % 2 != 0  || mac_length < 4 || mac_length > 16) {
-        return CCM_ERR_INVALID_MAC_LENGTH;
+    if (res < 0) {
+        return res;
     }
 
-    length_max = 2 << (8 * length_encoding);
-    if (length_encoding < 2 || length_encoding > 8 ||
-            input_len - auth_data_len > length_max) {
-        return CCM_ERR_INVALID_LENGTH_ENCODING;
+    /* MAC the plaintext before it is overwritten */
+    res = cipher_cbc_mac_update(&ctx->cbc_mac, input, len);
+    if (res < 0) {
+        return res;
     }
 
-    /* Create B0, encrypt it (X1) and use it as mac_iv */
-    block_size = cipher_get_block_size(cipher);
-    if (ccm_create_mac_iv(cipher, auth_data_len, mac_length, length_encoding,
-                          nonce, nonce_len, input_len, mac_iv) < 0) {
-        return CCM_ERR_INVALID_DATA_LENGTH;
+    return cipher_ctr_update(&ctx->ctr, input, len, output);
+}
+
+int cipher_ccm_decrypt_update(cipher_ccm_t *ctx, const uint8_t *input,
+                              size_t len, uint8_t *output)
+{
+    int res = _check_payload_len(ctx, len);
+
+    if (res < 0) {
+        return res;
     }
 
-    /* MAC calulation (T) with additional data and plaintext */
-    ccm_compute_adata_mac(cipher, auth_data, auth_data_len, mac_iv);
-    len = ccm_compute_cbc_mac(cipher, mac_iv, input, input_len, mac);
-    if (len < 0) {
-        return len;
+    res = cipher_ctr_update(&ctx->ctr, input, len, output);
+    if (res < 0) {
+        return res;
     }
 
-    /* Compute first stream block */
-    nonce_counter[0] = length_encoding - 1;
-    memcpy(&nonce_counter[1], nonce,
-           min(nonce_len, (size_t) 15 - length_encoding));
-    len = cipher_encrypt_ctr(cipher, nonce_counter, block_size,
-                             zero_block, block_size, stream_block);
-    if (len < 0) {
-        return len;
+    res = cipher_cbc_mac_update(&ctx->cbc_mac, output, len);
+    if (res < 0) {
+        return res;
     }
 
-    /* Encrypt message in counter mode  */
-    crypto_block_inc_ctr(nonce_counter, block_size - nonce_len);
-    len = cipher_encrypt_ctr(cipher, nonce_counter, nonce_len, input,
-                             input_len, output);
-    if (len < 0) {
-        return len;
+    return len;
+}
+
+static int _compute_mac(cipher_ccm_t *ctx, uint8_t *mac)
+{
+    int res;
+
+    if ((ctx->auth_data_len > 0) || (ctx->input_len > 0)) {
+        return CCM_ERR_INVALID_DATA_LENGTH;
+    }
+
+    res = _cbc_mac_pad(&ctx->cbc_mac);
+    if (res < 0) {
+        return res;
     }
 
     /* auth value: mac ^ first stream block */
-    for (uint8_t i = 0; i < mac_length; ++i) {
-        output[len + i] = mac[i] ^ stream_block[i];
+    for (uint8_t i = 0; i < ctx->mac_length; ++i) {
+        mac[i] = ctx->cbc_mac.mac[i] ^ ctx->tag_stream[i];
     }
 
-    return len + mac_length;
+    return ctx->mac_length;
 }
 
+int cipher_ccm_encrypt_final(cipher_ccm_t *ctx, uint8_t *mac)
+{
+    return _compute_mac(ctx, mac);
+}
 
-int cipher_decrypt_ccm(cipher_t* cipher, uint8_t* auth_data,
-                       uint32_t auth_data_len, uint8_t mac_length,
-                       uint8_t length_encoding, uint8_t* nonce, size_t nonce_len,
-                       uint8_t* input, size_t input_len, uint8_t* plain)
+int cipher_ccm_decrypt_final(cipher_ccm_t *ctx, const uint8_t *mac)
 {
-    int len = -1;
-    uint32_t length_max;
-    uint8_t nonce_counter[16] = {0}, mac_iv[16] = {0}, mac[16] = {0},
-                                mac_recv[16] = {0}, stream_block[16] = {0}, zero_block[16] = {0},
-                                        plain_len, block_size;
+    uint8_t mac_computed[CCM_BLOCK_SIZE], mac_recv[CCM_BLOCK_SIZE];
+    int res = _compute_mac(ctx, mac_computed);
 
-    if (mac_length % 2 != 0  || mac_length < 4 || mac_length > 16) {
-        return CCM_ERR_INVALID_MAC_LENGTH;
+    if (res < 0) {
+        return res;
     }
 
-    length_max = 2 << (8 * length_encoding);
-    if (length_encoding < 2 || length_encoding > 8 ||
-            input_len - auth_data_len > length_max) {
-        return CCM_ERR_INVALID_LENGTH_ENCODING;
+    memcpy(mac_recv, mac, ctx->mac_length);
+    if (!crypto_equals(mac_recv, mac_computed, ctx->mac_length)) {
+        return CCM_ERR_INVALID_CBC_MAC;
+    }
+
+    return 0;
+}
+
+int cipher_encrypt_ccm(cipher_t* cipher, uint8_t* auth_data, uint32_t auth_data_len,
+                       uint8_t mac_length, uint8_t length_encoding,
+                       uint8_t* nonce, size_t nonce_len,
+                       uint8_t* input, size_t input_len,
+                       uint8_t* output)
+{
+    cipher_ccm_t ctx;
+    int res;
+
+    res = cipher_ccm_init(&ctx, cipher, mac_length, length_encoding, nonce,
+                          nonce_len, auth_data_len, input_len);
+    if (res < 0) {
+        return res;
     }
 
-    /* Compute first stream block */
-    nonce_counter[0] = length_encoding - 1;
-    block_size = cipher_get_block_size(cipher);
-    memcpy(&nonce_counter[1], nonce, min(nonce_len, (size_t) 15 - length_encoding));
-    len = cipher_encrypt_ctr(cipher, nonce_counter, block_size, zero_block,
-                             block_size, stream_block);
-    if (len < 0) {
-        return len;
+    res = cipher_ccm_update_auth_data(&ctx, auth_data, auth_data_len);
+    if (res < 0) {
+        return res;
     }
 
-    /* Decrypt message in counter mode */
-    plain_len = input_len - mac_length;
-    crypto_block_inc_ctr(nonce_counter, block_size - nonce_len);
-    len = cipher_encrypt_ctr(cipher, nonce_counter, nonce_len, input,
-                             plain_len, plain);
-    if (len < 0) {
-        return len;
+    res = cipher_ccm_encrypt_update(&ctx, input, input_len, output);
+    if (res < 0) {
+        return res;
+    }
+
+    res = cipher_ccm_encrypt_final(&ctx, output + input_len);
+    if (res < 0) {
+        return res;
     }
 
-    /* Create B0, encrypt it (X1) and use it as mac_iv */
-    if (ccm_create_mac_iv(cipher, auth_data_len, mac_length, length_encoding,
-                          nonce, nonce_len, plain_len, mac_iv) < 0) {
+    return input_len + mac_length;
+}
+
+
+int cipher_decrypt_ccm(cipher_t* cipher, uint8_t* auth_data,
+                       uint32_t auth_data_len, uint8_t mac_length,
+                       uint8_t length_encoding, uint8_t* nonce, size_t nonce_len,
+                       uint8_t* input, size_t input_len, uint8_t* plain)
+{
+    cipher_ccm_t ctx;
+    size_t plain_len;
+    int res;
+
+    if (input_len < mac_length) {
         return CCM_ERR_INVALID_DATA_LENGTH;
     }
+    plain_len = input_len - mac_length;
+
+    res = cipher_ccm_init(&ctx, cipher, mac_length, length_encoding, nonce,
+                          nonce_len, auth_data_len, plain_len);
+    if (res < 0) {
+        return res;
+    }
 
-    /* MAC calulation (T) with additional data and plaintext */
-    ccm_compute_adata_mac(cipher, auth_data, auth_data_len, mac_iv);
-    len = ccm_compute_cbc_mac(cipher, mac_iv, plain, plain_len, mac);
-    if (len < 0) {
-        return len;
+    res = cipher_ccm_update_auth_data(&ctx, auth_data, auth_data_len);
+    if (res < 0) {
+        return res;
     }
 
-    /* mac = input[plain_len...plain_len+mac_length] ^ first stream block */
-    for (uint8_t i = 0; i < mac_length; ++i) {
-        mac_recv[i] = input[len + i] ^ stream_block[i];
+    res = cipher_ccm_decrypt_update(&ctx, input, plain_len, plain);
+    if (res < 0) {
+        return res;
     }
 
-    if (!crypto_equals(mac_recv, mac, mac_length)) {
-        return CCM_ERR_INVALID_CBC_MAC;
+    res = cipher_ccm_decrypt_final(&ctx, input + plain_len);
+    if (res < 0) {
+        return res;
     }
 
     return plain_len;
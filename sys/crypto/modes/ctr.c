@@ -18,37 +18,61 @@
 * @}
 */
 
+#include <string.h>
+
 #include "crypto/helper.h"
 #include "crypto/modes/ctr.h"
 
-int cipher_encrypt_ctr(cipher_t* cipher, uint8_t nonce_counter[16],
-                       uint8_t nonce_len, uint8_t* input, size_t length,
-                       uint8_t* output)
+/**
+ * @brief   Number of key stream blocks generated per cipher call
+ */
+#ifndef CTR_BATCH_BLOCKS
+#define CTR_BATCH_BLOCKS    (4)
+#endif
+
+static int _ctr(const cipher_t* cipher, uint8_t nonce_counter[16],
+                uint8_t nonce_len, const uint8_t* input, size_t length,
+                uint8_t* output)
 {
     size_t offset = 0;
-    uint8_t stream_block[16] = {0}, block_size;
+    uint8_t stream[CTR_BATCH_BLOCKS * CIPHER_MAX_BLOCK_SIZE], block_size;
 
     block_size = cipher_get_block_size(cipher);
-    do {
-        uint8_t block_size_input;
+    while (offset < length) {
+        size_t stream_len = 0, stream_len_input;
 
-        if (cipher_encrypt(cipher, nonce_counter, stream_block) != 1) {
+        /* generate the key stream for several blocks at once */
+        do {
+            memcpy(stream + stream_len, nonce_counter, block_size);
+            crypto_block_inc_ctr(nonce_counter, block_size - nonce_len);
+            stream_len += block_size;
+        } while ((stream_len < sizeof(stream)) &&
+                 (stream_len < length - offset));
+
+        if (cipher_encrypt_blocks(cipher, stream, stream,
+                                  stream_len / block_size) != 1) {
             return CIPHER_ERR_ENC_FAILED;
         }
 
-        block_size_input = (length - offset > block_size) ?
-                           block_size : length - offset;
-        for (uint8_t i = 0; i < block_size_input; ++i) {
-            output[offset + i] = stream_block[i] ^ input[offset + i];
+        stream_len_input = (length - offset > stream_len) ?
+                           stream_len : length - offset;
+        for (size_t i = 0; i < stream_len_input; ++i) {
+            output[offset + i] = stream[i] ^ input[offset + i];
         }
 
-        offset += block_size_input;
-        crypto_block_inc_ctr(nonce_counter, block_size - nonce_len);
-    } while (offset < length);
+        offset += stream_len_input;
+    }
 
     return offset;
 }
 
+int cipher_encrypt_ctr(cipher_t* cipher, uint8_t nonce_counter[16],
+                       uint8_t nonce_len, uint8_t* input, size_t length,
+                       uint8_t* output)
+{
+    return _ctr(cipher, nonce_counter, nonce_len, input, length, output);
+}
+
 int cipher_decrypt_ctr(cipher_t* cipher, uint8_t nonce_counter[16],
                        uint8_t nonce_len, uint8_t* input, size_t length,
                        uint8_t* output)
@@ -56,3 +80,51 @@ int cipher_decrypt_ctr(cipher_t* cipher, uint8_t nonce_counter[16],
     return cipher_encrypt_ctr(cipher, nonce_counter, nonce_len, input,
                               length, output);
 }
+
+void cipher_ctr_init(cipher_ctr_t *ctx, const cipher_t *cipher,
+                     const uint8_t nonce_counter[16], uint8_t nonce_len)
+{
+    ctx->cipher = cipher;
+    memcpy(ctx->nonce_counter, nonce_counter, sizeof(ctx->nonce_counter));
+    ctx->nonce_len = nonce_len;
+    /* no key stream left */
+    ctx->stream_offset = sizeof(ctx->stream);
+}
+
+int cipher_ctr_update(cipher_ctr_t *ctx, const uint8_t *input, size_t length,
+                      uint8_t *output)
+{
+    uint8_t block_size = cipher_get_block_size(ctx->cipher);
+    size_t offset = 0, blocks_len;
+    int res;
+
+    /* use up the key stream left over from the previous chunk */
+    while ((offset < length) && (ctx->stream_offset < block_size)) {
+        output[offset] = input[offset] ^ ctx->stream[ctx->stream_offset++];
+        offset++;
+    }
+
+    blocks_len = (length - offset) - ((length - offset) % block_size);
+    res = _ctr(ctx->cipher, ctx->nonce_counter, ctx->nonce_len,
+               input + offset, blocks_len, output + offset);
+    if (res < 0) {
+        return res;
+    }
+    offset += blocks_len;
+
+    /* keep the key stream of a trailing partial block */
+    if (offset < length) {
+        if (cipher_encrypt(ctx->cipher, ctx->nonce_counter,
+                           ctx->stream) != 1) {
+            return CIPHER_ERR_ENC_FAILED;
+        }
+        crypto_block_inc_ctr(ctx->nonce_counter, block_size - ctx->nonce_len);
+        ctx->stream_offset = 0;
+        while (offset < length) {
+            output[offset] = input[offset] ^ ctx->stream[ctx->stream_offset++];
+            offset++;
+        }
+    }
+
+    return length;
+}
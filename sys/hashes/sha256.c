@@ -50,6 +50,11 @@
 
 #include "hashes/sha256.h"
 
+#if defined(__SHA__) && defined(__SSE4_1__)
+#include <immintrin.h>
+#define SHA256_USE_SHA_NI
+#endif
+
 #ifdef __BIG_ENDIAN__
 /* Copy a vector of big-endian uint32_t into a vector of bytes */
 #define be32enc_vect memcpy
@@ -122,6 +127,54 @@ static const uint32_t K[64] = {
     0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
 };
 
+#ifdef SHA256_USE_SHA_NI
+/*
+ * SHA256 block compression function using the x86 SHA extensions, enabled
+ * when building with -msha -msse4.1.
+ */
+static void sha256_transform(uint32_t *state, const unsigned char block[64])
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+                                        0x0405060700010203ULL);
+    __m128i state0, state1, abef, cdgh, tmp, msg[4];
+
+    /* the instructions expect the state as ABEF and CDGH */
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xb1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1b);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+    abef = state0;
+    cdgh = state1;
+
+    for (int i = 0; i < 4; i++) {
+        msg[i] = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)&block[16 * i]), mask);
+    }
+
+    /* four rounds per iteration, the message schedule is computed on the fly */
+    for (int i = 0; i < 16; i++) {
+        tmp = _mm_add_epi32(msg[i % 4],
+                            _mm_loadu_si128((const __m128i *)&K[4 * i]));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, tmp);
+        state0 = _mm_sha256rnds2_epu32(state0, state1,
+                                       _mm_shuffle_epi32(tmp, 0x0e));
+        if (i < 12) {
+            tmp = _mm_alignr_epi8(msg[(i + 3) % 4], msg[(i + 2) % 4], 4);
+            tmp = _mm_add_epi32(_mm_sha256msg1_epu32(msg[i % 4],
+                                                     msg[(i + 1) % 4]), tmp);
+            msg[i % 4] = _mm_sha256msg2_epu32(tmp, msg[(i + 3) % 4]);
+        }
+    }
+
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, state1, 0xf0));
+    _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+#else
 /*
  * SHA256 block compression function.  The 256-bit state is transformed via
  * the 512-bit input block to produce a new state.
@@ -159,6 +212,7 @@ static void sha256_transform(uint32_t *state, const unsigned char block[64])
         state[i] += S[i];
     }
 }
+#endif /* SHA256_USE_SHA_NI */
 
 static unsigned char PAD[64] = {
     0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -187,21 +241,19 @@ static void sha256_pad(sha256_context_t *ctx)
     sha256_update(ctx, len, 8);
 }
 
+/* Magic initialization constants */
+static const uint32_t IV[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
 /* SHA-256 initialization.  Begins a SHA-256 operation. */
 void sha256_init(sha256_context_t *ctx)
 {
     /* Zero bits processed so far */
     ctx->count[0] = ctx->count[1] = 0;
 
-    /* Magic initialization constants */
-    ctx->state[0] = 0x6A09E667;
-    ctx->state[1] = 0xBB67AE85;
-    ctx->state[2] = 0x3C6EF372;
-    ctx->state[3] = 0xA54FF53A;
-    ctx->state[4] = 0x510E527F;
-    ctx->state[5] = 0x9B05688C;
-    ctx->state[6] = 0x1F83D9AB;
-    ctx->state[7] = 0x5BE0CD19;
+    memcpy(ctx->state, IV, sizeof(ctx->state));
 }
 
 /* Add bytes into the hash */
@@ -279,7 +331,8 @@ void *sha256(const void *data, size_t len, void *digest)
 }
 
 
-void hmac_sha256_init(hmac_context_t *ctx, const void *key, size_t key_length)
+void hmac_sha256_key_init(hmac_sha256_key_t *hkey, const void *key,
+                          size_t key_length)
 {
     unsigned char k[SHA256_INTERNAL_BLOCK_SIZE];
 
@@ -305,20 +358,41 @@ void hmac_sha256_init(hmac_context_t *ctx, const void *key, size_t key_length)
         i_key_pad[i] = 0x36 ^ k[i];
     }
 
+    /*
+     * Each key pad fills exactly one block, so the states after hashing
+     * them are all that needs to be kept.
+     */
+    memcpy(hkey->state_in, IV, sizeof(hkey->state_in));
+    sha256_transform(hkey->state_in, i_key_pad);
+    memcpy(hkey->state_out, IV, sizeof(hkey->state_out));
+    sha256_transform(hkey->state_out, o_key_pad);
+}
+
+void hmac_sha256_init_key(hmac_context_t *ctx, const hmac_sha256_key_t *hkey)
+{
     /*
      * Initiate calculation of the inner hash
      * tmp = hash(i_key_pad CONCAT message)
      */
-    sha256_init(&ctx->c_in);
-    sha256_update(&ctx->c_in, i_key_pad, SHA256_INTERNAL_BLOCK_SIZE);
+    memcpy(ctx->c_in.state, hkey->state_in, sizeof(ctx->c_in.state));
+    ctx->c_in.count[0] = 0;
+    ctx->c_in.count[1] = SHA256_INTERNAL_BLOCK_SIZE * 8;
 
     /*
      * Initiate calculation of the outer hash
      * result = hash(o_key_pad CONCAT tmp)
      */
-    sha256_init(&ctx->c_out);
-    sha256_update(&ctx->c_out, o_key_pad, SHA256_INTERNAL_BLOCK_SIZE);
+    memcpy(ctx->c_out.state, hkey->state_out, sizeof(ctx->c_out.state));
+    ctx->c_out.count[0] = 0;
+    ctx->c_out.count[1] = SHA256_INTERNAL_BLOCK_SIZE * 8;
+}
+
+void hmac_sha256_init(hmac_context_t *ctx, const void *key, size_t key_length)
+{
+    hmac_sha256_key_t hkey;
 
+    hmac_sha256_key_init(&hkey, key, key_length);
+    hmac_sha256_init_key(ctx, &hkey);
 }
 
 void hmac_sha256_update(hmac_context_t *ctx, const void *data, size_t len)
@@ -362,11 +436,16 @@ const void *hmac_sha256(const void *key, size_t key_length,
  */
 static inline void sha256_inplace(unsigned char element[SHA256_DIGEST_LENGTH])
 {
-    sha256_context_t ctx;
-
-    sha256_init(&ctx);
-    sha256_update(&ctx, element, SHA256_DIGEST_LENGTH);
-    sha256_final(&ctx, element);
+    uint32_t state[8];
+    /* the padded element fits into a single block: 256 bits message length */
+    unsigned char block[SHA256_INTERNAL_BLOCK_SIZE] = {
+        [SHA256_DIGEST_LENGTH] = 0x80, [62] = 0x01,
+    };
+
+    memcpy(block, element, SHA256_DIGEST_LENGTH);
+    memcpy(state, IV, sizeof(state));
+    sha256_transform(state, block);
+    be32enc_vect(element, state, SHA256_DIGEST_LENGTH);
 }
 
 void *sha256_chain(const void *seed, size_t seed_length,
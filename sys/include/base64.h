@@ -13,6 +13,11 @@
  * @brief       base64 encoder and decoder
  * @{
  *
+ * Besides the standard alphabet of RFC 4648, section 4, the URL and filename
+ * safe alphabet of section 5 is supported through base64url_encode() and
+ * base64url_decode(). Both decoders accept symbols of both alphabets and skip
+ * padding and any other symbols, e.g. line breaks.
+ *
  * @brief       encoding and decoding functions for base64
  * @author      Martin Landsmann <Martin.Landsmann@HAW-Hamburg.de>
  */
@@ -70,10 +75,34 @@ int base64_encode(unsigned char *data_in, size_t data_in_size, \
                                     but the size for `data_out_size` is sufficient,
             BASE64_ERROR_DATA_IN if `base64_in` equals NULL,
             BASE64_ERROR_DATA_IN_SIZE if `base64_in_size` is less then 4.
+
+ * @note    `base64_in` and `data_out` may point to the same buffer to decode
+            in place.
  */
 int base64_decode(unsigned char *base64_in, size_t base64_in_size, \
                   unsigned char *data_out, size_t *data_out_size);
 
+/**
+ * @brief           Encodes a given datum to base64 with the URL and filename safe
+ *                  alphabet, without padding.
+ *
+ * The required size of `base64_out` is `(4 * data_in_size + 2) / 3`.
+ * Parameters and return values are the same as for base64_encode().
+ */
+int base64url_encode(unsigned char *data_in, size_t data_in_size, \
+                     unsigned char *base64_out, size_t *base64_out_size);
+
+/**
+ * @brief           Decodes a given base64 string with or without padding.
+ *
+ * The required size of `data_out` is `(3 * base64_in_size) / 4`.
+ * Parameters and return values are the same as for base64_decode(), except
+ * that BASE64_ERROR_DATA_IN_SIZE is returned if `base64_in_size` is less
+ * then 2.
+ */
+int base64url_decode(unsigned char *base64_in, size_t base64_in_size, \
+                     unsigned char *data_out, size_t *data_out_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -111,6 +111,8 @@ enum can_msg {
 #if defined(MODULE_CAN_ISOTP) || defined(DOXYGEN)
     CAN_MSG_ISOTP_RX_TIMEOUT = 0x400,  /**< isotp rx timeout */
     CAN_MSG_ISOTP_TX_TIMEOUT,          /**< isotp tx timeout */
+    CAN_MSG_ISOTP_RX_DATA,             /**< isotp stream data available */
+    CAN_MSG_ISOTP_RX_RESUME,           /**< isotp resume stream after error */
 #endif
 };
 
@@ -166,6 +166,40 @@ int conn_can_isotp_close(conn_can_isotp_t *conn);
  */
 int conn_can_isotp_recv(conn_can_isotp_t *conn, void *buf, size_t size, uint32_t timeout);
 
+/**
+ * @brief  Stream received isotp data into a ring buffer
+ *
+ * Received messages are not reassembled but appended frame by frame to
+ * @p ring, each preceded by its length as 16 bit big endian value (see
+ * isotp_set_rx_ring()). Use conn_can_isotp_recv_stream() instead of
+ * conn_can_isotp_recv() to read them.
+ *
+ * @param[in] conn          ISO-TP connection, created but not bound
+ * @param[in] ring          ring to stream into
+ *
+ * @return 0 on success
+ * @return -EALREADY if @p conn is already bound
+ */
+int conn_can_isotp_set_rx_ring(conn_can_isotp_t *conn, tsrb_t *ring);
+
+/**
+ * @brief  Read streamed isotp data
+ *
+ * Waits until data is available in the rx ring of @p conn and reads up to
+ * @p size bytes of it.
+ *
+ * @param[in] conn          ISO-TP connection with an rx ring
+ * @param[out] buf          buf to fill in with received data
+ * @param[in] size          size of the buffer in bytes
+ * @param[in] timeout       timeout in us, 0 for infinite
+ *
+ * @return the number of bytes read
+ * @return -EIO if the last message in the ring was truncated, all data of
+ *         it was read before
+ * @return any other negative number in case of an error
+ */
+int conn_can_isotp_recv_stream(conn_can_isotp_t *conn, void *buf, size_t size, uint32_t timeout);
+
 /**
  * @brief  Generic can send
  *
@@ -29,6 +29,7 @@ extern "C" {
 #include "can/common.h"
 #include "thread.h"
 #include "xtimer.h"
+#include "tsrb.h"
 #include "net/gnrc/pktbuf.h"
 
 
@@ -71,6 +72,7 @@ struct isotp_options {
  */
 struct tpcon {
     unsigned idx;         /**< current index in @p buf */
+    unsigned len;         /**< length of the current message */
     uint8_t state;        /**< the protocol state */
     uint8_t bs;           /**< block size */
     uint8_t sn;           /**< current sequence number */
@@ -96,6 +98,8 @@ struct isotp {
     uint32_t tx_gap;               /**< transmit gap from fc (in us) */
     uint8_t tx_wft;                /**< transmit wait counter */
     void *arg;                     /**< upper layer private arg */
+    tsrb_t *rx_ring;               /**< ring for streaming reception, NULL to
+                                        reassemble whole messages */
 };
 
 /**
@@ -178,6 +182,46 @@ int isotp_bind(struct isotp *isotp, can_reg_entry_t *entry, void *arg);
  */
 int isotp_release(struct isotp *isotp);
 
+/**
+ * @brief Stream received messages into a ring buffer
+ *
+ * Instead of reassembling each message in the packet buffer, the payload of
+ * every frame is appended to @p ring as soon as it was received. Each message
+ * is preceded by its length as 16 bit big endian value.
+ *
+ * The flow control frames are derived from the free space of @p ring: the
+ * block size covers as many consecutive frames as fit and STmin is 0, so
+ * the sender transmits at full speed but never overruns the ring. The
+ * configured block size and STmin are ignored.
+ *
+ * The upper layer receives a CAN_MSG_ISOTP_RX_DATA message with the channel's
+ * upper layer parameter when the ring held no other data once the new data
+ * was added, so a reader that found the ring empty is always woken up. Other
+ * notifications may be spurious, the data having been read already. If a message
+ * could not be completed, CAN_MSG_RX_ERROR is sent instead. Further messages
+ * are dropped until isotp_rx_resume() was called.
+ *
+ * Must be called before isotp_bind().
+ *
+ * @param isotp           the channel
+ * @param ring            the ring to stream into, NULL to receive whole
+ *                        messages
+ */
+static inline void isotp_set_rx_ring(struct isotp *isotp, tsrb_t *ring)
+{
+    isotp->rx_ring = ring;
+}
+
+/**
+ * @brief Resume streaming reception after CAN_MSG_RX_ERROR
+ *
+ * The upper layer has to read the remaining data of the truncated message
+ * from the ring first.
+ *
+ * @param isotp           the channel
+ */
+void isotp_rx_resume(struct isotp *isotp);
+
 /**
  * @brief Free a received buffer
  *
@@ -29,6 +29,24 @@ extern "C" {
 #include "can/can.h"
 #include "can/pkt.h"
 
+/**
+ * @brief   Number of hash buckets for the filters of an interface, must be a
+ *          power of two
+ */
+#ifndef CAN_ROUTER_HASH_SIZE
+#define CAN_ROUTER_HASH_SIZE    (16)
+#endif
+
+/**
+ * @brief   Number of distinct filter masks per interface that are looked up
+ *          through the hash table
+ *
+ * Filters with further masks are compared one by one for every received frame.
+ */
+#ifndef CAN_ROUTER_MASK_GROUPS
+#define CAN_ROUTER_MASK_GROUPS  (4)
+#endif
+
 /**
  * @brief Register a user @p entry to receive a frame @p can_id
  *
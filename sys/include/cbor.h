@@ -98,6 +98,42 @@
  *
  * @see [RFC7049, section 2.4](https://tools.ietf.org/html/rfc7049#section-2.3)
  *
+ * # Streaming API
+ *
+ * The functions above work on a @ref cbor_stream_t that has to hold the whole
+ * encoding, and the decoder has to know the offset of every item. For larger
+ * or unknown data, there is a second API:
+ *
+ * - @ref cbor_reader_t is a pull parser. cbor_reader_next() reads the next
+ *   data item of any type and moves on, so every byte is only looked at once.
+ *   Strings are not copied, @ref cbor_item_t points to them within the input.
+ *   Truncated input is detected, so data arriving in pieces can be parsed as
+ *   far as it goes.
+ * - @ref cbor_writer_t encodes into a small buffer and hands it to a
+ *   callback whenever it is full, so the size of the encoding is not bounded
+ *   by the buffer. Strings that don't fit into the buffer are handed to the
+ *   callback directly.
+ *
+ * Reading a SenML pack of unknown length looks like this:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~ {.c}
+ * cbor_reader_t reader;
+ * cbor_item_t item;
+ *
+ * cbor_reader_init(&reader, buf, len);
+ * cbor_reader_next(&reader, &item);    // the array of records
+ * while ((cbor_reader_next(&reader, &item) == 0) &&
+ *        (item.type == CBOR_ITEM_MAP)) {
+ *     for (uint64_t i = 0; i < item.val.u; i++) {
+ *         cbor_item_t label, value;
+ *         cbor_reader_next(&reader, &label);
+ *         cbor_reader_next(&reader, &value);
+ *         // (...)
+ *         cbor_reader_skip(&reader, &value);  // ignore nested items
+ *     }
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
  * @todo API for Indefinite-Length Byte Strings and Text Strings
  *       (see https://tools.ietf.org/html/rfc7049#section-2.2.2)
  * @{
@@ -119,6 +155,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <sys/types.h>
 
 #ifdef MODULE_CBOR_CTIME
 #include <time.h>
@@ -700,6 +737,311 @@ bool cbor_at_break(const cbor_stream_t *stream, size_t offset);
  */
 bool cbor_at_end(const cbor_stream_t *stream, size_t offset);
 
+/**
+ * @brief Length of indefinite arrays and maps for cbor_writer_array() and
+ *        cbor_writer_map()
+ */
+#define CBOR_INDEFINITE         (SIZE_MAX)
+
+/**
+ * @brief Maximum nesting of arrays, maps and tags cbor_reader_skip() handles
+ */
+#ifndef CBOR_READER_DEPTH_MAX
+#define CBOR_READER_DEPTH_MAX   (8)
+#endif
+
+/**
+ * @brief Types of data items returned by cbor_reader_next()
+ */
+typedef enum {
+    CBOR_ITEM_UINT,         /**< unsigned integer (major type 0) */
+    CBOR_ITEM_NEGINT,       /**< negative integer (major type 1) */
+    CBOR_ITEM_BYTES,        /**< byte string (major type 2) */
+    CBOR_ITEM_TEXT,         /**< text string (major type 3) */
+    CBOR_ITEM_ARRAY,        /**< array (major type 4) */
+    CBOR_ITEM_MAP,          /**< map (major type 5) */
+    CBOR_ITEM_TAG,          /**< tag of the next item (major type 6) */
+    CBOR_ITEM_SIMPLE,       /**< simple value, e.g. true (major type 7) */
+    CBOR_ITEM_FLOAT,        /**< floating point number (major type 7) */
+    CBOR_ITEM_BREAK,        /**< end of an indefinite length item */
+} cbor_item_type_t;
+
+/**
+ * @brief A data item read by cbor_reader_next()
+ *
+ * Arrays, maps and tags only describe the items that follow them. The chunks
+ * of an indefinite length string follow as separate string items, until an
+ * item of type @ref CBOR_ITEM_BREAK.
+ */
+typedef struct {
+    cbor_item_type_t type;  /**< type of the item */
+    bool indefinite;        /**< indefinite length string, array or map */
+    uint8_t size;           /**< size of a float in bytes (2, 4 or 8) */
+    union {
+        /**
+         * @brief value of unsigned integers, tags and simple values,
+         *        length of strings, number of items of arrays, number of
+         *        pairs of maps, -1 - value of negative integers
+         */
+        uint64_t u;
+        uint64_t bits;      /**< raw bits of floats */
+    } val;                  /**< value of the item */
+    const uint8_t *data;    /**< strings: the string within the input */
+} cbor_item_t;
+
+/**
+ * @brief Pull parser for CBOR data items
+ */
+typedef struct {
+    const uint8_t *pos;     /**< next byte to read */
+    const uint8_t *end;     /**< end of the input */
+} cbor_reader_t;
+
+/**
+ * @brief Callback consuming encoded data of a @ref cbor_writer_t
+ *
+ * @param[in] arg   argument given to cbor_writer_init()
+ * @param[in] data  encoded data
+ * @param[in] len   length of @p data
+ *
+ * @return 0 on success, < 0 to abort encoding
+ */
+typedef int (*cbor_writer_flush_t)(void *arg, const uint8_t *data, size_t len);
+
+/**
+ * @brief CBOR encoder writing to a buffer or a callback
+ *
+ * The first error is remembered and makes all later calls fail, so a
+ * sequence of items can be written without checking every call.
+ */
+typedef struct {
+    uint8_t *buf;               /**< buffer for encoded data */
+    size_t size;                /**< size of @p buf */
+    size_t pos;                 /**< number of bytes in @p buf */
+    size_t flushed;             /**< number of bytes handed to @p flush */
+    cbor_writer_flush_t flush;  /**< callback for full buffers, or NULL */
+    void *arg;                  /**< argument for @p flush */
+    int res;                    /**< first error, or 0 */
+} cbor_writer_t;
+
+/**
+ * @brief Initialize a pull parser
+ *
+ * @param[out] reader   the parser
+ * @param[in] buf       CBOR encoded data
+ * @param[in] len       length of @p buf
+ */
+static inline void cbor_reader_init(cbor_reader_t *reader, const uint8_t *buf,
+                                    size_t len)
+{
+    reader->pos = buf;
+    reader->end = buf + len;
+}
+
+/**
+ * @brief Number of bytes of the input not read yet
+ *
+ * @param[in] reader    the parser
+ *
+ * @return number of bytes left
+ */
+static inline size_t cbor_reader_remaining(const cbor_reader_t *reader)
+{
+    return reader->end - reader->pos;
+}
+
+/**
+ * @brief Read the next data item
+ *
+ * @param[in, out] reader   the parser
+ * @param[out] item         the item
+ *
+ * @return 0 on success
+ * @return -ENODATA at the end of the input
+ * @return -EAGAIN if the item is cut off by the end of the input, the parser
+ *         is left at the start of the item
+ * @return -EBADMSG on malformed input
+ */
+int cbor_reader_next(cbor_reader_t *reader, cbor_item_t *item);
+
+/**
+ * @brief Skip the items nested into an item
+ *
+ * Skips all items of an array or map, or the item after a tag. Does nothing
+ * for other items.
+ *
+ * @param[in, out] reader   the parser
+ * @param[in] item          item just returned by cbor_reader_next()
+ *
+ * @return 0 on success
+ * @return -EAGAIN if the nested items are cut off by the end of the input,
+ *         the parser is left after @p item
+ * @return -EBADMSG on malformed input or items nested deeper than
+ *         @ref CBOR_READER_DEPTH_MAX
+ */
+int cbor_reader_skip(cbor_reader_t *reader, const cbor_item_t *item);
+
+/**
+ * @brief Get the value of an integer item
+ *
+ * @param[in] item  the item
+ * @param[out] val  the value
+ *
+ * @return 0 on success
+ * @return -EINVAL if @p item is no integer
+ * @return -ERANGE if the value does not fit into @p val
+ */
+int cbor_item_get_int(const cbor_item_t *item, int64_t *val);
+
+#ifdef MODULE_CBOR_FLOAT
+/**
+ * @brief Get the value of a floating point or integer item
+ *
+ * @param[in] item  the item
+ * @param[out] val  the value
+ *
+ * @return 0 on success
+ * @return -EINVAL if @p item is no number
+ */
+int cbor_item_get_double(const cbor_item_t *item, double *val);
+#endif /* MODULE_CBOR_FLOAT */
+
+/**
+ * @brief Initialize an encoder
+ *
+ * Without @p flush, encoding fails once @p buf is full.
+ *
+ * @param[out] writer   the encoder
+ * @param[in] buf       buffer for encoded data, at least 9 bytes
+ * @param[in] size      size of @p buf
+ * @param[in] flush     callback for the encoded data, may be NULL
+ * @param[in] arg       argument for @p flush
+ */
+void cbor_writer_init(cbor_writer_t *writer, uint8_t *buf, size_t size,
+                      cbor_writer_flush_t flush, void *arg);
+
+/**
+ * @brief Encode an unsigned integer
+ *
+ * @param[in, out] writer   the encoder
+ * @param[in] val           the value
+ *
+ * @return 0 on success
+ * @return -ENOBUFS if the buffer is full and there is no callback
+ * @return < 0 on earlier errors or errors of the callback
+ */
+int cbor_writer_uint(cbor_writer_t *writer, uint64_t val);
+
+/**
+ * @brief Encode a signed integer
+ *
+ * @param[in, out] writer   the encoder
+ * @param[in] val           the value
+ *
+ * @return see cbor_writer_uint()
+ */
+int cbor_writer_int(cbor_writer_t *writer, int64_t val);
+
+/**
+ * @brief Encode a byte string
+ *
+ * @param[in, out] writer   the encoder
+ * @param[in] data          the string
+ * @param[in] len           length of @p data
+ *
+ * @return see cbor_writer_uint()
+ */
+int cbor_writer_bytes(cbor_writer_t *writer, const void *data, size_t len);
+
+/**
+ * @brief Encode a text string
+ *
+ * @param[in, out] writer   the encoder
+ * @param[in] str           the string, must be UTF-8 encoded
+ * @param[in] len           length of @p str in bytes
+ *
+ * @return see cbor_writer_uint()
+ */
+int cbor_writer_text(cbor_writer_t *writer, const char *str, size_t len);
+
+/**
+ * @brief Start an array
+ *
+ * @param[in, out] writer   the encoder
+ * @param[in] len           number of items that follow, or
+ *                          @ref CBOR_INDEFINITE to end it with
+ *                          cbor_writer_break()
+ *
+ * @return see cbor_writer_uint()
+ */
+int cbor_writer_array(cbor_writer_t *writer, size_t len);
+
+/**
+ * @brief Start a map
+ *
+ * @param[in, out] writer   the encoder
+ * @param[in] len           number of pairs that follow, or
+ *                          @ref CBOR_INDEFINITE to end it with
+ *                          cbor_writer_break()
+ *
+ * @return see cbor_writer_uint()
+ */
+int cbor_writer_map(cbor_writer_t *writer, size_t len);
+
+/**
+ * @brief Encode a tag for the next item
+ *
+ * @param[in, out] writer   the encoder
+ * @param[in] tag           the tag
+ *
+ * @return see cbor_writer_uint()
+ */
+int cbor_writer_tag(cbor_writer_t *writer, uint64_t tag);
+
+/**
+ * @brief Encode a boolean value
+ *
+ * @param[in, out] writer   the encoder
+ * @param[in] val           the value
+ *
+ * @return see cbor_writer_uint()
+ */
+int cbor_writer_bool(cbor_writer_t *writer, bool val);
+
+/**
+ * @brief End an indefinite length array or map
+ *
+ * @param[in, out] writer   the encoder
+ *
+ * @return see cbor_writer_uint()
+ */
+int cbor_writer_break(cbor_writer_t *writer);
+
+#ifdef MODULE_CBOR_FLOAT
+/**
+ * @brief Encode a floating point number
+ *
+ * Uses single precision if it represents @p val exactly, double precision
+ * otherwise.
+ *
+ * @param[in, out] writer   the encoder
+ * @param[in] val           the value
+ *
+ * @return see cbor_writer_uint()
+ */
+int cbor_writer_double(cbor_writer_t *writer, double val);
+#endif /* MODULE_CBOR_FLOAT */
+
+/**
+ * @brief Hand the rest of the encoded data to the callback
+ *
+ * @param[in, out] writer   the encoder
+ *
+ * @return total length of the encoded data
+ * @return < 0 on errors, see cbor_writer_uint()
+ */
+ssize_t cbor_writer_finish(cbor_writer_t *writer);
+
 #ifdef __cplusplus
 }
 #endif
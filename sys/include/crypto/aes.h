@@ -50,6 +50,7 @@ typedef uint8_t u8;
 #define AES_MAXNR         14
 #define AES_BLOCK_SIZE    16
 #define AES_KEY_SIZE      16
+#define AES_ROUNDS        10    /**< number of rounds for AES_KEY_SIZE */
 
 /**
  * @brief AES key
@@ -66,10 +67,17 @@ typedef struct aes_key_st AES_KEY;
 
 /**
  * @brief the cipher_context_t-struct adapted for AES
+ *
+ * The round keys are expanded once by aes_init(), so encrypting or decrypting
+ * a block does not need to run the key schedule again. When compiled with
+ * AES-NI support (`-maes` on x86), the round keys are stored in the byte order
+ * expected by the AES-NI instructions.
  */
 typedef struct {
-    /** context data buffer */
-    uint32_t context[(4 * (AES_MAXNR + 1)) + 1];
+    /** round keys for encryption */
+    uint32_t enc_key[4 * (AES_ROUNDS + 1)];
+    /** round keys for decryption */
+    uint32_t dec_key[4 * (AES_ROUNDS + 1)];
 } aes_context_t;
 
 /**
@@ -82,7 +90,8 @@ typedef struct {
  *
  * @return  CIPHER_INIT_SUCCESS if the initialization was successful.
  *          The command may be unsuccessful if the key size is not valid.
- *          CIPHER_ERR_BAD_CONTEXT_SIZE if CIPHER_MAX_CONTEXT_SIZE has not been defined (which means that the cipher has not been included in the build)
+ *          CIPHER_ERR_BAD_CONTEXT_SIZE if CIPHER_MAX_CONTEXT_SIZE is too small
+ *          to hold an aes_context_t (build with -DCRYPTO_AES)
  */
 int aes_init(cipher_context_t *context, const uint8_t *key, uint8_t keySize);
 
@@ -99,7 +108,7 @@ int aes_init(cipher_context_t *context, const uint8_t *key, uint8_t keySize);
  * @param       cipher_block  a pointer to the place where the ciphertext will
  *                            be stored
  *
- * @return  1 or result of aes_set_encrypt_key if it failed
+ * @return  1
  */
 int aes_encrypt(const cipher_context_t *context, const uint8_t *plain_block,
                 uint8_t *cipher_block);
@@ -117,12 +126,43 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plain_block,
  * @param       plain_block   a pointer to the place where the decrypted
  *                            plaintext will be stored
  *
- * @return  1 or negative value if cipher key cannot be expanded into
- *          decryption key schedule
+ * @return  1
  */
 int aes_decrypt(const cipher_context_t *context, const uint8_t *cipher_block,
                 uint8_t *plain_block);
 
+/**
+ * @brief   encrypts @p blocks consecutive blocks of plaintext
+ *
+ * @param       context       the cipher_context_t-struct to use for this
+ *                            encryption
+ * @param       plain         a pointer to the plaintext (of size
+ *                            blocks * blocksize)
+ * @param       cipher        a pointer to the place where the ciphertext will
+ *                            be stored, may be equal to @p plain
+ * @param       blocks        number of blocks to encrypt
+ *
+ * @return  1
+ */
+int aes_encrypt_blocks(const cipher_context_t *context, const uint8_t *plain,
+                       uint8_t *cipher, size_t blocks);
+
+/**
+ * @brief   decrypts @p blocks consecutive blocks of ciphertext
+ *
+ * @param       context       the cipher_context_t-struct to use for this
+ *                            decryption
+ * @param       cipher        a pointer to the ciphertext (of size
+ *                            blocks * blocksize)
+ * @param       plain         a pointer to the place where the plaintext will
+ *                            be stored, may be equal to @p cipher
+ * @param       blocks        number of blocks to decrypt
+ *
+ * @return  1
+ */
+int aes_decrypt_blocks(const cipher_context_t *context, const uint8_t *cipher,
+                       uint8_t *plain, size_t blocks);
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,6 +21,7 @@
 #define CRYPTO_MODES_CCM_H
 
 #include "crypto/ciphers.h"
+#include "crypto/modes/ctr.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -81,6 +82,142 @@ int cipher_decrypt_ccm(cipher_t* cipher, uint8_t* auth_data,
                        uint8_t length_encoding, uint8_t* nonce, size_t nonce_len,
                        uint8_t* input, size_t input_len, uint8_t* output);
 
+/**
+ * @brief Context for computing a CBC-MAC over a stream of data
+ */
+typedef struct {
+    const cipher_t *cipher;             /**< cipher used for the MAC */
+    uint8_t mac[CIPHER_MAX_BLOCK_SIZE]; /**< current MAC state */
+    uint8_t offset;                     /**< bytes added to the current block */
+} cipher_cbc_mac_t;
+
+/**
+ * @brief Context for encrypting or decrypting a stream of data in ccm mode
+ *
+ * CCM needs to know the length of the additional data and of the payload in
+ * advance. Both can then be passed in chunks of arbitrary size, e.g. one chunk
+ * per packet snip or iovec, without copying them into one buffer first.
+ */
+typedef struct {
+    cipher_cbc_mac_t cbc_mac;           /**< CBC-MAC state */
+    cipher_ctr_t ctr;                   /**< counter mode state */
+    uint8_t tag_stream[CIPHER_MAX_BLOCK_SIZE]; /**< key stream for the MAC */
+    uint32_t auth_data_len;             /**< remaining additional data */
+    size_t input_len;                   /**< remaining payload */
+    uint8_t mac_length;                 /**< length of the MAC */
+} cipher_ccm_t;
+
+/**
+ * @brief Initialize a CBC-MAC computation
+ * @param ctx       context to initialize
+ * @param cipher    Already initialized cipher struct, has to stay valid while
+ *                  @p ctx is used
+ * @param iv        initialization vector of block size length
+ */
+void cipher_cbc_mac_init(cipher_cbc_mac_t *ctx, const cipher_t *cipher,
+                         const uint8_t *iv);
+
+/**
+ * @brief Add the next chunk of data to a CBC-MAC computation
+ * @param ctx       initialized CBC-MAC context
+ * @param data      data to authenticate
+ * @param len       length of @p data
+ * @return          0 or error code
+ */
+int cipher_cbc_mac_update(cipher_cbc_mac_t *ctx, const uint8_t *data,
+                          size_t len);
+
+/**
+ * @brief Finish a CBC-MAC computation
+ *
+ * The last block is padded with zeros if it is incomplete.
+ *
+ * @param ctx       initialized CBC-MAC context
+ * @param mac       the block size long MAC is written here
+ * @return          0 or error code
+ */
+int cipher_cbc_mac_final(cipher_cbc_mac_t *ctx, uint8_t *mac);
+
+/**
+ * @brief Initialize a ccm mode stream
+ * @param ctx              context to initialize
+ * @param cipher           Already initialized cipher struct, has to stay valid
+ *                         while @p ctx is used
+ * @param mac_length       length of the MAC (between 4 and 16 - only even
+ *                         values)
+ * @param length_encoding  maximal supported length of plaintext
+ *                         (2^(8*length_enc)).
+ * @param nonce            Nounce for ctr mode encryption
+ * @param nonce_len        Length of the nonce in octets
+ *                         (maximum: 15-length_encoding)
+ * @param auth_data_len    total length of the additional data
+ * @param input_len        total length of the payload, without the MAC
+ * @return                 0 or error code
+ */
+int cipher_ccm_init(cipher_ccm_t *ctx, const cipher_t *cipher,
+                    uint8_t mac_length, uint8_t length_encoding,
+                    const uint8_t *nonce, size_t nonce_len,
+                    uint32_t auth_data_len, size_t input_len);
+
+/**
+ * @brief Add the next chunk of additional data to authenticate
+ *
+ * All additional data has to be passed before the payload.
+ *
+ * @param ctx              initialized ccm context
+ * @param auth_data        additional data
+ * @param len              length of @p auth_data
+ * @return                 0 or error code
+ */
+int cipher_ccm_update_auth_data(cipher_ccm_t *ctx, const uint8_t *auth_data,
+                                size_t len);
+
+/**
+ * @brief Encrypt the next chunk of the payload
+ * @param ctx              initialized ccm context
+ * @param input            plaintext
+ * @param len              length of @p input
+ * @param output           pointer to allocated memory for the ciphertext of
+ *                         size @p len, may be equal to @p input
+ * @return                 @p len or error code
+ */
+int cipher_ccm_encrypt_update(cipher_ccm_t *ctx, const uint8_t *input,
+                              size_t len, uint8_t *output);
+
+/**
+ * @brief Decrypt the next chunk of the payload
+ *
+ * The plaintext must not be used before cipher_ccm_decrypt_final() verified
+ * the MAC.
+ *
+ * @param ctx              initialized ccm context
+ * @param input            ciphertext
+ * @param len              length of @p input
+ * @param output           pointer to allocated memory for the plaintext of
+ *                         size @p len, may be equal to @p input
+ * @return                 @p len or error code
+ */
+int cipher_ccm_decrypt_update(cipher_ccm_t *ctx, const uint8_t *input,
+                              size_t len, uint8_t *output);
+
+/**
+ * @brief Finish encryption and compute the MAC
+ * @param ctx              initialized ccm context
+ * @param mac              the MAC of length mac_length is written here
+ * @return                 length of the MAC or error code
+ */
+int cipher_ccm_encrypt_final(cipher_ccm_t *ctx, uint8_t *mac);
+
+/**
+ * @brief Finish decryption and verify the MAC
+ * @param ctx              initialized ccm context
+ * @param mac              received MAC of length mac_length
+ * @return                 0 if the MAC is valid
+ * @return                 CCM_ERR_INVALID_CBC_MAC if the MAC is invalid
+ * @return                 other error codes
+ */
+int cipher_ccm_decrypt_final(cipher_ccm_t *ctx, const uint8_t *mac);
+
 #ifdef __cplusplus
 }
 #endif
@@ -66,6 +66,44 @@ int cipher_decrypt_ctr(cipher_t* cipher, uint8_t nonce_counter[16],
                        uint8_t nonce_len, uint8_t* input, size_t length,
                        uint8_t* output);
 
+/**
+ * @brief Context for encrypting a stream of data in counter mode
+ *
+ * The data can be passed in chunks of arbitrary size, e.g. one chunk per
+ * packet snip or iovec, without copying it into one buffer first.
+ */
+typedef struct {
+    const cipher_t *cipher;             /**< cipher to generate the key
+                                             stream with */
+    uint8_t nonce_counter[CIPHER_MAX_BLOCK_SIZE]; /**< next counter block */
+    uint8_t stream[CIPHER_MAX_BLOCK_SIZE]; /**< current key stream block */
+    uint8_t stream_offset;              /**< used bytes of @p stream */
+    uint8_t nonce_len;                  /**< length of the nonce in octets */
+} cipher_ctr_t;
+
+/**
+ * @brief Initialize a counter mode stream
+ * @param ctx           context to initialize
+ * @param cipher        Already initialized cipher struct, has to stay valid
+ *                      while @p ctx is used
+ * @param nonce_counter A nonce and a counter encoded in 16 octets.
+ * @param nonce_len     Length of the nonce in octets
+ */
+void cipher_ctr_init(cipher_ctr_t *ctx, const cipher_t *cipher,
+                     const uint8_t nonce_counter[16], uint8_t nonce_len);
+
+/**
+ * @brief Encrypt or decrypt the next chunk of a counter mode stream
+ * @param ctx           initialized counter mode context
+ * @param input         pointer to input data
+ * @param length        length of the input data
+ * @param output        pointer to allocated memory for the result. It has to
+ *                      be of size length and may be equal to @p input.
+ * @return              length or error code
+ */
+int cipher_ctr_update(cipher_ctr_t *ctx, const uint8_t *input, size_t length,
+                      uint8_t *output);
+
 #ifdef __cplusplus
 }
 #endif
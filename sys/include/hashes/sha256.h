@@ -81,6 +81,21 @@ typedef struct {
     sha256_context_t c_out;
 } hmac_context_t;
 
+/**
+ * @brief Precomputed HMAC SHA-256 key
+ *
+ * Holds the hash states after absorbing the inner and outer key pads. Starting
+ * a HMAC computation from it with hmac_sha256_init_key() costs two copies of
+ * the state instead of two SHA-256 block transforms, so it pays off when many
+ * messages are authenticated with the same key.
+ */
+typedef struct {
+    /** state after hashing the inner key pad */
+    uint32_t state_in[8];
+    /** state after hashing the outer key pad */
+    uint32_t state_out[8];
+} hmac_sha256_key_t;
+
 /**
  * @brief sha256-chain indexed element
  */
@@ -136,6 +151,22 @@ void *sha256(const void *data, size_t len, void *digest);
  */
 void hmac_sha256_init(hmac_context_t *ctx, const void *key, size_t key_length);
 
+/**
+ * @brief Precompute a HMAC SHA-256 key
+ * @param[out] hkey precomputed key
+ * @param[in] key key used in the hmac-sha256 computation
+ * @param[in] key_length the size in bytes of the key
+ */
+void hmac_sha256_key_init(hmac_sha256_key_t *hkey, const void *key,
+                          size_t key_length);
+
+/**
+ * @brief Initiate calculation of a HMAC from a precomputed key
+ * @param[out] ctx hmac_context_t handle to init
+ * @param[in] hkey key precomputed by hmac_sha256_key_init()
+ */
+void hmac_sha256_init_key(hmac_context_t *ctx, const hmac_sha256_key_t *hkey);
+
 /**
  * @brief hmac_sha256_update Add data bytes for HMAC calculation
  * @param[in] ctx hmac_context_t handle to use
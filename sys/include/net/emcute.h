@@ -26,6 +26,13 @@
  * handled. All 'user space functions' have to run from (a) different (i.e.
  * user) thread(s). emCute uses thread flags to synchronize between threads.
  *
+ * Requests sent with the blocking functions are answered one after the other,
+ * so their throughput is bound by the round trip time to the gateway. QoS 1
+ * messages published with emcute_pub_async() are pipelined instead: up to
+ * @ref EMCUTE_WINDOW of them may wait for their PUBACK at the same time, each
+ * with its own retransmission deadline. QoS 0 messages do not wait for any
+ * pending request.
+ *
  * Further know restrictions are:
  * - ASCII topic names only (no support for UTF8 names, yet)
  * - topic length is restricted to fit in a single length byte (248 byte max)
@@ -57,6 +64,7 @@
  * - unsubscribing from topics
  * - updating will topic
  * - updating will message
+ * - publishing multiple QoS 1 messages without waiting for each PUBACK
  * - sending out periodic PINGREQ messages
  * - handling re-transmits
  *
@@ -164,6 +172,14 @@ extern "C" {
 #define EMCUTE_N_RETRY          (3U)
 #endif
 
+#ifndef EMCUTE_WINDOW
+/**
+ * @brief   Number of QoS 1 messages published with emcute_pub_async() that
+ *          may wait for their PUBACK at the same time
+ */
+#define EMCUTE_WINDOW           (4U)
+#endif
+
 /**
  * @brief   MQTT-SN flags
  *
@@ -218,6 +234,28 @@ typedef struct {
  */
 typedef void(*emcute_cb_t)(const emcute_topic_t *topic, void *data, size_t len);
 
+/**
+ * @brief   Signature for callbacks fired when an asynchronous publication is
+ *          done
+ *
+ * The callback is executed in emCute's thread, it must not block and must not
+ * call any emCute function.
+ *
+ * @param[in] res       EMCUTE_OK when the gateway acknowledged the message,
+ *                      EMCUTE_REJECT, EMCUTE_TIMEOUT or EMCUTE_NOGW otherwise
+ * @param[in] arg       argument given to emcute_pub_async()
+ */
+typedef void(*emcute_pub_cb_t)(int res, void *arg);
+
+/**
+ * @brief   Message to publish with emcute_pub_batch()
+ */
+typedef struct {
+    const emcute_topic_t *topic;    /**< registered topic to publish on */
+    const void *data;               /**< data to publish */
+    size_t len;                     /**< length of @p data in bytes */
+} emcute_msg_t;
+
 /**
  * @brief   Data-structure for keeping track of topics we register to
  */
@@ -293,6 +331,48 @@ int emcute_reg(emcute_topic_t *topic);
 int emcute_pub(emcute_topic_t *topic, const void *buf, size_t len,
                unsigned flags);
 
+/**
+ * @brief   Publish data on the given topic with QoS 1 without waiting for the
+ *          acknowledgment
+ *
+ * Blocks only while @ref EMCUTE_WINDOW messages are waiting for their PUBACK
+ * already. The message is retransmitted every @ref EMCUTE_T_RETRY seconds
+ * until the gateway acknowledges it or @ref EMCUTE_N_RETRY transmissions
+ * failed, then @p cb is called.
+ *
+ * @param[in] topic     topic to send data to, topic **must** be registered
+ *                      (topic.id **must** populated).
+ * @param[in] buf       data to publish, **must** stay valid until @p cb was
+ *                      called
+ * @param[in] len       length of @p data in bytes
+ * @param[in] flags     flags used for publication, **must** contain
+ *                      EMCUTE_QOS_1, retain is allowed additionally
+ * @param[in] cb        function called once the publication is done, may be
+ *                      NULL
+ * @param[in] arg       argument passed to @p cb
+ *
+ * @return  EMCUTE_OK if the message was sent
+ * @return  EMCUTE_NOGW if not connected to a gateway
+ * @return  EMCUTE_OVERFLOW if length of data exceeds @ref EMCUTE_BUFSIZE
+ */
+int emcute_pub_async(emcute_topic_t *topic, const void *buf, size_t len,
+                     unsigned flags, emcute_pub_cb_t cb, void *arg);
+
+/**
+ * @brief   Publish a number of messages with QoS 0
+ *
+ * @param[in] msgs      messages to publish, their topics **must** be
+ *                      registered
+ * @param[in] num       number of messages in @p msgs
+ * @param[in] flags     flags used for publication, only retain is allowed
+ *
+ * @return  EMCUTE_OK on success
+ * @return  EMCUTE_NOGW if not connected to a gateway
+ * @return  EMCUTE_OVERFLOW if the data of any message exceeds
+ *          @ref EMCUTE_BUFSIZE, no message was sent then
+ */
+int emcute_pub_batch(const emcute_msg_t *msgs, size_t num, unsigned flags);
+
 /**
  * @brief   Subscribe to the given topic
  *
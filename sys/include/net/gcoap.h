@@ -161,6 +161,19 @@
  * the Observe option value set to 1. The server does not support cancellation
  * via a reset (RST) response to a non-confirmable notification.
  *
+ * ## Block-wise Transfers ##
+ *
+ * Resources larger than a PDU are transferred in blocks (RFC 7959). A server
+ * callback produces one block per request with gcoap_resp_block2(), or
+ * consumes one with gcoap_resp_block1(). Only the current block is kept in
+ * the PDU buffer, the block size is reduced to fit it.
+ *
+ * A client selects a block by setting the _block2_ attribute of the request
+ * coap_pkt_t with coap_block_encode() before calling gcoap_finish(). The
+ * response handler reads the block with coap_get_block2(). As blocks can be
+ * requested independently, a client may keep up to GCOAP_REQ_WAITING_MAX
+ * block requests in flight to keep the link busy.
+ *
  * ## Implementation Notes ##
  *
  * ### Building a packet ###
@@ -255,9 +268,9 @@ extern "C" {
 /**
  * @brief   Size of the buffer used to write options in a response
  *
- * Accommodates Content-Format.
+ * Accommodates Content-Format, Block2 and Block1.
  */
-#define GCOAP_RESP_OPTIONS_BUF  (8)
+#define GCOAP_RESP_OPTIONS_BUF  (12)
 
 /**
  * @brief   Size of the buffer used to write options in an Observe notification
@@ -634,6 +647,47 @@ static inline ssize_t gcoap_response(coap_pkt_t *pdu, uint8_t *buf,
                 : -1;
 }
 
+/**
+ * @brief   Writes a complete CoAP response PDU with one block of a resource
+ *
+ * Serves the block selected by the Block2 option of the request in @p pdu, or
+ * the first one. @p read is asked for one byte more than the block size to
+ * learn whether more blocks follow. A smaller block size is used if the
+ * requested one does not fit into @p buf.
+ *
+ * @param[in,out] pdu   Request to respond to
+ * @param[out] buf      Buffer containing the PDU
+ * @param[in] len       Length of the buffer
+ * @param[in] format    Format code of the resource
+ * @param[in] read      Callback producing the resource
+ * @param[in] arg       Argument for @p read
+ *
+ * @return  size of the PDU within the buffer
+ * @return  < 0 on error
+ */
+ssize_t gcoap_resp_block2(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                          unsigned format, coap_block_read_t read, void *arg);
+
+/**
+ * @brief   Consumes one block of a request and writes the complete response
+ *          PDU
+ *
+ * Hands the payload to @p write at the offset given by the Block1 option of
+ * the request, then responds with 2.31 (Continue), or 2.04 (Changed) after
+ * the last block. See coap_block1_code() for the response to errors.
+ *
+ * @param[in,out] pdu   Request to respond to
+ * @param[out] buf      Buffer containing the PDU
+ * @param[in] len       Length of the buffer
+ * @param[in] write     Callback consuming the payload
+ * @param[in] arg       Argument for @p write
+ *
+ * @return  size of the PDU within the buffer
+ * @return  < 0 on error
+ */
+ssize_t gcoap_resp_block1(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                          coap_block_write_t write, void *arg);
+
 /**
  * @brief   Initializes a CoAP Observe notification packet on a buffer, for the
  *          observer registered for a resource
@@ -101,6 +101,8 @@ int gnrc_netif_ipv6_addr_add_internal(gnrc_netif_t *netif,
  * @param[in,out] netif the network interface
  * @param[in] addr      the address to remove
  *
+ * @note    Blocks until concurrent address lookups are finished, see
+ *          rcu_synchronize().
  * @note    Only available with @ref net_gnrc_ipv6 "gnrc_ipv6".
  */
 void gnrc_netif_ipv6_addr_remove_internal(gnrc_netif_t *netif,
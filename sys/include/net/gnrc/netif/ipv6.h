@@ -88,6 +88,10 @@ typedef struct {
     /**
      * @brief   IPv6 unicast and anycast addresses of the interface
      *
+     * Lookups read this table within an @ref core_rcu "RCU" read-side
+     * critical section instead of acquiring the interface. An address is
+     * only valid if its gnrc_netif_ipv6_t::addrs_flags are not 0.
+     *
      * @note    Only available with module @ref net_gnrc_ipv6 "gnrc_ipv6".
      */
     ipv6_addr_t addrs[GNRC_NETIF_IPV6_ADDRS_NUMOF];
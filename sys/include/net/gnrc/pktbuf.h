@@ -284,6 +284,16 @@ gnrc_pktsnip_t *gnrc_pktbuf_duplicate_upto(gnrc_pktsnip_t *pkt, gnrc_nettype_t t
  * @details Statistics include maximum number of reserved bytes.
  */
 void gnrc_pktbuf_stats(void);
+
+/**
+ * @brief   Returns the high-water mark of the packet buffer.
+ *
+ * @note    Only available with DEVELHELP defined.
+ *
+ * @return  Position of the last byte ever used in the packet buffer.
+ * @return  0, if the packet buffer implementation does not track it.
+ */
+size_t gnrc_pktbuf_max_byte_count(void);
 #endif
 
 /* for testing */
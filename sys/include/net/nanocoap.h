@@ -51,6 +51,17 @@ extern "C" {
 #define NANOCOAP_QS_MAX         (64)
 /** @} */
 
+/**
+ * @brief   Largest block size exponent used for block-wise transfers
+ *
+ * Blocks are 2^(SZX + 4) bytes long, the default of 6 allows 1024 bytes.
+ * Smaller sizes are negotiated with the peer if a block does not fit into
+ * the buffer.
+ */
+#ifndef NANOCOAP_BLOCK_SZX_MAX
+#define NANOCOAP_BLOCK_SZX_MAX  (6U)
+#endif
+
 /**
  * @name    CoAP option numbers
  * @{
@@ -60,6 +71,10 @@ extern "C" {
 #define COAP_OPT_URI_PATH       (11)
 #define COAP_OPT_CONTENT_FORMAT (12)
 #define COAP_OPT_URI_QUERY      (15)
+#define COAP_OPT_BLOCK2         (23)
+#define COAP_OPT_BLOCK1         (27)
+#define COAP_OPT_SIZE2          (28)
+#define COAP_OPT_SIZE1          (60)
 /** @} */
 
 /**
@@ -120,6 +135,7 @@ extern "C" {
 #define COAP_CODE_204          ((2 << 5) | 4)
 #define COAP_CODE_CONTENT      ((2 << 5) | 5)
 #define COAP_CODE_205          ((2 << 5) | 5)
+#define COAP_CODE_CONTINUE     ((2 << 5) | 31)
 #define COAP_CODE_231          ((2 << 5) | 31)
 /** @} */
 
@@ -136,6 +152,7 @@ extern "C" {
 #define COAP_CODE_404                        ((4 << 5) | 4)
 #define COAP_CODE_METHOD_NOT_ALLOWED         ((4 << 5) | 5)
 #define COAP_CODE_NOT_ACCEPTABLE             ((4 << 5) | 6)
+#define COAP_CODE_REQUEST_ENTITY_INCOMPLETE  ((4 << 5) | 8)
 #define COAP_CODE_PRECONDITION_FAILED        ((4 << 5) | 0xC)
 #define COAP_CODE_REQUEST_ENTITY_TOO_LARGE   ((4 << 5) | 0xD)
 #define COAP_CODE_UNSUPPORTED_CONTENT_FORMAT ((4 << 5) | 0xF)
@@ -228,8 +245,55 @@ typedef struct {
     unsigned payload_len;           /**< length of payload                  */
     uint16_t content_type;          /**< content type                       */
     uint32_t observe_value;         /**< observe value                      */
+    uint32_t block1;                /**< raw Block1 option value            */
+    uint32_t block2;                /**< raw Block2 option value            */
 } coap_pkt_t;
 
+/**
+ * @brief   Value of the block options of @ref coap_pkt_t if not present
+ */
+#define COAP_BLOCK_NONE         (UINT32_MAX)
+
+/**
+ * @brief   Block1 or Block2 option (RFC 7959)
+ */
+typedef struct {
+    uint32_t num;                   /**< block number                       */
+    uint8_t szx;                    /**< block size exponent                */
+    bool more;                      /**< more blocks follow                 */
+} coap_block_t;
+
+/**
+ * @brief   Callback producing the data of a block-wise transfer
+ *
+ * @param[in]   arg     argument given along with the callback
+ * @param[in]   offset  offset of the requested data
+ * @param[out]  buf     buffer to write the data to
+ * @param[in]   len     number of bytes requested
+ *
+ * @returns     number of bytes written, less than @p len at the end
+ * @returns     <0 on error
+ */
+typedef ssize_t (*coap_block_read_t)(void *arg, size_t offset, uint8_t *buf,
+                                     size_t len);
+
+/**
+ * @brief   Callback consuming the data of a block-wise transfer
+ *
+ * @param[in]   arg     argument given along with the callback
+ * @param[in]   offset  offset of the data
+ * @param[in]   buf     the data
+ * @param[in]   len     length of @p buf
+ * @param[in]   more    false for the last block
+ *
+ * @returns     0 on success
+ * @returns     -EINVAL if the data was not expected at @p offset
+ * @returns     -EFBIG if the data exceeds the space available
+ * @returns     <0 on other errors
+ */
+typedef int (*coap_block_write_t)(void *arg, size_t offset, const uint8_t *buf,
+                                  size_t len, bool more);
+
 /**
  * @brief   Resource handler type
  */
@@ -254,6 +318,50 @@ extern const coap_resource_t coap_resources[];
  */
 extern const unsigned coap_resources_numof;
 
+/**
+ * @brief   Minimal perfect hash over the paths of @ref coap_resources
+ *
+ * With the `nanocoap_resources` module, the application lists its resources
+ * in the file named by the `NANOCOAP_RESOURCES` make variable instead of
+ * defining @ref coap_resources itself. One resource per line gives path,
+ * methods and handler, e.g.
+ *
+ *     /riot/board     GET             riot_board_handler
+ *     /riot/value     GET|PUT|POST    riot_value_handler
+ *
+ * `dist/tools/nanocoap/gen_resources.py` sorts and verifies the list at build
+ * time and generates @ref coap_resources along with this index, so requests
+ * are dispatched in constant time. The handlers must not be static.
+ *
+ * A path is hashed twice: the first hash selects a bucket, the displacement
+ * of the bucket is added to the second hash to select the slot of the path.
+ * The slot holds the index of the first resource with this path.
+ */
+typedef struct {
+    const uint16_t *disp;           /**< displacement per bucket            */
+    const uint16_t *first;          /**< first resource per slot            */
+    uint16_t buckets;               /**< number of buckets                  */
+    uint16_t slots;                 /**< number of slots (distinct paths)   */
+} coap_resource_index_t;
+
+/**
+ * @brief   Index of the global CoAP resource list
+ */
+extern const coap_resource_index_t coap_resource_index;
+
+/**
+ * @brief   Finds the first resource with the given path
+ *
+ * Resources with the same path but different methods follow it in
+ * @ref coap_resources.
+ *
+ * @param[in]   path    path to look up
+ *
+ * @returns     index of the resource in @ref coap_resources
+ * @returns     -1 if there is no resource with this path
+ */
+int coap_resource_find(const char *path);
+
 /**
  * @brief   Parse a CoAP PDU
  *
@@ -316,6 +424,60 @@ ssize_t coap_reply_simple(coap_pkt_t *pkt,
                           unsigned ct,
                           const uint8_t *payload, uint8_t payload_len);
 
+/**
+ * @brief   Reply to a request with one block of a larger resource
+ *
+ * Serves the block selected by the Block2 option of @p pkt, or the first one
+ * if there is none. @p read is called once for the block, asking for one
+ * byte more than the block size to learn whether more blocks follow. If the
+ * requested block does not fit into @p buf, a smaller block size is used.
+ *
+ * @param[in]   pkt     request to reply to
+ * @param[out]  buf     buffer to write the reply to
+ * @param[in]   len     size of @p buf
+ * @param[in]   ct      content type of the resource
+ * @param[in]   read    callback producing the resource
+ * @param[in]   arg     argument for @p read
+ *
+ * @returns     size of reply packet on success
+ * @returns     <0 on error
+ */
+ssize_t coap_block2_reply(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                          unsigned ct, coap_block_read_t read, void *arg);
+
+/**
+ * @brief   Consume one block of a request and reply to it
+ *
+ * Hands the payload of @p pkt to @p write at the offset given by its Block1
+ * option, then replies with 2.31 (Continue) or, after the last block, with
+ * 2.04 (Changed). Requests without Block1 option are handled as a single
+ * last block. A failing @p write is answered with 4.08, 4.13 or 5.00.
+ *
+ * If @p buf is too small for the block size of the client, the reply asks it
+ * to continue with smaller blocks.
+ *
+ * @param[in]   pkt     request to reply to
+ * @param[out]  buf     buffer to write the reply to
+ * @param[in]   len     size of @p buf
+ * @param[in]   write   callback consuming the payload
+ * @param[in]   arg     argument for @p write
+ *
+ * @returns     size of reply packet on success
+ * @returns     <0 on error
+ */
+ssize_t coap_block1_reply(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                          coap_block_write_t write, void *arg);
+
+/**
+ * @brief   Get the response code for the result of a block write callback
+ *
+ * @param[in]   res     return value of a @ref coap_block_write_t
+ * @param[in]   more    more blocks follow
+ *
+ * @returns     response code for the block
+ */
+unsigned coap_block1_code(int res, bool more);
+
 /**
  * @brief   Handle incoming CoAP request
  *
@@ -391,6 +553,20 @@ size_t coap_put_option_ct(uint8_t *buf, uint16_t lastonum, uint16_t content_type
  */
 size_t coap_put_option_uri(uint8_t *buf, uint16_t lastonum, const char *uri, uint16_t optnum);
 
+/**
+ * @brief   Insert block option into buffer
+ *
+ * @param[out]  buf         buffer to write to
+ * @param[in]   lastonum    number of previous option (for delta calculation),
+ *                          or 0 if first option
+ * @param[in]   onum        COAP_OPT_BLOCK1 or COAP_OPT_BLOCK2
+ * @param[in]   block       block to encode
+ *
+ * @returns     amount of bytes written to @p buf
+ */
+size_t coap_put_option_block(uint8_t *buf, uint16_t lastonum, uint16_t onum,
+                             const coap_block_t *block);
+
 /**
  * @brief   Get the CoAP version number
  *
@@ -590,6 +766,89 @@ static inline uint32_t coap_get_observe(coap_pkt_t *pkt)
     return pkt->observe_value;
 }
 
+/**
+ * @brief   Get the size of blocks with the given size exponent
+ *
+ * @param[in]   szx     block size exponent
+ *
+ * @returns     block size in bytes
+ */
+static inline size_t coap_szx2size(unsigned szx)
+{
+    return 1U << (szx + 4);
+}
+
+/**
+ * @brief   Get the largest block size exponent for blocks fitting into @p size
+ *          bytes
+ *
+ * @pre     @p size is at least 16
+ *
+ * @param[in]   size    available space
+ *
+ * @returns     block size exponent, at most @ref NANOCOAP_BLOCK_SZX_MAX
+ */
+static inline unsigned coap_size2szx(size_t size)
+{
+    unsigned szx = 0;
+
+    assert(size >= 16);
+    while ((szx < NANOCOAP_BLOCK_SZX_MAX) && (coap_szx2size(szx + 1) <= size)) {
+        szx++;
+    }
+    return szx;
+}
+
+/**
+ * @brief   Encode a block to the value of a block option
+ *
+ * @param[in]   block   block to encode
+ *
+ * @returns     raw option value
+ */
+static inline uint32_t coap_block_encode(const coap_block_t *block)
+{
+    return (block->num << 4) | (block->more << 3) | block->szx;
+}
+
+/**
+ * @brief   Get the Block1 option of a packet
+ *
+ * @param[in]   pkt     packet to read from
+ * @param[out]  block   the option, left untouched if not present
+ *
+ * @returns     true if the option is present
+ */
+static inline bool coap_get_block1(const coap_pkt_t *pkt, coap_block_t *block)
+{
+    if (pkt->block1 == COAP_BLOCK_NONE) {
+        return false;
+    }
+    block->num = pkt->block1 >> 4;
+    block->more = (pkt->block1 >> 3) & 1;
+    block->szx = pkt->block1 & 0x7;
+    return true;
+}
+
+/**
+ * @brief   Get the Block2 option of a packet
+ *
+ * @param[in]   pkt     packet to read from
+ * @param[out]  block   the option, left untouched if not present
+ *
+ * @returns     true if the option is present
+ */
+static inline bool coap_get_block2(const coap_pkt_t *pkt, coap_block_t *block)
+{
+    if (pkt->block2 == COAP_BLOCK_NONE) {
+        return false;
+    }
+    block->num = pkt->block2 >> 4;
+    block->more = (pkt->block2 >> 3) & 1;
+    block->szx = pkt->block2 & 0x7;
+    return true;
+}
+
 /**
  * @brief   Reference to the default .well-known/core handler defined by the
  *          application
@@ -23,12 +23,95 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#include "net/nanocoap.h"
 #include "net/sock/udp.h"
+#include "thread.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief   Number of requests remembered for duplicate detection
+ *
+ * The servers remember message ID and endpoint of recent requests. A
+ * retransmission of a request that is still handled is dropped, one of a
+ * handled request is answered with the cached response without calling the
+ * handler again. Set to 0 to disable duplicate detection.
+ */
+#ifndef NANOCOAP_DEDUP_SIZE
+#define NANOCOAP_DEDUP_SIZE         (4U)
+#endif
+
+/**
+ * @brief   Time in seconds a request is remembered
+ *
+ * RFC 7252 defines EXCHANGE_LIFETIME as 247 seconds, which covers all
+ * retransmissions of a client using the default transmission parameters.
+ */
+#ifndef NANOCOAP_DEDUP_LIFETIME
+#define NANOCOAP_DEDUP_LIFETIME     (247U)
+#endif
+
+/**
+ * @brief   Maximum length of a cached response
+ *
+ * Retransmissions of requests with longer responses are handled again.
+ */
+#ifndef NANOCOAP_DEDUP_RESP_MAX
+#define NANOCOAP_DEDUP_RESP_MAX     (64U)
+#endif
+
+/**
+ * @brief   Number of worker threads of nanocoap_server_mt()
+ */
+#ifndef NANOCOAP_SERVER_WORKERS
+#define NANOCOAP_SERVER_WORKERS     (2U)
+#endif
+
+/**
+ * @brief   Number of request buffers of nanocoap_server_mt()
+ *
+ * Limits the number of requests that are queued or handled at the same time.
+ * Must be a power of two.
+ */
+#ifndef NANOCOAP_SERVER_QUEUE_SIZE
+#define NANOCOAP_SERVER_QUEUE_SIZE  (4U)
+#endif
+
+/**
+ * @brief   Size of each request buffer of nanocoap_server_mt()
+ *
+ * Responses are written to the buffer of the request as well.
+ */
+#ifndef NANOCOAP_SERVER_BUFSIZE
+#define NANOCOAP_SERVER_BUFSIZE     (128U)
+#endif
+
+/**
+ * @brief   Stack size of the worker threads of nanocoap_server_mt()
+ */
+#ifndef NANOCOAP_SERVER_STACKSIZE
+#define NANOCOAP_SERVER_STACKSIZE   (THREAD_STACKSIZE_DEFAULT)
+#endif
+
+/**
+ * @brief   Priority of the worker threads of nanocoap_server_mt()
+ */
+#ifndef NANOCOAP_SERVER_PRIO
+#define NANOCOAP_SERVER_PRIO        (THREAD_PRIORITY_MAIN - 1)
+#endif
+
+/**
+ * @brief   Number of blocks nanocoap_get_blockwise() requests at once
+ *
+ * Keeps the link busy while responses are in flight. Set to 1 for
+ * stop-and-wait transfers.
+ */
+#ifndef NANOCOAP_BLOCK_WINDOW
+#define NANOCOAP_BLOCK_WINDOW       (4U)
+#endif
+
 /**
  * @brief   Start a nanocoap server instance
  *
@@ -43,6 +126,22 @@ extern "C" {
  */
 int nanocoap_server(sock_udp_ep_t *local, uint8_t *buf, size_t bufsize);
 
+/**
+ * @brief   Start a multi-threaded nanocoap server instance
+ *
+ * The calling thread receives requests and queues them for
+ * @ref NANOCOAP_SERVER_WORKERS worker threads, so a slow handler only blocks
+ * its own worker. Handlers may thus be called concurrently.
+ *
+ * Like nanocoap_server(), this function only returns on errors. It must not
+ * be called more than once.
+ *
+ * @param[in]   local   local UDP endpoint to bind to
+ *
+ * @returns     -1 on error
+ */
+int nanocoap_server_mt(sock_udp_ep_t *local);
+
 /**
  * @brief   Simple synchronous CoAP get
  *
@@ -57,6 +156,56 @@ int nanocoap_server(sock_udp_ep_t *local, uint8_t *buf, size_t bufsize);
 ssize_t nanocoap_get(sock_udp_ep_t *remote, const char *path, uint8_t *buf,
                      size_t len);
 
+/**
+ * @brief   Block-wise CoAP get of a resource larger than @p buf
+ *
+ * The first block is requested alone to agree on the block size with the
+ * server. After that, up to @ref NANOCOAP_BLOCK_WINDOW blocks are requested
+ * at once. Each block is handed to @p cb along with its offset as soon as
+ * it arrives, so blocks may be delivered out of order. @p more is false for
+ * the last block of the resource, which is not necessarily delivered last.
+ *
+ * A response without Block2 option is delivered as a whole.
+ *
+ * @param[in]   remote  remote UDP endpoint
+ * @param[in]   path    remote path
+ * @param[out]  buf     buffer for requests and responses, at least 32 bytes
+ * @param[in]   len     length of @p buf, determines the block size
+ * @param[in]   cb      callback consuming the resource
+ * @param[in]   arg     argument for @p cb
+ *
+ * @returns     length of the resource on success
+ * @returns     -ETIMEDOUT if a block was not answered
+ * @returns     negative response code if the request failed
+ * @returns     <0 on other errors, including errors returned by @p cb
+ */
+ssize_t nanocoap_get_blockwise(sock_udp_ep_t *remote, const char *path,
+                               uint8_t *buf, size_t len,
+                               coap_block_write_t cb, void *arg);
+
+/**
+ * @brief   Block-wise CoAP put of data larger than @p buf
+ *
+ * Sends one block at a time and waits for its acknowledgement. @p read may
+ * be asked for the same offset again if a block is retransmitted. If the
+ * server asks for smaller blocks, the transfer continues with these.
+ *
+ * @param[in]   remote  remote UDP endpoint
+ * @param[in]   path    remote path
+ * @param[out]  buf     buffer for requests and responses
+ * @param[in]   len     length of @p buf, determines the block size
+ * @param[in]   read    callback producing the data
+ * @param[in]   arg     argument for @p read
+ *
+ * @returns     number of bytes sent on success
+ * @returns     -ETIMEDOUT if a block was not answered
+ * @returns     negative response code if the server rejected a block
+ * @returns     <0 on other errors, including errors returned by @p read
+ */
+ssize_t nanocoap_put_blockwise(sock_udp_ep_t *remote, const char *path,
+                               uint8_t *buf, size_t len,
+                               coap_block_read_t read, void *arg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,6 +12,15 @@
  *
  * @brief       Sock DNS client
  *
+ * Resolved addresses are kept in a small cache for the time to live the
+ * server announced. Answers stating that a name or record does not exist are
+ * cached as well, for at most @ref SOCK_DNS_NEG_TTL seconds.
+ *
+ * When both A and AAAA records are requested, both queries are sent at once
+ * and their replies are told apart by the DNS message ID. Every call of
+ * sock_dns_query() uses its own UDP sock, so several threads can have
+ * queries outstanding at the same time.
+ *
  * @{
  *
  * @file
@@ -58,19 +67,43 @@ typedef struct {
 #define SOCK_DNS_RETRIES        (2)
 
 #define SOCK_DNS_MAX_NAME_LEN   (64U)       /* we're in embedded context. */
-#define SOCK_DNS_QUERYBUF_LEN   (sizeof(sock_dns_hdr_t) + 4 + SOCK_DNS_MAX_NAME_LEN)
+#define SOCK_DNS_QUERYBUF_LEN   (sizeof(sock_dns_hdr_t) + 2 + 4 + SOCK_DNS_MAX_NAME_LEN)
 /** @} */
 
+/**
+ * @brief   Number of cached records
+ *
+ * A and AAAA records of a name take one entry each.
+ */
+#ifndef SOCK_DNS_CACHE_SIZE
+#define SOCK_DNS_CACHE_SIZE     (4U)
+#endif
+
+/**
+ * @brief   Maximum time in seconds to cache the absence of a record
+ */
+#ifndef SOCK_DNS_NEG_TTL
+#define SOCK_DNS_NEG_TTL        (60U)
+#endif
+
+/**
+ * @brief   Time in microseconds to wait for replies before retrying
+ */
+#ifndef SOCK_DNS_TIMEOUT
+#define SOCK_DNS_TIMEOUT        (1000000U)
+#endif
+
 /**
  * @brief Get IP address for DNS name
  *
  * This function will synchronously try to resolve a DNS A or AAAA record by contacting
- * the DNS server specified in the global variable @ref sock_dns_server.
+ * the DNS server specified in the global variable @ref sock_dns_server,
+ * unless the answer is still cached.
  *
  * By supplying AF_INET, AF_INET6 or AF_UNSPEC in @p family requesting of A
  * records (IPv4), AAAA records (IPv6) or both can be selected.
  *
- * This fuction will return the first DNS record it receives. IF both A and
+ * This fuction will return the first matching DNS record. If both A and
  * AAAA are requested, AAAA will be preferred.
  *
  * @note @p addr_out needs to provide space for any possible result!
@@ -80,11 +113,21 @@ typedef struct {
  * @param[out]  addr_out        buffer to write result into
  * @param[in]   family          Either AF_INET, AF_INET6 or AF_UNSPEC
  *
- * @return      0 on success
- * @return      !=0 otherwise
+ * @return      the length of the address on success
+ * @return      -ENOSPC if @p domain_name is too long
+ * @return      -EHOSTUNREACH if the server has no such record
+ * @return      -ETIMEDOUT if the server did not reply
+ * @return      <0 on other errors
  */
 int sock_dns_query(const char *domain_name, void *addr_out, int family);
 
+/**
+ * @brief Drops all cached records
+ *
+ * Should be called after @ref sock_dns_server was changed.
+ */
+void sock_dns_cache_flush(void);
+
 /**
  * @brief global DNS server endpoint
  */
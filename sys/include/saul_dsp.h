@@ -0,0 +1,345 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sys_saul_dsp SAUL sample pipeline
+ * @ingroup     sys
+ * @brief       Periodic sampling of SAUL devices and fixed-point processing
+ *
+ * Samples of one dimension of a SAUL device are taken periodically with
+ * saul_dsp_acquire() and stored in a @ref saul_dsp_ring_t. A processing
+ * thread takes blocks of samples out of the ring and runs them through a
+ * chain of stages, e.g. a DC blocker, a FIR filter and a decimator. Instead of
+ * the samples, only features derived from a block, like its RMS value and its
+ * dominant frequency, need to be sent over the network.
+ *
+ * All processing uses 16-bit samples and Q15 coefficients, so it runs without
+ * a FPU:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~ {.c}
+ * saul_dsp_dc_init(&dc, SAUL_DSP_Q15(0.99));
+ * saul_dsp_fir_init(&fir, lowpass, sizeof(lowpass) / sizeof(lowpass[0]));
+ * saul_dsp_decim_init(&decim, 4);
+ * dc.stage.next = &fir.stage;
+ * fir.stage.next = &decim.stage;
+ *
+ * while (1) {
+ *     size_t len = saul_dsp_ring_get(&ring, block, sizeof(block) / 2);
+ *     len = saul_dsp_process(&dc.stage, block, len);
+ *     ...
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * @see @ref sys_saul_reg
+ *
+ * @{
+ *
+ * @file
+ * @brief       SAUL sample pipeline interface definition
+ */
+
+#ifndef SAUL_DSP_H
+#define SAUL_DSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "saul_reg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Maximum number of taps of a FIR filter
+ */
+#ifndef SAUL_DSP_FIR_TAPS_MAX
+#define SAUL_DSP_FIR_TAPS_MAX       (32U)
+#endif
+
+/**
+ * @brief   Binary logarithm of the maximum FFT size
+ */
+#define SAUL_DSP_FFT_LOG2_MAX       (8U)
+
+/**
+ * @brief   Converts a constant in [-1, 1) to Q15
+ */
+#define SAUL_DSP_Q15(x)             ((int16_t)((x) * 32768.0 + (((x) < 0) ? -0.5 : 0.5)))
+
+/**
+ * @brief   Single producer, single consumer ring buffer of samples
+ *
+ * Samples are stored in one contiguous buffer, so a DMA transfer can fill it
+ * directly, see saul_dsp_ring_write_ptr().
+ */
+typedef struct {
+    int16_t *buf;                   /**< sample buffer */
+    unsigned mask;                  /**< size of @ref buf - 1 */
+    volatile unsigned reads;        /**< number of samples taken out */
+    volatile unsigned writes;       /**< number of samples put in */
+} saul_dsp_ring_t;
+
+/**
+ * @brief   Periodic acquisition of one dimension of a SAUL device
+ */
+typedef struct {
+    saul_reg_t *dev;                /**< device to sample */
+    saul_dsp_ring_t *ring;          /**< ring to store the samples in */
+    uint32_t period;                /**< sampling period in microseconds */
+    unsigned overruns;              /**< samples dropped on a full ring */
+    uint8_t dim;                    /**< dimension to sample */
+    uint8_t unit;                   /**< unit of the samples */
+    int8_t scale;                   /**< scale of the samples */
+} saul_dsp_acq_t;
+
+typedef struct saul_dsp_stage saul_dsp_stage_t;
+
+/**
+ * @brief   Processes a block of samples in place
+ *
+ * @param[in] stage     the stage
+ * @param[in,out] block samples
+ * @param[in] len       number of samples in @p block
+ *
+ * @return  number of samples in @p block after processing
+ */
+typedef size_t (*saul_dsp_process_t)(saul_dsp_stage_t *stage, int16_t *block,
+                                     size_t len);
+
+/**
+ * @brief   Processing stage, embedded into the state of a stage
+ */
+struct saul_dsp_stage {
+    saul_dsp_stage_t *next;         /**< next stage of the chain */
+    saul_dsp_process_t process;     /**< processing function */
+};
+
+/**
+ * @brief   FIR filter stage
+ */
+typedef struct {
+    saul_dsp_stage_t stage;                 /**< stage */
+    const int16_t *coeffs;                  /**< Q15 coefficients */
+    uint8_t taps;                           /**< number of coefficients */
+    uint8_t pos;                            /**< position of the latest
+                                             *   sample in @ref state */
+    int16_t state[SAUL_DSP_FIR_TAPS_MAX];   /**< latest samples */
+} saul_dsp_fir_t;
+
+/**
+ * @brief   DC blocking stage, a first order high-pass filter
+ */
+typedef struct {
+    saul_dsp_stage_t stage;         /**< stage */
+    int16_t alpha;                  /**< Q15 pole, close to 1 */
+    int16_t last_in;                /**< last input sample */
+    int32_t last_out;               /**< last output, Q15 fraction kept */
+} saul_dsp_dc_t;
+
+/**
+ * @brief   Decimation stage, averaging consecutive samples
+ */
+typedef struct {
+    saul_dsp_stage_t stage;         /**< stage */
+    int32_t sum;                    /**< sum of the pending samples */
+    uint8_t factor;                 /**< decimation factor */
+    uint8_t count;                  /**< number of pending samples */
+} saul_dsp_decim_t;
+
+/**
+ * @brief   Features of a block of samples
+ */
+typedef struct {
+    int16_t mean;                   /**< mean value */
+    uint16_t rms;                   /**< root mean square */
+    uint16_t peak;                  /**< maximum absolute value */
+    uint16_t peak_bin;              /**< FFT bin of the dominant frequency */
+    uint16_t peak_mag;              /**< magnitude of the dominant frequency */
+} saul_dsp_features_t;
+
+/**
+ * @brief   Initializes a ring buffer
+ *
+ * @param[out] ring     the ring buffer
+ * @param[in] buf       sample buffer
+ * @param[in] size      number of samples in @p buf, must be a power of two
+ */
+void saul_dsp_ring_init(saul_dsp_ring_t *ring, int16_t *buf, size_t size);
+
+/**
+ * @brief   Gets the number of samples in a ring buffer
+ *
+ * @param[in] ring      the ring buffer
+ *
+ * @return  number of samples to take out
+ */
+static inline size_t saul_dsp_ring_avail(const saul_dsp_ring_t *ring)
+{
+    return ring->writes - ring->reads;
+}
+
+/**
+ * @brief   Puts a sample into a ring buffer
+ *
+ * @param[in] ring      the ring buffer
+ * @param[in] sample    the sample
+ *
+ * @return  0 on success
+ * @return  -ENOBUFS if the ring buffer is full
+ */
+int saul_dsp_ring_put(saul_dsp_ring_t *ring, int16_t sample);
+
+/**
+ * @brief   Gets the contiguous free space of a ring buffer
+ *
+ * Fill it, e.g. with a DMA transfer, and publish the samples with
+ * saul_dsp_ring_commit().
+ *
+ * @param[in] ring      the ring buffer
+ * @param[out] len      number of samples that fit
+ *
+ * @return  the free space
+ */
+int16_t *saul_dsp_ring_write_ptr(saul_dsp_ring_t *ring, size_t *len);
+
+/**
+ * @brief   Publishes samples written to saul_dsp_ring_write_ptr()
+ *
+ * @param[in] ring      the ring buffer
+ * @param[in] len       number of samples written
+ */
+void saul_dsp_ring_commit(saul_dsp_ring_t *ring, size_t len);
+
+/**
+ * @brief   Takes samples out of a ring buffer
+ *
+ * @param[in] ring      the ring buffer
+ * @param[out] dst      buffer for the samples
+ * @param[in] len       maximum number of samples to take
+ *
+ * @return  number of samples written to @p dst
+ */
+size_t saul_dsp_ring_get(saul_dsp_ring_t *ring, int16_t *dst, size_t len);
+
+/**
+ * @brief   Initializes a periodic acquisition
+ *
+ * @param[out] acq      the acquisition
+ * @param[in] dev       device to sample
+ * @param[in] dim       dimension of the device's values to sample
+ * @param[in] ring      ring buffer for the samples
+ * @param[in] period    sampling period in microseconds, 0 to sample as fast
+ *                      as possible
+ */
+void saul_dsp_acq_init(saul_dsp_acq_t *acq, saul_reg_t *dev, uint8_t dim,
+                       saul_dsp_ring_t *ring, uint32_t period);
+
+/**
+ * @brief   Takes samples periodically
+ *
+ * Blocks the calling thread until @p num samples were taken. Samples that do
+ * not fit into the ring buffer are counted in saul_dsp_acq_t::overruns.
+ *
+ * @param[in] acq       the acquisition
+ * @param[in] num       number of samples to take
+ *
+ * @return  @p num on success
+ * @return  -EINVAL if the device returned less dimensions than needed
+ * @return  any error of saul_reg_read()
+ */
+int saul_dsp_acquire(saul_dsp_acq_t *acq, size_t num);
+
+/**
+ * @brief   Runs a block of samples through a chain of stages
+ *
+ * @param[in] first     first stage of the chain
+ * @param[in,out] block samples
+ * @param[in] len       number of samples in @p block
+ *
+ * @return  number of samples in @p block after the last stage
+ */
+size_t saul_dsp_process(saul_dsp_stage_t *first, int16_t *block, size_t len);
+
+/**
+ * @brief   Initializes a FIR filter stage
+ *
+ * @param[out] fir      the stage
+ * @param[in] coeffs    Q15 coefficients, must stay valid
+ * @param[in] taps      number of coefficients, at most
+ *                      @ref SAUL_DSP_FIR_TAPS_MAX
+ */
+void saul_dsp_fir_init(saul_dsp_fir_t *fir, const int16_t *coeffs,
+                       uint8_t taps);
+
+/**
+ * @brief   Initializes a DC blocking stage
+ *
+ * @param[out] dc       the stage
+ * @param[in] alpha     Q15 pole, the closer to 1, the lower the cut-off
+ */
+void saul_dsp_dc_init(saul_dsp_dc_t *dc, int16_t alpha);
+
+/**
+ * @brief   Initializes a decimation stage
+ *
+ * Samples left over at the end of a block are carried over to the next one.
+ *
+ * @param[out] decim    the stage
+ * @param[in] factor    number of samples to average into one
+ */
+void saul_dsp_decim_init(saul_dsp_decim_t *decim, uint8_t factor);
+
+/**
+ * @brief   Fixed-point FFT
+ *
+ * Every stage scales its result by 1/2 to prevent overflows, so the result is
+ * the discrete Fourier transform divided by the number of samples.
+ *
+ * @param[in,out] re    real parts
+ * @param[in,out] im    imaginary parts
+ * @param[in] log2n     binary logarithm of the number of samples, at most
+ *                      @ref SAUL_DSP_FFT_LOG2_MAX
+ */
+void saul_dsp_fft(int16_t *re, int16_t *im, unsigned log2n);
+
+/**
+ * @brief   Computes the time domain features of a block
+ *
+ * Sets all features but saul_dsp_features_t::peak_bin and
+ * saul_dsp_features_t::peak_mag, which are set to 0.
+ *
+ * @param[in] block     samples
+ * @param[in] len       number of samples in @p block
+ * @param[out] features features of @p block
+ */
+void saul_dsp_features(const int16_t *block, size_t len,
+                       saul_dsp_features_t *features);
+
+/**
+ * @brief   Finds the dominant frequency of a block
+ *
+ * The DC component is ignored. The frequency of bin `i` is
+ * `i * sample_rate / (1 << log2n)`.
+ *
+ * @param[in,out] block samples, overwritten with the real parts of the
+ *                      spectrum
+ * @param[out] scratch  buffer for the imaginary parts, as large as @p block
+ * @param[in] log2n     binary logarithm of the number of samples
+ * @param[out] features saul_dsp_features_t::peak_bin and
+ *                      saul_dsp_features_t::peak_mag are set
+ */
+void saul_dsp_spectrum_peak(int16_t *block, int16_t *scratch, unsigned log2n,
+                            saul_dsp_features_t *features);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAUL_DSP_H */
+/** @} */
@@ -13,6 +13,15 @@
  *
  * @see @ref drivers_saul
  *
+ * Lookups use an index of the registry, sorted by position, by type and by
+ * name. It is rebuilt on the first lookup after the registry was changed with
+ * saul_reg_add() or saul_reg_rm(). Registries with more than
+ * @ref SAUL_REG_INDEX_SIZE entries are searched linearly.
+ *
+ * The index is protected by a mutex, so the lookup functions and
+ * saul_reg_add() and saul_reg_rm() may block and must not be called from
+ * interrupt context.
+ *
  * @{
  *
  * @file
@@ -24,6 +33,7 @@
 #ifndef SAUL_REG_H
 #define SAUL_REG_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "saul.h"
@@ -33,6 +43,20 @@
 extern "C" {
 #endif
 
+/**
+ * @brief   Maximum number of indexed registry entries
+ */
+#ifndef SAUL_REG_INDEX_SIZE
+#define SAUL_REG_INDEX_SIZE         (16U)
+#endif
+
+/**
+ * @brief   Maximum number of devices handed to a driver's read_multi()
+ */
+#ifndef SAUL_REG_BATCH_MAX
+#define SAUL_REG_BATCH_MAX          (8U)
+#endif
+
 /**
  * @brief   SAUL registry entry
  */
@@ -82,6 +106,8 @@ int saul_reg_rm(saul_reg_t *dev);
 /**
  * @brief   Find a device by it's position in the registry
  *
+ * @note    Must not be called from interrupt context, see @ref sys_saul_reg
+ *
  * @param[in] pos       position to look up
  *
  * @return      pointer to the device at position specified by @p pos
@@ -92,6 +118,8 @@ saul_reg_t *saul_reg_find_nth(int pos);
 /**
  * @brief   Find the first device of the given type in the registry
  *
+ * @note    Must not be called from interrupt context, see @ref sys_saul_reg
+ *
  * @param[in] type      device type to look for
  *
  * @return      pointer to the first device matching the given type
@@ -102,6 +130,8 @@ saul_reg_t *saul_reg_find_type(uint8_t type);
 /**
  * @brief   Find a device by its name
  *
+ * @note    Must not be called from interrupt context, see @ref sys_saul_reg
+ *
  * @param[in] name      the name to look for
  *
  * @return      pointer to the first device matching the given name
@@ -122,6 +152,25 @@ saul_reg_t *saul_reg_find_name(const char *name);
  */
 int saul_reg_read(saul_reg_t *dev, phydat_t *res);
 
+/**
+ * @brief   Read data from several devices
+ *
+ * Consecutive devices of a driver that implements saul_driver_t::read_multi
+ * are read with a single call to it, the others one by one.
+ * Devices read in such a batch may yield fresher values than saul_reg_read()
+ * and share a single error, see @ref saul_read_multi_t.
+ *
+ * @param[in] devs      devices to read from
+ * @param[out] res      location to store the results in, one per device
+ * @param[out] dims     the return value of saul_reg_read() for each device,
+ *                      may be NULL
+ * @param[in] num       number of devices
+ *
+ * @return      the number of devices read successfully
+ */
+int saul_reg_read_batch(saul_reg_t *const *devs, phydat_t *res, int *dims,
+                        size_t num);
+
 /**
  * @brief   Write data to the given device
  *
@@ -11,6 +11,33 @@
  * @ingroup     sys
  * @brief       Simple shell interpreter
  *
+ * shell_run() reads lines from stdio and blocks the calling thread. Its
+ * commands are looked up in a @ref shell_index_t, a sorted index of the given
+ * commands and the builtin shell commands, built once when the shell starts.
+ *
+ * A @ref shell_session_t assembles lines from input handed to
+ * shell_session_input() without blocking, so a single thread can serve
+ * several sessions, e.g. stdio, a UDP socket and a pipe, that share one
+ * index:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~ {.c}
+ * shell_index_init(&index, commands);
+ * shell_session_init(&udp_session, &index, udp_line, sizeof(udp_line),
+ *                    _udp_write, &remote);
+ * udp_session.flags = 0;
+ *
+ * while (1) {
+ *     ssize_t res = sock_udp_recv(&sock, buf, sizeof(buf), timeout, &remote);
+ *     if (res > 0) {
+ *         shell_session_input(&udp_session, buf, res);
+ *     }
+ *     ...
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Echo, prompts and the shell's own messages are written with the session's
+ * write function. Commands print to stdio, as they always do.
+ *
  * @{
  *
  * @file
@@ -20,6 +47,7 @@
 #ifndef SHELL_H
 #define SHELL_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "kernel_defines.h"
@@ -33,6 +61,23 @@ extern "C" {
  */
 #define SHELL_DEFAULT_BUFSIZE   (128)
 
+/**
+ * @brief Maximum number of commands in a @ref shell_index_t
+ *
+ * If there are more commands, they are looked up by a linear search.
+ */
+#ifndef SHELL_INDEX_SIZE
+#define SHELL_INDEX_SIZE        (64)
+#endif
+
+/**
+ * @name    Session flags
+ * @{
+ */
+#define SHELL_SESSION_ECHO      (0x01)  /**< echo the input */
+#define SHELL_SESSION_PROMPT    (0x02)  /**< print a prompt for every line */
+/** @} */
+
 /**
  * @brief           Protype of a shell callback handler.
  * @details         The functions supplied to shell_run() must use this signature.
@@ -63,6 +108,108 @@ typedef struct shell_command_t {
     shell_command_handler_t handler; /**< The callback function. */
 } shell_command_t;
 
+/**
+ * @brief           Index of the commands of a shell
+ *
+ * Holds the positions of the commands in the user supplied list, followed by
+ * the builtin ones, sorted by name.
+ */
+typedef struct {
+    const shell_command_t *commands;    /**< user supplied commands */
+    uint8_t user_numof;                 /**< number of user supplied commands */
+    uint8_t numof;                      /**< number of indexed commands,
+                                         *   0 to search linearly */
+    uint8_t order[SHELL_INDEX_SIZE];    /**< command positions by name */
+} shell_index_t;
+
+typedef struct shell_session shell_session_t;
+
+/**
+ * @brief           Writes output of a session
+ *
+ * @param[in]       session     the session
+ * @param[in]       buf         output
+ * @param[in]       len         number of bytes in @p buf
+ */
+typedef void (*shell_session_write_t)(shell_session_t *session,
+                                      const char *buf, size_t len);
+
+/**
+ * @brief           State of a shell session
+ */
+struct shell_session {
+    const shell_index_t *index;     /**< commands of the session */
+    shell_session_write_t write;    /**< output function, NULL for stdio */
+    void *arg;                      /**< argument for the output function */
+    char *line_buf;                 /**< buffer for the current line */
+    size_t size;                    /**< size of the line buffer */
+    size_t pos;                     /**< length of the current line */
+    uint8_t flags;                  /**< session flags, e.g.
+                                     *   @ref SHELL_SESSION_ECHO */
+};
+
+/**
+ * @brief           Builds the index of a command list and the builtin commands
+ *
+ * A user supplied command hides a builtin command of the same name.
+ *
+ * @param[out]      index       the index
+ * @param[in]       commands    NULL terminated command list, may be NULL.
+ *                              Must stay valid while @p index is used.
+ */
+void shell_index_init(shell_index_t *index, const shell_command_t *commands);
+
+/**
+ * @brief           Looks up a command by name
+ *
+ * @param[in]       index       the index
+ * @param[in]       name        name of the command
+ *
+ * @return          the command
+ * @return          NULL if there is no command @p name
+ */
+const shell_command_t *shell_index_find(const shell_index_t *index,
+                                        const char *name);
+
+/**
+ * @brief           Initializes a shell session
+ *
+ * Echo and prompt are enabled unless `SHELL_NO_ECHO` or `SHELL_NO_PROMPT`
+ * are defined. Change shell_session_t::flags to override this.
+ *
+ * @param[out]      session     the session
+ * @param[in]       index       commands of the session
+ * @param[in]       line_buf    buffer for the current line, longer lines are
+ *                              dropped
+ * @param[in]       len         nr of bytes that fit in line_buf
+ * @param[in]       write       output function, NULL for stdio
+ * @param[in]       arg         argument for @p write
+ */
+void shell_session_init(shell_session_t *session, const shell_index_t *index,
+                        char *line_buf, size_t len,
+                        shell_session_write_t write, void *arg);
+
+/**
+ * @brief           Prints the prompt of a session, if enabled
+ *
+ * @param[in]       session     the session
+ */
+void shell_session_prompt(shell_session_t *session);
+
+/**
+ * @brief           Hands input to a session
+ *
+ * Every complete line is handled before this function returns. The rest of
+ * the input is kept for the next call.
+ *
+ * @param[in]       session     the session
+ * @param[in]       buf         input
+ * @param[in]       len         number of bytes in @p buf
+ *
+ * @return          number of command lines handled
+ */
+int shell_session_input(shell_session_t *session, const char *buf, size_t len);
+
 /**
  * @brief           Start a shell.
  *
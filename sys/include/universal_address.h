@@ -124,6 +124,8 @@ uint8_t* universal_address_get_address(universal_address_container_t *entry,
  * @return UNIVERSAL_ADDRESS_IS_ALL_ZERO_ADDRESS if the entry address is all `0`s
  *                                               and considered as default route
  * @return -ENOENT if the given adresses do not match
+ *
+ * @note The caller must hold a reference on @p entry (see universal_address_add()).
  */
 int universal_address_compare(universal_address_container_t *entry,
                               uint8_t *addr, size_t *addr_size_in_bits);
@@ -146,6 +148,8 @@ int universal_address_compare(universal_address_container_t *entry,
 * @return UNIVERSAL_ADDRESS_MATCHING_PREFIX if the entry matches to a certain prefix
 *                                           (trailing '0's in @p prefix)
 * @return -ENOENT if the given adresses do not match
+*
+* @note The caller must hold a reference on @p entry (see universal_address_add()).
 */
 int universal_address_compare_prefix(universal_address_container_t *entry,
                             uint8_t *prefix, size_t prefix_size_in_bits);
@@ -158,6 +158,15 @@ extern "C" {
  */
 #define VFS_ANY_FD (-1)
 
+#ifndef VFS_POLL_THREAD_FLAG
+/**
+ * @brief Thread flag used by file drivers to wake up a thread in poll()
+ *
+ * @see vfs_file_ops::poll
+ */
+#define VFS_POLL_THREAD_FLAG (0x1 << 12)
+#endif
+
 /* Forward declarations */
 /**
  * @brief struct @c vfs_file_ops typedef
@@ -370,6 +379,30 @@ struct vfs_file_ops {
      * @return <0 on error
      */
     ssize_t (*write) (vfs_file_t *filp, const void *src, size_t nbytes);
+
+    /**
+     * @brief Query the readiness of an open file for poll()
+     *
+     * If none of the requested events is ready and @p waiter is not
+     * @c KERNEL_PID_UNDEF, the driver must remember @p waiter and set
+     * @ref VFS_POLL_THREAD_FLAG on it as soon as one of the events might
+     * have become ready. Several threads may poll the same file at once, so
+     * the driver must be able to remember all of them. A call with
+     * @p waiter set to @c KERNEL_PID_UNDEF cancels the registration of the
+     * calling thread.
+     *
+     * Drivers which do not implement this operation are considered to be
+     * always ready for reading and writing, like regular files.
+     *
+     * @param[in]  filp     pointer to open file
+     * @param[in]  events   requested events (@c POLLIN, @c POLLOUT)
+     * @param[in]  waiter   thread to notify, or @c KERNEL_PID_UNDEF
+     *
+     * @return the subset of @p events that is ready, possibly or'ed with
+     *         @c POLLERR or @c POLLHUP
+     * @return <0 on error
+     */
+    int (*poll) (vfs_file_t *filp, int events, kernel_pid_t waiter);
 };
 
 /**
@@ -584,6 +617,22 @@ int vfs_fcntl(int fd, int cmd, int arg);
  */
 int vfs_fstat(int fd, struct stat *buf);
 
+/**
+ * @brief Query the readiness of an open file
+ *
+ * @see vfs_file_ops::poll
+ *
+ * @param[in]  fd       fd number obtained from vfs_open
+ * @param[in]  events   requested events (@c POLLIN, @c POLLOUT)
+ * @param[in]  waiter   thread to notify with @ref VFS_POLL_THREAD_FLAG
+ *                      once an event might have become ready, or
+ *                      @c KERNEL_PID_UNDEF
+ *
+ * @return the subset of @p events that is ready
+ * @return <0 on error
+ */
+int vfs_poll(int fd, int events, kernel_pid_t waiter);
+
 /**
  * @brief Get file system status of the file system containing an open file
  *
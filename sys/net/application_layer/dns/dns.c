@@ -18,8 +18,11 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "mutex.h"
 #include "net/sock/udp.h"
 #include "net/sock/dns.h"
+#include "random.h"
+#include "xtimer.h"
 
 #ifdef RIOT_VERSION
 #include "byteorder.h"
@@ -28,6 +31,28 @@
 /* min domain name length is 1, so minimum record length is 7 */
 #define DNS_MIN_REPLY_LEN   (unsigned)(sizeof(sock_dns_hdr_t ) + 7)
 
+#define DNS_FLAG_QR         (0x8000)
+#define DNS_RCODE_MASK      (0x000f)
+#define DNS_RCODE_NXDOMAIN  (3)
+
+typedef struct {
+    char name[SOCK_DNS_MAX_NAME_LEN + 1];
+    uint8_t addr[16];
+    uint32_t expires;   /* in seconds */
+    uint16_t type;      /* 0 marks an unused entry */
+    uint8_t addrlen;    /* 0 marks a negative entry */
+} _cache_entry_t;
+
+typedef struct {
+    uint16_t type;
+    uint16_t id;
+    int res;            /* address length, error or 0 while pending */
+    uint8_t addr[16];
+} _query_t;
+
+static _cache_entry_t _cache[SOCK_DNS_CACHE_SIZE];
+static mutex_t _cache_lock = MUTEX_INIT;
+
 static ssize_t _enc_domain_name(uint8_t *out, const char *domain_name)
 {
     /*
@@ -70,121 +95,289 @@ static unsigned _get_short(uint8_t *buf)
     return _tmp;
 }
 
-static size_t _skip_hostname(uint8_t *buf)
+static uint32_t _get_long(uint8_t *buf)
+{
+    uint32_t _tmp;
+    memcpy(&_tmp, buf, 4);
+    return _tmp;
+}
+
+static size_t _skip_hostname(uint8_t *buf, uint8_t *end)
 {
     uint8_t *bufpos = buf;
 
-    /* handle DNS Message Compression */
-    if (*bufpos >= 192) {
-        return 2;
+    while (bufpos < end) {
+        /* handle DNS Message Compression */
+        if (*bufpos >= 192) {
+            return (bufpos - buf + 2);
+        }
+        if (*bufpos == 0) {
+            return (bufpos - buf + 1);
+        }
+        bufpos += *bufpos + 1;
     }
+    return 0;
+}
 
-    while(*bufpos) {
-        bufpos += *bufpos + 1;
+static uint32_t _now(void)
+{
+    return (uint32_t)(xtimer_now_usec64() / US_PER_SEC);
+}
+
+static _cache_entry_t *_cache_find(const char *name, uint16_t type,
+                                   uint32_t now)
+{
+    for (unsigned i = 0; i < SOCK_DNS_CACHE_SIZE; i++) {
+        _cache_entry_t *entry = &_cache[i];
+
+        if ((entry->type == type) && ((int32_t)(entry->expires - now) > 0) &&
+            (strcmp(entry->name, name) == 0)) {
+            return entry;
+        }
     }
-    return (bufpos - buf + 1);
+    return NULL;
 }
 
-static int _parse_dns_reply(uint8_t *buf, size_t len, void* addr_out, int family)
+static void _cache_get(const char *name, _query_t *q, uint32_t now)
 {
+    _cache_entry_t *entry = _cache_find(name, q->type, now);
+
+    if (entry) {
+        memcpy(q->addr, entry->addr, entry->addrlen);
+        q->res = (entry->addrlen) ? (int)entry->addrlen : -EHOSTUNREACH;
+    }
+}
+
+static void _cache_put(const char *name, const _query_t *q, uint32_t ttl,
+                       uint32_t now)
+{
+    _cache_entry_t *entry = &_cache[0];
+
+    /* replace unused or expired entries first, then the one expiring next */
+    for (unsigned i = 0; i < SOCK_DNS_CACHE_SIZE; i++) {
+        int32_t left = (int32_t)(_cache[i].expires - now);
+
+        if ((_cache[i].type == 0) || (left <= 0)) {
+            entry = &_cache[i];
+            break;
+        }
+        if (left < (int32_t)(entry->expires - now)) {
+            entry = &_cache[i];
+        }
+    }
+
+    strcpy(entry->name, name);
+    entry->type = q->type;
+    entry->expires = now + ttl;
+    entry->addrlen = (q->res > 0) ? q->res : 0;
+    memcpy(entry->addr, q->addr, entry->addrlen);
+}
+
+static ssize_t _send_query(sock_udp_t *sock, const char *domain_name,
+                           const _query_t *q)
+{
+    uint8_t buf[SOCK_DNS_QUERYBUF_LEN];
     sock_dns_hdr_t *hdr = (sock_dns_hdr_t*) buf;
     uint8_t *bufpos = buf + sizeof(*hdr);
 
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->id = q->id;
+    hdr->flags = htons(0x0120);
+    hdr->qdcount = htons(1);
+
+    bufpos += _enc_domain_name(bufpos, domain_name);
+    bufpos += _put_short(bufpos, htons(q->type));
+    bufpos += _put_short(bufpos, htons(DNS_CLASS_IN));
+
+    return sock_udp_send(sock, buf, (bufpos - buf), NULL);
+}
+
+/* fills in the result of @p q, returns the TTL to cache it for */
+static uint32_t _parse_dns_reply(uint8_t *buf, size_t len, _query_t *q)
+{
+    sock_dns_hdr_t *hdr = (sock_dns_hdr_t*) buf;
+    uint8_t *bufpos = buf + sizeof(*hdr);
+    uint8_t *end = buf + len;
+    unsigned rcode = ntohs(hdr->flags) & DNS_RCODE_MASK;
+    unsigned expected = (q->type == DNS_TYPE_A) ? 4 : 16;
+
+    if (rcode == DNS_RCODE_NXDOMAIN) {
+        q->res = -EHOSTUNREACH;
+        return SOCK_DNS_NEG_TTL;
+    }
+    if (rcode != 0) {
+        q->res = -EBADMSG;
+        return 0;
+    }
+
     /* skip all queries that are part of the reply */
     for (unsigned n = 0; n < ntohs(hdr->qdcount); n++) {
-        bufpos += _skip_hostname(bufpos);
-        bufpos += 4;    /* skip type and class of query */
+        size_t namelen = _skip_hostname(bufpos, end);
+        if (namelen == 0) {
+            q->res = -EBADMSG;
+            return 0;
+        }
+        bufpos += namelen + 4;  /* skip type and class of query */
     }
 
     for (unsigned n = 0; n < ntohs(hdr->ancount); n++) {
-        bufpos += _skip_hostname(bufpos);
+        size_t namelen = _skip_hostname(bufpos, end);
+        if ((namelen == 0) || ((bufpos + namelen + 10) > end)) {
+            q->res = -EBADMSG;
+            return 0;
+        }
+        bufpos += namelen;
         uint16_t _type = ntohs(_get_short(bufpos));
         bufpos += 2;
         uint16_t class = ntohs(_get_short(bufpos));
         bufpos += 2;
-        bufpos += 4; /* skip ttl */
+        uint32_t ttl = ntohl(_get_long(bufpos));
+        bufpos += 4;
 
         unsigned addrlen = ntohs(_get_short(bufpos));
         bufpos += 2;
-        if ((bufpos + addrlen) > (buf + len)) {
-            return -EBADMSG;
+        if ((bufpos + addrlen) > end) {
+            q->res = -EBADMSG;
+            return 0;
         }
 
-        /* skip unwanted answers */
-        if ((class != DNS_CLASS_IN) ||
-                ((_type == DNS_TYPE_A) && (family == AF_INET6)) ||
-                ((_type == DNS_TYPE_AAAA) && (family == AF_INET)) ||
-                ! ((_type == DNS_TYPE_A) || ((_type == DNS_TYPE_AAAA))
-                    )) {
+        /* skip unwanted answers, e.g. CNAME records */
+        if ((class != DNS_CLASS_IN) || (_type != q->type) ||
+            (addrlen != expected)) {
             bufpos += addrlen;
             continue;
         }
 
-        memcpy(addr_out, bufpos, addrlen);
-        return addrlen;
+        memcpy(q->addr, bufpos, addrlen);
+        q->res = addrlen;
+        return ttl;
     }
 
-    return -1;
+    /* the name exists, but has no record of the requested type */
+    q->res = -EHOSTUNREACH;
+    return SOCK_DNS_NEG_TTL;
+}
+
+/* returns 0 as long as a preferred query is pending */
+static int _result(_query_t *queries, unsigned num, void *addr_out)
+{
+    for (unsigned i = 0; i < num; i++) {
+        if (queries[i].res == 0) {
+            return 0;
+        }
+        if (queries[i].res > 0) {
+            memcpy(addr_out, queries[i].addr, queries[i].res);
+            return queries[i].res;
+        }
+    }
+    return queries[0].res;
+}
+
+static void _handle_reply(const char *domain_name, _query_t *queries,
+                          unsigned num, uint8_t *buf, size_t len)
+{
+    sock_dns_hdr_t *hdr = (sock_dns_hdr_t*) buf;
+
+    if ((len < DNS_MIN_REPLY_LEN) || !(ntohs(hdr->flags) & DNS_FLAG_QR)) {
+        return;
+    }
+    for (unsigned i = 0; i < num; i++) {
+        _query_t *q = &queries[i];
+
+        if ((q->res == 0) && (q->id == hdr->id)) {
+            uint32_t ttl = _parse_dns_reply(buf, len, q);
+
+            if (ttl > 0) {
+                if ((q->res < 0) && (ttl > SOCK_DNS_NEG_TTL)) {
+                    ttl = SOCK_DNS_NEG_TTL;
+                }
+                mutex_lock(&_cache_lock);
+                _cache_put(domain_name, q, ttl, _now());
+                mutex_unlock(&_cache_lock);
+            }
+            return;
+        }
+    }
 }
 
 int sock_dns_query(const char *domain_name, void *addr_out, int family)
 {
-    uint8_t buf[SOCK_DNS_QUERYBUF_LEN];
     uint8_t reply_buf[512];
+    _query_t queries[2];
+    unsigned num = 0;
+    int res;
 
     if (strlen(domain_name) > SOCK_DNS_MAX_NAME_LEN) {
         return -ENOSPC;
     }
 
-    sock_dns_hdr_t *hdr = (sock_dns_hdr_t*) buf;
-    memset(hdr, 0, sizeof(*hdr));
-    hdr->id = 0; /* random? */
-    hdr->flags = htons(0x0120);
-    hdr->qdcount = htons(1 + (family == AF_UNSPEC));
-
-    uint8_t *bufpos = buf + sizeof(*hdr);
-
-    unsigned _name_ptr;
+    memset(queries, 0, sizeof(queries));
+    /* ordered by preference */
     if ((family == AF_INET6) || (family == AF_UNSPEC)) {
-        _name_ptr = (bufpos - buf);
-        bufpos += _enc_domain_name(bufpos, domain_name);
-        bufpos += _put_short(bufpos, htons(DNS_TYPE_AAAA));
-        bufpos += _put_short(bufpos, htons(DNS_CLASS_IN));
+        queries[num++].type = DNS_TYPE_AAAA;
     }
-
     if ((family == AF_INET) || (family == AF_UNSPEC)) {
-        if (family == AF_UNSPEC) {
-            bufpos += _put_short(bufpos, htons((0xc000) | (_name_ptr)));
-        }
-        else {
-            bufpos += _enc_domain_name(bufpos, domain_name);
-        }
-        bufpos += _put_short(bufpos, htons(DNS_TYPE_A));
-        bufpos += _put_short(bufpos, htons(DNS_CLASS_IN));
+        queries[num++].type = DNS_TYPE_A;
+    }
+
+    mutex_lock(&_cache_lock);
+    uint32_t now = _now();
+    for (unsigned i = 0; i < num; i++) {
+        _cache_get(domain_name, &queries[i], now);
+    }
+    mutex_unlock(&_cache_lock);
+
+    if ((res = _result(queries, num, addr_out)) != 0) {
+        return res;
     }
 
     sock_udp_t sock_dns;
 
-    ssize_t res = sock_udp_create(&sock_dns, NULL, &sock_dns_server, 0);
+    res = sock_udp_create(&sock_dns, NULL, &sock_dns_server, 0);
     if (res) {
-            puts("a");
-        goto out;
+        return res;
+    }
+
+    for (unsigned i = 0; i < num; i++) {
+        queries[i].id = (uint16_t)random_uint32();
     }
 
     for (int i = 0; i < SOCK_DNS_RETRIES; i++) {
-        res = sock_udp_send(&sock_dns, buf, (bufpos-buf), NULL);
-        if (res <= 0) {
-            continue;
+        /* issue all missing queries at once */
+        for (unsigned n = 0; n < num; n++) {
+            if (queries[n].res == 0) {
+                _send_query(&sock_dns, domain_name, &queries[n]);
+            }
         }
-        res = sock_udp_recv(&sock_dns, reply_buf, sizeof(reply_buf), 1000000LU, NULL);
-        if ((res > 0) && (res > (int)DNS_MIN_REPLY_LEN)) {
-            if ((res = _parse_dns_reply(reply_buf, res, addr_out, family)) > 0) {
+
+        uint32_t start = xtimer_now_usec();
+        uint32_t waited = 0;
+        do {
+            ssize_t len = sock_udp_recv(&sock_dns, reply_buf, sizeof(reply_buf),
+                                        SOCK_DNS_TIMEOUT - waited, NULL);
+            if (len < 0) {
+                res = len;
+                break;
+            }
+            _handle_reply(domain_name, queries, num, reply_buf, len);
+            if ((res = _result(queries, num, addr_out)) != 0) {
                 goto out;
             }
-        }
+            waited = xtimer_now_usec() - start;
+        } while (waited < SOCK_DNS_TIMEOUT);
+    }
+    if (res == 0) {
+        res = -ETIMEDOUT;
     }
 
 out:
     sock_udp_close(&sock_dns);
     return res;
 }
+
+void sock_dns_cache_flush(void)
+{
+    mutex_lock(&_cache_lock);
+    memset(_cache, 0, sizeof(_cache));
+    mutex_unlock(&_cache_lock);
+}
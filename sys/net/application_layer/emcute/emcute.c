@@ -20,9 +20,11 @@
 
 #include <string.h>
 
+#include "irq.h"
 #include "log.h"
 #include "mutex.h"
 #include "sched.h"
+#include "sema.h"
 #include "xtimer.h"
 #include "thread_flags.h"
 
@@ -59,6 +61,28 @@ static volatile uint8_t waiton = 0xff;
 static volatile uint16_t waitonid = 0;
 static volatile int result;
 
+/**
+ * @brief   QoS 1 message waiting for its PUBACK
+ */
+typedef struct {
+    const void *data;           /**< published data, NULL if slot is unused */
+    emcute_pub_cb_t cb;         /**< called when done */
+    void *arg;                  /**< argument for cb */
+    uint32_t deadline;          /**< time of the next retransmission */
+    uint16_t len;               /**< length of data */
+    uint16_t tid;               /**< topic ID */
+    uint16_t mid;               /**< message ID */
+    uint8_t flags;              /**< publish flags */
+    uint8_t sent;               /**< number of transmissions */
+} inflight_t;
+
+/* the in-flight window and pbuf are guarded by winlock, never txlock: the
+ * emCute thread handles retransmissions while user threads hold txlock */
+static inflight_t window[EMCUTE_WINDOW];
+static mutex_t winlock = MUTEX_INIT;
+static sema_t winsema = SEMA_CREATE(EMCUTE_WINDOW);
+static uint8_t pbuf[EMCUTE_BUFSIZE];
+
 static inline uint16_t get_u16(const uint8_t *buf)
 {
 #if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
@@ -87,7 +111,7 @@ static size_t set_len(uint8_t *buf, size_t len)
     }
     else {
         buf[0] = 0x01;
-        set_u16(&tbuf[1], (uint16_t)(len + 3));
+        set_u16(&buf[1], (uint16_t)(len + 3));
         return 3;
     }
 }
@@ -104,6 +128,28 @@ static size_t get_len(uint8_t *buf, uint16_t *len)
     }
 }
 
+static uint16_t next_id(void)
+{
+    unsigned state = irq_disable();
+    uint16_t id = id_next++;
+    irq_restore(state);
+    return id;
+}
+
+static size_t build_pub(uint8_t *buf, uint16_t tid, uint16_t mid,
+                        const void *data, size_t len, unsigned flags)
+{
+    size_t pos = set_len(buf, (len + 6));
+    buf[pos++] = PUBLISH;
+    buf[pos++] = flags;
+    set_u16(&buf[pos], tid);
+    pos += 2;
+    set_u16(&buf[pos], mid);
+    pos += 2;
+    memcpy(&buf[pos], data, len);
+    return (pos + len);
+}
+
 static void time_evt(void *arg)
 {
     thread_flags_set((thread_t *)arg, TFLAGS_TIMEOUT);
@@ -165,6 +211,81 @@ static void on_ack(uint8_t type, int id_pos, int ret_pos, int res_pos)
     }
 }
 
+/* frees an in-flight slot and reports the result, called with winlock held */
+static void pub_done(inflight_t *msg, int res)
+{
+    emcute_pub_cb_t cb = msg->cb;
+    void *arg = msg->arg;
+
+    msg->data = NULL;
+    mutex_unlock(&winlock);
+    sema_post(&winsema);
+    if (cb) {
+        cb(res, arg);
+    }
+    mutex_lock(&winlock);
+}
+
+static void on_puback(void)
+{
+    uint16_t mid = get_u16(&rbuf[4]);
+
+    mutex_lock(&winlock);
+    for (unsigned i = 0; i < EMCUTE_WINDOW; i++) {
+        if (window[i].data && (window[i].mid == mid)) {
+            DEBUG("[emcute] on puback: message %u done\n", (unsigned)mid);
+            pub_done(&window[i],
+                     (rbuf[6] == ACCEPT) ? EMCUTE_OK : EMCUTE_REJECT);
+            mutex_unlock(&winlock);
+            return;
+        }
+    }
+    mutex_unlock(&winlock);
+
+    on_ack(PUBACK, 4, 6, 0);
+}
+
+/* retransmits overdue in-flight messages, returns the time until the next
+ * retransmission is due */
+static uint32_t check_window(uint32_t now)
+{
+    uint32_t next = (EMCUTE_T_RETRY * US_PER_SEC);
+
+    mutex_lock(&winlock);
+    for (unsigned i = 0; i < EMCUTE_WINDOW; i++) {
+        inflight_t *msg = &window[i];
+        int32_t left = (int32_t)(msg->deadline - now);
+
+        if (!msg->data) {
+            continue;
+        }
+        if (gateway.port == 0) {
+            pub_done(msg, EMCUTE_NOGW);
+            continue;
+        }
+        if (left <= 0) {
+            if (msg->sent >= EMCUTE_N_RETRY) {
+                DEBUG("[emcute] message %u timed out\n", (unsigned)msg->mid);
+                pub_done(msg, EMCUTE_TIMEOUT);
+                continue;
+            }
+            DEBUG("[emcute] retransmitting message %u\n", (unsigned)msg->mid);
+            size_t len = build_pub(pbuf, msg->tid, msg->mid, msg->data,
+                                   msg->len, msg->flags | EMCUTE_DUP);
+            sock_udp_send(&sock, pbuf, len, &gateway);
+            msg->sent++;
+            msg->deadline = now + (EMCUTE_T_RETRY * US_PER_SEC);
+            left = (EMCUTE_T_RETRY * US_PER_SEC);
+        }
+        if ((uint32_t)left < next) {
+            next = (uint32_t)left;
+        }
+    }
+    mutex_unlock(&winlock);
+
+    return next;
+}
+
 static void on_publish(size_t len, size_t pos)
 {
     /* make sure packet length is valid - if not, drop packet silently */
@@ -345,8 +466,6 @@ int emcute_reg(emcute_topic_t *topic)
 int emcute_pub(emcute_topic_t *topic, const void *data, size_t len,
                unsigned flags)
 {
-    int res = EMCUTE_OK;
-
     assert((topic->id != 0) && data && (len > 0) && !(flags & ~PUB_FLAGS));
 
     if (gateway.port == 0) {
@@ -359,28 +478,80 @@ int emcute_pub(emcute_topic_t *topic, const void *data, size_t len,
         return EMCUTE_NOTSUP;
     }
 
+    if (!(flags & EMCUTE_QOS_1)) {
+        emcute_msg_t msg = { .topic = topic, .data = data, .len = len };
+        return emcute_pub_batch(&msg, 1, flags);
+    }
+
     mutex_lock(&txlock);
 
-    size_t pos = set_len(tbuf, (len + 6));
-    len += (pos + 6);
-    tbuf[pos++] = PUBLISH;
-    tbuf[pos++] = flags;
-    set_u16(&tbuf[pos], topic->id);
-    pos += 2;
-    set_u16(&tbuf[pos], id_next);
-    waitonid = id_next++;
-    pos += 2;
-    memcpy(&tbuf[pos], data, len);
+    waitonid = next_id();
+    len = build_pub(tbuf, topic->id, waitonid, data, len, flags);
+
+    return syncsend(PUBACK, len, true);
+}
+
+int emcute_pub_async(emcute_topic_t *topic, const void *data, size_t len,
+                     unsigned flags, emcute_pub_cb_t cb, void *arg)
+{
+    assert((topic->id != 0) && data && (len > 0) && !(flags & ~PUB_FLAGS) &&
+           ((flags & EMCUTE_QOS_MASK) == EMCUTE_QOS_1));
 
-    if (flags & EMCUTE_QOS_1) {
-        res = syncsend(PUBACK, len, true);
+    if (gateway.port == 0) {
+        return EMCUTE_NOGW;
     }
-    else {
-        sock_udp_send(&sock, tbuf, len, &gateway);
-        mutex_unlock(&txlock);
+    if (len >= (EMCUTE_BUFSIZE - 9)) {
+        return EMCUTE_OVERFLOW;
     }
 
-    return res;
+    /* wait for a free slot in the window */
+    sema_wait(&winsema);
+    mutex_lock(&winlock);
+
+    inflight_t *msg = window;
+    while (msg->data) {
+        msg++;
+    }
+    msg->data = data;
+    msg->cb = cb;
+    msg->arg = arg;
+    msg->len = (uint16_t)len;
+    msg->tid = topic->id;
+    msg->mid = next_id();
+    msg->flags = (uint8_t)flags;
+    msg->sent = 1;
+    msg->deadline = xtimer_now_usec() + (EMCUTE_T_RETRY * US_PER_SEC);
+
+    len = build_pub(pbuf, msg->tid, msg->mid, data, len, flags);
+    sock_udp_send(&sock, pbuf, len, &gateway);
+
+    mutex_unlock(&winlock);
+    return EMCUTE_OK;
+}
+
+int emcute_pub_batch(const emcute_msg_t *msgs, size_t num, unsigned flags)
+{
+    assert(msgs && !(flags & ~EMCUTE_RETAIN));
+
+    if (gateway.port == 0) {
+        return EMCUTE_NOGW;
+    }
+    for (size_t i = 0; i < num; i++) {
+        assert((msgs[i].topic->id != 0) && msgs[i].data && (msgs[i].len > 0));
+        if (msgs[i].len >= (EMCUTE_BUFSIZE - 9)) {
+            return EMCUTE_OVERFLOW;
+        }
+    }
+
+    mutex_lock(&winlock);
+    for (size_t i = 0; i < num; i++) {
+        size_t len = build_pub(pbuf, msgs[i].topic->id, 0, msgs[i].data,
+                               msgs[i].len, flags);
+        sock_udp_send(&sock, pbuf, len, &gateway);
+    }
+    mutex_unlock(&winlock);
+
+    return EMCUTE_OK;
 }
 
 int emcute_sub(emcute_sub_t *sub, unsigned flags)
@@ -556,7 +727,7 @@ void emcute_run(uint16_t port, const char *id)
                 case WILLMSGREQ:    on_ack(type, 0, 0, 0);              break;
                 case REGACK:        on_ack(type, 4, 6, 2);              break;
                 case PUBLISH:       on_publish((size_t)pkt_len, pos);   break;
-                case PUBACK:        on_ack(type, 4, 6, 0);              break;
+                case PUBACK:        on_puback();                        break;
                 case SUBACK:        on_ack(type, 5, 7, 3);              break;
                 case UNSUBACK:      on_ack(type, 2, 0, 0);              break;
                 case PINGREQ:       on_pingreq(&remote);                break;
@@ -579,5 +750,11 @@ void emcute_run(uint16_t port, const char *id)
         else {
             t_out = (EMCUTE_KEEPALIVE * US_PER_SEC) - (now - start);
         }
+
+        /* wake up for the next retransmission */
+        uint32_t t_retry = check_window(now);
+        if (t_retry < t_out) {
+            t_out = t_retry;
+        }
     }
 }
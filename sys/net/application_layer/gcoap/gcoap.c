@@ -513,11 +513,22 @@ static ssize_t _write_options(coap_pkt_t *pdu, uint8_t *buf, size_t len)
     }
 
     /* Uri-query for requests */
-    if (coap_get_code_class(pdu) == COAP_CLASS_REQ) {
+    if ((coap_get_code_class(pdu) == COAP_CLASS_REQ) && pdu->qs[0]) {
         bufpos += coap_put_option_uri(bufpos, last_optnum, (char *)pdu->qs,
                                       COAP_OPT_URI_QUERY);
-        /* uncomment when further options are added below ... */
-        /* last_optnum = COAP_OPT_URI_QUERY; */
+        last_optnum = COAP_OPT_URI_QUERY;
+    }
+
+    /* Block2 and Block1 for block-wise transfers */
+    coap_block_t block;
+    if (coap_get_block2(pdu, &block)) {
+        bufpos += coap_put_option_block(bufpos, last_optnum, COAP_OPT_BLOCK2,
+                                        &block);
+        last_optnum = COAP_OPT_BLOCK2;
+    }
+    if (coap_get_block1(pdu, &block)) {
+        bufpos += coap_put_option_block(bufpos, last_optnum, COAP_OPT_BLOCK1,
+                                        &block);
     }
 
     /* write payload marker */
@@ -705,6 +716,8 @@ int gcoap_req_init(coap_pkt_t *pdu, uint8_t *buf, size_t len, unsigned code,
          * length in the buffer. Allows us to reconstruct buffer length later. */
         pdu->payload_len  = len - (pdu->payload - buf);
         pdu->content_type = COAP_FORMAT_NONE;
+        pdu->block1       = COAP_BLOCK_NONE;
+        pdu->block2       = COAP_BLOCK_NONE;
 
         memcpy(&pdu->url[0], path, strlen(path));
         return 0;
@@ -855,10 +868,67 @@ int gcoap_resp_init(coap_pkt_t *pdu, uint8_t *buf, size_t len, unsigned code)
      * length in the buffer. Allows us to reconstruct buffer length later. */
     pdu->payload_len  = len - (pdu->payload - buf);
     pdu->content_type = COAP_FORMAT_NONE;
+    /* options of the request must not show up in the response */
+    pdu->block1       = COAP_BLOCK_NONE;
+    pdu->block2       = COAP_BLOCK_NONE;
 
     return 0;
 }
 
+ssize_t gcoap_resp_block2(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                          unsigned format, coap_block_read_t read, void *arg)
+{
+    coap_block_t block = { .num = 0, .szx = NANOCOAP_BLOCK_SZX_MAX };
+
+    coap_get_block2(pdu, &block);
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    if (pdu->payload_len < coap_szx2size(0) + 1) {
+        return -ENOSPC;
+    }
+
+    /* one more byte tells whether more blocks follow */
+    unsigned szx = coap_size2szx(pdu->payload_len - 1);
+    if (block.szx > szx) {
+        /* the offset stays the same with smaller blocks */
+        block.num <<= (block.szx - szx);
+        block.szx = szx;
+    }
+
+    size_t size = coap_szx2size(block.szx);
+    ssize_t res = read(arg, block.num * size, pdu->payload, size + 1);
+    if ((res < 0) || ((res == 0) && (block.num > 0))) {
+        coap_hdr_set_code(pdu->hdr, (res < 0) ? COAP_CODE_INTERNAL_SERVER_ERROR
+                                              : COAP_CODE_BAD_OPTION);
+        return gcoap_finish(pdu, 0, COAP_FORMAT_NONE);
+    }
+    block.more = ((size_t)res > size);
+    pdu->block2 = coap_block_encode(&block);
+
+    return gcoap_finish(pdu, block.more ? size : (size_t)res, format);
+}
+
+ssize_t gcoap_resp_block1(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                          coap_block_write_t write, void *arg)
+{
+    coap_block_t block = { .num = 0, .szx = 0, .more = false };
+    bool blockwise = coap_get_block1(pdu, &block);
+    size_t size = coap_szx2size(block.szx);
+    int res = -EINVAL;
+
+    /* only the last block may be shorter */
+    if (!block.more || (pdu->payload_len == size)) {
+        res = write(arg, block.num * size, pdu->payload, pdu->payload_len,
+                    block.more);
+    }
+
+    gcoap_resp_init(pdu, buf, len, coap_block1_code(res, block.more));
+    if (blockwise) {
+        pdu->block1 = coap_block_encode(&block);
+    }
+
+    return gcoap_finish(pdu, 0, COAP_FORMAT_NONE);
+}
+
 int gcoap_obs_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
                                                   const coap_resource_t *resource)
 {
@@ -885,6 +955,8 @@ int gcoap_obs_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
          * length in the buffer. Allows us to reconstruct buffer length later. */
         pdu->payload_len   = len - (pdu->payload - buf);
         pdu->content_type  = COAP_FORMAT_NONE;
+        pdu->block1        = COAP_BLOCK_NONE;
+        pdu->block2        = COAP_BLOCK_NONE;
 
         return GCOAP_OBS_INIT_OK;
     }
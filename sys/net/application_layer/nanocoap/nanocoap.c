@@ -57,6 +57,8 @@ int coap_parse(coap_pkt_t *pkt, uint8_t *buf, size_t len)
     memset(pkt->url, '\0', NANOCOAP_URL_MAX);
     pkt->payload_len = 0;
     pkt->observe_value = UINT32_MAX;
+    pkt->block1 = COAP_BLOCK_NONE;
+    pkt->block2 = COAP_BLOCK_NONE;
 
     /* token value (tkl bytes) */
     if (coap_get_token_len(pkt)) {
@@ -121,6 +123,26 @@ int coap_parse(coap_pkt_t *pkt, uint8_t *buf, size_t len)
                         return -EBADMSG;
                     }
                     break;
+                case COAP_OPT_BLOCK1:
+                case COAP_OPT_BLOCK2: {
+                    uint32_t value;
+                    if (option_len > 3) {
+                        DEBUG("nanocoap: discarding packet with invalid option length.\n");
+                        return -EBADMSG;
+                    }
+                    value = _decode_uint(pkt_pos, option_len);
+                    if ((value & 0x7) == 7) {
+                        DEBUG("nanocoap: discarding packet with reserved block size.\n");
+                        return -EBADMSG;
+                    }
+                    if (option_nr == COAP_OPT_BLOCK1) {
+                        pkt->block1 = value;
+                    }
+                    else {
+                        pkt->block2 = value;
+                    }
+                    break;
+                }
                 default:
                     DEBUG("nanocoap: unhandled option nr=%i len=%i critical=%u\n", option_nr, option_len, option_nr & 1);
                     if (option_nr & 1) {
@@ -154,6 +176,21 @@ ssize_t coap_handle_req(coap_pkt_t *pkt, uint8_t *resp_buf, unsigned resp_buf_le
 
     unsigned method_flag = coap_method2flag(coap_get_code_detail(pkt));
 
+#ifdef MODULE_NANOCOAP_RESOURCES
+    int first = coap_resource_find((char *)pkt->url);
+    if (first >= 0) {
+        const char *path = coap_resources[first].path;
+
+        for (unsigned i = first; (i < coap_resources_numof) &&
+             (strcmp(coap_resources[i].path, path) == 0); i++) {
+            if (coap_resources[i].methods & method_flag) {
+                return coap_resources[i].handler(pkt, resp_buf, resp_buf_len);
+            }
+        }
+        return coap_build_reply(pkt, COAP_CODE_METHOD_NOT_ALLOWED, resp_buf,
+                                resp_buf_len, 0);
+    }
+#else
     for (unsigned i = 0; i < coap_resources_numof; i++) {
         if (!(coap_resources[i].methods & method_flag)) {
             continue;
@@ -170,10 +207,110 @@ ssize_t coap_handle_req(coap_pkt_t *pkt, uint8_t *resp_buf, unsigned resp_buf_le
             return coap_resources[i].handler(pkt, resp_buf, resp_buf_len);
         }
     }
+#endif
 
     return coap_build_reply(pkt, COAP_CODE_404, resp_buf, resp_buf_len, 0);
 }
 
+ssize_t coap_block2_reply(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                          unsigned ct, coap_block_read_t read, void *arg)
+{
+    coap_block_t block = { .num = 0, .szx = NANOCOAP_BLOCK_SZX_MAX };
+    uint8_t *opt = buf + coap_get_total_hdr_len(pkt);
+    /* room for Content-Format, Block2 and payload marker */
+    uint8_t *data = opt + 8;
+
+    if ((data + coap_szx2size(0) + 1) > (buf + len)) {
+        return -ENOSPC;
+    }
+
+    coap_get_block2(pkt, &block);
+    /* one more byte tells whether more blocks follow */
+    unsigned szx = coap_size2szx(buf + len - data - 1);
+    if (block.szx > szx) {
+        /* the offset stays the same with smaller blocks */
+        block.num <<= (block.szx - szx);
+        block.szx = szx;
+    }
+
+    size_t size = coap_szx2size(block.szx);
+    ssize_t n = read(arg, block.num * size, data, size + 1);
+    if (n < 0) {
+        return coap_build_reply(pkt, COAP_CODE_INTERNAL_SERVER_ERROR, buf, len, 0);
+    }
+    if ((n == 0) && (block.num > 0)) {
+        /* beyond the end of the resource */
+        return coap_build_reply(pkt, COAP_CODE_BAD_OPTION, buf, len, 0);
+    }
+    block.more = ((size_t)n > size);
+    if (block.more) {
+        n = size;
+    }
+
+    uint8_t *bufpos = opt;
+    bufpos += coap_put_option_ct(bufpos, 0, ct);
+    bufpos += coap_put_option_block(bufpos, COAP_OPT_CONTENT_FORMAT,
+                                    COAP_OPT_BLOCK2, &block);
+    if (n) {
+        *bufpos++ = 0xff;
+        memmove(bufpos, data, n);
+        bufpos += n;
+    }
+
+    return coap_build_reply(pkt, COAP_CODE_CONTENT, buf, len, bufpos - opt);
+}
+
+unsigned coap_block1_code(int res, bool more)
+{
+    switch (res) {
+        case 0:
+            return more ? COAP_CODE_CONTINUE : COAP_CODE_CHANGED;
+        case -EINVAL:
+            return COAP_CODE_REQUEST_ENTITY_INCOMPLETE;
+        case -EFBIG:
+            return COAP_CODE_REQUEST_ENTITY_TOO_LARGE;
+        default:
+            return COAP_CODE_INTERNAL_SERVER_ERROR;
+    }
+}
+
+ssize_t coap_block1_reply(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                          coap_block_write_t write, void *arg)
+{
+    coap_block_t block = { .num = 0, .szx = 0, .more = false };
+    bool blockwise = coap_get_block1(pkt, &block);
+    size_t size = coap_szx2size(block.szx);
+    int res;
+
+    if (block.more && (pkt->payload_len != size)) {
+        /* only the last block may be shorter */
+        res = -EINVAL;
+    }
+    else {
+        /* consume the payload before the reply overwrites it */
+        res = write(arg, block.num * size, pkt->payload, pkt->payload_len,
+                    block.more);
+    }
+
+    uint8_t *opt = buf + coap_get_total_hdr_len(pkt);
+    uint8_t *bufpos = opt;
+
+    if (blockwise) {
+        /* ask for smaller blocks if larger ones would not fit */
+        size_t hdr_len = pkt->payload - (uint8_t *)pkt->hdr;
+        if (len >= hdr_len + coap_szx2size(0)) {
+            unsigned szx = coap_size2szx(len - hdr_len);
+            if (block.szx > szx) {
+                block.szx = szx;
+            }
+        }
+        bufpos += coap_put_option_block(bufpos, 0, COAP_OPT_BLOCK1, &block);
+    }
+
+    return coap_build_reply(pkt, coap_block1_code(res, block.more), buf, len,
+                            bufpos - opt);
+}
+
 ssize_t coap_reply_simple(coap_pkt_t *pkt,
                           unsigned code,
                           uint8_t *buf, size_t len,
@@ -345,6 +482,21 @@ size_t coap_put_option_ct(uint8_t *buf, uint16_t lastonum, uint16_t content_type
     }
 }
 
+size_t coap_put_option_block(uint8_t *buf, uint16_t lastonum, uint16_t onum,
+                             const coap_block_t *block)
+{
+    uint32_t value = htonl(coap_block_encode(block));
+    uint8_t *pos = (uint8_t *)&value;
+    unsigned len = sizeof(value);
+
+    /* use the shortest encoding */
+    while (len && (*pos == 0)) {
+        pos++;
+        len--;
+    }
+    return coap_put_option(buf, lastonum, onum, pos, len);
+}
+
 size_t coap_put_option_uri(uint8_t *buf, uint16_t lastonum, const char *uri, uint16_t optnum)
 {
     char separator = (optnum == COAP_OPT_URI_PATH) ? '/' : '&';
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_net_nanocoap
+ * @{
+ *
+ * @file
+ * @brief       Constant time resource lookup
+ *
+ * The hash functions must match the ones in
+ * dist/tools/nanocoap/gen_resources.py.
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "net/nanocoap.h"
+
+static uint32_t _mix(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+int coap_resource_find(const char *path)
+{
+    const coap_resource_index_t *idx = &coap_resource_index;
+    uint32_t h1 = 2166136261U;  /* FNV-1a */
+    uint32_t h2 = 5381;         /* djb2 */
+
+    for (const char *c = path; *c; c++) {
+        h1 = (h1 ^ (uint8_t)*c) * 16777619U;
+        h2 = (h2 * 33) ^ (uint8_t)*c;
+    }
+
+    uint16_t disp = idx->disp[h1 % idx->buckets];
+    unsigned first = idx->first[_mix(h2 + disp) % idx->slots];
+
+    if (strcmp(coap_resources[first].path, path) != 0) {
+        return -1;
+    }
+    return first;
+}
@@ -19,15 +19,53 @@
  */
 
 #include <errno.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdio.h>
 
+#include "mbox.h"
+#include "mutex.h"
 #include "net/nanocoap.h"
+#include "net/nanocoap_sock.h"
 #include "net/sock/udp.h"
+#include "thread.h"
+#include "xtimer.h"
 
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
+#define DEDUP_UNUSED    (0)
+#define DEDUP_PENDING   (1)
+#define DEDUP_DONE      (2)
+
+#if NANOCOAP_DEDUP_SIZE
+typedef struct {
+    sock_udp_ep_t remote;
+    uint32_t expires;       /* in seconds */
+    uint16_t id;
+    uint16_t len;           /* 0 if the response was not cached */
+    uint8_t state;
+    uint8_t resp[NANOCOAP_DEDUP_RESP_MAX];
+} _dedup_t;
+
+static _dedup_t _dedup[NANOCOAP_DEDUP_SIZE];
+static mutex_t _dedup_lock = MUTEX_INIT;
+#endif
+
+typedef struct {
+    sock_udp_ep_t remote;
+    size_t len;
+    uint8_t buf[NANOCOAP_SERVER_BUFSIZE];
+} _req_t;
+
+static char _stacks[NANOCOAP_SERVER_WORKERS][NANOCOAP_SERVER_STACKSIZE];
+static _req_t _reqs[NANOCOAP_SERVER_QUEUE_SIZE];
+static msg_t _queue_msgs[NANOCOAP_SERVER_QUEUE_SIZE];
+static msg_t _free_msgs[NANOCOAP_SERVER_QUEUE_SIZE];
+static mbox_t _queue;   /* received requests */
+static mbox_t _free;    /* unused request buffers */
+static sock_udp_t _sock;
+
 ssize_t nanocoap_get(sock_udp_ep_t *remote, const char *path, uint8_t *buf, size_t len)
 {
     ssize_t res;
@@ -101,6 +139,451 @@ out:
     return res;
 }
 
+/* space for header, Content-Format or Uri-Path, block option and payload
+ * marker next to a block */
+#define BLOCK_OVERHEAD      (16U)
+
+typedef struct {
+    uint32_t num;
+    uint32_t deadline;      /* in microseconds */
+    uint32_t timeout;
+    uint16_t id;
+    uint8_t tries;          /* 0 if the slot is unused */
+} _block_slot_t;
+
+static size_t _build_block_req(uint8_t *buf, unsigned code, uint16_t id,
+                               const char *path, uint16_t onum,
+                               const coap_block_t *block)
+{
+    uint8_t *pktpos = buf;
+
+    pktpos += coap_build_hdr((coap_hdr_t *)pktpos, COAP_REQ, NULL, 0, code, id);
+    pktpos += coap_put_option_uri(pktpos, 0, path, COAP_OPT_URI_PATH);
+    pktpos += coap_put_option_block(pktpos, COAP_OPT_URI_PATH, onum, block);
+
+    return pktpos - buf;
+}
+
+static ssize_t _send_block2_req(sock_udp_t *sock, uint8_t *buf,
+                                const char *path, _block_slot_t *slot,
+                                unsigned szx)
+{
+    coap_block_t block = { .num = slot->num, .szx = szx, .more = false };
+    size_t len = _build_block_req(buf, COAP_METHOD_GET, slot->id, path,
+                                  COAP_OPT_BLOCK2, &block);
+
+    slot->tries++;
+    slot->deadline = xtimer_now_usec() + slot->timeout;
+    return sock_udp_send(sock, buf, len, NULL);
+}
+
+static void _cancel_beyond(_block_slot_t *slots, uint32_t *last, uint32_t num)
+{
+    if (num < *last) {
+        *last = num;
+        for (unsigned i = 0; i < NANOCOAP_BLOCK_WINDOW; i++) {
+            if (slots[i].num > num) {
+                slots[i].tries = 0;
+            }
+        }
+    }
+}
+
+ssize_t nanocoap_get_blockwise(sock_udp_ep_t *remote, const char *path,
+                               uint8_t *buf, size_t len,
+                               coap_block_write_t cb, void *arg)
+{
+    _block_slot_t slots[NANOCOAP_BLOCK_WINDOW];
+    sock_udp_t sock;
+    ssize_t res;
+
+    if (len < coap_szx2size(0) + BLOCK_OVERHEAD + strlen(path)) {
+        return -ENOBUFS;
+    }
+    if (!remote->port) {
+        remote->port = COAP_PORT;
+    }
+    res = sock_udp_create(&sock, NULL, remote, 0);
+    if (res < 0) {
+        return res;
+    }
+
+    memset(slots, 0, sizeof(slots));
+    unsigned szx = coap_size2szx(len - BLOCK_OVERHEAD - strlen(path));
+    uint16_t id = (uint16_t)xtimer_now_usec();
+    uint32_t next = 0;                  /* next block to request */
+    uint32_t last = UINT32_MAX;         /* last block, once it is known */
+    unsigned window = 1;                /* until the block size is agreed on */
+    size_t total = 0;
+
+    while (1) {
+        unsigned pending = 0;
+
+        for (unsigned i = 0; i < NANOCOAP_BLOCK_WINDOW; i++) {
+            pending += (slots[i].tries > 0);
+        }
+        for (unsigned i = 0; (i < window) && (pending < window) &&
+                             (next <= last); i++) {
+            if (slots[i].tries) {
+                continue;
+            }
+            slots[i].num = next++;
+            slots[i].id = id++;
+            slots[i].timeout = COAP_ACK_TIMEOUT * US_PER_SEC;
+            res = _send_block2_req(&sock, buf, path, &slots[i], szx);
+            if (res < 0) {
+                goto out;
+            }
+            pending++;
+        }
+        if (!pending) {
+            res = total;
+            break;
+        }
+
+        /* retransmit overdue requests before waiting for the response that
+         * is due next, so the timeout passed to recv is never 0 */
+        uint32_t now = xtimer_now_usec();
+        uint32_t timeout = UINT32_MAX;
+        for (unsigned i = 0; i < NANOCOAP_BLOCK_WINDOW; i++) {
+            _block_slot_t *slot = &slots[i];
+            if (!slot->tries) {
+                continue;
+            }
+            if ((int32_t)(slot->deadline - now) <= 0) {
+                if (slot->tries > COAP_MAX_RETRANSMIT) {
+                    DEBUG("nanocoap: maximum retries reached.\n");
+                    res = -ETIMEDOUT;
+                    goto out;
+                }
+                DEBUG("nanocoap: timeout of block %" PRIu32 "\n", slot->num);
+                slot->timeout *= 2;
+                res = _send_block2_req(&sock, buf, path, slot, szx);
+                if (res < 0) {
+                    goto out;
+                }
+                now = xtimer_now_usec();
+            }
+            int32_t left = (int32_t)(slot->deadline - now);
+            if (left < 1) {
+                left = 1;
+            }
+            if ((uint32_t)left < timeout) {
+                timeout = left;
+            }
+        }
+
+        res = sock_udp_recv(&sock, buf, len, timeout, NULL);
+        if ((res == -ETIMEDOUT) || (res == -EAGAIN)) {
+            /* overdue requests are retransmitted above */
+            continue;
+        }
+        if (res < 0) {
+            DEBUG("nanocoap: error receiving coap response\n");
+            goto out;
+        }
+
+        coap_pkt_t pkt;
+        if ((coap_parse(&pkt, buf, res) < 0) || (pkt.hdr->code == 0)) {
+            DEBUG("nanocoap: ignoring unexpected packet\n");
+            continue;
+        }
+        _block_slot_t *slot = NULL;
+        for (unsigned i = 0; i < NANOCOAP_BLOCK_WINDOW; i++) {
+            if (slots[i].tries && (slots[i].id == coap_get_id(&pkt))) {
+                slot = &slots[i];
+                break;
+            }
+        }
+        if (!slot) {
+            /* response to a retransmission that was answered already */
+            continue;
+        }
+        slot->tries = 0;
+        if ((coap_get_code_raw(&pkt) == COAP_CODE_BAD_OPTION) && slot->num) {
+            /* requested beyond the end, the last block is still in flight */
+            _cancel_beyond(slots, &last, slot->num - 1);
+            continue;
+        }
+        if (coap_get_code_raw(&pkt) != COAP_CODE_CONTENT) {
+            res = -coap_get_code(&pkt);
+            break;
+        }
+
+        coap_block_t block;
+        if (!coap_get_block2(&pkt, &block)) {
+            /* the server sent the resource at once */
+            res = cb(arg, 0, pkt.payload, pkt.payload_len, false);
+            if (res == 0) {
+                res = pkt.payload_len;
+            }
+            break;
+        }
+        if (window == 1) {
+            /* the first response determines the block size */
+            szx = (block.szx < szx) ? block.szx : szx;
+            next = (block.num + 1);
+            window = NANOCOAP_BLOCK_WINDOW;
+        }
+        else if (block.szx != szx) {
+            res = -EPROTO;
+            break;
+        }
+
+        res = cb(arg, block.num * coap_szx2size(block.szx), pkt.payload,
+                 pkt.payload_len, block.more);
+        if (res < 0) {
+            break;
+        }
+        total += pkt.payload_len;
+        if (!block.more) {
+            _cancel_beyond(slots, &last, block.num);
+        }
+    }
+
+out:
+    sock_udp_close(&sock);
+
+    return res;
+}
+
+ssize_t nanocoap_put_blockwise(sock_udp_ep_t *remote, const char *path,
+                               uint8_t *buf, size_t len,
+                               coap_block_read_t read, void *arg)
+{
+    sock_udp_t sock;
+    ssize_t res;
+
+    if ((len < coap_szx2size(0) + BLOCK_OVERHEAD + strlen(path) + 1)) {
+        return -ENOBUFS;
+    }
+    if (!remote->port) {
+        remote->port = COAP_PORT;
+    }
+    res = sock_udp_create(&sock, NULL, remote, 0);
+    if (res < 0) {
+        return res;
+    }
+
+    /* one more byte tells whether more blocks follow */
+    unsigned szx = coap_size2szx(len - BLOCK_OVERHEAD - strlen(path) - 1);
+    uint16_t id = (uint16_t)xtimer_now_usec();
+    size_t offset = 0;
+    bool more = true;
+
+    while (more) {
+        size_t size = coap_szx2size(szx);
+        coap_block_t block = { .num = offset / size, .szx = szx };
+        uint32_t timeout = COAP_ACK_TIMEOUT * US_PER_SEC;
+        unsigned tries = 0;
+        size_t n = 0;
+
+        id++;
+        while (1) {
+            if (tries++ > COAP_MAX_RETRANSMIT) {
+                DEBUG("nanocoap: maximum retries reached.\n");
+                res = -ETIMEDOUT;
+                goto out;
+            }
+
+            /* the response overwrote the request, so build it again. The
+             * data goes to the end of the buffer first, as the length of the
+             * options depends on whether more blocks follow. */
+            uint8_t *payload = buf + len - (size + 1);
+            res = read(arg, offset, payload, size + 1);
+            if (res < 0) {
+                goto out;
+            }
+            n = res;
+            block.more = (n > size);
+            if (block.more) {
+                n = size;
+            }
+            uint8_t *pktpos = buf + _build_block_req(buf, COAP_METHOD_PUT, id,
+                                                     path, COAP_OPT_BLOCK1,
+                                                     &block);
+            if (n) {
+                *pktpos++ = 0xff;
+                memmove(pktpos, payload, n);
+                pktpos += n;
+            }
+
+            res = sock_udp_send(&sock, buf, pktpos - buf, NULL);
+            if (res < 0) {
+                goto out;
+            }
+
+            /* stale responses don't cut the timeout short */
+            uint32_t deadline = xtimer_now_usec() + timeout;
+            coap_pkt_t pkt;
+            coap_block_t ack;
+            bool acked = false;
+            while (1) {
+                int32_t left = (int32_t)(deadline - xtimer_now_usec());
+                if (left < 1) {
+                    res = -ETIMEDOUT;
+                    break;
+                }
+                res = sock_udp_recv(&sock, buf, len, left, NULL);
+                if (res < 0) {
+                    break;
+                }
+                if ((coap_parse(&pkt, buf, res) < 0) ||
+                    (coap_get_id(&pkt) != id) || (pkt.hdr->code == 0)) {
+                    DEBUG("nanocoap: ignoring unexpected packet\n");
+                    continue;
+                }
+                acked = coap_get_block1(&pkt, &ack);
+                if (acked && (ack.num != block.num)) {
+                    DEBUG("nanocoap: ignoring response to block %" PRIu32 "\n",
+                          ack.num);
+                    continue;
+                }
+                break;
+            }
+            if ((res == -ETIMEDOUT) || (res == -EAGAIN)) {
+                DEBUG("nanocoap: timeout\n");
+                timeout *= 2;
+                continue;
+            }
+            if (res < 0) {
+                goto out;
+            }
+
+            unsigned code = coap_get_code_raw(&pkt);
+            if ((code != COAP_CODE_CONTINUE) &&
+                (coap_get_code_class(&pkt) != COAP_CLASS_SUCCESS)) {
+                res = -coap_get_code(&pkt);
+                goto out;
+            }
+            if (acked && (ack.szx < szx)) {
+                /* continue with the block size of the server */
+                szx = ack.szx;
+            }
+            break;
+        }
+        offset += n;
+        more = block.more;
+    }
+    res = offset;
+
+out:
+    sock_udp_close(&sock);
+
+    return res;
+}
+
+#if NANOCOAP_DEDUP_SIZE
+static bool _ep_equal(const sock_udp_ep_t *a, const sock_udp_ep_t *b)
+{
+    size_t addrlen = (a->family == AF_INET6) ? 16 : 4;
+
+    return (a->family == b->family) && (a->port == b->port) &&
+           (memcmp(&a->addr, &b->addr, addrlen) == 0);
+}
+
+/* returns false if the request with @p id is a duplicate that was taken care
+ * of. Otherwise @p entry is set to the entry the response is to be stored in,
+ * or to NULL if the request can't be tracked. */
+static bool _dedup_lookup(sock_udp_t *sock, const sock_udp_ep_t *remote,
+                          uint16_t id, _dedup_t **entry)
+{
+    uint32_t now = (uint32_t)(xtimer_now_usec64() / US_PER_SEC);
+    _dedup_t *victim = NULL;
+    bool victim_unused = false;
+
+    mutex_lock(&_dedup_lock);
+    for (unsigned i = 0; i < NANOCOAP_DEDUP_SIZE; i++) {
+        _dedup_t *e = &_dedup[i];
+        bool valid = (e->state != DEDUP_UNUSED) &&
+                     ((int32_t)(e->expires - now) > 0);
+
+        if (valid && (e->id == id) && _ep_equal(&e->remote, remote)) {
+            if (e->state == DEDUP_PENDING) {
+                /* the response will follow */
+                mutex_unlock(&_dedup_lock);
+                return false;
+            }
+            if (e->len) {
+                sock_udp_send(sock, e->resp, e->len, remote);
+                mutex_unlock(&_dedup_lock);
+                return false;
+            }
+            /* the response was too long to be cached */
+            victim = e;
+            break;
+        }
+        /* prefer unused entries, then the done one expiring next */
+        if (!valid) {
+            if (!victim_unused) {
+                victim = e;
+                victim_unused = true;
+            }
+        }
+        else if (!victim_unused && (e->state == DEDUP_DONE) &&
+                 (!victim || ((int32_t)(e->expires - victim->expires) < 0))) {
+            victim = e;
+        }
+    }
+    if (victim) {
+        victim->remote = *remote;
+        victim->id = id;
+        victim->len = 0;
+        victim->state = DEDUP_PENDING;
+        victim->expires = now + NANOCOAP_DEDUP_LIFETIME;
+    }
+    mutex_unlock(&_dedup_lock);
+
+    *entry = victim;
+    return true;
+}
+
+static void _dedup_store(_dedup_t *entry, const uint8_t *resp, ssize_t len)
+{
+    mutex_lock(&_dedup_lock);
+    if ((len > 0) && ((size_t)len <= NANOCOAP_DEDUP_RESP_MAX)) {
+        memcpy(entry->resp, resp, len);
+        entry->len = len;
+    }
+    entry->state = DEDUP_DONE;
+    mutex_unlock(&_dedup_lock);
+}
+#endif
+
+static void _serve(sock_udp_t *sock, const sock_udp_ep_t *remote,
+                   uint8_t *buf, size_t len, size_t bufsize)
+{
+    coap_pkt_t pkt;
+    ssize_t res;
+
+    if (coap_parse(&pkt, buf, len) < 0) {
+        DEBUG("error parsing packet\n");
+        return;
+    }
+
+#if NANOCOAP_DEDUP_SIZE
+    _dedup_t *entry = NULL;
+
+    if ((coap_get_code_class(&pkt) == COAP_REQ) && (pkt.hdr->code != 0) &&
+        !_dedup_lookup(sock, remote, coap_get_id(&pkt), &entry)) {
+        DEBUG("nanocoap: duplicate of request %u\n", coap_get_id(&pkt));
+        return;
+    }
+#endif
+
+    res = coap_handle_req(&pkt, buf, bufsize);
+
+#if NANOCOAP_DEDUP_SIZE
+    if (entry) {
+        _dedup_store(entry, buf, res);
+    }
+#endif
+
+    if (res > 0) {
+        sock_udp_send(sock, buf, res, remote);
+    }
+}
+
 int nanocoap_server(sock_udp_ep_t *local, uint8_t *buf, size_t bufsize)
 {
     sock_udp_t sock;
@@ -117,20 +600,76 @@ int nanocoap_server(sock_udp_ep_t *local, uint8_t *buf, size_t bufsize)
 
     while (1) {
         res = sock_udp_recv(&sock, buf, bufsize, -1, &remote);
-        if (res == -1) {
+        if (res == -ENOBUFS) {
+            DEBUG("request too long\n");
+            continue;
+        }
+        if (res < 0) {
             DEBUG("error receiving UDP packet\n");
             return -1;
         }
-        else {
-            coap_pkt_t pkt;
-            if (coap_parse(&pkt, (uint8_t *)buf, res) < 0) {
-                DEBUG("error parsing packet\n");
-                continue;
-            }
-            if ((res = coap_handle_req(&pkt, buf, bufsize)) > 0) {
-                res = sock_udp_send(&sock, buf, res, &remote);
-            }
+        _serve(&sock, &remote, buf, res, bufsize);
+    }
+
+    return 0;
+}
+
+static void *_worker(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        msg_t msg;
+        mbox_get(&_queue, &msg);
+
+        _req_t *req = msg.content.ptr;
+        _serve(&_sock, &req->remote, req->buf, req->len, sizeof(req->buf));
+        mbox_put(&_free, &msg);
+    }
+
+    return NULL;
+}
+
+int nanocoap_server_mt(sock_udp_ep_t *local)
+{
+    if (!local->port) {
+        local->port = COAP_PORT;
+    }
+
+    if (sock_udp_create(&_sock, local, NULL, 0) < 0) {
+        return -1;
+    }
+
+    mbox_init(&_queue, _queue_msgs, NANOCOAP_SERVER_QUEUE_SIZE);
+    mbox_init(&_free, _free_msgs, NANOCOAP_SERVER_QUEUE_SIZE);
+    for (unsigned i = 0; i < NANOCOAP_SERVER_QUEUE_SIZE; i++) {
+        msg_t msg = { .content.ptr = &_reqs[i] };
+        mbox_put(&_free, &msg);
+    }
+    for (unsigned i = 0; i < NANOCOAP_SERVER_WORKERS; i++) {
+        thread_create(_stacks[i], sizeof(_stacks[i]), NANOCOAP_SERVER_PRIO,
+                      THREAD_CREATE_STACKTEST, _worker, NULL, "nanocoap");
+    }
+
+    while (1) {
+        msg_t msg;
+        /* blocks while all buffers are queued or being handled */
+        mbox_get(&_free, &msg);
+
+        _req_t *req = msg.content.ptr;
+        ssize_t res = sock_udp_recv(&_sock, req->buf, sizeof(req->buf),
+                                    SOCK_NO_TIMEOUT, &req->remote);
+        if (res == -ENOBUFS) {
+            DEBUG("request too long\n");
+            mbox_put(&_free, &msg);
+            continue;
+        }
+        if (res < 0) {
+            DEBUG("error receiving UDP packet\n");
+            return -1;
         }
+        req->len = res;
+        mbox_put(&_queue, &msg);
     }
 
     return 0;
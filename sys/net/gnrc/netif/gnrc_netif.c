@@ -26,6 +26,7 @@
 #include "net/netstats.h"
 #endif
 #include "log.h"
+#include "rcu.h"
 #include "sched.h"
 
 #include "net/gnrc/netif.h"
@@ -555,8 +556,11 @@ int gnrc_netif_ipv6_addr_add_internal(gnrc_netif_t *netif,
         gnrc_netif_release(netif);
         return -ENOMEM;
     }
-    netif->ipv6.addrs_flags[idx] = flags;
     memcpy(&netif->ipv6.addrs[idx], addr, sizeof(netif->ipv6.addrs[idx]));
+    /* readers only look at slots with flags set, so publish the address
+     * afterwards */
+    RCU_BARRIER();
+    netif->ipv6.addrs_flags[idx] = flags;
 #ifdef MODULE_GNRC_IPV6_NIB
 #if GNRC_IPV6_NIB_CONF_ARSM
     ipv6_addr_t sol_nodes;
@@ -611,6 +615,8 @@ void gnrc_netif_ipv6_addr_remove_internal(gnrc_netif_t *netif,
     for (unsigned i = 0; i < GNRC_NETIF_IPV6_ADDRS_NUMOF; i++) {
         if (ipv6_addr_equal(&netif->ipv6.addrs[i], addr)) {
             netif->ipv6.addrs_flags[i] = 0;
+            /* lock-free readers might still compare against the address */
+            rcu_synchronize();
             ipv6_addr_set_unspecified(&netif->ipv6.addrs[i]);
         }
         else {
@@ -639,9 +645,9 @@ int gnrc_netif_ipv6_addr_idx(gnrc_netif_t *netif,
     DEBUG("gnrc_netif: get index of %s from inteface %i\n",
           ipv6_addr_to_str(addr_str, addr, sizeof(addr_str)),
           netif->pid);
-    gnrc_netif_acquire(netif);
+    unsigned epoch = rcu_read_lock();
     idx = _addr_idx(netif, addr);
-    gnrc_netif_release(netif);
+    rcu_read_unlock(epoch);
     return idx;
 }
 
@@ -651,9 +657,9 @@ int gnrc_netif_ipv6_addr_match(gnrc_netif_t *netif,
     int idx;
 
     assert((netif != NULL) && (addr != NULL));
-    gnrc_netif_acquire(netif);
+    unsigned epoch = rcu_read_lock();
     _match(netif, addr, NULL, &idx);
-    gnrc_netif_release(netif);
+    rcu_read_unlock(epoch);
     return idx;
 }
 
@@ -667,7 +673,7 @@ ipv6_addr_t *gnrc_netif_ipv6_addr_best_src(gnrc_netif_t *netif,
 
     assert((netif != NULL) && (dst != NULL));
     memset(candidate_set, 0, sizeof(candidate_set));
-    gnrc_netif_acquire(netif);
+    unsigned epoch = rcu_read_lock();
     int first_candidate = _create_candidate_set(netif, dst, ll_only,
                                                 candidate_set);
     if (first_candidate >= 0) {
@@ -676,13 +682,14 @@ ipv6_addr_t *gnrc_netif_ipv6_addr_best_src(gnrc_netif_t *netif,
             best_src = &(netif->ipv6.addrs[first_candidate]);
         }
     }
-    gnrc_netif_release(netif);
+    rcu_read_unlock(epoch);
     return best_src;
 }
 
 gnrc_netif_t *gnrc_netif_get_by_ipv6_addr(const ipv6_addr_t *addr)
 {
     gnrc_netif_t *netif = NULL;
+    unsigned epoch = rcu_read_lock();
 
     DEBUG("gnrc_netif: get interface by IPv6 address %s\n",
           ipv6_addr_to_str(addr_str, addr, sizeof(addr_str)));
@@ -694,6 +701,7 @@ gnrc_netif_t *gnrc_netif_get_by_ipv6_addr(const ipv6_addr_t *addr)
             break;
         }
     }
+    rcu_read_unlock(epoch);
     return netif;
 }
 
@@ -701,6 +709,7 @@ gnrc_netif_t *gnrc_netif_get_by_prefix(const ipv6_addr_t *prefix)
 {
     gnrc_netif_t *netif = NULL, *best_netif = NULL;
     unsigned best_match = 0;
+    unsigned epoch = rcu_read_lock();
 
     while ((netif = gnrc_netif_iter(netif))) {
         unsigned match;
@@ -712,6 +721,7 @@ gnrc_netif_t *gnrc_netif_get_by_prefix(const ipv6_addr_t *prefix)
             best_netif = netif;
         }
     }
+    rcu_read_unlock(epoch);
     return best_netif;
 }
 
@@ -842,7 +852,9 @@ static inline bool _addr_anycast(const gnrc_netif_t *netif, unsigned idx)
 static int _addr_idx(const gnrc_netif_t *netif, const ipv6_addr_t *addr)
 {
     for (unsigned i = 0; i < GNRC_NETIF_IPV6_ADDRS_NUMOF; i++) {
-        if (ipv6_addr_equal(&netif->ipv6.addrs[i], addr)) {
+        /* unused slots might still hold an address being removed */
+        if ((netif->ipv6.addrs_flags[i] != 0) &&
+            ipv6_addr_equal(&netif->ipv6.addrs[i], addr)) {
             return i;
         }
     }
@@ -326,6 +326,11 @@ void gnrc_pktbuf_stats(void)
     DEBUG("pktbuf: needs od module\n");
 #endif
 }
+
+size_t gnrc_pktbuf_max_byte_count(void)
+{
+    return max_byte_count;
+}
 #endif
 
 #ifdef TEST_SUITES
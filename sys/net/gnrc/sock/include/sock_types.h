@@ -40,18 +40,44 @@ extern "C" {
 #define SOCK_MBOX_SIZE      (8)         /**< Size for gnrc_sock_reg_t::mbox_queue */
 #endif
 
+/**
+ * @brief   Forward declaration
+ * @internal
+ */
+typedef struct gnrc_sock_reg gnrc_sock_reg_t;
+
+#if defined(MODULE_GNRC_SOCK_ASYNC) || defined(DOXYGEN)
+/**
+ * @brief   Callback for a packet that was queued in gnrc_sock_reg_t::mbox
+ *
+ * @note    Only available with module `gnrc_sock_async`.
+ *
+ * The callback is executed in the context of the thread that dispatched the
+ * packet, so it must not block.
+ *
+ * @param[in] reg   The sock registry info the packet was queued for.
+ * @param[in] arg   gnrc_sock_reg_t::async_cb_arg
+ */
+typedef void (*gnrc_sock_reg_cb_t)(gnrc_sock_reg_t *reg, void *arg);
+#endif
+
 /**
  * @brief   sock @ref net_gnrc_netreg info
  * @internal
  */
-typedef struct gnrc_sock_reg {
+struct gnrc_sock_reg {
 #ifdef MODULE_GNRC_SOCK_CHECK_REUSE
     struct gnrc_sock_reg *next;         /**< list-like for internal storage */
 #endif
     gnrc_netreg_entry_t entry;          /**< @ref net_gnrc_netreg entry for mbox */
     mbox_t mbox;                        /**< @ref core_mbox target for the sock */
     msg_t mbox_queue[SOCK_MBOX_SIZE];   /**< queue for gnrc_sock_reg_t::mbox */
-} gnrc_sock_reg_t;
+#if defined(MODULE_GNRC_SOCK_ASYNC) || defined(DOXYGEN)
+    gnrc_netreg_entry_cbd_t netreg_cb;  /**< netreg callback filling the mbox */
+    gnrc_sock_reg_cb_t async_cb;        /**< called when a packet was queued */
+    void *async_cb_arg;                 /**< argument for gnrc_sock_reg_t::async_cb */
+#endif
+};
 
 /**
  * @brief   Raw IP sock type
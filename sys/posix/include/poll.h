@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    posix_poll POSIX poll
+ * @ingroup     posix
+ * @brief       Synchronous I/O multiplexing over @ref sys_vfs file descriptors
+ *
+ * Readiness is queried through vfs_file_ops::poll, so it works for sockets
+ * of @ref posix_sockets as well as for files. A thread waiting in poll() is
+ * woken up by the file drivers through @ref VFS_POLL_THREAD_FLAG instead of
+ * polling the descriptors periodically.
+ *
+ * poll() only uses @ref VFS_POLL_THREAD_FLAG, for the timeout as well, and
+ * leaves all other thread flags of the caller alone. Any number of threads
+ * may poll the same descriptor. Sockets are not bound as a side effect: an
+ * unbound datagram socket never becomes readable, and a thread polling it is
+ * woken up by the first packet after bind() or connect(). Readability is
+ * only known for raw and UDP sockets with module `gnrc_sock_async`, other
+ * sockets are always reported as readable.
+ *
+ * @{
+ *
+ * @file
+ * @brief   POSIX compatible poll.h definitions
+ * @see     <a href="http://pubs.opengroup.org/onlinepubs/9699919799/basedefs/poll.h.html">
+ *              The Open Group Base Specifications Issue 7, <poll.h>
+ *          </a>
+ */
+
+#ifndef DOXYGEN
+#if defined(CPU_NATIVE)
+/* If building on native we need to use the system header instead */
+#pragma GCC system_header
+/* without the GCC pragma above #include_next will trigger a pedantic error */
+#include_next <poll.h>
+#else
+#ifndef POLL_H
+#define POLL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define POLLIN      (0x0001)    /**< data other than high-priority data may be read */
+#define POLLPRI     (0x0002)    /**< high-priority data may be read */
+#define POLLOUT     (0x0004)    /**< data may be written */
+#define POLLERR     (0x0008)    /**< an error has occurred (revents only) */
+#define POLLHUP     (0x0010)    /**< device has been disconnected (revents only) */
+#define POLLNVAL    (0x0020)    /**< invalid fd member (revents only) */
+#define POLLRDNORM  (POLLIN)    /**< normal data may be read */
+#define POLLWRNORM  (POLLOUT)   /**< normal data may be written */
+
+/**
+ * @brief   Type for the number of file descriptors
+ */
+typedef unsigned int nfds_t;
+
+/**
+ * @brief   File descriptor and events to poll for
+ */
+struct pollfd {
+    int fd;             /**< the file descriptor to poll */
+    short events;       /**< the requested events */
+    short revents;      /**< the returned events */
+};
+
+/**
+ * @brief   Waits for events on a set of file descriptors
+ *
+ * @param[in,out] fds       array of file descriptors to poll
+ * @param[in]     nfds      number of entries in @p fds
+ * @param[in]     timeout   timeout in milliseconds, 0 to return immediately
+ *                          or -1 to wait infinitely
+ *
+ * @return  number of entries in @p fds with non-zero revents
+ * @return  0 on timeout
+ * @return  -1 on error, errno is set accordingly
+ */
+int poll(struct pollfd *fds, nfds_t nfds, int timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POLL_H */
+
+#endif /* CPU_NATIVE */
+
+#endif /* DOXYGEN */
+/** @} */
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     posix_poll
+ * @{
+ *
+ * @file
+ * @brief       poll() and select() on top of the VFS layer
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <poll.h>
+#include <sys/select.h>
+
+#include "thread.h"
+#include "thread_flags.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* checks all entries of fds and (un)registers waiter with their drivers */
+static int _scan(struct pollfd *fds, nfds_t nfds, kernel_pid_t waiter)
+{
+    int ready = 0;
+
+    for (nfds_t i = 0; i < nfds; i++) {
+        int res;
+
+        if (fds[i].fd < 0) {
+            fds[i].revents = 0;
+            continue;
+        }
+        res = vfs_poll(fds[i].fd, fds[i].events, waiter);
+        fds[i].revents = (res < 0) ? POLLNVAL : res;
+        if (fds[i].revents) {
+            ready++;
+        }
+    }
+
+    return ready;
+}
+
+/* the timeout wakes up poll() like a driver, so no other thread flag of the
+ * caller is touched */
+typedef struct {
+    thread_t *thread;
+    volatile bool expired;
+} _timeout_t;
+
+static void _timeout_cb(void *arg)
+{
+    _timeout_t *t = arg;
+
+    t->expired = true;
+    thread_flags_set(t->thread, VFS_POLL_THREAD_FLAG);
+}
+
+int poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+    if ((fds == NULL) && (nfds > 0)) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (timeout != 0) {
+        _timeout_t t = { .thread = (thread_t *)sched_active_thread };
+        xtimer_t timer = { .callback = _timeout_cb, .arg = &t };
+
+        thread_flags_clear(VFS_POLL_THREAD_FLAG);
+        if (timeout > 0) {
+            uint32_t us = ((uint32_t)timeout < (UINT32_MAX / US_PER_MS)) ?
+                          (uint32_t)timeout * US_PER_MS : UINT32_MAX;
+            xtimer_set(&timer, us);
+        }
+        /* a driver sets the flag any time after registration, so no event
+         * can get lost between _scan() and waiting */
+        while (!t.expired && (_scan(fds, nfds, sched_active_pid) == 0)) {
+            thread_flags_wait_any(VFS_POLL_THREAD_FLAG);
+            DEBUG("poll: woken up%s\n", t.expired ? " by timeout" : "");
+        }
+        if (timeout > 0) {
+            xtimer_remove(&timer);
+        }
+    }
+    /* final scan to collect the results and to unregister from the drivers */
+    return _scan(fds, nfds, KERNEL_PID_UNDEF);
+}
+
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *errorfds,
+           struct timeval *timeout)
+{
+    struct pollfd fds[VFS_MAX_OPEN_FILES];
+    nfds_t num = 0;
+    int res, timeout_ms = -1;
+
+    if ((nfds < 0) || (nfds > VFS_MAX_OPEN_FILES)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (timeout != NULL) {
+        if ((timeout->tv_sec < 0) || (timeout->tv_usec < 0)) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (timeout->tv_sec < (INT_MAX / MS_PER_SEC) - 1) {
+            timeout_ms = (timeout->tv_sec * MS_PER_SEC) +
+                         ((timeout->tv_usec + US_PER_MS - 1) / US_PER_MS);
+        }
+        else {
+            timeout_ms = INT_MAX;
+        }
+    }
+    for (int fd = 0; fd < nfds; fd++) {
+        short events = 0;
+
+        if ((readfds != NULL) && FD_ISSET(fd, readfds)) {
+            events |= POLLIN;
+        }
+        if ((writefds != NULL) && FD_ISSET(fd, writefds)) {
+            events |= POLLOUT;
+        }
+        if ((errorfds != NULL) && FD_ISSET(fd, errorfds)) {
+            events |= POLLPRI;
+        }
+        if (events) {
+            fds[num].fd = fd;
+            fds[num].events = events;
+            num++;
+        }
+    }
+    if ((res = poll(fds, num, timeout_ms)) < 0) {
+        return res;
+    }
+    for (nfds_t i = 0; i < num; i++) {
+        if (fds[i].revents & POLLNVAL) {
+            errno = EBADF;
+            return -1;
+        }
+    }
+    res = 0;
+    for (nfds_t i = 0; i < num; i++) {
+        int fd = fds[i].fd;
+
+        if ((readfds != NULL) && FD_ISSET(fd, readfds)) {
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                res++;
+            }
+            else {
+                FD_CLR(fd, readfds);
+            }
+        }
+        if ((writefds != NULL) && FD_ISSET(fd, writefds)) {
+            if (fds[i].revents & (POLLOUT | POLLERR)) {
+                res++;
+            }
+            else {
+                FD_CLR(fd, writefds);
+            }
+        }
+        if ((errorfds != NULL) && FD_ISSET(fd, errorfds)) {
+            if (fds[i].revents & POLLPRI) {
+                res++;
+            }
+            else {
+                FD_CLR(fd, errorfds);
+            }
+        }
+    }
+    return res;
+}
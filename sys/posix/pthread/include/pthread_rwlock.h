@@ -27,23 +27,68 @@
 extern "C" {
 #endif
 
+/**
+ * @name    Fairness policies of the reader/writer lock
+ * @{
+ */
+#define PTHREAD_RWLOCK_PREFER_READERS   (0) /**< readers only wait for an active writer */
+#define PTHREAD_RWLOCK_PREFER_WRITERS   (1) /**< readers wait if any writer is waiting */
+#define PTHREAD_RWLOCK_PRIORITY_FAIR    (2) /**< readers only wait for writers of the same or a higher priority */
+/** @} */
+
+/**
+ * @brief     Fairness policy used by all reader/writer locks.
+ * @details   With @ref PTHREAD_RWLOCK_PREFER_READERS readers can enter the
+ *            critical section without touching the mutex even if writers
+ *            are waiting. Writers may starve under this policy.
+ *            @ref PTHREAD_RWLOCK_PRIORITY_FAIR is the historical behavior:
+ *            no new readers will enter the critical section if a writer of
+ *            the same or a higher priority waits for the lock, and after a
+ *            writer all waiting readers up to the next writer are continued.
+ *            This is not phase-fair: readers of a higher priority than the
+ *            first waiting writer still join, so writers of a low priority
+ *            may starve.
+ */
+#ifndef PTHREAD_RWLOCK_POLICY
+#define PTHREAD_RWLOCK_POLICY           PTHREAD_RWLOCK_PRIORITY_FAIR
+#endif
+
+/**
+ * @name    Bits of pthread_rwlock_t::state
+ * @{
+ */
+#define PTHREAD_RWLOCK_WRITER   (0x8000U)   /**< a writer holds the lock */
+#define PTHREAD_RWLOCK_WAITERS  (0x4000U)   /**< threads wait in the queue */
+#define PTHREAD_RWLOCK_READERS  (0x3fffU)   /**< mask for the number of readers */
+/** @} */
+
 /**
  * @brief     A fair reader writer lock.
  * @details   The implementation ensures that readers and writers of the same priority
- *            won't starve each other.
- *            E.g. no new readers will get into the critical section
- *            if a writer of the same or a higher priority already waits for the lock.
+ *            won't starve each other, unless configured otherwise by
+ *            @ref PTHREAD_RWLOCK_POLICY.
+ *
+ *            As long as no thread has to wait for the lock, it is acquired and
+ *            released with a single atomic operation on
+ *            pthread_rwlock_t::state, using the compiler's `__atomic`
+ *            builtins. The mutex and the priority queue are
+ *            only used once a thread has to block.
  */
 typedef struct
 {
     /**
-     * @brief     The current amount of reader inside the critical section.
+     * @brief     The current state of the lock.
      * @details
-     *            * `== 0`: no thread is in the critical section.
-     *            * `> 0`: the number of readers currently in the critical section.
-     *            * `< 0`: a writer is currently in the critical section.
+     *            * `& PTHREAD_RWLOCK_READERS`: the number of readers currently
+     *              in the critical section.
+     *            * `& PTHREAD_RWLOCK_WRITER`: a writer is currently in the
+     *              critical section.
+     *            * `& PTHREAD_RWLOCK_WAITERS`: the queue is not empty, unlocking
+     *              needs to take the mutex.
+     *
+     *            Is `0` if no thread is in the critical section or waiting.
      */
-    int readers;
+    volatile unsigned state;
 
     /**
      * @brief     Queue of waiting threads.
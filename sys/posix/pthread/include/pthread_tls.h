@@ -18,10 +18,30 @@
 #ifndef PTHREAD_TLS_H
 #define PTHREAD_TLS_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief   Maximum number of thread-specific keys that can exist at a time
+ *
+ * Every pthread reserves one slot per key, so the value is a trade-off
+ * between the number of keys and the memory used by each pthread.
+ */
+#ifndef PTHREAD_TLS_KEYS
+#define PTHREAD_TLS_KEYS            (8)
+#endif
+
+/**
+ * @brief   Maximum number of rounds the destructors are called on
+ *          pthread_exit(), if they set new values
+ */
+#ifndef PTHREAD_TLS_DTOR_ITERATIONS
+#define PTHREAD_TLS_DTOR_ITERATIONS (4)
+#endif
+
 /**
  * @brief   Internal representation of a thread-specific key.
  * @internal
@@ -32,7 +52,10 @@ struct __pthread_tls_key;
  * @brief   A single thread-specific datum.
  * @internal
  */
-struct __pthread_tls_datum;
+struct __pthread_tls_datum {
+    void *value;            /**< the value set by pthread_setspecific() */
+    uint16_t generation;    /**< generation of the key @p value belongs to */
+};
 
 /**
  * @brief   A thread-specific key.
@@ -78,10 +101,10 @@ int pthread_key_delete(pthread_key_t key);
 void __pthread_keys_exit(int self_id);
 
 /**
- * @brief Returns the pointer to the head of the list of thread-specific data.
+ * @brief Returns the thread-specific data slots of pthread `self_id`.
  * @internal
  */
-struct __pthread_tls_datum **__pthread_get_tls_head(int self_id) PURE;
+struct __pthread_tls_datum *__pthread_get_tls(int self_id) PURE;
 
 #ifdef __cplusplus
 }
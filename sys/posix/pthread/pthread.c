@@ -68,12 +68,14 @@ typedef struct {
 
     char *stack;
 
-    struct __pthread_tls_datum *tls_head;
+    struct __pthread_tls_datum tls[PTHREAD_TLS_KEYS];
 
     __pthread_cleanup_datum_t *cleanup_top;
 } pthread_thread_t;
 
 static pthread_thread_t *volatile pthread_sched_threads[MAXTHREADS];
+/* pthread_t of the running pthread for each kernel pid, 0 for other threads */
+static volatile pthread_t pthread_by_pid[KERNEL_PID_LAST + 1];
 static mutex_t pthread_mutex;
 
 static volatile kernel_pid_t pthread_reaper_pid = KERNEL_PID_UNDEF;
@@ -168,6 +170,7 @@ int pthread_create(pthread_t *newthread, const pthread_attr_t *attr, void *(*sta
         pthread_sched_threads[pthread_pid-1] = NULL;
         return -1;
     }
+    pthread_by_pid[pt->thread_pid] = pthread_pid;
 
     sched_switch(THREAD_PRIORITY_MAIN);
 
@@ -197,6 +200,7 @@ void pthread_exit(void *retval)
             __pthread_keys_exit(self_id);
         }
 
+        pthread_by_pid[self->thread_pid] = 0;
         self->thread_pid = KERNEL_PID_UNDEF;
         DEBUG("pthread_exit(%p), self == %p\n", retval, (void *) self);
         if (self->status != PTS_DETACHED) {
@@ -280,17 +284,9 @@ int pthread_detach(pthread_t th)
 
 pthread_t pthread_self(void)
 {
-    pthread_t result = 0;
-    mutex_lock(&pthread_mutex);
     kernel_pid_t pid = sched_active_pid; /* sched_active_pid is volatile */
-    for (int i = 0; i < MAXTHREADS; i++) {
-        if (pthread_sched_threads[i] && pthread_sched_threads[i]->thread_pid == pid) {
-            result = i+1;
-            break;
-        }
-    }
-    mutex_unlock(&pthread_mutex);
-    return result;
+
+    return pid_is_valid(pid) ? pthread_by_pid[pid] : 0;
 }
 
 int pthread_cancel(pthread_t th)
@@ -367,8 +363,8 @@ void __pthread_cleanup_pop(__pthread_cleanup_datum_t *datum, int execute)
     }
 }
 
-struct __pthread_tls_datum **__pthread_get_tls_head(int self_id)
+struct __pthread_tls_datum *__pthread_get_tls(int self_id)
 {
     pthread_thread_t *self = pthread_sched_threads[self_id-1];
-    return self ? &self->tls_head : NULL;
+    return self ? self->tls : NULL;
 }
@@ -23,6 +23,14 @@
  * @file
  * @brief       Implementation of a fair, POSIX conforming reader/writer lock.
  *
+ * Uncontended locking and unlocking only needs a compare-and-swap on
+ * pthread_rwlock_t::state. Once a thread has to wait, it sets
+ * PTHREAD_RWLOCK_WAITERS while holding the mutex. This makes the state
+ * word differ from what any concurrent fast path expects, so unlockers fall
+ * back to the mutex and will find the waiting thread in the queue.
+ * While the flag is set, a writer can only be admitted by a thread holding
+ * the mutex.
+ *
  * @author      René Kijewski <rene.kijewski@fu-berlin.de>
  *
  * @}
@@ -40,6 +48,75 @@
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
+#if PTHREAD_RWLOCK_POLICY == PTHREAD_RWLOCK_PREFER_READERS
+/* readers may join other readers even if someone waits */
+#define FAST_RDLOCK_BLOCKED     (PTHREAD_RWLOCK_WRITER)
+#else
+#define FAST_RDLOCK_BLOCKED     (PTHREAD_RWLOCK_WRITER | PTHREAD_RWLOCK_WAITERS)
+#endif
+
+static inline bool _cas(volatile unsigned *state, unsigned *expected,
+                        unsigned desired, bool weak)
+{
+    return __atomic_compare_exchange_n(state, expected, desired, weak,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline bool _is_writer(const priority_queue_node_t *qnode)
+{
+    return ((__pthread_rwlock_waiter_node_t *) qnode->data)->is_writer;
+}
+
+static bool _fast_rdlock(pthread_rwlock_t *rwlock)
+{
+    unsigned state = __atomic_load_n(&rwlock->state, __ATOMIC_SEQ_CST);
+
+    while (!(state & FAST_RDLOCK_BLOCKED)) {
+        if (_cas(&rwlock->state, &state, state + 1, true)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool _fast_wrlock(pthread_rwlock_t *rwlock)
+{
+    unsigned state = 0;
+
+    return _cas(&rwlock->state, &state, PTHREAD_RWLOCK_WRITER, false);
+}
+
+/* must be called with the mutex held and PTHREAD_RWLOCK_WAITERS set */
+static bool _acquire(pthread_rwlock_t *rwlock, bool is_writer)
+{
+    if (!is_writer) {
+        if (__pthread_rwlock_blocked_readingly(rwlock)) {
+            return false;
+        }
+        /* no writer can get in without the mutex */
+        __atomic_fetch_add(&rwlock->state, 1, __ATOMIC_SEQ_CST);
+        return true;
+    }
+
+    /* readers might still join on the fast path */
+    unsigned state = __atomic_load_n(&rwlock->state, __ATOMIC_SEQ_CST);
+    do {
+        if (state & (PTHREAD_RWLOCK_WRITER | PTHREAD_RWLOCK_READERS)) {
+            return false;
+        }
+    } while (!_cas(&rwlock->state, &state, state | PTHREAD_RWLOCK_WRITER,
+                   true));
+    return true;
+}
+
+/* must be called with the mutex held */
+static void _clear_waiters(pthread_rwlock_t *rwlock)
+{
+    if (rwlock->queue.first == NULL) {
+        __atomic_fetch_and(&rwlock->state, ~PTHREAD_RWLOCK_WAITERS, __ATOMIC_SEQ_CST);
+    }
+}
+
 int pthread_rwlock_init(pthread_rwlock_t *rwlock, const pthread_rwlockattr_t *attr)
 {
     (void) attr;
@@ -61,7 +138,7 @@ int pthread_rwlock_destroy(pthread_rwlock_t *rwlock)
     }
 
     /* do not unlock the mutex, no need */
-    if ((mutex_trylock(&rwlock->mutex) == 0) || (rwlock->readers != 0)) {
+    if ((mutex_trylock(&rwlock->mutex) == 0) || (__atomic_load_n(&rwlock->state, __ATOMIC_SEQ_CST) != 0)) {
         return EBUSY;
     }
 
@@ -70,11 +147,22 @@ int pthread_rwlock_destroy(pthread_rwlock_t *rwlock)
 
 bool __pthread_rwlock_blocked_readingly(const pthread_rwlock_t *rwlock)
 {
-    if (rwlock->readers < 0) {
+    if (__atomic_load_n(&rwlock->state, __ATOMIC_SEQ_CST) & PTHREAD_RWLOCK_WRITER) {
         /* a writer holds the lock */
         return true;
     }
 
+#if PTHREAD_RWLOCK_POLICY == PTHREAD_RWLOCK_PREFER_READERS
+    return false;
+#elif PTHREAD_RWLOCK_POLICY == PTHREAD_RWLOCK_PREFER_WRITERS
+    /* any waiting writer blocks new readers */
+    for (priority_queue_node_t *qnode = rwlock->queue.first; qnode; qnode = qnode->next) {
+        if (_is_writer(qnode)) {
+            return true;
+        }
+    }
+    return false;
+#else
     /* Determine if there is a writer waiting to get this lock who has a higher or the same priority: */
 
     if (rwlock->queue.first == NULL) {
@@ -89,20 +177,18 @@ bool __pthread_rwlock_blocked_readingly(const pthread_rwlock_t *rwlock)
     }
 
     /* if the waiting node is a writer, then we cannot enter the critical section (to prevent starving the writer) */
-    __pthread_rwlock_waiter_node_t *waiting_node = (__pthread_rwlock_waiter_node_t *) qnode->data;
-    return waiting_node->is_writer;
+    return _is_writer(qnode);
+#endif
 }
 
 bool __pthread_rwlock_blocked_writingly(const pthread_rwlock_t *rwlock)
 {
     /* if any thread holds the lock, then no writer may enter the critical section */
-    return rwlock->readers != 0;
+    return (__atomic_load_n(&rwlock->state, __ATOMIC_SEQ_CST) & (PTHREAD_RWLOCK_WRITER | PTHREAD_RWLOCK_READERS)) != 0;
 }
 
 static int pthread_rwlock_lock(pthread_rwlock_t *rwlock,
-                               bool (*is_blocked)(const pthread_rwlock_t *rwlock),
                                bool is_writer,
-                               int incr_when_held,
                                bool allow_spurious)
 {
     if (rwlock == NULL) {
@@ -111,11 +197,17 @@ static int pthread_rwlock_lock(pthread_rwlock_t *rwlock,
         return EINVAL;
     }
 
+    if (is_writer ? _fast_wrlock(rwlock) : _fast_rdlock(rwlock)) {
+        return 0;
+    }
+
     mutex_lock(&rwlock->mutex);
-    if (!is_blocked(rwlock)) {
+    /* divert concurrent unlockers to the slow path before checking the state */
+    __atomic_fetch_or(&rwlock->state, PTHREAD_RWLOCK_WAITERS, __ATOMIC_SEQ_CST);
+    if (_acquire(rwlock, is_writer)) {
         DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): is_writer=%u, allow_spurious=%u %s\n",
               thread_getpid(), "lock", is_writer, allow_spurious, "is open");
-        rwlock->readers += incr_when_held;
+        _clear_waiters(rwlock);
     }
     else {
         DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): is_writer=%u, allow_spurious=%u %s\n",
@@ -140,7 +232,7 @@ static int pthread_rwlock_lock(pthread_rwlock_t *rwlock,
 
             mutex_lock(&rwlock->mutex);
             if (waiting_node.continue_) {
-                /* pthread_rwlock_unlock() already set rwlock->readers */
+                /* pthread_rwlock_unlock() already updated rwlock->state */
                 DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): is_writer=%u, allow_spurious=%u %s\n",
                       thread_getpid(), "lock", is_writer, allow_spurious, "continued");
                 break;
@@ -149,6 +241,7 @@ static int pthread_rwlock_lock(pthread_rwlock_t *rwlock,
                 DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): is_writer=%u, allow_spurious=%u %s\n",
                       thread_getpid(), "lock", is_writer, allow_spurious, "is timed out");
                 priority_queue_remove(&rwlock->queue, &waiting_node.qnode);
+                _clear_waiters(rwlock);
                 mutex_unlock(&rwlock->mutex);
                 return ETIMEDOUT;
             }
@@ -160,31 +253,29 @@ static int pthread_rwlock_lock(pthread_rwlock_t *rwlock,
 }
 
 static int pthread_rwlock_trylock(pthread_rwlock_t *rwlock,
-                                  bool (*is_blocked)(const pthread_rwlock_t *rwlock),
-                                  int incr_when_held)
+                                  bool is_writer)
 {
     if (rwlock == NULL) {
         DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): rwlock=NULL supplied\n", thread_getpid(), "trylock");
         return EINVAL;
     }
-    else if (mutex_trylock(&rwlock->mutex) == 0) {
-        return EBUSY;
+    else if (is_writer ? _fast_wrlock(rwlock) : _fast_rdlock(rwlock)) {
+        return 0;
     }
-    else if (is_blocked(rwlock)) {
-        mutex_unlock(&rwlock->mutex);
+    else if (mutex_trylock(&rwlock->mutex) == 0) {
         return EBUSY;
     }
 
-    rwlock->readers += incr_when_held;
+    __atomic_fetch_or(&rwlock->state, PTHREAD_RWLOCK_WAITERS, __ATOMIC_SEQ_CST);
+    bool acquired = _acquire(rwlock, is_writer);
+    _clear_waiters(rwlock);
 
     mutex_unlock(&rwlock->mutex);
-    return 0;
+    return acquired ? 0 : EBUSY;
 }
 
 static int pthread_rwlock_timedlock(pthread_rwlock_t *rwlock,
-                                    bool (*is_blocked)(const pthread_rwlock_t *rwlock),
                                     bool is_writer,
-                                    int incr_when_held,
                                     const struct timespec *abstime)
 {
     uint64_t now = xtimer_now_usec64();
@@ -197,7 +288,7 @@ static int pthread_rwlock_timedlock(pthread_rwlock_t *rwlock,
     else {
         xtimer_t timer;
         xtimer_set_wakeup64(&timer, (then - now), sched_active_pid);
-        int result = pthread_rwlock_lock(rwlock, is_blocked, is_writer, incr_when_held, true);
+        int result = pthread_rwlock_lock(rwlock, is_writer, true);
         if (result != ETIMEDOUT) {
             xtimer_remove(&timer);
         }
@@ -208,32 +299,74 @@ static int pthread_rwlock_timedlock(pthread_rwlock_t *rwlock,
 
 int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
 {
-    return pthread_rwlock_lock(rwlock, __pthread_rwlock_blocked_readingly, false, +1, false);
+    return pthread_rwlock_lock(rwlock, false, false);
 }
 
 int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
 {
-    return pthread_rwlock_lock(rwlock, __pthread_rwlock_blocked_writingly, true, -1, false);
+    return pthread_rwlock_lock(rwlock, true, false);
 }
 
 int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
 {
-    return pthread_rwlock_trylock(rwlock, __pthread_rwlock_blocked_readingly, +1);
+    return pthread_rwlock_trylock(rwlock, false);
 }
 
 int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
 {
-    return pthread_rwlock_trylock(rwlock, __pthread_rwlock_blocked_writingly, -1);
+    return pthread_rwlock_trylock(rwlock, true);
 }
 
 int pthread_rwlock_timedrdlock(pthread_rwlock_t *rwlock, const struct timespec *abstime)
 {
-    return pthread_rwlock_timedlock(rwlock, __pthread_rwlock_blocked_readingly, false, +1, abstime);
+    return pthread_rwlock_timedlock(rwlock, false, abstime);
 }
 
 int pthread_rwlock_timedwrlock(pthread_rwlock_t *rwlock, const struct timespec *abstime)
 {
-    return pthread_rwlock_timedlock(rwlock, __pthread_rwlock_blocked_writingly, true, -1, abstime);
+    return pthread_rwlock_timedlock(rwlock, true, abstime);
+}
+
+static uint16_t _continue(pthread_rwlock_t *rwlock, priority_queue_node_t *qnode)
+{
+    __pthread_rwlock_waiter_node_t *waiting_node = (__pthread_rwlock_waiter_node_t *) qnode->data;
+
+    DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): continue %s %" PRIkernel_pid "\n",
+          thread_getpid(), "unlock", waiting_node->is_writer ? "writer" : "reader",
+          waiting_node->thread->pid);
+
+    if (rwlock->queue.first == qnode) {
+        priority_queue_remove_head(&rwlock->queue);
+    }
+    else {
+        priority_queue_remove(&rwlock->queue, qnode);
+    }
+    waiting_node->continue_ = true;
+    sched_set_status(waiting_node->thread, STATUS_PENDING);
+
+    return qnode->priority;
+}
+
+/* picks the writer to continue next, NULL means readers go first */
+static priority_queue_node_t *_next_writer(const pthread_rwlock_t *rwlock)
+{
+    priority_queue_node_t *qnode = rwlock->queue.first;
+
+#if PTHREAD_RWLOCK_POLICY == PTHREAD_RWLOCK_PREFER_READERS
+    for (priority_queue_node_t *n = qnode; n; n = n->next) {
+        if (!_is_writer(n)) {
+            return NULL;
+        }
+    }
+    return qnode;
+#elif PTHREAD_RWLOCK_POLICY == PTHREAD_RWLOCK_PREFER_WRITERS
+    while (qnode && !_is_writer(qnode)) {
+        qnode = qnode->next;
+    }
+    return qnode;
+#else
+    return _is_writer(qnode) ? qnode : NULL;
+#endif
 }
 
 int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
@@ -243,70 +376,81 @@ int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
         return EINVAL;
     }
 
+    unsigned state = __atomic_load_n(&rwlock->state, __ATOMIC_SEQ_CST);
+    while (!(state & PTHREAD_RWLOCK_WAITERS)) {
+        if (state == 0) {
+            /* the lock is open */
+            DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): lock is open\n", thread_getpid(), "unlock");
+            return EPERM;
+        }
+        /* nobody is waiting: drop the writer bit or one reader */
+        unsigned next = (state & PTHREAD_RWLOCK_WRITER) ? 0 : state - 1;
+        if (_cas(&rwlock->state, &state, next, true)) {
+            return 0;
+        }
+    }
+
     mutex_lock(&rwlock->mutex);
-    if (rwlock->readers == 0) {
+    state = __atomic_load_n(&rwlock->state, __ATOMIC_SEQ_CST);
+    if ((state & (PTHREAD_RWLOCK_WRITER | PTHREAD_RWLOCK_READERS)) == 0) {
         /* the lock is open */
         DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): lock is open\n", thread_getpid(), "unlock");
         mutex_unlock(&rwlock->mutex);
         return EPERM;
     }
 
-    if (rwlock->readers > 0) {
-        DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): release %s lock\n", thread_getpid(), "unlock", "read");
-        --rwlock->readers;
+    if (state & PTHREAD_RWLOCK_WRITER) {
+        DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): release %s lock\n", thread_getpid(), "unlock", "write");
+        state = __atomic_fetch_and(&rwlock->state, ~PTHREAD_RWLOCK_WRITER, __ATOMIC_SEQ_CST) & ~PTHREAD_RWLOCK_WRITER;
     }
     else {
-        DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): release %s lock\n", thread_getpid(), "unlock", "write");
-        rwlock->readers = 0;
+        DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): release %s lock\n", thread_getpid(), "unlock", "read");
+        state = __atomic_fetch_sub(&rwlock->state, 1, __ATOMIC_SEQ_CST) - 1;
     }
 
-    if (rwlock->readers != 0 || rwlock->queue.first == NULL) {
+    if ((state & PTHREAD_RWLOCK_READERS) || rwlock->queue.first == NULL) {
         /* this thread was not the last reader, or no one is waiting to aquire the lock */
         DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): no one is waiting\n", thread_getpid(), "unlock");
         mutex_unlock(&rwlock->mutex);
         return 0;
     }
 
-    /* wake up the next thread */
-    priority_queue_node_t *qnode = priority_queue_remove_head(&rwlock->queue);
-    __pthread_rwlock_waiter_node_t *waiting_node = (__pthread_rwlock_waiter_node_t *) qnode->data;
-    waiting_node->continue_ = true;
-    uint16_t prio = qnode->priority;
-    sched_set_status(waiting_node->thread, STATUS_PENDING);
-
-    if (waiting_node->is_writer) {
-        DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): continue %s %" PRIkernel_pid "\n",
-              thread_getpid(), "unlock", "writer", waiting_node->thread->pid);
-        --rwlock->readers;
+    /* wake up the next thread(s) */
+    uint16_t prio;
+    priority_queue_node_t *qnode = _next_writer(rwlock);
+    if (qnode) {
+        if (!_acquire(rwlock, true)) {
+            /* a reader joined on the fast path, it will continue the writer */
+            mutex_unlock(&rwlock->mutex);
+            return 0;
+        }
+        prio = _continue(rwlock, qnode);
     }
     else {
-        DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): continue %s %" PRIkernel_pid "\n",
-              thread_getpid(), "unlock", "reader", waiting_node->thread->pid);
-        ++rwlock->readers;
-
-        /* wake up further readers */
-        while (rwlock->queue.first) {
-            waiting_node = (__pthread_rwlock_waiter_node_t *) rwlock->queue.first->data;
-            if (waiting_node->is_writer) {
+        prio = rwlock->queue.first->priority;
+        qnode = rwlock->queue.first;
+        while (qnode) {
+            priority_queue_node_t *next = qnode->next;
+            if (!_is_writer(qnode)) {
+                __atomic_fetch_add(&rwlock->state, 1, __ATOMIC_SEQ_CST);
+                uint16_t qprio = _continue(rwlock, qnode);
+                if (qprio < prio) {
+                    prio = qprio;
+                }
+            }
+#if PTHREAD_RWLOCK_POLICY == PTHREAD_RWLOCK_PRIORITY_FAIR
+            else {
                 /* Not to be unfair to writers, we don't try to wake up readers that came after the first writer. */
                 DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): continuing readers blocked by writer %" PRIkernel_pid "\n",
-                      thread_getpid(), "unlock", waiting_node->thread->pid);
+                      thread_getpid(), "unlock",
+                      ((__pthread_rwlock_waiter_node_t *) qnode->data)->thread->pid);
                 break;
             }
-            waiting_node->continue_ = true;
-            DEBUG("Thread %" PRIkernel_pid ": pthread_rwlock_%s(): continue %s %" PRIkernel_pid "\n",
-                  thread_getpid(), "unlock", "reader", waiting_node->thread->pid);
-
-            /* wake up this reader */
-            qnode = priority_queue_remove_head(&rwlock->queue);
-            if (qnode->priority < prio) {
-                prio = qnode->priority;
-            }
-            sched_set_status(waiting_node->thread, STATUS_PENDING);
-
-            ++rwlock->readers;
+#endif
+            qnode = next;
         }
     }
+    _clear_waiters(rwlock);
 
     mutex_unlock(&rwlock->mutex);
 
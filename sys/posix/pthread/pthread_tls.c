@@ -16,107 +16,75 @@
  * @}
  */
 
-#include "pthread.h"
+#include <errno.h>
+#include <stdbool.h>
 
-#ifdef HAVE_MALLOC_H
-#include <malloc.h>
-#endif
+#include "pthread.h"
 
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
-typedef struct __pthread_tls_datum {
-    pthread_key_t key;
-    struct __pthread_tls_datum *next;
-    void *value;
-} tls_data_t;
-
 struct __pthread_tls_key {
     void (*destructor)(void *);
+    uint16_t generation;
+    bool used;
 };
 
 /**
- * @brief   Used while manipulating the TLS of a pthread.
+ * @brief   All thread-specific keys, a key's index is its slot in the TLS of
+ *          each pthread.
  */
-static mutex_t tls_mutex;
+static struct __pthread_tls_key tls_keys[PTHREAD_TLS_KEYS];
 
 /**
- * @brief        Find a thread-specific datum.
- * @param[in]    tls    Pointer to the list of the thread-specific datums.
- * @param[in]    key    The key to look up.
- * @param[out]   prev   The datum before the result. `NULL` if the result is the first key. Spurious if the key was not found.
- * @returns      The datum or `NULL`.
+ * @brief   Used while creating and deleting keys.
  */
-static tls_data_t *find_specific(tls_data_t **tls, pthread_key_t key, tls_data_t **prev)
-{
-    tls_data_t *specific = *tls;
-    *prev = NULL;
-
-    while (specific) {
-        if (specific->key == key) {
-            return specific;
-        }
-
-        *prev = specific;
-        specific = specific->next;
-    }
-
-    return 0;
-}
+static mutex_t tls_mutex;
 
 /**
- * @brief       Find or allocate a thread specific datum.
- * @details     The `key` must be initialized.
- *              The result will be the head of the thread-specific datums afterwards.
- * @param[in]   key   The key to lookup.
- * @returns     The datum. `NULL` on ENOMEM or if the caller is not a pthread.
+ * @brief       Find the thread-specific datum of the calling pthread.
+ * @param[in]   key   The key to look up.
+ * @returns     The datum. `NULL` if the key is invalid or if the caller is
+ *              not a pthread.
  */
-static tls_data_t *get_specific(pthread_key_t key)
+static struct __pthread_tls_datum *get_specific(pthread_key_t key)
 {
+    if ((key < &tls_keys[0]) || (key > &tls_keys[PTHREAD_TLS_KEYS - 1]) ||
+        !key->used) {
+        return NULL;
+    }
+
     pthread_t self_id = pthread_self();
     if (self_id == 0) {
         DEBUG("ERROR called pthread_self() returned 0 in \"%s\"!\n", __func__);
         return NULL;
     }
 
-    tls_data_t **tls = __pthread_get_tls_head(self_id);
-    tls_data_t *prev, *specific = find_specific(tls, key, &prev);
-
-    /* Did the datum already exist? */
-    if (specific) {
-        if (prev) {
-            /* Move the datum to the front for a faster next lookup. */
-            /* Let's pretend that we have a totally degenerated splay tree. ;-) */
-            prev->next = specific->next;
-            specific->next = *tls;
-            *tls = specific;
-        }
-        return specific;
-    }
-
-    /* Allocate new datum. */
-    specific = malloc(sizeof (*specific));
-    if (specific) {
-        specific->key = key;
-        specific->next = *tls;
-        specific->value = NULL;
-        *tls = specific;
-    }
-    else {
-        DEBUG("ERROR out of memory in %s!\n", __func__);
-    }
-    return specific;
+    return &__pthread_get_tls(self_id)[key - tls_keys];
 }
 
 int pthread_key_create(pthread_key_t *key, void (*destructor)(void *))
 {
-    *key = malloc(sizeof (**key));
-    if (!*key) {
-        return ENOMEM;
+    int res = EAGAIN;
+
+    mutex_lock(&tls_mutex);
+    for (unsigned i = 0; i < PTHREAD_TLS_KEYS; i++) {
+        if (!tls_keys[i].used) {
+            /* values stored for a previous key in this slot become invalid,
+             * generation 0 is reserved for slots that were never set */
+            if (++tls_keys[i].generation == 0) {
+                tls_keys[i].generation = 1;
+            }
+            tls_keys[i].destructor = destructor;
+            tls_keys[i].used = true;
+            *key = &tls_keys[i];
+            res = 0;
+            break;
+        }
     }
+    mutex_unlock(&tls_mutex);
 
-    (*key)->destructor = destructor;
-    return 0;
+    return res;
 }
 
 int pthread_key_delete(pthread_key_t key)
@@ -125,76 +93,63 @@ int pthread_key_delete(pthread_key_t key)
         return EINVAL;
     }
 
-    mutex_lock(&tls_mutex);
-    for (unsigned i = 1; i <= MAXTHREADS; ++i) {
-        tls_data_t **tls = __pthread_get_tls_head(i);
-        if (!tls) {
-            continue;
-        }
-
-        tls_data_t *prev, *specific = find_specific(tls, key, &prev);
-        if (specific) {
-            if (prev) {
-                prev->next = specific->next;
-            }
-            else {
-                *tls = specific->next;
-            }
-            free(specific);
-        }
+    /* deleting an unknown key is a no-op */
+    if ((key >= &tls_keys[0]) && (key <= &tls_keys[PTHREAD_TLS_KEYS - 1])) {
+        mutex_lock(&tls_mutex);
+        key->used = false;
+        mutex_unlock(&tls_mutex);
     }
-    mutex_unlock(&tls_mutex);
 
     return 0;
 }
 
 void *pthread_getspecific(pthread_key_t key)
 {
-    if (!key) {
-        return NULL;
-    }
+    struct __pthread_tls_datum *specific = get_specific(key);
 
-    mutex_lock(&tls_mutex);
-    tls_data_t *specific = get_specific(key);
-    void *result = specific ? specific->value : NULL;
-    mutex_unlock(&tls_mutex);
-
-    return result;
+    if (specific && (specific->generation == key->generation)) {
+        return specific->value;
+    }
+    return NULL;
 }
 
 int pthread_setspecific(pthread_key_t key, const void *value)
 {
-    if (!key) {
+    struct __pthread_tls_datum *specific = get_specific(key);
+
+    if (!specific) {
         return EINVAL;
     }
+    specific->value = (void *) value;
+    specific->generation = key->generation;
 
-    mutex_lock(&tls_mutex);
-    tls_data_t *specific = get_specific(key);
-    if (specific) {
-        specific->value = (void *) value;
-    }
-    mutex_unlock(&tls_mutex);
-
-    return specific ? 0 : ENOMEM;
+    return 0;
 }
 
 void __pthread_keys_exit(int self_id)
 {
-    tls_data_t **tls = __pthread_get_tls_head(self_id);
+    struct __pthread_tls_datum *tls = __pthread_get_tls(self_id);
 
-    /* Calling the dtor could cause another pthread_exit(), so we dehead and free defore calling it. */
-    mutex_lock(&tls_mutex);
-    for (tls_data_t *specific; (specific = *tls); ) {
-        *tls = specific->next;
-        void *value = specific->value;
-        void (*destructor)(void *) = specific->key->destructor;
-        free(specific);
-
-        if (value && destructor) {
-            mutex_unlock(&tls_mutex);
-            destructor(value);
-            mutex_lock(&tls_mutex);
+    /* Destructors may set new values, so repeat until all values are gone. */
+    for (unsigned round = 0; round < PTHREAD_TLS_DTOR_ITERATIONS; round++) {
+        bool called = false;
+
+        for (unsigned i = 0; i < PTHREAD_TLS_KEYS; i++) {
+            struct __pthread_tls_key *key = &tls_keys[i];
+            void *value = tls[i].value;
+
+            if (!key->used || (tls[i].generation != key->generation) || !value) {
+                continue;
+            }
+            /* clear before calling the dtor, so it can set a new value */
+            tls[i].value = NULL;
+            if (key->destructor) {
+                key->destructor(value);
+                called = true;
+            }
+        }
+        if (!called) {
+            break;
         }
     }
-    mutex_unlock(&tls_mutex);
 }
@@ -21,12 +21,20 @@
 #include <errno.h>
 #include <stdbool.h>
 #include <string.h>
+#ifdef MODULE_POSIX_POLL
+#include <poll.h>
+#endif
 
 #include "bitfield.h"
 #include "mutex.h"
 #include "net/ipv4/addr.h"
 #include "net/ipv6/addr.h"
 #include "random.h"
+#ifdef MODULE_POSIX_POLL
+#include "irq.h"
+#include "thread.h"
+#include "thread_flags.h"
+#endif
 #include "vfs.h"
 
 #include "sys/socket.h"
@@ -79,9 +87,15 @@ typedef struct {
     unsigned queue_array_len;
 #endif
     sock_tcp_ep_t local;        /* to store bind before connect/listen */
+#ifdef MODULE_POSIX_POLL
+    /* threads waiting in poll() on this socket, by pid - KERNEL_PID_FIRST */
+    BITFIELD(poll_waiters, MAXTHREADS);
+#endif
 } socket_t;
 
 static socket_t _socket_pool[_ACTUAL_SOCKET_POOL_SIZE];
+/* maps file descriptors to sockets, so look-ups don't need to search the pool */
+static socket_t *_fd_sockets[VFS_MAX_OPEN_FILES];
 static socket_sock_t _sock_pool[SOCKET_POOL_SIZE];
 #ifdef MODULE_SOCK_TCP
 static sock_tcp_t _tcp_sock_pool[SOCKET_POOL_SIZE][SOCKET_TCP_QUEUE_SIZE];
@@ -99,6 +113,8 @@ static ssize_t socket_recvfrom(socket_t *s, void *restrict buffer,
 static ssize_t socket_sendto(socket_t *s, const void *buffer, size_t length,
                              int flags, const struct sockaddr *address,
                              socklen_t address_len);
+static int _bind_connect(socket_t *s, const struct sockaddr *address,
+                         socklen_t address_len);
 
 static socket_t *_get_free_socket(void)
 {
@@ -121,12 +137,10 @@ static socket_sock_t *_get_free_sock(void)
 
 static socket_t *_get_socket(int fd)
 {
-    for (int i = 0; i < _ACTUAL_SOCKET_POOL_SIZE; i++) {
-        if (_socket_pool[i].fd == fd) {
-            return &_socket_pool[i];
-        }
+    if ((unsigned)fd >= VFS_MAX_OPEN_FILES) {
+        return NULL;
     }
-    return NULL;
+    return _fd_sockets[fd];
 }
 
 static int _get_sock_idx(socket_sock_t *sock)
@@ -283,6 +297,7 @@ static int socket_close(vfs_file_t *filp)
             bf_unset(_sock_pool_used, idx);
         }
     }
+    _fd_sockets[s->fd] = NULL;
     mutex_unlock(&_socket_pool_mutex);
     s->sock = NULL;
     s->domain = AF_UNSPEC;
@@ -316,6 +331,98 @@ static inline ssize_t socket_write(vfs_file_t *filp, const void *buf, size_t n)
     return socket_sendto(filp->private_data.ptr, buf, n, 0, NULL, 0);
 }
 
+#ifdef MODULE_POSIX_POLL
+static void _poll_register(socket_t *s, kernel_pid_t waiter)
+{
+    unsigned state = irq_disable();
+
+    if (waiter != KERNEL_PID_UNDEF) {
+        bf_set(s->poll_waiters, waiter - KERNEL_PID_FIRST);
+    }
+    else {
+        bf_unset(s->poll_waiters, sched_active_pid - KERNEL_PID_FIRST);
+    }
+    irq_restore(state);
+}
+
+static void _poll_wake(socket_t *s)
+{
+    unsigned state = irq_disable();
+
+    for (unsigned i = 0; i < MAXTHREADS; i++) {
+        if (bf_isset(s->poll_waiters, i)) {
+            thread_t *thread = (thread_t *)thread_get(KERNEL_PID_FIRST + i);
+
+            if (thread != NULL) {
+                thread_flags_set(thread, VFS_POLL_THREAD_FLAG);
+            }
+        }
+    }
+    irq_restore(state);
+}
+
+static int socket_poll(vfs_file_t *filp, int events, kernel_pid_t waiter)
+{
+    socket_t *s = filp->private_data.ptr;
+    /* sending is synchronous for all sock types */
+    int revents = events & POLLOUT;
+
+    _poll_register(s, waiter);
+    if (!(events & POLLIN)) {
+        return revents;
+    }
+    if (s->sock == NULL) {
+#ifdef MODULE_SOCK_TCP
+        if (s->type == SOCK_STREAM) {
+            /* neither listening nor connected */
+            return revents | POLLHUP;
+        }
+#endif
+        if (!s->bound) {
+            /* nothing can be received before the socket is bound, the waiter
+             * is woken up by the first packet after connect() or sendto() */
+            return revents;
+        }
+        /* bind() only stores the address, register with the stack now so
+         * packets can arrive */
+        if (_bind_connect(s, NULL, 0) < 0) {
+            return revents | POLLERR;
+        }
+    }
+    switch (s->type) {
+#if defined(MODULE_GNRC_SOCK_ASYNC) && defined(MODULE_SOCK_IP)
+        case SOCK_RAW:
+            if (cib_avail(&s->sock->raw.reg.mbox.cib)) {
+                revents |= POLLIN;
+            }
+            break;
+#endif
+#if defined(MODULE_GNRC_SOCK_ASYNC) && defined(MODULE_SOCK_UDP)
+        case SOCK_DGRAM:
+            if (cib_avail(&s->sock->udp.reg.mbox.cib)) {
+                revents |= POLLIN;
+            }
+            break;
+#endif
+        default:
+            /* the stack does not provide readiness information: report the
+             * socket as readable, so the caller falls back to a blocking
+             * receive */
+            revents |= POLLIN;
+            break;
+    }
+    return revents;
+}
+
+#ifdef MODULE_GNRC_SOCK_ASYNC
+static void _sock_async_cb(gnrc_sock_reg_t *reg, void *arg)
+{
+    (void)reg;
+    _poll_wake(arg);
+}
+#endif
+#endif
+
 static const vfs_file_ops_t socket_ops = {
     .close = socket_close,
     .fcntl = NULL,          /* TODO: provide when needed */
@@ -323,6 +430,9 @@ static const vfs_file_ops_t socket_ops = {
     .lseek = socket_lseek,
     .read = socket_read,
     .write = socket_write,
+#ifdef MODULE_POSIX_POLL
+    .poll = socket_poll,
+#endif
 };
 
 int socket(int domain, int type, int protocol)
@@ -352,7 +462,11 @@ int socket(int domain, int type, int protocol)
             }
             else {
                 s->fd = res = fd;
+                _fd_sockets[fd] = s;
             }
+#ifdef MODULE_POSIX_POLL
+            memset(s->poll_waiters, 0, sizeof(s->poll_waiters));
+#endif
             s->domain = domain;
             s->type = type;
             if ((s->protocol = _choose_ipproto(type, protocol)) < 0) {
@@ -451,7 +565,11 @@ int accept(int socket, struct sockaddr *restrict address,
                 }
                 else {
                     new_s->fd = res = fd;
+                    _fd_sockets[fd] = new_s;
                 }
+#ifdef MODULE_POSIX_POLL
+                memset(new_s->poll_waiters, 0, sizeof(new_s->poll_waiters));
+#endif
                 new_s->domain = s->domain;
                 new_s->type = s->type;
                 new_s->protocol = s->protocol;
@@ -590,6 +708,32 @@ static int _bind_connect(socket_t *s, const struct sockaddr *address,
         mutex_unlock(&_socket_pool_mutex);
         return -1;
     }
+#if defined(MODULE_POSIX_POLL) && defined(MODULE_GNRC_SOCK_ASYNC)
+    gnrc_sock_reg_t *reg = NULL;
+
+    switch (s->type) {
+#ifdef MODULE_SOCK_IP
+        case SOCK_RAW:
+            reg = &sock->raw.reg;
+            break;
+#endif
+#ifdef MODULE_SOCK_UDP
+        case SOCK_DGRAM:
+            reg = &sock->udp.reg;
+            break;
+#endif
+        default:
+            break;
+    }
+    if (reg != NULL) {
+        reg->async_cb_arg = s;
+        reg->async_cb = _sock_async_cb;
+        /* packets queued since the sock was registered didn't wake anyone */
+        if (cib_avail(&reg->mbox.cib)) {
+            _poll_wake(s);
+        }
+    }
+#endif
     s->sock = sock;
     return 0;
 }
@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_saul_dsp
+ * @{
+ *
+ * @file
+ * @brief       SAUL sample pipeline implementation
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "saul_dsp.h"
+#include "xtimer.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+/* orders buffer accesses before publishing a new position, sufficient on
+ * single core systems */
+#define BARRIER()       __asm__ volatile ("" : : : "memory")
+
+#define FFT_SIZE_MAX    (1U << SAUL_DSP_FFT_LOG2_MAX)
+
+/* first quarter of sin(2 * pi * k / FFT_SIZE_MAX) in Q15 */
+static const int16_t _sin_table[FFT_SIZE_MAX / 4 + 1] = {
+        0,   804,  1608,  2411,  3212,  4011,  4808,  5602,
+     6393,  7180,  7962,  8740,  9512, 10279, 11039, 11793,
+    12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531,
+    18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595,
+    23170, 23732, 24279, 24812, 25330, 25833, 26320, 26791,
+    27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+    30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972,
+    32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758,
+    32767,
+};
+
+static inline int16_t _sat16(int64_t val)
+{
+    if (val > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (val < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)val;
+}
+
+static int16_t _sin(unsigned k)
+{
+    k &= FFT_SIZE_MAX - 1;
+    if (k <= FFT_SIZE_MAX / 4) {
+        return _sin_table[k];
+    }
+    if (k <= FFT_SIZE_MAX / 2) {
+        return _sin_table[FFT_SIZE_MAX / 2 - k];
+    }
+    if (k <= 3 * FFT_SIZE_MAX / 4) {
+        return -_sin_table[k - FFT_SIZE_MAX / 2];
+    }
+    return -_sin_table[FFT_SIZE_MAX - k];
+}
+
+static uint32_t _isqrt(uint32_t val)
+{
+    uint32_t res = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > val) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (val >= res + bit) {
+            val -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+void saul_dsp_ring_init(saul_dsp_ring_t *ring, int16_t *buf, size_t size)
+{
+    assert(size && !(size & (size - 1)));
+
+    ring->buf = buf;
+    ring->mask = size - 1;
+    ring->reads = 0;
+    ring->writes = 0;
+}
+
+int saul_dsp_ring_put(saul_dsp_ring_t *ring, int16_t sample)
+{
+    unsigned writes = ring->writes;
+
+    if ((writes - ring->reads) > ring->mask) {
+        return -ENOBUFS;
+    }
+    ring->buf[writes & ring->mask] = sample;
+    BARRIER();
+    ring->writes = writes + 1;
+    return 0;
+}
+
+int16_t *saul_dsp_ring_write_ptr(saul_dsp_ring_t *ring, size_t *len)
+{
+    unsigned writes = ring->writes;
+    unsigned pos = writes & ring->mask;
+    size_t free = ring->mask + 1 - (writes - ring->reads);
+    size_t contiguous = ring->mask + 1 - pos;
+
+    *len = (free < contiguous) ? free : contiguous;
+    return &ring->buf[pos];
+}
+
+void saul_dsp_ring_commit(saul_dsp_ring_t *ring, size_t len)
+{
+    BARRIER();
+    ring->writes += len;
+}
+
+size_t saul_dsp_ring_get(saul_dsp_ring_t *ring, int16_t *dst, size_t len)
+{
+    unsigned reads = ring->reads;
+    size_t avail = ring->writes - reads;
+
+    if (len > avail) {
+        len = avail;
+    }
+    BARRIER();
+    for (size_t done = 0; done < len;) {
+        unsigned pos = (reads + done) & ring->mask;
+        size_t chunk = ring->mask + 1 - pos;
+
+        if (chunk > (len - done)) {
+            chunk = len - done;
+        }
+        memcpy(&dst[done], &ring->buf[pos], chunk * sizeof(int16_t));
+        done += chunk;
+    }
+    BARRIER();
+    ring->reads = reads + len;
+    return len;
+}
+
+void saul_dsp_acq_init(saul_dsp_acq_t *acq, saul_reg_t *dev, uint8_t dim,
+                       saul_dsp_ring_t *ring, uint32_t period)
+{
+    assert(dim < PHYDAT_DIM);
+
+    acq->dev = dev;
+    acq->ring = ring;
+    acq->period = period;
+    acq->overruns = 0;
+    acq->dim = dim;
+    acq->unit = UNIT_UNDEF;
+    acq->scale = 0;
+}
+
+int saul_dsp_acquire(saul_dsp_acq_t *acq, size_t num)
+{
+    xtimer_ticks32_t last_wakeup = xtimer_now();
+
+    for (size_t i = 0; i < num; i++) {
+        phydat_t data;
+        int res = saul_reg_read(acq->dev, &data);
+
+        if (res < 0) {
+            return res;
+        }
+        if (res <= acq->dim) {
+            return -EINVAL;
+        }
+        acq->unit = data.unit;
+        acq->scale = data.scale;
+        if (saul_dsp_ring_put(acq->ring, data.val[acq->dim]) < 0) {
+            acq->overruns++;
+        }
+        if (acq->period && (i + 1 < num)) {
+            xtimer_periodic_wakeup(&last_wakeup, acq->period);
+        }
+    }
+    return num;
+}
+
+size_t saul_dsp_process(saul_dsp_stage_t *first, int16_t *block, size_t len)
+{
+    for (saul_dsp_stage_t *stage = first; stage && len; stage = stage->next) {
+        len = stage->process(stage, block, len);
+    }
+    return len;
+}
+
+static size_t _fir_process(saul_dsp_stage_t *stage, int16_t *block,
+                           size_t len)
+{
+    saul_dsp_fir_t *fir = (saul_dsp_fir_t *)stage;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned pos = fir->pos;
+        int64_t acc = 0;
+
+        fir->state[pos] = block[i];
+        for (unsigned t = 0; t < fir->taps; t++) {
+            acc += (int32_t)fir->coeffs[t] * fir->state[pos];
+            pos = (pos == 0) ? (fir->taps - 1U) : (pos - 1U);
+        }
+        fir->pos = (fir->pos + 1U == fir->taps) ? 0 : fir->pos + 1U;
+        block[i] = _sat16(acc >> 15);
+    }
+    return len;
+}
+
+void saul_dsp_fir_init(saul_dsp_fir_t *fir, const int16_t *coeffs,
+                       uint8_t taps)
+{
+    assert(taps && (taps <= SAUL_DSP_FIR_TAPS_MAX));
+
+    memset(fir, 0, sizeof(*fir));
+    fir->stage.process = _fir_process;
+    fir->coeffs = coeffs;
+    fir->taps = taps;
+}
+
+static size_t _dc_process(saul_dsp_stage_t *stage, int16_t *block,
+                          size_t len)
+{
+    saul_dsp_dc_t *dc = (saul_dsp_dc_t *)stage;
+
+    for (size_t i = 0; i < len; i++) {
+        /* y[n] = x[n] - x[n - 1] + alpha * y[n - 1], y kept in Q15 */
+        int64_t out = ((int64_t)block[i] - dc->last_in) * 32768 +
+                      (((int64_t)dc->alpha * dc->last_out) >> 15);
+        int16_t sat = _sat16(out >> 15);
+
+        if (sat != (out >> 15)) {
+            out = (int64_t)sat * 32768;
+        }
+        dc->last_in = block[i];
+        dc->last_out = out;
+        block[i] = sat;
+    }
+    return len;
+}
+
+void saul_dsp_dc_init(saul_dsp_dc_t *dc, int16_t alpha)
+{
+    memset(dc, 0, sizeof(*dc));
+    dc->stage.process = _dc_process;
+    dc->alpha = alpha;
+}
+
+static size_t _decim_process(saul_dsp_stage_t *stage, int16_t *block,
+                             size_t len)
+{
+    saul_dsp_decim_t *decim = (saul_dsp_decim_t *)stage;
+    size_t out = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        decim->sum += block[i];
+        if (++decim->count == decim->factor) {
+            block[out++] = decim->sum / decim->factor;
+            decim->sum = 0;
+            decim->count = 0;
+        }
+    }
+    return out;
+}
+
+void saul_dsp_decim_init(saul_dsp_decim_t *decim, uint8_t factor)
+{
+    assert(factor);
+
+    memset(decim, 0, sizeof(*decim));
+    decim->stage.process = _decim_process;
+    decim->factor = factor;
+}
+
+void saul_dsp_fft(int16_t *re, int16_t *im, unsigned log2n)
+{
+    unsigned n = 1U << log2n;
+
+    assert(log2n <= SAUL_DSP_FFT_LOG2_MAX);
+
+    /* bit reversed reordering */
+    for (unsigned i = 1, j = 0; i < n; i++) {
+        unsigned bit = n >> 1;
+
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            int16_t tmp = re[i];
+            re[i] = re[j];
+            re[j] = tmp;
+            tmp = im[i];
+            im[i] = im[j];
+            im[j] = tmp;
+        }
+    }
+
+    /* radix-2 butterflies, halving every stage */
+    for (unsigned len = 2; len <= n; len <<= 1) {
+        unsigned step = FFT_SIZE_MAX / len;
+
+        for (unsigned k = 0; k < len / 2; k++) {
+            int32_t wr = _sin(k * step + FFT_SIZE_MAX / 4);
+            int32_t wi = -_sin(k * step);
+
+            for (unsigned a = k; a < n; a += len) {
+                unsigned b = a + len / 2;
+                int32_t tr = (re[b] * wr - im[b] * wi) >> 15;
+                int32_t ti = (re[b] * wi + im[b] * wr) >> 15;
+
+                re[b] = (re[a] - tr) >> 1;
+                im[b] = (im[a] - ti) >> 1;
+                re[a] = (re[a] + tr) >> 1;
+                im[a] = (im[a] + ti) >> 1;
+            }
+        }
+    }
+}
+
+void saul_dsp_features(const int16_t *block, size_t len,
+                       saul_dsp_features_t *features)
+{
+    int64_t sum = 0;
+    uint64_t sum_sq = 0;
+    uint16_t peak = 0;
+
+    memset(features, 0, sizeof(*features));
+    if (len == 0) {
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        int32_t val = block[i];
+        uint16_t abs = (val < 0) ? -val : val;
+
+        sum += val;
+        sum_sq += (uint32_t)(val * val);
+        if (abs > peak) {
+            peak = abs;
+        }
+    }
+    features->mean = sum / (int64_t)len;
+    features->rms = _isqrt(sum_sq / len);
+    features->peak = peak;
+}
+
+void saul_dsp_spectrum_peak(int16_t *block, int16_t *scratch, unsigned log2n,
+                            saul_dsp_features_t *features)
+{
+    unsigned n = 1U << log2n;
+    uint32_t peak_sq = 0;
+
+    memset(scratch, 0, n * sizeof(int16_t));
+    saul_dsp_fft(block, scratch, log2n);
+
+    features->peak_bin = 0;
+    for (unsigned i = 1; i <= n / 2; i++) {
+        uint32_t mag_sq = (uint32_t)(block[i] * block[i]) +
+                          (uint32_t)(scratch[i] * scratch[i]);
+
+        if (mag_sq > peak_sq) {
+            peak_sq = mag_sq;
+            features->peak_bin = i;
+        }
+    }
+    features->peak_mag = _isqrt(peak_sq);
+}
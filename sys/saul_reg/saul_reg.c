@@ -18,10 +18,12 @@
  * @}
  */
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
 
+#include "mutex.h"
 #include "saul_reg.h"
 
 /**
@@ -29,6 +31,97 @@
  */
 saul_reg_t *saul_reg = NULL;
 
+#if SAUL_REG_INDEX_SIZE > 255
+#error "SAUL_REG_INDEX_SIZE must fit into uint8_t"
+#endif
+
+/**
+ * @brief   Index of the registry, positions sorted by type and by name
+ */
+static struct {
+    saul_reg_t *head;                       /**< head it was built for */
+    bool valid;                             /**< built since last change */
+    uint8_t numof;                          /**< 0 to search linearly */
+    saul_reg_t *by_pos[SAUL_REG_INDEX_SIZE];  /**< entries by position */
+    uint8_t by_type[SAUL_REG_INDEX_SIZE];     /**< positions by type */
+    uint8_t by_name[SAUL_REG_INDEX_SIZE];     /**< positions by name */
+} _index;
+
+/**
+ * @brief   Serializes building and using the index
+ */
+static mutex_t _index_lock = MUTEX_INIT;
+
+typedef int (*_cmp_t)(saul_reg_t *dev, const void *key);
+
+static int _cmp_type(saul_reg_t *dev, const void *key)
+{
+    return (int)dev->driver->type - *((const uint8_t *)key);
+}
+
+static int _cmp_name(saul_reg_t *dev, const void *key)
+{
+    return strcmp(dev->name, key);
+}
+
+/* first position in order whose entry is not less than key, or greater than
+ * key if upper is set */
+static unsigned _bound(const uint8_t *order, unsigned numof, _cmp_t cmp,
+                       const void *key, bool upper)
+{
+    unsigned lo = 0, hi = numof;
+
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        int res = cmp(_index.by_pos[order[mid]], key);
+
+        if ((res < 0) || (upper && (res == 0))) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* entries with equal keys stay in registration order, so lookups find the
+ * first registered one */
+static void _insert(uint8_t *order, unsigned numof, _cmp_t cmp,
+                    const void *key, uint8_t pos)
+{
+    unsigned i = _bound(order, numof, cmp, key, true);
+
+    memmove(&order[i + 1], &order[i], numof - i);
+    order[i] = pos;
+}
+
+/* must be called with _index_lock held, the index is only published once it
+ * is complete */
+static bool _indexed(void)
+{
+    unsigned numof = 0;
+
+    if (_index.valid && (_index.head == saul_reg)) {
+        return _index.numof > 0;
+    }
+
+    for (saul_reg_t *tmp = saul_reg; tmp; tmp = tmp->next) {
+        if (numof == SAUL_REG_INDEX_SIZE) {
+            /* too many entries, search linearly */
+            numof = 0;
+            break;
+        }
+        _index.by_pos[numof] = tmp;
+        _insert(_index.by_type, numof, _cmp_type, &tmp->driver->type, numof);
+        _insert(_index.by_name, numof, _cmp_name, tmp->name, numof);
+        numof++;
+    }
+    _index.numof = numof;
+    _index.head = saul_reg;
+    _index.valid = true;
+    return numof > 0;
+}
 
 int saul_reg_add(saul_reg_t *dev)
 {
@@ -40,6 +133,8 @@ int saul_reg_add(saul_reg_t *dev)
 
     /* prepare new entry */
     dev->next = NULL;
+    mutex_lock(&_index_lock);
+    _index.valid = false;
     /* add to registry */
     if (saul_reg == NULL) {
         saul_reg = dev;
@@ -50,16 +145,20 @@ int saul_reg_add(saul_reg_t *dev)
         }
         tmp->next = dev;
     }
+    mutex_unlock(&_index_lock);
     return 0;
 }
 
 int saul_reg_rm(saul_reg_t *dev)
 {
     saul_reg_t *tmp = saul_reg;
+    int res = 0;
 
     if (saul_reg == NULL || dev == NULL) {
         return -ENODEV;
     }
+    mutex_lock(&_index_lock);
+    _index.valid = false;
     if (saul_reg == dev) {
         saul_reg = dev->next;
     }
@@ -70,15 +169,26 @@ int saul_reg_rm(saul_reg_t *dev)
         tmp->next = dev->next;
     }
     else {
-        return -ENODEV;
+        res = -ENODEV;
     }
-    return 0;
+    mutex_unlock(&_index_lock);
+    return res;
 }
 
 saul_reg_t *saul_reg_find_nth(int pos)
 {
     saul_reg_t *tmp = saul_reg;
 
+    if (pos > 0) {
+        mutex_lock(&_index_lock);
+        if (_indexed()) {
+            tmp = (pos < _index.numof) ? _index.by_pos[pos] : NULL;
+            mutex_unlock(&_index_lock);
+            return tmp;
+        }
+        mutex_unlock(&_index_lock);
+    }
+
     for (int i = 0; (i < pos) && tmp; i++) {
         tmp = tmp->next;
     }
@@ -89,6 +199,21 @@ saul_reg_t *saul_reg_find_type(uint8_t type)
 {
     saul_reg_t *tmp = saul_reg;
 
+    mutex_lock(&_index_lock);
+    if (_indexed()) {
+        unsigned i = _bound(_index.by_type, _index.numof, _cmp_type, &type,
+                            false);
+
+        tmp = NULL;
+        if ((i < _index.numof) &&
+            (_index.by_pos[_index.by_type[i]]->driver->type == type)) {
+            tmp = _index.by_pos[_index.by_type[i]];
+        }
+        mutex_unlock(&_index_lock);
+        return tmp;
+    }
+    mutex_unlock(&_index_lock);
+
     while (tmp) {
         if (tmp->driver->type == type) {
             return tmp;
@@ -102,6 +227,21 @@ saul_reg_t *saul_reg_find_name(const char *name)
 {
     saul_reg_t *tmp = saul_reg;
 
+    mutex_lock(&_index_lock);
+    if (_indexed()) {
+        unsigned i = _bound(_index.by_name, _index.numof, _cmp_name, name,
+                            false);
+
+        tmp = NULL;
+        if ((i < _index.numof) &&
+            (strcmp(_index.by_pos[_index.by_name[i]]->name, name) == 0)) {
+            tmp = _index.by_pos[_index.by_name[i]];
+        }
+        mutex_unlock(&_index_lock);
+        return tmp;
+    }
+    mutex_unlock(&_index_lock);
+
     while (tmp) {
         if (strcmp(tmp->name, name) == 0) {
             return tmp;
@@ -119,6 +259,52 @@ int saul_reg_read(saul_reg_t *dev, phydat_t *res)
     return dev->driver->read(dev->dev, res);
 }
 
+int saul_reg_read_batch(saul_reg_t *const *devs, phydat_t *res, int *dims,
+                        size_t num)
+{
+    int read = 0;
+
+    for (size_t i = 0; i < num;) {
+        saul_reg_t *dev = devs[i];
+        size_t n = 1;
+        int dim = -ENOTSUP;
+
+        if (dev == NULL) {
+            dim = -ENODEV;
+        }
+        else if (dev->driver->read_multi) {
+            const void *descs[SAUL_REG_BATCH_MAX];
+
+            descs[0] = dev->dev;
+            while ((i + n < num) && (n < SAUL_REG_BATCH_MAX) && devs[i + n] &&
+                   (devs[i + n]->driver == dev->driver)) {
+                descs[n] = devs[i + n]->dev;
+                n++;
+            }
+            if (n > 1) {
+                dim = dev->driver->read_multi(descs, &res[i], n);
+            }
+        }
+
+        for (size_t j = i; j < i + n; j++) {
+            int d = dim;
+
+            if (d == -ENOTSUP) {
+                /* no batch support for this run, read one by one */
+                d = devs[j]->driver->read(devs[j]->dev, &res[j]);
+            }
+            if (dims) {
+                dims[j] = d;
+            }
+            if (d > 0) {
+                read++;
+            }
+        }
+        i += n;
+    }
+    return read;
+}
+
 int saul_reg_write(saul_reg_t *dev, phydat_t *data)
 {
     if (dev == NULL) {
@@ -25,6 +25,7 @@
  * @}
  */
 
+#include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -32,7 +33,6 @@
 #include "shell.h"
 #include "shell_commands.h"
 
-#if !defined(SHELL_NO_ECHO) || !defined(SHELL_NO_PROMPT)
 #ifdef MODULE_NEWLIB
 /* use local copy of putchar, as it seems to be inlined,
  * enlarging code by 50% */
@@ -42,15 +42,120 @@ static void _putchar(int c) {
 #else
 #define _putchar putchar
 #endif
+
+#ifdef MODULE_SHELL_COMMANDS
+#define BUILTIN_COMMANDS    _shell_command_list
+#else
+#define BUILTIN_COMMANDS    ((const shell_command_t *)NULL)
 #endif
 
-static shell_command_handler_t find_handler(const shell_command_t *command_list, char *command)
+static void _write(shell_session_t *session, const char *buf, size_t len)
+{
+    if (session->write) {
+        session->write(session, buf, len);
+        return;
+    }
+    while (len--) {
+        _putchar(*buf++);
+    }
+}
+
+static void _write_str(shell_session_t *session, const char *str)
+{
+    _write(session, str, strlen(str));
+}
+
+static void _write_line(shell_session_t *session, const char *str)
 {
+    _write_str(session, str);
+    _write(session, "\n", 1);
+}
+
+static const shell_command_t *_entry(const shell_index_t *index, unsigned pos)
+{
+    if (pos < index->user_numof) {
+        return &index->commands[pos];
+    }
+    return &BUILTIN_COMMANDS[pos - index->user_numof];
+}
+
+void shell_index_init(shell_index_t *index, const shell_command_t *commands)
+{
+    const shell_command_t *command_lists[] = { commands, BUILTIN_COMMANDS };
+    unsigned pos = 0;
+
+    index->commands = commands;
+    index->user_numof = 0;
+    index->numof = 0;
+
+    for (unsigned i = 0; i < sizeof(command_lists) / sizeof(commands); i++) {
+        const shell_command_t *entry = command_lists[i];
+
+        for (; entry && entry->name; entry++, pos++) {
+            if ((index->numof == SHELL_INDEX_SIZE) || (pos > UINT8_MAX)) {
+                /* too many commands, search linearly */
+                index->numof = 0;
+                return;
+            }
+            if (i == 0) {
+                index->user_numof++;
+            }
+
+            /* insert sorted by name, the first of equally named commands
+             * wins */
+            unsigned lo = 0, hi = index->numof;
+            while (lo < hi) {
+                unsigned mid = (lo + hi) / 2;
+                int cmp = strcmp(entry->name,
+                                 _entry(index, index->order[mid])->name);
+                if (cmp == 0) {
+                    break;
+                }
+                else if (cmp < 0) {
+                    hi = mid;
+                }
+                else {
+                    lo = mid + 1;
+                }
+            }
+            if (lo < hi) {
+                continue;
+            }
+            memmove(&index->order[lo + 1], &index->order[lo],
+                    index->numof - lo);
+            index->order[lo] = pos;
+            index->numof++;
+        }
+    }
+}
+
+const shell_command_t *shell_index_find(const shell_index_t *index,
+                                        const char *name)
+{
+    if (index->numof) {
+        unsigned lo = 0, hi = index->numof;
+
+        while (lo < hi) {
+            unsigned mid = (lo + hi) / 2;
+            const shell_command_t *entry = _entry(index, index->order[mid]);
+            int cmp = strcmp(name, entry->name);
+
+            if (cmp == 0) {
+                return entry;
+            }
+            else if (cmp < 0) {
+                hi = mid;
+            }
+            else {
+                lo = mid + 1;
+            }
+        }
+        return NULL;
+    }
+
     const shell_command_t *command_lists[] = {
-        command_list,
-#ifdef MODULE_SHELL_COMMANDS
-        _shell_command_list,
-#endif
+        index->commands,
+        BUILTIN_COMMANDS,
     };
 
     const shell_command_t *entry;
@@ -60,8 +165,8 @@ static shell_command_handler_t find_handler(const shell_command_t *command_list,
         if ((entry = command_lists[i])) {
             /* iterating over commands in command_lists entry */
             while (entry->name != NULL) {
-                if (strcmp(entry->name, command) == 0) {
-                    return entry->handler;
+                if (strcmp(entry->name, name) == 0) {
+                    return entry;
                 }
                 else {
                     entry++;
@@ -80,9 +185,7 @@ static void print_help(const shell_command_t *command_list)
 
     const shell_command_t *command_lists[] = {
         command_list,
-#ifdef MODULE_SHELL_COMMANDS
-        _shell_command_list,
-#endif
+        BUILTIN_COMMANDS,
     };
 
     const shell_command_t *entry;
@@ -99,7 +202,7 @@ static void print_help(const shell_command_t *command_list)
     }
 }
 
-static void handle_input_line(const shell_command_t *command_list, char *line)
+static void handle_input_line(shell_session_t *session, char *line)
 {
     static const char *INCORRECT_QUOTING = "shell: incorrect quoting";
 
@@ -116,7 +219,7 @@ static void handle_input_line(const shell_command_t *command_list, char *line)
                 do {
                     ++pos;
                     if (!*pos) {
-                        puts(INCORRECT_QUOTING);
+                        _write_line(session, INCORRECT_QUOTING);
                         return;
                     }
                     else if (*pos == '\\') {
@@ -124,14 +227,14 @@ static void handle_input_line(const shell_command_t *command_list, char *line)
                         ++contains_esc_seq;
                         ++pos;
                         if (!*pos) {
-                            puts(INCORRECT_QUOTING);
+                            _write_line(session, INCORRECT_QUOTING);
                             return;
                         }
                         continue;
                     }
                 } while (*pos != quote_char);
                 if ((unsigned char) pos[1] > ' ') {
-                    puts(INCORRECT_QUOTING);
+                    _write_line(session, INCORRECT_QUOTING);
                     return;
                 }
             }
@@ -143,13 +246,13 @@ static void handle_input_line(const shell_command_t *command_list, char *line)
                         ++contains_esc_seq;
                         ++pos;
                         if (!*pos) {
-                            puts(INCORRECT_QUOTING);
+                            _write_line(session, INCORRECT_QUOTING);
                             return;
                         }
                     }
                     ++pos;
                     if (*pos == '"') {
-                        puts(INCORRECT_QUOTING);
+                        _write_line(session, INCORRECT_QUOTING);
                         return;
                     }
                 } while ((unsigned char) *pos > ' ');
@@ -203,94 +306,127 @@ static void handle_input_line(const shell_command_t *command_list, char *line)
     }
 
     /* then we call the appropriate handler */
-    shell_command_handler_t handler = find_handler(command_list, argv[0]);
-    if (handler != NULL) {
-        handler(argc, argv);
+    const shell_command_t *command = shell_index_find(session->index, argv[0]);
+    if (command != NULL) {
+        command->handler(argc, argv);
     }
     else {
         if (strcmp("help", argv[0]) == 0) {
-            print_help(command_list);
+            print_help(session->index->commands);
         }
         else {
-            printf("shell: command not found: %s\n", argv[0]);
+            _write_str(session, "shell: command not found: ");
+            _write_line(session, argv[0]);
         }
     }
 }
 
-static int readline(char *buf, size_t size)
+void shell_session_init(shell_session_t *session, const shell_index_t *index,
+                        char *line_buf, size_t len,
+                        shell_session_write_t write, void *arg)
 {
-    char *line_buf_ptr = buf;
+    session->index = index;
+    session->write = write;
+    session->arg = arg;
+    session->line_buf = line_buf;
+    session->size = len;
+    session->pos = 0;
+    session->flags = 0;
+#ifndef SHELL_NO_ECHO
+    session->flags |= SHELL_SESSION_ECHO;
+#endif
+#ifndef SHELL_NO_PROMPT
+    session->flags |= SHELL_SESSION_PROMPT;
+#endif
+}
 
-    while (1) {
-        if ((line_buf_ptr - buf) >= ((int) size) - 1) {
-            return -1;
-        }
+void shell_session_prompt(shell_session_t *session)
+{
+    if (session->flags & SHELL_SESSION_PROMPT) {
+        _write(session, "> ", 2);
+    }
 
-        int c = getchar();
-        if (c < 0) {
-            return 1;
-        }
+#ifdef MODULE_NEWLIB
+    if (!session->write) {
+        fflush(stdout);
+    }
+#endif
+}
+
+int shell_session_input(shell_session_t *session, const char *buf, size_t len)
+{
+    bool echo = session->flags & SHELL_SESSION_ECHO;
+    int lines = 0;
+
+    for (const char *end = buf + len; buf < end; buf++) {
+        char c = *buf;
 
         /* We allow Unix linebreaks (\n), DOS linebreaks (\r\n), and Mac linebreaks (\r). */
         /* QEMU transmits only a single '\r' == 13 on hitting enter ("-serial stdio"). */
         /* DOS newlines are handled like hitting enter twice, but empty lines are ignored. */
         if (c == '\r' || c == '\n') {
-            *line_buf_ptr = '\0';
-#ifndef SHELL_NO_ECHO
-            _putchar('\r');
-            _putchar('\n');
-#endif
-
-            /* return 1 if line is empty, 0 otherwise */
-            return line_buf_ptr == buf;
+            if (echo) {
+                _write(session, "\r\n", 2);
+            }
+            if (session->pos > session->size) {
+                _write_line(session, "shell: maximum line length exceeded");
+            }
+            else if (session->pos > 0) {
+                session->line_buf[session->pos] = '\0';
+                handle_input_line(session, session->line_buf);
+                lines++;
+            }
+            session->pos = 0;
+            shell_session_prompt(session);
         }
         /* QEMU uses 0x7f (DEL) as backspace, while 0x08 (BS) is for most terminals */
         else if (c == 0x08 || c == 0x7f) {
-            if (line_buf_ptr == buf) {
-                /* The line is empty. */
+            if ((session->pos == 0) || (session->pos > session->size)) {
+                /* The line is empty or dropped. */
                 continue;
             }
 
-            *--line_buf_ptr = '\0';
+            session->pos--;
             /* white-tape the character */
-#ifndef SHELL_NO_ECHO
-            _putchar('\b');
-            _putchar(' ');
-            _putchar('\b');
-#endif
+            if (echo) {
+                _write(session, "\b \b", 3);
+            }
+        }
+        else if (session->pos >= session->size - 1) {
+            /* drop the line up to its end */
+            session->pos = session->size + 1;
         }
         else {
-            *line_buf_ptr++ = c;
-#ifndef SHELL_NO_ECHO
-            _putchar(c);
-#endif
+            session->line_buf[session->pos++] = c;
+            if (echo) {
+                _write(session, &c, 1);
+            }
         }
     }
-}
-
-static inline void print_prompt(void)
-{
-#ifndef SHELL_NO_PROMPT
-    _putchar('>');
-    _putchar(' ');
-#endif
 
-#ifdef MODULE_NEWLIB
-    fflush(stdout);
-#endif
+    return lines;
 }
 
 void shell_run(const shell_command_t *shell_commands, char *line_buf, int len)
 {
-    print_prompt();
+    shell_index_t index;
+    shell_session_t session;
+
+    shell_index_init(&index, shell_commands);
+    shell_session_init(&session, &index, line_buf, len, NULL, NULL);
+    shell_session_prompt(&session);
 
     while (1) {
-        int res = readline(line_buf, len);
+        int c = getchar();
 
-        if (!res) {
-            handle_input_line(shell_commands, line_buf);
+        if (c < 0) {
+            /* drop the current line */
+            session.pos = 0;
+            shell_session_prompt(&session);
+            continue;
         }
 
-        print_prompt();
+        char ch = c;
+        shell_session_input(&session, &ch, 1);
     }
 }
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <stdbool.h>
 #ifdef MODULE_FIB
 #include "net/fib.h"
 #ifdef MODULE_GNRC_IPV6
@@ -46,6 +47,21 @@
 #   define UNIVERSAL_ADDRESS_MAX_ENTRIES    (UA_ADD0)
 #endif
 
+/**
+ * @brief Number of hash buckets used to find entries, must be a power of two
+ */
+#ifndef UNIVERSAL_ADDRESS_HASH_SIZE
+#define UNIVERSAL_ADDRESS_HASH_SIZE (16)
+#endif
+
+/**
+ * @brief marks the end of a hash chain or the free list
+ *
+ * Links store the entry index + 1, so the zero-initialized table is valid
+ * even before universal_address_init() was called.
+ */
+#define UA_NONE                     (0)
+
 /**
  * @brief counter indicating the number of entries allocated
  */
@@ -56,11 +72,70 @@ static size_t universal_address_table_filled = 0;
  */
 static universal_address_container_t universal_address_table[UNIVERSAL_ADDRESS_MAX_ENTRIES];
 
+/**
+ * @brief first entry of each hash chain
+ */
+static uint16_t universal_address_buckets[UNIVERSAL_ADDRESS_HASH_SIZE];
+
+/**
+ * @brief successor of each entry, either in its hash chain or in the free list
+ */
+static uint16_t universal_address_next[UNIVERSAL_ADDRESS_MAX_ENTRIES];
+
+/**
+ * @brief first entry of the free list
+ */
+static uint16_t universal_address_free;
+
+/**
+ * @brief number of entries from the start of the table which were ever used,
+ *        the entries behind are free but not part of the free list
+ */
+static uint16_t universal_address_touched;
+
+/**
+ * @brief entries containing only `0`s, determined when the address is stored
+ */
+static bool universal_address_all_zeros[UNIVERSAL_ADDRESS_MAX_ENTRIES];
+
 /**
  * @brief access mutex to control exclusive operations on calls
  */
 static mutex_t mtx_access = MUTEX_INIT;
 
+/**
+ * @brief computes the hash bucket for the given address
+ *
+ * @param[in] addr       pointer to the address
+ * @param[in] addr_size  the number of bytes required for the address entry
+ *
+ * @return index into universal_address_buckets
+ */
+static size_t universal_address_hash(const uint8_t *addr, size_t addr_size)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U ^ addr_size;
+
+    for (size_t i = 0; i < addr_size; ++i) {
+        hash = (hash ^ addr[i]) * 16777619U;
+    }
+
+    return hash & (UNIVERSAL_ADDRESS_HASH_SIZE - 1);
+}
+
+/**
+ * @brief drops all entries from the hash chains and the free list
+ */
+static void universal_address_rebuild(void)
+{
+    for (size_t i = 0; i < UNIVERSAL_ADDRESS_HASH_SIZE; ++i) {
+        universal_address_buckets[i] = UA_NONE;
+    }
+
+    universal_address_free = UA_NONE;
+    universal_address_touched = 0;
+}
+
 /**
  * @brief finds the universal address container for the given address
  *
@@ -68,45 +143,78 @@ static mutex_t mtx_access = MUTEX_INIT;
  * @param[in] addr_size  the number of bytes required for the address entry
  *
  * @return pointer to the universal_address_container_t containing the address on success
- *         NULL if the address could not be inserted
+ *         NULL if the address is not stored
  */
 static universal_address_container_t *universal_address_find_entry(uint8_t *addr, size_t addr_size)
 {
-    /* cppcheck-suppress unsignedLessThanZero
-     * (reason: UNIVERSAL_ADDRESS_MAX_ENTRIES may be zero in which case this
-     * code is optimized out) */
-    for (size_t i = 0; i < UNIVERSAL_ADDRESS_MAX_ENTRIES; ++i) {
-        if (universal_address_table[i].address_size == addr_size) {
-            if (memcmp((universal_address_table[i].address), addr, addr_size) == 0) {
-                return &(universal_address_table[i]);
-            }
+    uint16_t link = universal_address_buckets[universal_address_hash(addr, addr_size)];
+
+    while (link != UA_NONE) {
+        universal_address_container_t *entry = &(universal_address_table[link - 1]);
+
+        if ((entry->address_size == addr_size) &&
+            (memcmp((entry->address), addr, addr_size) == 0)) {
+            return entry;
         }
+        link = universal_address_next[link - 1];
     }
 
     return NULL;
 }
 
 /**
- * @brief finds the next empty or unused universal address containers
+ * @brief takes the next unused universal address container from the free list
+ *        and links it into the hash chain for @p addr
+ *
+ * @param[in] addr       pointer to the address
+ * @param[in] addr_size  the number of bytes required for the address entry
  *
  * @return pointer to the next free/unused universal_address_container_t
  *         or NULL if no memory is left in universal_address_table
  */
-static universal_address_container_t *universal_address_get_next_unused_entry(void)
+static universal_address_container_t *universal_address_get_next_unused_entry(uint8_t *addr,
+                                                                              size_t addr_size)
 {
+    uint16_t link = universal_address_free;
+
+    if (link != UA_NONE) {
+        universal_address_free = universal_address_next[link - 1];
+    }
     /* cppcheck-suppress unsignedLessThanZero
      * (reason: UNIVERSAL_ADDRESS_MAX_ENTRIES may be zero in which case this
      * code is optimized out) */
-    if (universal_address_table_filled < UNIVERSAL_ADDRESS_MAX_ENTRIES) {
-        /* cppcheck-suppress unsignedLessThanZero */
-        for (size_t i = 0; i < UNIVERSAL_ADDRESS_MAX_ENTRIES; ++i) {
-            if (universal_address_table[i].use_count == 0) {
-                return &(universal_address_table[i]);
-            }
-        }
+    else if (universal_address_touched < UNIVERSAL_ADDRESS_MAX_ENTRIES) {
+        link = ++universal_address_touched;
+    }
+    else {
+        return NULL;
     }
 
-    return NULL;
+    size_t bucket = universal_address_hash(addr, addr_size);
+    universal_address_next[link - 1] = universal_address_buckets[bucket];
+    universal_address_buckets[bucket] = link;
+
+    return &(universal_address_table[link - 1]);
+}
+
+/**
+ * @brief unlinks an unused entry from its hash chain and puts it on the free list
+ *
+ * @param[in] entry  pointer to the universal_address_container_t to be released
+ */
+static void universal_address_release_entry(universal_address_container_t *entry)
+{
+    uint16_t idx = entry - universal_address_table;
+    uint16_t *link = &universal_address_buckets[universal_address_hash(entry->address,
+                                                                       entry->address_size)];
+
+    while (*link != (idx + 1)) {
+        link = &universal_address_next[*link - 1];
+    }
+    *link = universal_address_next[idx];
+
+    universal_address_next[idx] = universal_address_free;
+    universal_address_free = idx + 1;
 }
 
 universal_address_container_t *universal_address_add(uint8_t *addr, size_t addr_size)
@@ -116,7 +224,7 @@ universal_address_container_t *universal_address_add(uint8_t *addr, size_t addr_
 
     if (pEntry == NULL) {
         /* look for a free entry */
-        pEntry = universal_address_get_next_unused_entry();
+        pEntry = universal_address_get_next_unused_entry(addr, addr_size);
 
         if (pEntry == NULL) {
             mutex_unlock(&mtx_access);
@@ -136,6 +244,15 @@ universal_address_container_t *universal_address_add(uint8_t *addr, size_t addr_
 
         /* copy the address */
         memcpy((pEntry->address), addr, addr_size);
+
+        bool all_zeros = true;
+        for (size_t i = 0; i < addr_size; i++) {
+            if (addr[i] != 0) {
+                all_zeros = false;
+                break;
+            }
+        }
+        universal_address_all_zeros[pEntry - universal_address_table] = all_zeros;
     }
 
     pEntry->use_count++;
@@ -161,6 +278,7 @@ void universal_address_rem(universal_address_container_t *entry)
             entry->use_count--;
 
             if (entry->use_count == 0) {
+                universal_address_release_entry(entry);
                 universal_address_table_filled--;
             }
         }
@@ -190,47 +308,35 @@ uint8_t* universal_address_get_address(universal_address_container_t *entry,
     return NULL;
 }
 
+/*
+ * The compare functions do not lock mtx_access: the caller holds a reference
+ * on entry, so its content cannot change while it is compared.
+ */
 int universal_address_compare(universal_address_container_t *entry,
                               uint8_t *addr, size_t *addr_size_in_bits)
 {
-    mutex_lock(&mtx_access);
-
-    int ret = -ENOENT;
-
     /* If we have distinct sizes, the addresses are probably not comperable */
     if ((size_t)(entry->address_size<<3) != *addr_size_in_bits) {
-        mutex_unlock(&mtx_access);
-        return ret;
-    }
-
-    /* compare up to fist distinct byte, pretty clumsy method for now */
-    int idx = -1;
-    bool test_all_zeros = true;
-    for (size_t i = 0; i < entry->address_size; i++) {
-        if ((idx == -1) && (entry->address[i] != addr[i])) {
-            idx = i;
-        }
-        if (test_all_zeros) {
-            test_all_zeros = (entry->address[i] == 0);
-        }
-        if ((idx != -1) && !test_all_zeros) {
-            break;
-        }
+        return -ENOENT;
     }
 
     /* if the address is all 0 its a default route address */
-    if (test_all_zeros) {
+    if (universal_address_all_zeros[entry - universal_address_table]) {
         *addr_size_in_bits = 0;
-        mutex_unlock(&mtx_access);
         return UNIVERSAL_ADDRESS_IS_ALL_ZERO_ADDRESS;
     }
 
     /* if we have no distinct bytes the addresses are equal */
-    if (idx == -1) {
-        mutex_unlock(&mtx_access);
+    if (memcmp(entry->address, addr, entry->address_size) == 0) {
         return UNIVERSAL_ADDRESS_EQUAL;
     }
 
+    /* find the fist distinct byte */
+    size_t idx = 0;
+    while (entry->address[idx] == addr[idx]) {
+        idx++;
+    }
+
     /* count equal bits */
     uint8_t xor = entry->address[idx]^addr[idx];
     int8_t j = 7;
@@ -242,20 +348,15 @@ int universal_address_compare(universal_address_container_t *entry,
 
     /* get the total number of matching bits */
     *addr_size_in_bits = (idx << 3) + j;
-    ret = UNIVERSAL_ADDRESS_MATCHING_PREFIX;
-
-    mutex_unlock(&mtx_access);
-    return ret;
+    return UNIVERSAL_ADDRESS_MATCHING_PREFIX;
 }
 
 int universal_address_compare_prefix(universal_address_container_t *entry,
                               uint8_t *prefix, size_t prefix_size_in_bits)
 {
-    mutex_lock(&mtx_access);
     int ret = -ENOENT;
     /* If we have distinct sizes, the prefix is not comperable */
     if ((size_t)(entry->address_size<<3) != prefix_size_in_bits) {
-        mutex_unlock(&mtx_access);
         return ret;
     }
 
@@ -293,7 +394,6 @@ int universal_address_compare_prefix(universal_address_container_t *entry,
         }
     }
 
-    mutex_unlock(&mtx_access);
     return ret;
 }
 
@@ -310,6 +410,8 @@ void universal_address_init(void)
         memset(universal_address_table[i].address, 0, UNIVERSAL_ADDRESS_SIZE);
     }
 
+    universal_address_table_filled = 0;
+    universal_address_rebuild();
     mutex_unlock(&mtx_access);
 }
 
@@ -325,6 +427,7 @@ void universal_address_reset(void)
     }
 
     universal_address_table_filled = 0;
+    universal_address_rebuild();
     mutex_unlock(&mtx_access);
 }
 
@@ -191,6 +191,21 @@ int vfs_fstat(int fd, struct stat *buf)
     return filp->f_op->fstat(filp, buf);
 }
 
+int vfs_poll(int fd, int events, kernel_pid_t waiter)
+{
+    DEBUG("vfs_poll: %d, 0x%x, %" PRIkernel_pid "\n", fd, events, waiter);
+    int res = _fd_is_valid(fd);
+    if (res < 0) {
+        return res;
+    }
+    vfs_file_t *filp = &_vfs_open_files[fd];
+    if (filp->f_op->poll == NULL) {
+        /* regular files never block */
+        return events;
+    }
+    return filp->f_op->poll(filp, events, waiter);
+}
+
 int vfs_fstatvfs(int fd, struct statvfs *buf)
 {
     DEBUG("vfs_fstatvfs: %d, %p\n", fd, (void *)buf);
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       base64 encoding and decoding throughput
+ *
+ * Encodes a buffer of pseudo random bytes and decodes it again, with both
+ * alphabets and for an input with line breaks, which takes the decoder's
+ * slow path. Each benchmark prints its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "base64.h"
+#include "xtimer.h"
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    (1000U)     /**< encodings/decodings per bench */
+#endif
+
+#ifndef BENCH_SIZE
+#define BENCH_SIZE          (384U)      /**< bytes per encoding */
+#endif
+
+#define BASE64_SIZE         (((BENCH_SIZE + 2U) / 3U) * 4U)
+#define LINE_LENGTH         (64U)
+
+static unsigned char _data[BENCH_SIZE];
+static unsigned char _base64[BASE64_SIZE];
+static size_t _base64_len;
+static unsigned char _lines[BASE64_SIZE + (2U * BASE64_SIZE / LINE_LENGTH) + 2U];
+static size_t _lines_len;
+static unsigned char _out[BASE64_SIZE];
+static unsigned _errors;
+
+static void _print_result(const char *name, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"bytes\": %u, \"errors\": %u, "
+           "\"duration_us\": %" PRIu32 ", \"kib_per_s\": %" PRIu32 "}\n",
+           name, BENCH_SIZE, _errors, usec,
+           (uint32_t)(((uint64_t)BENCH_SIZE * BENCH_ITERATIONS * 1000000U) /
+                      ((uint64_t)usec * 1024U)));
+}
+
+static void _check_decoded(int res, size_t size)
+{
+    if ((res != BASE64_SUCCESS) || (size != BENCH_SIZE) ||
+        memcmp(_out, _data, BENCH_SIZE)) {
+        _errors++;
+    }
+}
+
+static void _bench_encode(const char *name, bool url)
+{
+    uint32_t start = xtimer_now_usec();
+
+    _errors = 0;
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        size_t size = sizeof(_base64);
+        int res = url ? base64url_encode(_data, BENCH_SIZE, _base64, &size)
+                      : base64_encode(_data, BENCH_SIZE, _base64, &size);
+        if (res != BASE64_SUCCESS) {
+            _errors++;
+        }
+        _base64_len = size;
+    }
+    _print_result(name, xtimer_now_usec() - start);
+}
+
+static void _bench_decode(const char *name, const unsigned char *in,
+                          size_t len, bool url)
+{
+    uint32_t start = xtimer_now_usec();
+
+    _errors = 0;
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        size_t size = sizeof(_out);
+        memset(_out, 0, BENCH_SIZE);
+        int res = url ? base64url_decode((unsigned char *)in, len, _out, &size)
+                      : base64_decode((unsigned char *)in, len, _out, &size);
+        _check_decoded(res, size);
+    }
+    _print_result(name, xtimer_now_usec() - start);
+}
+
+int main(void)
+{
+    uint32_t seed = 0x12345678;
+
+    for (unsigned i = 0; i < BENCH_SIZE; i++) {
+        seed = seed * 1103515245U + 12345U;
+        _data[i] = seed >> 24;
+    }
+
+    puts("Start.");
+
+    _bench_encode("encode", false);
+    _bench_decode("decode", _base64, _base64_len, false);
+
+    /* break the encoding into lines like PEM does */
+    _lines_len = 0;
+    for (size_t i = 0; i < _base64_len; i++) {
+        if (i && !(i % LINE_LENGTH)) {
+            _lines[_lines_len++] = '\r';
+            _lines[_lines_len++] = '\n';
+        }
+        _lines[_lines_len++] = _base64[i];
+    }
+    _bench_decode("decode_lines", _lines, _lines_len, false);
+
+    _bench_encode("encode_url", true);
+    _bench_decode("decode_url", _base64, _base64_len, true);
+
+    puts("Done.");
+
+    return 0;
+}
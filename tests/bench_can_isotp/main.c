@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       ISO-TP receive throughput with and without streaming
+ *
+ * A sender thread transmits maximum sized ISO-TP messages on CAN interface 1,
+ * the main thread receives them on interface 0. Both interfaces are attached
+ * to the same (virtual) bus. The messages are received once reassembled in
+ * the packet buffer and once streamed through a small ring buffer. Each
+ * benchmark prints its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "can/conn/isotp.h"
+#include "msg.h"
+#include "thread.h"
+#include "tsrb.h"
+#include "xtimer.h"
+
+#ifndef BENCH_MESSAGES
+#define BENCH_MESSAGES      (5U)        /**< messages per benchmark */
+#endif
+
+#ifndef BENCH_MSG_LEN
+#define BENCH_MSG_LEN       (4095U)     /**< length of each message */
+#endif
+
+#ifndef BENCH_RING_SIZE
+#define BENCH_RING_SIZE     (256U)      /**< rx ring size, a power of two */
+#endif
+
+#define BENCH_CHUNK_SIZE    (64U)       /**< bytes read from the ring at once */
+#define RX_TIMEOUT          (10U * US_PER_SEC)
+
+static char _sender_stack[THREAD_STACKSIZE_MAIN];
+static kernel_pid_t _sender_pid;
+static kernel_pid_t _main_pid;
+static msg_t _main_msg_queue[4];
+
+static conn_can_isotp_t _rx_conn;
+static conn_can_isotp_t _tx_conn;
+static uint8_t _tx_buf[BENCH_MSG_LEN];
+static uint8_t _rx_buf[BENCH_MSG_LEN];
+static char _ring_buf[BENCH_RING_SIZE];
+static tsrb_t _ring;
+
+static void _print_result(const char *name, unsigned buf_size, uint32_t bytes,
+                          unsigned errors, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"messages\": %u, \"msg_len\": %u, "
+           "\"rx_buf_size\": %u, \"errors\": %u, \"duration_us\": %" PRIu32
+           ", \"kbytes_per_s\": %" PRIu32 "}\n", name, BENCH_MESSAGES,
+           BENCH_MSG_LEN, buf_size, errors, usec,
+           (uint32_t)(((uint64_t)bytes * 1000U) / (usec ? usec : 1)));
+}
+
+static void *_sender(void *arg)
+{
+    struct isotp_options opt = { .tx_id = 0x7e0, .rx_id = 0x7e8 };
+    msg_t msg;
+
+    (void)arg;
+    conn_can_isotp_create(&_tx_conn, &opt, 1);
+    conn_can_isotp_bind(&_tx_conn);
+
+    while (1) {
+        msg_receive(&msg);
+        for (unsigned i = 0; i < BENCH_MESSAGES; i++) {
+            if (conn_can_isotp_send(&_tx_conn, _tx_buf, sizeof(_tx_buf), 0) < 0) {
+                puts("error: send failed");
+            }
+        }
+        msg_send(&msg, _main_pid);
+    }
+
+    return NULL;
+}
+
+static int _open_rx(tsrb_t *ring)
+{
+    struct isotp_options opt = { .tx_id = 0x7e8, .rx_id = 0x7e0 };
+
+    conn_can_isotp_create(&_rx_conn, &opt, 0);
+    if (ring) {
+        conn_can_isotp_set_rx_ring(&_rx_conn, ring);
+    }
+    return conn_can_isotp_bind(&_rx_conn);
+}
+
+static void _start_sender(void)
+{
+    msg_t msg;
+    msg_send(&msg, _sender_pid);
+}
+
+static void _wait_sender(void)
+{
+    msg_t msg;
+    msg_receive(&msg);
+}
+
+static void _bench_reassembled(void)
+{
+    unsigned errors = 0;
+    uint32_t start;
+
+    _open_rx(NULL);
+    start = xtimer_now_usec();
+    _start_sender();
+    for (unsigned i = 0; i < BENCH_MESSAGES; i++) {
+        int res = conn_can_isotp_recv(&_rx_conn, _rx_buf, sizeof(_rx_buf),
+                                      RX_TIMEOUT);
+        if ((res != (int)sizeof(_rx_buf)) ||
+            memcmp(_rx_buf, _tx_buf, sizeof(_rx_buf))) {
+            errors++;
+        }
+    }
+    _print_result("reassembled", sizeof(_rx_buf), BENCH_MESSAGES * BENCH_MSG_LEN,
+                  errors, xtimer_now_usec() - start);
+    _wait_sender();
+    conn_can_isotp_close(&_rx_conn);
+}
+
+static void _bench_stream(void)
+{
+    unsigned errors = 0;
+    uint32_t received = 0;
+    uint32_t start;
+
+    tsrb_init(&_ring, _ring_buf, sizeof(_ring_buf));
+    _open_rx(&_ring);
+    start = xtimer_now_usec();
+    _start_sender();
+    for (unsigned i = 0; i < BENCH_MESSAGES; i++) {
+        uint8_t hdr[2];
+        unsigned len, pos = 0;
+
+        /* every message starts with its length */
+        for (unsigned got = 0; got < sizeof(hdr);) {
+            int res = conn_can_isotp_recv_stream(&_rx_conn, hdr + got,
+                                                 sizeof(hdr) - got, RX_TIMEOUT);
+            if (res < 0) {
+                errors++;
+                goto out;
+            }
+            got += res;
+        }
+        len = (hdr[0] << 8) | hdr[1];
+        if (len != BENCH_MSG_LEN) {
+            errors++;
+        }
+        while (pos < len) {
+            uint8_t chunk[BENCH_CHUNK_SIZE];
+            size_t size = ((len - pos) < sizeof(chunk)) ? (len - pos) : sizeof(chunk);
+            int res = conn_can_isotp_recv_stream(&_rx_conn, chunk, size,
+                                                 RX_TIMEOUT);
+            if (res < 0) {
+                errors++;
+                goto out;
+            }
+            if (memcmp(chunk, _tx_buf + pos, res)) {
+                errors++;
+            }
+            pos += res;
+        }
+        received += len;
+    }
+
+out:
+    _print_result("stream", sizeof(_ring_buf), received, errors,
+                  xtimer_now_usec() - start);
+    _wait_sender();
+    conn_can_isotp_close(&_rx_conn);
+}
+
+int main(void)
+{
+    _main_pid = thread_getpid();
+    msg_init_queue(_main_msg_queue, 4);
+
+    for (unsigned i = 0; i < sizeof(_tx_buf); i++) {
+        _tx_buf[i] = i;
+    }
+    _sender_pid = thread_create(_sender_stack, sizeof(_sender_stack),
+                                THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                                _sender, NULL, "sender");
+
+    puts("Start.");
+
+    _bench_reassembled();
+    _bench_stream();
+
+    puts("Done.");
+
+    return 0;
+}
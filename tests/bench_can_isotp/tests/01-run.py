@@ -0,0 +1,29 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2017 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import os
+import sys
+import json
+
+BENCHMARKS = ('reassembled', 'stream')
+
+
+def testfunc(child):
+    child.expect_exact('Start.')
+    for name in BENCHMARKS:
+        child.expect(r'(\{"bench": "%s".*\})\r\n' % name, timeout=120)
+        res = json.loads(child.match.group(1))
+        assert res['errors'] == 0
+        print(json.dumps(res))
+    child.expect_exact('Done.')
+
+
+if __name__ == "__main__":
+    sys.path.append(os.path.join(os.environ['RIOTBASE'], 'dist/tools/testrunner'))
+    from testrunner import run
+    sys.exit(run(testfunc))
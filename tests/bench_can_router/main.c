@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       CAN router receive dispatch with many filters
+ *
+ * Registers filters with a few typical masks directly at the router and
+ * measures how long it takes to dispatch a received frame to its subscriber,
+ * once for a frame matching an exact ID filter and once for a frame no filter
+ * matches. Each benchmark prints its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "can/pkt.h"
+#include "can/raw.h"
+#include "can/router.h"
+#include "msg.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    (10000U)    /**< frames per benchmark */
+#endif
+
+#ifndef BENCH_FILTERS
+#define BENCH_FILTERS       (64U)       /**< exact ID filters to register */
+#endif
+
+#define MSG_QUEUE_SIZE      (8U)
+#define RANGE_FILTERS       (sizeof(_range_filters) / sizeof(_range_filters[0]))
+
+static msg_t _msg_queue[MSG_QUEUE_SIZE];
+static can_reg_entry_t _entry;
+
+/* filters like a typical gateway or diagnostic node registers them */
+static const struct {
+    canid_t id;
+    canid_t mask;
+} _range_filters[] = {
+    { 0x700, 0x780 },   /* diagnostic requests */
+    { 0x600, 0x700 },   /* node management */
+    { 0x080, 0x7f0 },   /* emergency */
+};
+
+static void _print_result(const char *name, unsigned filters, uint32_t frames,
+                          uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"filters\": %u, \"mask_groups\": %u, "
+           "\"frames\": %" PRIu32 ", \"duration_us\": %" PRIu32
+           ", \"ns_per_frame\": %" PRIu32 "}\n", name, filters,
+           (unsigned)CAN_ROUTER_MASK_GROUPS, frames, usec,
+           (uint32_t)(((uint64_t)usec * 1000U) / frames));
+}
+
+static int _bench_dispatch(const char *name, canid_t can_id)
+{
+    struct can_frame frame = { .can_id = can_id, .can_dlc = 1 };
+    int received = 0;
+    uint32_t start = xtimer_now_usec();
+
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        can_pkt_t *pkt = can_pkt_alloc_rx(_entry.ifnum, &frame);
+        msg_t msg;
+
+        if (!pkt) {
+            puts("error: out of packet buffer");
+            return -1;
+        }
+        /* the router releases the packet itself if nobody subscribed, the
+         * subscribers get their indications through the message queue */
+        can_router_dispatch_rx_indic(pkt);
+        while (msg_try_receive(&msg) == 1) {
+            if (msg.type == CAN_MSG_RX_INDICATION) {
+                raw_can_free_frame(msg.content.ptr);
+                received++;
+            }
+        }
+    }
+    _print_result(name, BENCH_FILTERS + RANGE_FILTERS,
+                  BENCH_ITERATIONS, xtimer_now_usec() - start);
+
+    return received;
+}
+
+int main(void)
+{
+    msg_init_queue(_msg_queue, MSG_QUEUE_SIZE);
+    _entry.ifnum = 0;
+    _entry.target.pid = thread_getpid();
+
+    for (unsigned i = 0; i < RANGE_FILTERS; i++) {
+        can_router_register(&_entry, _range_filters[i].id,
+                            _range_filters[i].mask, NULL);
+    }
+    for (unsigned i = 0; i < BENCH_FILTERS; i++) {
+        if (can_router_register(&_entry, 0x100 + i, CAN_SFF_MASK, NULL) < 0) {
+            puts("error: out of filter elements");
+            return 1;
+        }
+    }
+
+    puts("Start.");
+
+    if (_bench_dispatch("rx_match", 0x100 + BENCH_FILTERS / 2)
+        != (int)BENCH_ITERATIONS) {
+        puts("error: frames lost");
+    }
+    if (_bench_dispatch("rx_nomatch", 0x050) != 0) {
+        puts("error: unexpected frames");
+    }
+
+    puts("Done.");
+
+    return 0;
+}
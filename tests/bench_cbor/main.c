@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Compares the offset based CBOR API to the streaming API
+ *
+ * Encodes and decodes a SenML pack (RFC 8428) of sensor readings with both
+ * APIs. The offset based decoder has to try each type at a given offset and
+ * copies strings, the reader walks the pack once and points into it. The
+ * writer only uses a small buffer that it hands to a callback. Each
+ * benchmark prints its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cbor.h"
+#include "xtimer.h"
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    (1000U)     /**< encodings/decodings per bench */
+#endif
+
+#ifndef BENCH_RECORDS
+#define BENCH_RECORDS       (8U)        /**< records per SenML pack */
+#endif
+
+#define WRITER_BUF_SIZE     (32U)
+#define STR_MAX             (48U)
+
+/* SenML labels */
+#define SENML_BN            (-2)
+#define SENML_BT            (-3)
+#define SENML_N             (0)
+#define SENML_U             (1)
+#define SENML_V             (2)
+#define SENML_T             (6)
+
+typedef struct {
+    const char *name;
+    const char *unit;
+    float value;
+} record_t;
+
+static const record_t _records[] = {
+    { "temperature", "Cel", 23.5f },
+    { "humidity", "%RH", 41.25f },
+    { "pressure", "Pa", 101325.0f },
+    { "illuminance", "lx", 312.0f },
+};
+
+#define RECORDS_NUMOF       (sizeof(_records) / sizeof(_records[0]))
+
+static const char _base_name[] = "urn:dev:ow:10e2073a01080063:";
+static const double _base_time = 1276020076.001;
+
+static unsigned char _pack[BENCH_RECORDS * 40U + 64U];
+static size_t _pack_len;
+static size_t _written;
+static unsigned _errors;
+
+static void _print_result(const char *name, size_t bytes, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"records\": %u, \"bytes\": %u, "
+           "\"errors\": %u, \"duration_us\": %" PRIu32
+           ", \"ns_per_record\": %" PRIu32 "}\n", name, BENCH_RECORDS,
+           (unsigned)bytes, _errors, usec,
+           (uint32_t)(((uint64_t)usec * 1000U) /
+                      (BENCH_ITERATIONS * BENCH_RECORDS)));
+}
+
+/* sum of all values and times, to check the decoders */
+static double _expected_sum(void)
+{
+    double sum = _base_time;
+
+    for (unsigned i = 0; i < BENCH_RECORDS; i++) {
+        sum += _records[i % RECORDS_NUMOF].value + i;
+    }
+    return sum;
+}
+
+static void _check(double sum, double expected)
+{
+    /* the order of the additions differs */
+    if ((sum - expected > 0.01) || (expected - sum > 0.01)) {
+        _errors++;
+    }
+}
+
+static size_t _encode_stream(cbor_stream_t *s)
+{
+    cbor_clear(s);
+    cbor_serialize_array(s, BENCH_RECORDS);
+    for (unsigned i = 0; i < BENCH_RECORDS; i++) {
+        const record_t *r = &_records[i % RECORDS_NUMOF];
+
+        cbor_serialize_map(s, (i == 0) ? 5 : 4);
+        if (i == 0) {
+            cbor_serialize_int(s, SENML_BN);
+            cbor_serialize_unicode_string(s, _base_name);
+            cbor_serialize_int(s, SENML_BT);
+            cbor_serialize_double(s, _base_time);
+        }
+        cbor_serialize_int(s, SENML_N);
+        cbor_serialize_unicode_string(s, r->name);
+        cbor_serialize_int(s, SENML_U);
+        cbor_serialize_unicode_string(s, r->unit);
+        cbor_serialize_int(s, SENML_V);
+        cbor_serialize_float(s, r->value);
+        if (i != 0) {
+            cbor_serialize_int(s, SENML_T);
+            cbor_serialize_int(s, i);
+        }
+    }
+    return s->pos;
+}
+
+static int _count(void *arg, const uint8_t *data, size_t len)
+{
+    (void)arg;
+    (void)data;
+    _written += len;
+    return 0;
+}
+
+static ssize_t _encode_writer(uint8_t *buf, size_t size,
+                              cbor_writer_flush_t flush)
+{
+    cbor_writer_t w;
+
+    cbor_writer_init(&w, buf, size, flush, NULL);
+    cbor_writer_array(&w, BENCH_RECORDS);
+    for (unsigned i = 0; i < BENCH_RECORDS; i++) {
+        const record_t *r = &_records[i % RECORDS_NUMOF];
+
+        cbor_writer_map(&w, (i == 0) ? 5 : 4);
+        if (i == 0) {
+            cbor_writer_int(&w, SENML_BN);
+            cbor_writer_text(&w, _base_name, sizeof(_base_name) - 1);
+            cbor_writer_int(&w, SENML_BT);
+            cbor_writer_double(&w, _base_time);
+        }
+        cbor_writer_int(&w, SENML_N);
+        cbor_writer_text(&w, r->name, strlen(r->name));
+        cbor_writer_int(&w, SENML_U);
+        cbor_writer_text(&w, r->unit, strlen(r->unit));
+        cbor_writer_int(&w, SENML_V);
+        cbor_writer_double(&w, r->value);
+        if (i != 0) {
+            cbor_writer_int(&w, SENML_T);
+            cbor_writer_int(&w, i);
+        }
+    }
+    return cbor_writer_finish(&w);
+}
+
+static double _decode_offset(const cbor_stream_t *s)
+{
+    char str[STR_MAX];
+    double sum = 0;
+    size_t records, pairs;
+    size_t offset = cbor_deserialize_array(s, 0, &records);
+
+    for (size_t i = 0; i < records; i++) {
+        offset += cbor_deserialize_map(s, offset, &pairs);
+        for (size_t j = 0; j < pairs; j++) {
+            int label, t;
+            float v;
+            double bt;
+
+            offset += cbor_deserialize_int(s, offset, &label);
+            switch (label) {
+                case SENML_BN:
+                case SENML_N:
+                case SENML_U:
+                    offset += cbor_deserialize_unicode_string(s, offset, str,
+                                                              sizeof(str));
+                    break;
+                case SENML_BT:
+                    offset += cbor_deserialize_double(s, offset, &bt);
+                    sum += bt;
+                    break;
+                case SENML_V:
+                    offset += cbor_deserialize_float(s, offset, &v);
+                    sum += v;
+                    break;
+                case SENML_T:
+                    offset += cbor_deserialize_int(s, offset, &t);
+                    sum += t;
+                    break;
+                default:
+                    _errors++;
+                    return sum;
+            }
+        }
+    }
+    return sum;
+}
+
+static double _decode_reader(const uint8_t *buf, size_t len)
+{
+    cbor_reader_t reader;
+    cbor_item_t item;
+    double sum = 0;
+
+    cbor_reader_init(&reader, buf, len);
+    if ((cbor_reader_next(&reader, &item) < 0) ||
+        (item.type != CBOR_ITEM_ARRAY)) {
+        _errors++;
+        return sum;
+    }
+    while (cbor_reader_next(&reader, &item) == 0) {
+        uint64_t pairs = item.val.u;
+
+        for (uint64_t j = 0; j < pairs; j++) {
+            cbor_item_t value;
+            int64_t label;
+            double v;
+
+            if ((cbor_reader_next(&reader, &item) < 0) ||
+                (cbor_item_get_int(&item, &label) < 0) ||
+                (cbor_reader_next(&reader, &value) < 0)) {
+                _errors++;
+                return sum;
+            }
+            switch (label) {
+                case SENML_BN:
+                case SENML_N:
+                case SENML_U:
+                    /* value.data and value.val.u describe the string */
+                    break;
+                case SENML_BT:
+                case SENML_V:
+                case SENML_T:
+                    cbor_item_get_double(&value, &v);
+                    sum += v;
+                    break;
+                default:
+                    cbor_reader_skip(&reader, &value);
+                    break;
+            }
+        }
+    }
+    return sum;
+}
+
+static void _bench_encode(void)
+{
+    cbor_stream_t s;
+    uint8_t buf[WRITER_BUF_SIZE];
+    uint32_t start;
+
+    cbor_init(&s, _pack, sizeof(_pack));
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        _pack_len = _encode_stream(&s);
+    }
+    _print_result("encode_stream", _pack_len, xtimer_now_usec() - start);
+
+    /* same encoding through a buffer of WRITER_BUF_SIZE bytes */
+    _written = 0;
+    if ((_encode_writer(buf, sizeof(buf), _count) != (ssize_t)_pack_len) ||
+        (_written != _pack_len)) {
+        _errors++;
+    }
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        _encode_writer(buf, sizeof(buf), _count);
+    }
+    _print_result("encode_writer", _pack_len, xtimer_now_usec() - start);
+}
+
+static void _bench_decode(void)
+{
+    cbor_stream_t s = { _pack, _pack_len, _pack_len };
+    double expected = _expected_sum();
+    uint32_t start;
+
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        _check(_decode_offset(&s), expected);
+    }
+    _print_result("decode_offset", _pack_len, xtimer_now_usec() - start);
+
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        _check(_decode_reader(_pack, _pack_len), expected);
+    }
+    _print_result("decode_reader", _pack_len, xtimer_now_usec() - start);
+}
+
+int main(void)
+{
+    puts("Start.");
+
+    _bench_encode();
+    _bench_decode();
+
+    puts("Done.");
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Measure AES-128 throughput in ECB, CBC, CTR and CCM mode
+ *
+ * Every benchmark processes @ref BENCH_ROUNDS times a buffer of
+ * @ref BENCH_LEN bytes and prints its result as one JSON object per line.
+ * CCM encrypts the buffer in messages of @ref BENCH_CCM_LEN bytes. The cycles
+ * per byte are only printed on boards defining CLOCK_CORECLOCK.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "periph_conf.h"
+#include "crypto/aes.h"
+#include "crypto/ciphers.h"
+#include "crypto/modes/cbc.h"
+#include "crypto/modes/ccm.h"
+#include "crypto/modes/ctr.h"
+#include "crypto/modes/ecb.h"
+#include "xtimer.h"
+
+#ifndef BENCH_LEN
+#define BENCH_LEN           (1024U)     /**< must be a multiple of 16 */
+#endif
+
+#ifndef BENCH_ROUNDS
+#define BENCH_ROUNDS        (256U)
+#endif
+
+#ifndef BENCH_CCM_LEN
+#define BENCH_CCM_LEN       (128U)      /**< must divide BENCH_LEN */
+#endif
+
+#define BENCH_MAC_LEN       (8U)
+#define BENCH_LEN_ENCODING  (2U)
+#define BENCH_NONCE_LEN     (13U)
+
+static const uint8_t _key[AES_KEY_SIZE] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static uint8_t _nonce[BENCH_NONCE_LEN];
+static uint8_t _iv[AES_BLOCK_SIZE];
+static uint8_t _input[BENCH_LEN];
+static uint8_t _output[BENCH_LEN + BENCH_MAC_LEN];
+static cipher_t _cipher;
+
+static void _print_result(const char *name, uint32_t usec)
+{
+    uint32_t bytes = BENCH_LEN * BENCH_ROUNDS;
+
+    if (usec == 0) {
+        usec = 1;
+    }
+    printf("{\"bench\": \"%s\", \"bytes\": %" PRIu32 ", \"duration_us\": %"
+           PRIu32 ", \"kib_per_sec\": %" PRIu32, name, bytes, usec,
+           (uint32_t)(((uint64_t)bytes * US_PER_SEC) / (1024U * usec)));
+#ifdef CLOCK_CORECLOCK
+    printf(", \"cycles_per_byte\": %" PRIu32,
+           (uint32_t)(((uint64_t)usec * (CLOCK_CORECLOCK / US_PER_SEC)) / bytes));
+#endif
+    puts("}");
+}
+
+static int _ccm_encrypt(void)
+{
+    for (unsigned off = 0; off < BENCH_LEN; off += BENCH_CCM_LEN) {
+        int res = cipher_encrypt_ccm(&_cipher, NULL, 0, BENCH_MAC_LEN,
+                                     BENCH_LEN_ENCODING, _nonce,
+                                     sizeof(_nonce), _input + off,
+                                     BENCH_CCM_LEN, _output);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return 0;
+}
+
+#define RUN_BENCH(name, body) \
+    do { \
+        uint32_t start = xtimer_now_usec(); \
+        for (unsigned i = 0; i < BENCH_ROUNDS; i++) { \
+            if ((body) < 0) { \
+                puts("error: " name); \
+                return 1; \
+            } \
+        } \
+        _print_result(name, xtimer_now_usec() - start); \
+    } while (0)
+
+int main(void)
+{
+    uint8_t iv[AES_BLOCK_SIZE];
+
+    puts("Start.");
+
+    for (unsigned i = 0; i < BENCH_LEN; i++) {
+        _input[i] = (uint8_t)i;
+    }
+
+    if (cipher_init(&_cipher, CIPHER_AES_128, _key, sizeof(_key)) < 0) {
+        puts("error: cipher_init");
+        return 1;
+    }
+
+    RUN_BENCH("aes_ecb_encrypt",
+              cipher_encrypt_ecb(&_cipher, _input, BENCH_LEN, _output));
+    RUN_BENCH("aes_ecb_decrypt",
+              cipher_decrypt_ecb(&_cipher, _input, BENCH_LEN, _output));
+    RUN_BENCH("aes_cbc_encrypt",
+              cipher_encrypt_cbc(&_cipher, _iv, _input, BENCH_LEN, _output));
+    RUN_BENCH("aes_cbc_decrypt",
+              cipher_decrypt_cbc(&_cipher, _iv, _input, BENCH_LEN, _output));
+    RUN_BENCH("aes_ctr",
+              (memcpy(iv, _iv, sizeof(iv)),
+               cipher_encrypt_ctr(&_cipher, iv, 8, _input, BENCH_LEN, _output)));
+    RUN_BENCH("aes_ccm_encrypt", _ccm_encrypt());
+
+    puts("Done.");
+    return 0;
+}
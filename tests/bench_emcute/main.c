@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       emCute publish throughput against a local gateway stand-in
+ *
+ * The gateway thread implements just enough of MQTT-SN to connect, register
+ * a topic and acknowledge publications. It delays every acknowledgment by
+ * @ref BENCH_GW_DELAY to simulate the round trip time to a real gateway.
+ * Each benchmark prints its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "net/emcute.h"
+#include "net/ipv6/addr.h"
+#include "net/sock/udp.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#ifndef BENCH_MESSAGES
+#define BENCH_MESSAGES      (64U)       /**< messages per benchmark */
+#endif
+
+#ifndef BENCH_GW_DELAY
+#define BENCH_GW_DELAY      (5000U)     /**< acknowledgment delay in us */
+#endif
+
+#define BENCH_BATCH_SIZE    (8U)
+#define BENCH_PAYLOAD_LEN   (32U)
+#define BENCH_TIMEOUT       (10U * US_PER_SEC)
+
+#define CLIENT_PORT         (1883U)
+#define GW_PORT             (1885U)
+#define GW_PENDING          (EMCUTE_WINDOW + 1)
+
+/* MQTT-SN message types handled by the gateway stand-in */
+#define CONNECT             (0x04)
+#define CONNACK             (0x05)
+#define REGISTER            (0x0a)
+#define REGACK              (0x0b)
+#define PUBLISH             (0x0c)
+#define PUBACK              (0x0d)
+#define DISCONNECT          (0x18)
+
+typedef struct {
+    uint32_t due;
+    uint8_t len;
+    uint8_t buf[7];
+} gw_resp_t;
+
+static char _emcute_stack[THREAD_STACKSIZE_DEFAULT];
+static char _gw_stack[THREAD_STACKSIZE_DEFAULT];
+static sock_udp_t _gw_sock;
+static sock_udp_ep_t _client;
+static uint8_t _gw_buf[EMCUTE_BUFSIZE];
+static gw_resp_t _gw_pending[GW_PENDING];
+static volatile unsigned _gw_received;
+static volatile unsigned _acked;
+static volatile unsigned _errors;
+
+static emcute_topic_t _topic = { .name = "bench" };
+static uint8_t _payload[BENCH_PAYLOAD_LEN];
+
+static void _gw_respond(const uint8_t *buf, uint8_t len)
+{
+    uint32_t now = xtimer_now_usec();
+
+    for (unsigned i = 0; i < GW_PENDING; i++) {
+        if (_gw_pending[i].len == 0) {
+            _gw_pending[i].due = now + BENCH_GW_DELAY;
+            _gw_pending[i].len = len;
+            memcpy(_gw_pending[i].buf, buf, len);
+            return;
+        }
+    }
+    /* more than a window full of requests: the client will retransmit */
+}
+
+/* sends due responses, returns the time until the next one is due */
+static uint32_t _gw_flush(void)
+{
+    uint32_t now = xtimer_now_usec();
+    uint32_t next = SOCK_NO_TIMEOUT;
+
+    for (unsigned i = 0; i < GW_PENDING; i++) {
+        gw_resp_t *resp = &_gw_pending[i];
+        int32_t left = (int32_t)(resp->due - now);
+
+        if (resp->len == 0) {
+            continue;
+        }
+        if (left <= 0) {
+            sock_udp_send(&_gw_sock, resp->buf, resp->len, &_client);
+            resp->len = 0;
+        }
+        else if ((uint32_t)left < next) {
+            next = left;
+        }
+    }
+    return next;
+}
+
+static void *_gateway(void *arg)
+{
+    sock_udp_ep_t local = SOCK_IPV6_EP_ANY;
+    uint32_t timeout = SOCK_NO_TIMEOUT;
+
+    (void)arg;
+    local.port = GW_PORT;
+    sock_udp_create(&_gw_sock, &local, NULL, 0);
+
+    while (1) {
+        ssize_t len = sock_udp_recv(&_gw_sock, _gw_buf, sizeof(_gw_buf),
+                                    timeout, &_client);
+
+        if ((len >= 2) && (_gw_buf[0] <= len)) {
+            switch (_gw_buf[1]) {
+                case CONNECT: {
+                    uint8_t resp[] = { 3, CONNACK, 0 };
+                    sock_udp_send(&_gw_sock, resp, sizeof(resp), &_client);
+                    break;
+                }
+                case REGISTER: {
+                    uint8_t resp[] = { 7, REGACK, 0, 1, _gw_buf[4], _gw_buf[5], 0 };
+                    sock_udp_send(&_gw_sock, resp, sizeof(resp), &_client);
+                    break;
+                }
+                case PUBLISH:
+                    _gw_received++;
+                    if (_gw_buf[2] & EMCUTE_QOS_1) {
+                        uint8_t resp[] = { 7, PUBACK, _gw_buf[3], _gw_buf[4],
+                                           _gw_buf[5], _gw_buf[6], 0 };
+                        _gw_respond(resp, sizeof(resp));
+                    }
+                    break;
+                case DISCONNECT: {
+                    uint8_t resp[] = { 2, DISCONNECT };
+                    sock_udp_send(&_gw_sock, resp, sizeof(resp), &_client);
+                    break;
+                }
+            }
+        }
+        timeout = _gw_flush();
+    }
+
+    return NULL;
+}
+
+static void *_emcute(void *arg)
+{
+    (void)arg;
+    emcute_run(CLIENT_PORT, "bench");
+    return NULL;
+}
+
+static void _pub_cb(int res, void *arg)
+{
+    (void)arg;
+    if (res != EMCUTE_OK) {
+        _errors++;
+    }
+    _acked++;
+}
+
+static void _wait_for(volatile unsigned *counter, unsigned value)
+{
+    uint32_t start = xtimer_now_usec();
+
+    while ((*counter < value) && ((xtimer_now_usec() - start) < BENCH_TIMEOUT)) {
+        xtimer_usleep(100);
+    }
+}
+
+static void _print_result(const char *name, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"messages\": %u, \"received\": %u, "
+           "\"errors\": %u, \"gw_delay_us\": %u, \"window\": %u, "
+           "\"duration_us\": %" PRIu32 ", \"msgs_per_s\": %" PRIu32 "}\n",
+           name, BENCH_MESSAGES, _gw_received, _errors, BENCH_GW_DELAY,
+           EMCUTE_WINDOW, usec,
+           (uint32_t)(((uint64_t)BENCH_MESSAGES * US_PER_SEC) / (usec ? usec : 1)));
+}
+
+static void _reset(void)
+{
+    _gw_received = 0;
+    _acked = 0;
+    _errors = 0;
+}
+
+static void _bench_qos0(void)
+{
+    uint32_t start;
+
+    _reset();
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_MESSAGES; i++) {
+        if (emcute_pub(&_topic, _payload, sizeof(_payload), EMCUTE_QOS_0) != EMCUTE_OK) {
+            _errors++;
+        }
+    }
+    _wait_for(&_gw_received, BENCH_MESSAGES);
+    _print_result("pub_qos0", xtimer_now_usec() - start);
+}
+
+static void _bench_qos0_batch(void)
+{
+    emcute_msg_t msgs[BENCH_BATCH_SIZE];
+    uint32_t start;
+
+    for (unsigned i = 0; i < BENCH_BATCH_SIZE; i++) {
+        msgs[i].topic = &_topic;
+        msgs[i].data = _payload;
+        msgs[i].len = sizeof(_payload);
+    }
+
+    _reset();
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_MESSAGES; i += BENCH_BATCH_SIZE) {
+        if (emcute_pub_batch(msgs, BENCH_BATCH_SIZE, 0) != EMCUTE_OK) {
+            _errors++;
+        }
+    }
+    _wait_for(&_gw_received, BENCH_MESSAGES);
+    _print_result("pub_qos0_batch", xtimer_now_usec() - start);
+}
+
+static void _bench_qos1(void)
+{
+    uint32_t start;
+
+    _reset();
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_MESSAGES; i++) {
+        if (emcute_pub(&_topic, _payload, sizeof(_payload), EMCUTE_QOS_1) != EMCUTE_OK) {
+            _errors++;
+        }
+    }
+    _print_result("pub_qos1", xtimer_now_usec() - start);
+}
+
+static void _bench_qos1_async(void)
+{
+    uint32_t start;
+
+    _reset();
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_MESSAGES; i++) {
+        if (emcute_pub_async(&_topic, _payload, sizeof(_payload), EMCUTE_QOS_1,
+                             _pub_cb, NULL) != EMCUTE_OK) {
+            _errors++;
+            _acked++;
+        }
+    }
+    _wait_for(&_acked, BENCH_MESSAGES);
+    _print_result("pub_qos1_async", xtimer_now_usec() - start);
+}
+
+int main(void)
+{
+    sock_udp_ep_t gw = { .family = AF_INET6, .port = GW_PORT };
+
+    memset(_payload, 'x', sizeof(_payload));
+    ipv6_addr_set_loopback((ipv6_addr_t *)&gw.addr.ipv6);
+
+    thread_create(_gw_stack, sizeof(_gw_stack), THREAD_PRIORITY_MAIN - 2, 0,
+                  _gateway, NULL, "gateway");
+    thread_create(_emcute_stack, sizeof(_emcute_stack), THREAD_PRIORITY_MAIN - 1,
+                  0, _emcute, NULL, "emcute");
+
+    if ((emcute_con(&gw, true, NULL, NULL, 0, 0) != EMCUTE_OK) ||
+        (emcute_reg(&_topic) != EMCUTE_OK)) {
+        puts("error: unable to connect to the gateway");
+        return 1;
+    }
+
+    puts("Start.");
+
+    _bench_qos0();
+    _bench_qos0_batch();
+    _bench_qos1();
+    _bench_qos1_async();
+
+    puts("Done.");
+
+    emcute_discon();
+
+    return 0;
+}
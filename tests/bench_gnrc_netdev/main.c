@@ -0,0 +1,405 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Performance benchmark for the GNRC network stack
+ *
+ * Synthetic IPv6 frames are injected at the link layer through a
+ * @ref sys_netdev_test device and sunk at @ref net_sock_udp and
+ * @ref net_sock_ip. The interface's IPv6 address lookups are timed
+ * separately. Results are printed as one JSON object per line so they
+ * can be compared automatically between runs.
+ *
+ * "lost" counts the packets that did not make it through the stack for any
+ * reason, e.g. a full message queue, an exhausted packet buffer or a receive
+ * timeout. The stack does not count queue overflows, so they are not
+ * reported separately.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "byteorder.h"
+#include "net/ethernet.h"
+#include "net/ethertype.h"
+#include "net/gnrc.h"
+#include "net/gnrc/netif/ethernet.h"
+#include "net/gnrc/netif/internal.h"
+#include "net/gnrc/pktbuf.h"
+#include "net/inet_csum.h"
+#include "net/ipv6/hdr.h"
+#include "net/netdev_test.h"
+#include "net/protnum.h"
+#include "net/sock/ip.h"
+#include "net/sock/udp.h"
+#include "net/udp.h"
+#include "rcu.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#ifndef BENCH_PKTS
+#define BENCH_PKTS          (1000U)
+#endif
+
+#ifndef BENCH_BURST
+#define BENCH_BURST         (4U)
+#endif
+
+#ifndef BENCH_PAYLOAD_LEN
+#define BENCH_PAYLOAD_LEN   (64U)
+#endif
+
+#ifndef BENCH_LOOKUPS
+#define BENCH_LOOKUPS       (10000U)
+#endif
+
+#define BENCH_PORT          (61616U)
+#define BENCH_PROTNUM       (253U)      /**< RFC 3692: experimentation and testing */
+#define BENCH_RECV_TIMEOUT  (10U * US_PER_MS)
+#define BENCH_SETTLE_DELAY  (500U * US_PER_MS)
+
+#define _MAC_STACKSIZE      (THREAD_STACKSIZE_DEFAULT)
+#define _MAC_PRIO           (THREAD_PRIORITY_MAIN - 4)
+
+#define _FRAME_MAX_LEN      (sizeof(ethernet_hdr_t) + sizeof(ipv6_hdr_t) + \
+                             sizeof(udp_hdr_t) + BENCH_PAYLOAD_LEN)
+
+typedef ssize_t (*_recv_t)(void *data, size_t max_len, uint32_t timeout);
+
+static uint8_t _dev_addr[] = { 0x6c, 0x5d, 0xff, 0x73, 0x84, 0x6f };
+static const uint8_t _all_nodes_l2[] = { 0x33, 0x33, 0x00, 0x00, 0x00, 0x01 };
+static const uint8_t _peer_l2[] = { 0x41, 0x9b, 0x9f, 0x56, 0x36, 0x46 };
+static const ipv6_addr_t _peer_addr = { {
+        0xfe, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x43, 0x9b, 0x9f, 0xff, 0xfe, 0x56, 0x36, 0x46
+    } };
+
+static char _mac_stack[_MAC_STACKSIZE];
+static netdev_test_t _dev;
+static gnrc_netif_t *_netif;
+static kernel_pid_t _mac_pid;
+static sock_udp_t _udp_sock;
+static sock_ip_t _ip_sock;
+
+static uint8_t _frame[_FRAME_MAX_LEN];
+static int _frame_len;
+static uint8_t _rcv_buf[BENCH_PAYLOAD_LEN];
+
+/* time stamps set along the path of a single packet */
+static volatile uint32_t _t_inject, _t_recv, _t_send;
+static volatile unsigned _sent_frames;
+
+/* per-packet samples; every layer gets its own array */
+static uint32_t _lat_l2[BENCH_PKTS];
+static uint32_t _lat_stack[BENCH_PKTS];
+static uint32_t _lat_total[BENCH_PKTS];
+
+static void _dev_isr(netdev_t *dev);
+static int _dev_recv(netdev_t *dev, char *buf, int len, void *info);
+static int _dev_send(netdev_t *dev, const struct iovec *vector, int count);
+static int _dev_get_addr(netdev_t *dev, void *value, size_t max_len);
+
+static ssize_t _udp_recv(void *data, size_t max_len, uint32_t timeout)
+{
+    return sock_udp_recv(&_udp_sock, data, max_len, timeout, NULL);
+}
+
+static ssize_t _ip_recv(void *data, size_t max_len, uint32_t timeout)
+{
+    return sock_ip_recv(&_ip_sock, data, max_len, timeout, NULL);
+}
+
+static void _build_frame(uint8_t protnum, uint32_t seq)
+{
+    ethernet_hdr_t *eth = (ethernet_hdr_t *)_frame;
+    ipv6_hdr_t *ipv6 = (ipv6_hdr_t *)(eth + 1);
+    udp_hdr_t *udp = (udp_hdr_t *)(ipv6 + 1);
+    uint8_t *payload = (uint8_t *)(ipv6 + 1);
+    uint16_t upper_len = BENCH_PAYLOAD_LEN;
+
+    memcpy(eth->dst, _all_nodes_l2, sizeof(eth->dst));
+    memcpy(eth->src, _peer_l2, sizeof(eth->src));
+    eth->type = byteorder_htons(ETHERTYPE_IPV6);
+
+    memset(ipv6, 0, sizeof(ipv6_hdr_t));
+    ipv6_hdr_set_version(ipv6);
+    ipv6->nh = protnum;
+    ipv6->hl = 64;
+    ipv6->src = _peer_addr;
+    ipv6->dst = ipv6_addr_all_nodes_link_local;
+
+    if (protnum == PROTNUM_UDP) {
+        payload += sizeof(udp_hdr_t);
+        upper_len += sizeof(udp_hdr_t);
+        udp->src_port = byteorder_htons(BENCH_PORT);
+        udp->dst_port = byteorder_htons(BENCH_PORT);
+        udp->length = byteorder_htons(upper_len);
+        udp->checksum = byteorder_htons(0);
+    }
+    ipv6->len = byteorder_htons(upper_len);
+
+    /* sequence number followed by a recognizable pattern */
+    memcpy(payload, &seq, sizeof(seq));
+    for (unsigned i = sizeof(seq); i < BENCH_PAYLOAD_LEN; i++) {
+        payload[i] = (uint8_t)i;
+    }
+
+    if (protnum == PROTNUM_UDP) {
+        uint16_t csum = ipv6_hdr_inet_csum(0, ipv6, PROTNUM_UDP, upper_len);
+
+        csum = ~inet_csum(csum, (uint8_t *)udp, upper_len);
+        udp->checksum = byteorder_htons((csum == 0) ? 0xffff : csum);
+    }
+    _frame_len = sizeof(ethernet_hdr_t) + sizeof(ipv6_hdr_t) + upper_len;
+}
+
+static inline void _inject(void)
+{
+    _t_inject = xtimer_now_usec();
+    _dev.netdev.event_callback(&_dev.netdev, NETDEV_EVENT_ISR);
+}
+
+static int _cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void _print_dist(const char *name, uint32_t *samples, unsigned num)
+{
+    if (num == 0) {
+        printf(", \"%s\": null", name);
+        return;
+    }
+    qsort(samples, num, sizeof(uint32_t), _cmp_u32);
+    printf(", \"%s\": {\"p50\": %" PRIu32 ", \"p90\": %" PRIu32
+           ", \"p99\": %" PRIu32 ", \"max\": %" PRIu32 "}", name,
+           samples[(num * 50) / 100], samples[(num * 90) / 100],
+           samples[(num * 99) / 100], samples[num - 1]);
+}
+
+static uint32_t _pps(unsigned pkts, uint32_t usec)
+{
+    return (usec == 0) ? 0 : (uint32_t)(((uint64_t)pkts * US_PER_SEC) / usec);
+}
+
+/* inject one frame at a time and time the layers it passes */
+static void _bench_rx_latency(const char *name, uint8_t protnum, _recv_t recv)
+{
+    unsigned received = 0;
+    uint32_t start = xtimer_now_usec();
+
+    for (unsigned i = 0; i < BENCH_PKTS; i++) {
+        uint32_t t_sock;
+
+        _build_frame(protnum, i);
+        _inject();
+        if (recv(_rcv_buf, sizeof(_rcv_buf), BENCH_RECV_TIMEOUT) < 0) {
+            continue;
+        }
+        t_sock = xtimer_now_usec();
+        _lat_l2[received] = _t_recv - _t_inject;
+        _lat_stack[received] = t_sock - _t_recv;
+        _lat_total[received] = t_sock - _t_inject;
+        received++;
+    }
+    printf("{\"bench\": \"%s\", \"pkts\": %u, \"lost\": %u, "
+           "\"pps\": %" PRIu32, name, BENCH_PKTS, BENCH_PKTS - received,
+           _pps(received, xtimer_now_usec() - start));
+    _print_dist("l2_us", _lat_l2, received);
+    _print_dist("stack_us", _lat_stack, received);
+    _print_dist("total_us", _lat_total, received);
+    puts("}");
+}
+
+/* inject bursts of frames before draining the sock to expose losses under
+ * load, e.g. by full message queues */
+static void _bench_rx_burst(const char *name, uint8_t protnum, _recv_t recv)
+{
+    unsigned received = 0, injected = 0;
+    uint32_t start = xtimer_now_usec();
+
+    while (injected < BENCH_PKTS) {
+        for (unsigned i = 0; (i < BENCH_BURST) && (injected < BENCH_PKTS); i++) {
+            _build_frame(protnum, injected++);
+            _inject();
+        }
+        while (recv(_rcv_buf, sizeof(_rcv_buf), 0) >= 0) {
+            received++;
+        }
+    }
+    printf("{\"bench\": \"%s\", \"pkts\": %u, \"burst\": %u, "
+           "\"lost\": %u, \"pps\": %" PRIu32 "}\n", name, BENCH_PKTS,
+           BENCH_BURST, BENCH_PKTS - received,
+           _pps(received, xtimer_now_usec() - start));
+}
+
+static void _bench_tx(const char *name)
+{
+    sock_udp_ep_t remote = { .family = AF_INET6, .port = BENCH_PORT,
+                             .netif = _mac_pid };
+    unsigned sent = 0;
+    uint32_t start;
+
+    memcpy(remote.addr.ipv6, &ipv6_addr_all_nodes_link_local,
+           sizeof(remote.addr.ipv6));
+    memset(_rcv_buf, 0x5a, sizeof(_rcv_buf));
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_PKTS; i++) {
+        unsigned before = _sent_frames;
+        uint32_t t_sock = xtimer_now_usec();
+
+        if ((sock_udp_send(&_udp_sock, _rcv_buf, sizeof(_rcv_buf), &remote) < 0) ||
+            (_sent_frames == before)) {
+            continue;
+        }
+        _lat_total[sent++] = _t_send - t_sock;
+    }
+    printf("{\"bench\": \"%s\", \"pkts\": %u, \"lost\": %u, "
+           "\"pps\": %" PRIu32, name, BENCH_PKTS, BENCH_PKTS - sent,
+           _pps(sent, xtimer_now_usec() - start));
+    _print_dist("total_us", _lat_total, sent);
+    puts("}");
+}
+
+#define TIME_LOOKUPS(body) \
+    ({ \
+        uint32_t start = xtimer_now_usec(); \
+        for (unsigned i = 0; i < BENCH_LOOKUPS; i++) { \
+            body; \
+        } \
+        (uint32_t)(((uint64_t)(xtimer_now_usec() - start) * 1000U) / \
+                   BENCH_LOOKUPS); \
+    })
+
+/* time the locking of the address table on its own and the lookups using it */
+static void _bench_addr_lookup(void)
+{
+    ipv6_addr_t *src = gnrc_netif_ipv6_addr_best_src(_netif,
+                                                     &ipv6_addr_all_nodes_link_local,
+                                                     true);
+    ipv6_addr_t addr;
+    uint32_t acquire, rcu_read, idx, match, best_src;
+
+    if (src == NULL) {
+        puts("No link-local address configured");
+        return;
+    }
+    memcpy(&addr, src, sizeof(addr));
+    acquire = TIME_LOOKUPS({
+        gnrc_netif_acquire(_netif);
+        gnrc_netif_release(_netif);
+    });
+    rcu_read = TIME_LOOKUPS(rcu_read_unlock(rcu_read_lock()));
+    idx = TIME_LOOKUPS(gnrc_netif_ipv6_addr_idx(_netif, &addr));
+    match = TIME_LOOKUPS(gnrc_netif_ipv6_addr_match(_netif, &addr));
+    best_src = TIME_LOOKUPS(gnrc_netif_ipv6_addr_best_src(_netif, &addr, false));
+    printf("{\"bench\": \"addr_lookup\", \"lookups\": %u, \"ns\": "
+           "{\"acquire\": %" PRIu32 ", \"rcu_read\": %" PRIu32
+           ", \"addr_idx\": %" PRIu32 ", \"addr_match\": %" PRIu32
+           ", \"best_src\": %" PRIu32 "}}\n", BENCH_LOOKUPS, acquire,
+           rcu_read, idx, match, best_src);
+}
+
+int main(void)
+{
+    sock_udp_ep_t udp_local = SOCK_IPV6_EP_ANY;
+    sock_ip_ep_t ip_local = SOCK_IPV6_EP_ANY;
+
+    netdev_test_setup(&_dev, NULL);
+    netdev_test_set_isr_cb(&_dev, _dev_isr);
+    netdev_test_set_recv_cb(&_dev, _dev_recv);
+    netdev_test_set_send_cb(&_dev, _dev_send);
+    netdev_test_set_get_cb(&_dev, NETOPT_ADDRESS, _dev_get_addr);
+    _netif = gnrc_netif_ethernet_create(_mac_stack, _MAC_STACKSIZE, _MAC_PRIO,
+                                        "netdev_test", &_dev.netdev);
+    _mac_pid = _netif->pid;
+
+    udp_local.port = BENCH_PORT;
+    if ((sock_udp_create(&_udp_sock, &udp_local, NULL, 0) < 0) ||
+        (sock_ip_create(&_ip_sock, &ip_local, NULL, BENCH_PROTNUM, 0) < 0)) {
+        puts("Unable to create socks");
+        return 1;
+    }
+    /* let address configuration and the stack's own signaling pass */
+    xtimer_usleep(BENCH_SETTLE_DELAY);
+
+    puts("Start.");
+    _bench_rx_latency("rx_udp", PROTNUM_UDP, _udp_recv);
+    _bench_rx_latency("rx_ip", BENCH_PROTNUM, _ip_recv);
+    _bench_rx_burst("rx_udp_burst", PROTNUM_UDP, _udp_recv);
+    _bench_rx_burst("rx_ip_burst", BENCH_PROTNUM, _ip_recv);
+    _bench_tx("tx_udp");
+    _bench_addr_lookup();
+    printf("{\"bench\": \"pktbuf\", \"size\": %u, \"max_used\": %u}\n",
+           (unsigned)GNRC_PKTBUF_SIZE, (unsigned)gnrc_pktbuf_max_byte_count());
+    puts("Done.");
+
+    return 0;
+}
+
+/* netdev_test callbacks */
+static void _dev_isr(netdev_t *dev)
+{
+    if (dev->event_callback) {
+        dev->event_callback(dev, NETDEV_EVENT_RX_COMPLETE);
+    }
+}
+
+static int _dev_recv(netdev_t *dev, char *buf, int len, void *info)
+{
+    (void)dev;
+    (void)info;
+    if (buf == NULL) {
+        return _frame_len;
+    }
+    else if (len < _frame_len) {
+        return -ENOBUFS;
+    }
+    memcpy(buf, _frame, _frame_len);
+    _t_recv = xtimer_now_usec();
+    return _frame_len;
+}
+
+static int _dev_send(netdev_t *dev, const struct iovec *vector, int count)
+{
+    uint32_t now = xtimer_now_usec();
+    int len = 0;
+
+    (void)dev;
+    for (int i = 0; i < count; i++) {
+        len += vector[i].iov_len;
+    }
+    /* only count our own UDP packets, not the stack's signaling */
+    if ((count > 1) && (vector[1].iov_len >= sizeof(ipv6_hdr_t)) &&
+        (((ipv6_hdr_t *)vector[1].iov_base)->nh == PROTNUM_UDP)) {
+        _t_send = now;
+        _sent_frames++;
+    }
+    return len;
+}
+
+static int _dev_get_addr(netdev_t *dev, void *value, size_t max_len)
+{
+    (void)dev;
+    if (max_len < sizeof(_dev_addr)) {
+        return -ENOBUFS;
+    }
+    memcpy(value, _dev_addr, sizeof(_dev_addr));
+    return sizeof(_dev_addr);
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Measure throughput and latency of core msg
+ *
+ * Every benchmark runs for @ref BENCH_DURATION seconds and prints its result
+ * as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "msg.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#ifndef BENCH_DURATION
+#define BENCH_DURATION      (2U)    /**< duration of each benchmark in seconds */
+#endif
+
+#ifndef BENCH_QUEUE_SIZE
+#define BENCH_QUEUE_SIZE    (8U)    /**< must be a power of two */
+#endif
+
+#define MSG_TYPE_DATA       (0x4e00)
+#define MSG_TYPE_LAST       (0x4e01)
+
+static char _server_stack[THREAD_STACKSIZE_DEFAULT];
+static char _sink_stack[THREAD_STACKSIZE_DEFAULT];
+static kernel_pid_t _server_pid, _sink_pid;
+static msg_t _main_queue[BENCH_QUEUE_SIZE];
+
+static void _done_cb(void *done)
+{
+    *((volatile int *)done) = 1;
+}
+
+static void _print_result(const char *name, uint32_t ops, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"ops\": %" PRIu32 ", \"duration_us\": %"
+           PRIu32 ", \"ops_per_sec\": %" PRIu32 ", \"ns_per_op\": %" PRIu32
+           "}\n", name, ops, usec,
+           (uint32_t)(((uint64_t)ops * US_PER_SEC) / usec),
+           (uint32_t)(((uint64_t)usec * 1000U) / ops));
+}
+
+#define RUN_BENCH(name, body) \
+    do { \
+        volatile int done = 0; \
+        uint32_t ops = 0, start; \
+        xtimer_t timer = { .callback = _done_cb, .arg = (void *)&done }; \
+        start = xtimer_now_usec(); \
+        xtimer_set(&timer, BENCH_DURATION * US_PER_SEC); \
+        while (!done) { \
+            body; \
+        } \
+        _print_result(name, ops, xtimer_now_usec() - start); \
+    } while (0)
+
+/* replies to every request it receives */
+static void *_server(void *arg)
+{
+    msg_t m;
+
+    (void)arg;
+    while (1) {
+        msg_receive(&m);
+        msg_reply(&m, &m);
+    }
+    return NULL;
+}
+
+/* drains its queue and signals the sender after the last message of a burst */
+static void *_sink(void *arg)
+{
+    msg_t queue[BENCH_QUEUE_SIZE];
+    msg_t m;
+
+    (void)arg;
+    msg_init_queue(queue, BENCH_QUEUE_SIZE);
+    while (1) {
+        msg_receive(&m);
+        if (m.type == MSG_TYPE_LAST) {
+            msg_send(&m, m.sender_pid);
+        }
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    msg_t m, reply;
+
+    msg_init_queue(_main_queue, BENCH_QUEUE_SIZE);
+    _server_pid = thread_create(_server_stack, sizeof(_server_stack),
+                                THREAD_PRIORITY_MAIN - 1,
+                                THREAD_CREATE_STACKTEST, _server, NULL,
+                                "server");
+    _sink_pid = thread_create(_sink_stack, sizeof(_sink_stack),
+                              THREAD_PRIORITY_MAIN + 1,
+                              THREAD_CREATE_STACKTEST, _sink, NULL, "sink");
+
+    puts("Start.");
+
+    /* synchronous round trip to a higher priority thread */
+    m.type = MSG_TYPE_DATA;
+    RUN_BENCH("send_receive", {
+        msg_send_receive(&m, &reply, _server_pid);
+        ops++;
+    });
+
+    /* enqueue and dequeue within one thread */
+    RUN_BENCH("queue_self", {
+        for (unsigned i = 0; i < BENCH_QUEUE_SIZE; i++) {
+            msg_send_to_self(&m);
+        }
+        for (unsigned i = 0; i < BENCH_QUEUE_SIZE; i++) {
+            msg_receive(&reply);
+        }
+        ops += BENCH_QUEUE_SIZE;
+    });
+
+    /* fill the queue of a lower priority thread, then wait for it to drain */
+    RUN_BENCH("queue_burst", {
+        m.type = MSG_TYPE_DATA;
+        for (unsigned i = 0; i < (BENCH_QUEUE_SIZE - 1); i++) {
+            msg_try_send(&m, _sink_pid);
+        }
+        m.type = MSG_TYPE_LAST;
+        msg_try_send(&m, _sink_pid);
+        msg_receive(&reply);
+        ops += BENCH_QUEUE_SIZE;
+    });
+
+    puts("Done.");
+    return 0;
+}
@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Throughput benchmark for MTD_0 and littlefs on top of it
+ *
+ * The littlefs benchmarks are run twice: directly on MTD_0 and with a
+ * mtd_cache in between. Results are printed as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "board.h"
+#include "fs/littlefs_fs.h"
+#include "mtd.h"
+#include "mtd_cache.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+#ifndef BENCH_MTD_OPS
+#define BENCH_MTD_OPS       (4096U)
+#endif
+
+#ifndef BENCH_FILES
+#define BENCH_FILES         (16U)
+#endif
+
+#ifndef BENCH_FILE_SIZE
+#define BENCH_FILE_SIZE     (4096U)
+#endif
+
+#ifndef BENCH_STAT_ROUNDS
+#define BENCH_STAT_ROUNDS   (32U)
+#endif
+
+#ifndef BENCH_DIRS
+#define BENCH_DIRS          (8U)
+#endif
+
+#define BENCH_CHUNK         (256U)
+#define BENCH_SMALL_READ    (16U)
+#define BENCH_SECTORS       (16U)
+
+#define MOUNT_POINT         "/lfs"
+#define NAME_LEN            (sizeof(MOUNT_POINT "/dir00/bench0000"))
+#define BENCH_NAME_LEN      (32U)
+
+static uint8_t _buf[BENCH_CHUNK];
+static uint8_t _cmp[BENCH_CHUNK];
+static mtd_cache_t _cache;
+static littlefs_desc_t _fs_desc;
+static vfs_mount_t _mount = {
+    .fs = &littlefs_file_system,
+    .mount_point = MOUNT_POINT,
+    .private_data = &_fs_desc,
+};
+
+static void _print_result(const char *name, uint32_t ops, uint32_t bytes,
+                          uint32_t usec)
+{
+    if (usec == 0) {
+        usec = 1;
+    }
+    printf("{\"bench\": \"%s\", \"ops\": %" PRIu32 ", \"bytes\": %" PRIu32
+           ", \"duration_us\": %" PRIu32 ", \"ops_per_sec\": %" PRIu32
+           ", \"kib_per_sec\": %" PRIu32 "}\n", name, ops, bytes, usec,
+           (uint32_t)(((uint64_t)ops * US_PER_SEC) / usec),
+           (uint32_t)(((uint64_t)bytes * US_PER_SEC) / (1024U * usec)));
+}
+
+static void _print_lfs_result(const char *prefix, const char *name,
+                              uint32_t ops, uint32_t bytes, uint32_t usec)
+{
+    char bench[BENCH_NAME_LEN];
+
+    snprintf(bench, sizeof(bench), "%s_%s", prefix, name);
+    _print_result(bench, ops, bytes, usec);
+}
+
+static void _fill(uint8_t *buf, unsigned file, unsigned chunk)
+{
+    for (unsigned i = 0; i < BENCH_CHUNK; i++) {
+        buf[i] = (uint8_t)(file + chunk + i);
+    }
+}
+
+static void _file_name(char *name, unsigned file)
+{
+    snprintf(name, NAME_LEN, MOUNT_POINT "/bench%02u", file);
+}
+
+static int _bench_mtd(mtd_dev_t *dev)
+{
+    uint32_t page_size = dev->page_size;
+    uint32_t sector_size = dev->pages_per_sector * page_size;
+    uint32_t mtd_size = dev->sector_count * sector_size;
+    uint32_t start, addr = 0, lcg = 1;
+
+    if (page_size > BENCH_CHUNK) {
+        puts("page size exceeds buffer");
+        return -1;
+    }
+
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_SECTORS; i++) {
+        if (mtd_erase(dev, i * sector_size, sector_size) < 0) {
+            return -1;
+        }
+    }
+    _print_result("mtd_erase", BENCH_SECTORS, BENCH_SECTORS * sector_size,
+                  xtimer_now_usec() - start);
+
+    memset(_buf, 0xa5, page_size);
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < (BENCH_SECTORS * dev->pages_per_sector); i++) {
+        if (mtd_write(dev, _buf, i * page_size, page_size) < 0) {
+            return -1;
+        }
+    }
+    _print_result("mtd_write_page", BENCH_SECTORS * dev->pages_per_sector,
+                  BENCH_SECTORS * sector_size, xtimer_now_usec() - start);
+
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_MTD_OPS; i++) {
+        if (mtd_read(dev, _buf, addr, page_size) < 0) {
+            return -1;
+        }
+        addr = (addr + page_size) % mtd_size;
+    }
+    _print_result("mtd_read_page", BENCH_MTD_OPS, BENCH_MTD_OPS * page_size,
+                  xtimer_now_usec() - start);
+
+    /* small scattered reads as issued for file system metadata */
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_MTD_OPS; i++) {
+        lcg = (lcg * 1103515245U) + 12345U;
+        addr = lcg % (mtd_size - BENCH_SMALL_READ);
+        if (mtd_read(dev, _buf, addr, BENCH_SMALL_READ) < 0) {
+            return -1;
+        }
+    }
+    _print_result("mtd_read_small", BENCH_MTD_OPS,
+                  BENCH_MTD_OPS * BENCH_SMALL_READ, xtimer_now_usec() - start);
+
+    start = xtimer_now_usec();
+    if (mtd_flush(dev) < 0) {
+        return -1;
+    }
+    _print_result("mtd_flush", 1, 0, xtimer_now_usec() - start);
+    return 0;
+}
+
+static int _bench_dirs(const char *prefix)
+{
+    char name[NAME_LEN];
+    vfs_DIR dir;
+    vfs_dirent_t entry;
+    uint32_t start, entries = 0;
+    int fd;
+
+    start = xtimer_now_usec();
+    for (unsigned d = 0; d < BENCH_DIRS; d++) {
+        snprintf(name, sizeof(name), MOUNT_POINT "/dir%02u", d);
+        if (vfs_mkdir(name, 0) < 0) {
+            return -1;
+        }
+        for (unsigned f = 0; f < BENCH_FILES; f++) {
+            snprintf(name, sizeof(name), MOUNT_POINT "/dir%02u/bench%02u", d, f);
+            fd = vfs_open(name, O_CREAT | O_WRONLY, 0);
+            if (fd < 0) {
+                return -1;
+            }
+            vfs_close(fd);
+        }
+    }
+    _print_lfs_result(prefix, "create", BENCH_DIRS * BENCH_FILES, 0,
+                      xtimer_now_usec() - start);
+
+    start = xtimer_now_usec();
+    for (unsigned r = 0; r < BENCH_STAT_ROUNDS; r++) {
+        for (unsigned d = 0; d < BENCH_DIRS; d++) {
+            snprintf(name, sizeof(name), MOUNT_POINT "/dir%02u", d);
+            if (vfs_opendir(&dir, name) < 0) {
+                return -1;
+            }
+            while (vfs_readdir(&dir, &entry) > 0) {
+                entries++;
+            }
+            vfs_closedir(&dir);
+        }
+    }
+    _print_lfs_result(prefix, "readdir", entries, 0, xtimer_now_usec() - start);
+
+    start = xtimer_now_usec();
+    for (unsigned d = 0; d < BENCH_DIRS; d++) {
+        for (unsigned f = 0; f < BENCH_FILES; f++) {
+            snprintf(name, sizeof(name), MOUNT_POINT "/dir%02u/bench%02u", d, f);
+            if (vfs_unlink(name) < 0) {
+                return -1;
+            }
+        }
+        snprintf(name, sizeof(name), MOUNT_POINT "/dir%02u", d);
+        if (vfs_rmdir(name) < 0) {
+            return -1;
+        }
+    }
+    _print_lfs_result(prefix, "remove", BENCH_DIRS * BENCH_FILES, 0,
+                      xtimer_now_usec() - start);
+    return 0;
+}
+
+static int _bench_littlefs(const char *prefix)
+{
+    char name[NAME_LEN];
+    struct stat st;
+    uint32_t start;
+    int fd;
+
+    start = xtimer_now_usec();
+    for (unsigned f = 0; f < BENCH_FILES; f++) {
+        _file_name(name, f);
+        fd = vfs_open(name, O_CREAT | O_TRUNC | O_WRONLY, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        for (unsigned c = 0; c < (BENCH_FILE_SIZE / BENCH_CHUNK); c++) {
+            _fill(_buf, f, c);
+            if (vfs_write(fd, _buf, BENCH_CHUNK) != BENCH_CHUNK) {
+                vfs_close(fd);
+                return -1;
+            }
+        }
+        vfs_close(fd);
+    }
+    _print_lfs_result(prefix, "write", BENCH_FILES,
+                      BENCH_FILES * BENCH_FILE_SIZE, xtimer_now_usec() - start);
+
+    start = xtimer_now_usec();
+    for (unsigned f = 0; f < BENCH_FILES; f++) {
+        _file_name(name, f);
+        fd = vfs_open(name, O_RDONLY, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        for (unsigned c = 0; c < (BENCH_FILE_SIZE / BENCH_CHUNK); c++) {
+            _fill(_cmp, f, c);
+            if ((vfs_read(fd, _buf, BENCH_CHUNK) != BENCH_CHUNK) ||
+                (memcmp(_buf, _cmp, BENCH_CHUNK) != 0)) {
+                puts("file content mismatch");
+                vfs_close(fd);
+                return -1;
+            }
+        }
+        vfs_close(fd);
+    }
+    _print_lfs_result(prefix, "read", BENCH_FILES,
+                      BENCH_FILES * BENCH_FILE_SIZE, xtimer_now_usec() - start);
+
+    start = xtimer_now_usec();
+    for (unsigned r = 0; r < BENCH_STAT_ROUNDS; r++) {
+        for (unsigned f = 0; f < BENCH_FILES; f++) {
+            _file_name(name, f);
+            if ((vfs_stat(name, &st) < 0) || (st.st_size != BENCH_FILE_SIZE)) {
+                return -1;
+            }
+        }
+    }
+    _print_lfs_result(prefix, "stat", BENCH_STAT_ROUNDS * BENCH_FILES, 0,
+                      xtimer_now_usec() - start);
+
+    start = xtimer_now_usec();
+    for (unsigned f = 0; f < BENCH_FILES; f++) {
+        _file_name(name, f);
+        if (vfs_unlink(name) < 0) {
+            return -1;
+        }
+    }
+    _print_lfs_result(prefix, "unlink", BENCH_FILES, 0,
+                      xtimer_now_usec() - start);
+
+    return _bench_dirs(prefix);
+}
+
+static int _run_littlefs(const char *prefix, mtd_dev_t *dev)
+{
+    int res;
+
+    /* littlefs formats the device if it holds no valid file system */
+    _fs_desc.dev = dev;
+    if (vfs_mount(&_mount) < 0) {
+        puts("Unable to mount littlefs");
+        return -1;
+    }
+    res = _bench_littlefs(prefix);
+    vfs_umount(&_mount);
+    if (res < 0) {
+        puts("littlefs benchmark failed");
+    }
+    return res;
+}
+
+int main(void)
+{
+    puts("Start.");
+
+    if ((mtd_init(MTD_0) < 0) || (_bench_mtd(MTD_0) < 0)) {
+        puts("MTD benchmark failed");
+        return 1;
+    }
+
+    if (_run_littlefs("lfs", MTD_0) < 0) {
+        return 1;
+    }
+
+    mtd_cache_setup(&_cache, MTD_0);
+    if ((mtd_init(&_cache.base) < 0) ||
+        (_run_littlefs("lfs_cached", &_cache.base) < 0) ||
+        (mtd_flush(&_cache.base) < 0)) {
+        return 1;
+    }
+    printf("{\"bench\": \"mtd_cache_stats\", \"hits\": %" PRIu32
+           ", \"misses\": %" PRIu32 ", \"writebacks\": %" PRIu32 "}\n",
+           _cache.stats.hits, _cache.stats.misses, _cache.stats.writebacks);
+
+    puts("Done.");
+    return 0;
+}
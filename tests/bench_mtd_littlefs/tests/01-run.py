@@ -0,0 +1,33 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2017 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import os
+import sys
+import json
+
+LFS_BENCHMARKS = ('write', 'read', 'stat', 'unlink', 'create', 'readdir',
+                  'remove')
+BENCHMARKS = (('mtd_erase', 'mtd_write_page', 'mtd_read_page', 'mtd_read_small',
+               'mtd_flush') +
+              tuple('lfs_' + name for name in LFS_BENCHMARKS) +
+              tuple('lfs_cached_' + name for name in LFS_BENCHMARKS) +
+              ('mtd_cache_stats',))
+
+
+def testfunc(child):
+    child.expect_exact('Start.')
+    for name in BENCHMARKS:
+        child.expect(r'(\{"bench": "%s".*\})\r\n' % name, timeout=120)
+        print(json.dumps(json.loads(child.match.group(1))))
+    child.expect_exact('Done.')
+
+
+if __name__ == "__main__":
+    sys.path.append(os.path.join(os.environ['RIOTBASE'], 'dist/tools/testrunner'))
+    from testrunner import run
+    sys.exit(run(testfunc))
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Throughput of block-wise transfers with nanocoap
+ *
+ * A nanocoap_server_mt() instance on the loopback address serves a resource
+ * much larger than its buffers with coap_block2_reply() and accepts uploads
+ * with coap_block1_reply(). Every request is delayed by the server to stand
+ * in for the round trip time of a real link, which is what pipelining with
+ * @ref NANOCOAP_BLOCK_WINDOW hides. The "get_loss" benchmark drops the first
+ * response to one block, so the transfer only completes if the client
+ * retransmits that request. Each benchmark checks the transferred data and
+ * prints its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "net/ipv6/addr.h"
+#include "net/nanocoap.h"
+#include "net/nanocoap_sock.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#ifndef BENCH_SIZE
+#define BENCH_SIZE          (16384U)    /**< size of the transferred resource */
+#endif
+
+#ifndef BENCH_DELAY
+#define BENCH_DELAY         (10000U)    /**< server delay per block in us */
+#endif
+
+#ifndef BENCH_DROP_BLOCK
+#define BENCH_DROP_BLOCK    (5U)        /**< block dropped by "get_loss" */
+#endif
+
+#define BUF_SIZE            (NANOCOAP_SERVER_BUFSIZE)
+
+static char _server_stack[THREAD_STACKSIZE_DEFAULT];
+static uint8_t _buf[BUF_SIZE];
+static sock_udp_ep_t _server = { .family = AF_INET6, .port = COAP_PORT };
+static volatile unsigned _requests;
+static volatile unsigned _dropped;
+static volatile bool _drop;
+static size_t _received;
+static unsigned _errors;
+
+static inline uint8_t _pattern(size_t offset)
+{
+    return (uint8_t)((offset * 7) ^ (offset >> 8));
+}
+
+static ssize_t _read(void *arg, size_t offset, uint8_t *buf, size_t len)
+{
+    (void)arg;
+    if (offset >= BENCH_SIZE) {
+        return 0;
+    }
+    if (len > BENCH_SIZE - offset) {
+        len = BENCH_SIZE - offset;
+    }
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = _pattern(offset + i);
+    }
+    return len;
+}
+
+static int _write(void *arg, size_t offset, const uint8_t *buf, size_t len,
+                  bool more)
+{
+    (void)arg;
+    (void)more;
+    if (offset + len > BENCH_SIZE) {
+        return -EFBIG;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] != _pattern(offset + i)) {
+            _errors++;
+            break;
+        }
+    }
+    _received += len;
+    return 0;
+}
+
+static ssize_t _image_handler(coap_pkt_t *pkt, uint8_t *buf, size_t len)
+{
+    coap_block_t block;
+
+    _requests++;
+    xtimer_usleep(BENCH_DELAY);
+    if (_drop && coap_get_block2(pkt, &block) &&
+        (block.num == BENCH_DROP_BLOCK)) {
+        /* no response is sent, the request is not cached as answered */
+        _drop = false;
+        _dropped++;
+        return 0;
+    }
+    return coap_block2_reply(pkt, buf, len, COAP_FORMAT_OCTET, _read, NULL);
+}
+
+static ssize_t _upload_handler(coap_pkt_t *pkt, uint8_t *buf, size_t len)
+{
+    _requests++;
+    xtimer_usleep(BENCH_DELAY);
+    return coap_block1_reply(pkt, buf, len, _write, NULL);
+}
+
+/* must be sorted by path (alphabetically) */
+const coap_resource_t coap_resources[] = {
+    { "/image", COAP_GET, _image_handler },
+    { "/upload", COAP_PUT, _upload_handler },
+};
+
+const unsigned coap_resources_numof = sizeof(coap_resources) / sizeof(coap_resources[0]);
+
+static void *_server_thread(void *arg)
+{
+    sock_udp_ep_t local = { .family = AF_INET6, .port = COAP_PORT };
+
+    (void)arg;
+    nanocoap_server_mt(&local);
+    puts("error: nanocoap server exited");
+    return NULL;
+}
+
+static void _print_result(const char *name, ssize_t res, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"window\": %u, \"size\": %u, "
+           "\"result\": %d, \"requests\": %u, \"dropped\": %u, "
+           "\"errors\": %u, "
+           "\"duration_us\": %" PRIu32 ", \"bytes_per_s\": %" PRIu32 "}\n",
+           name, NANOCOAP_BLOCK_WINDOW, BENCH_SIZE, (int)res, _requests,
+           _dropped, _errors, usec,
+           (uint32_t)(((uint64_t)_received * US_PER_SEC) / usec));
+}
+
+static void _bench_get(const char *name, bool drop)
+{
+    _requests = 0;
+    _dropped = 0;
+    _received = 0;
+    _errors = 0;
+    _drop = drop;
+
+    uint32_t start = xtimer_now_usec();
+    ssize_t res = nanocoap_get_blockwise(&_server, "/image", _buf,
+                                         sizeof(_buf), _write, NULL);
+    _print_result(name, res, xtimer_now_usec() - start);
+}
+
+static void _bench_put(void)
+{
+    _requests = 0;
+    _dropped = 0;
+    _received = 0;
+    _errors = 0;
+
+    uint32_t start = xtimer_now_usec();
+    ssize_t res = nanocoap_put_blockwise(&_server, "/upload", _buf,
+                                         sizeof(_buf), _read, NULL);
+    _print_result("put", res, xtimer_now_usec() - start);
+}
+
+int main(void)
+{
+    ipv6_addr_set_loopback((ipv6_addr_t *)&_server.addr.ipv6);
+
+    /* receives above the workers, so requests are queued right away */
+    thread_create(_server_stack, sizeof(_server_stack), NANOCOAP_SERVER_PRIO - 1,
+                  THREAD_CREATE_STACKTEST, _server_thread, NULL, "coap server");
+
+    puts("Start.");
+
+    _bench_get("get", false);
+    _bench_get("get_loss", true);
+    _bench_put();
+
+    puts("Done.");
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       nanocoap request dispatch latency
+ *
+ * The resource table with @ref BENCH_RESOURCES entries is generated at build
+ * time. Requests are dispatched through the generated index by
+ * coap_handle_req() and, for comparison, by a linear search over the sorted
+ * table. Each benchmark prints its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "net/nanocoap.h"
+#include "xtimer.h"
+
+#ifndef BENCH_ROUNDS
+#define BENCH_ROUNDS        (100U)      /**< lookups per resource */
+#endif
+
+#define BUF_SIZE            (128U)
+
+static uint8_t _req_buf[BUF_SIZE];
+static uint8_t _resp_buf[BUF_SIZE];
+static coap_pkt_t _pkt;
+static unsigned _hits;
+static unsigned _errors;
+
+ssize_t bench_handler(coap_pkt_t *pkt, uint8_t *buf, size_t len)
+{
+    _hits++;
+    return coap_build_reply(pkt, COAP_CODE_204, buf, len, 0);
+}
+
+/* the search coap_handle_req() did before the index was generated */
+static ssize_t _linear_dispatch(coap_pkt_t *pkt, uint8_t *resp_buf,
+                                unsigned resp_buf_len)
+{
+    unsigned method_flag = coap_method2flag(coap_get_code_detail(pkt));
+
+    for (unsigned i = 0; i < coap_resources_numof; i++) {
+        if (!(coap_resources[i].methods & method_flag)) {
+            continue;
+        }
+
+        int res = strcmp((char *)pkt->url, coap_resources[i].path);
+        if (res > 0) {
+            continue;
+        }
+        else if (res < 0) {
+            break;
+        }
+        else {
+            return coap_resources[i].handler(pkt, resp_buf, resp_buf_len);
+        }
+    }
+
+    return coap_build_reply(pkt, COAP_CODE_404, resp_buf, resp_buf_len, 0);
+}
+
+static void _set_path(unsigned i, bool hit)
+{
+    sprintf((char *)_pkt.url, hit ? "/sensor/%u/value" : "/sensor/%u/state", i);
+}
+
+static void _bench(const char *name, bool linear, bool hit)
+{
+    uint32_t start = xtimer_now_usec();
+    uint32_t usec;
+    unsigned lookups = BENCH_ROUNDS * BENCH_RESOURCES;
+
+    _hits = 0;
+    _errors = 0;
+    for (unsigned round = 0; round < BENCH_ROUNDS; round++) {
+        for (unsigned i = 0; i < BENCH_RESOURCES; i++) {
+            _set_path(i, hit);
+            ssize_t res = linear ? _linear_dispatch(&_pkt, _resp_buf, BUF_SIZE)
+                                 : coap_handle_req(&_pkt, _resp_buf, BUF_SIZE);
+            unsigned code = ((coap_hdr_t *)_resp_buf)->code;
+
+            if ((res <= 0) || (code != (hit ? COAP_CODE_204 : COAP_CODE_404))) {
+                _errors++;
+            }
+        }
+    }
+    usec = xtimer_now_usec() - start;
+    if (_hits != (hit ? lookups : 0)) {
+        _errors++;
+    }
+
+    printf("{\"bench\": \"%s\", \"resources\": %u, \"lookups\": %u, "
+           "\"errors\": %u, \"duration_us\": %" PRIu32
+           ", \"ns_per_lookup\": %" PRIu32 "}\n", name, BENCH_RESOURCES,
+           lookups, _errors, usec, (uint32_t)(((uint64_t)usec * 1000U) / lookups));
+}
+
+int main(void)
+{
+    uint8_t *pos = _req_buf;
+
+    /* the URL is overwritten for every lookup, so parse the request once */
+    pos += coap_build_hdr((coap_hdr_t *)pos, COAP_TYPE_NON, NULL, 0,
+                          COAP_METHOD_GET, 1);
+    pos += coap_put_option_uri(pos, 0, "/sensor/0/value", COAP_OPT_URI_PATH);
+    if (coap_parse(&_pkt, _req_buf, pos - _req_buf) < 0) {
+        puts("error: unable to parse request");
+        return 1;
+    }
+
+    puts("Start.");
+
+    _bench("linear_hit", true, true);
+    _bench("linear_miss", true, false);
+    _bench("index_hit", false, true);
+    _bench("index_miss", false, false);
+
+    puts("Done.");
+
+    return 0;
+}
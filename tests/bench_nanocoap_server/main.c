@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Load test of the multi-threaded nanocoap server
+ *
+ * Client threads send confirmable requests to a nanocoap_server_mt() instance
+ * on the loopback address. Besides plain throughput, the test measures how
+ * much a slow handler delays requests to other resources, and checks that
+ * retransmissions are answered from the duplicate cache without calling the
+ * handler again. Each benchmark prints its result as one JSON object per
+ * line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "msg.h"
+#include "net/ipv6/addr.h"
+#include "net/nanocoap.h"
+#include "net/nanocoap_sock.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#ifndef BENCH_REQUESTS
+#define BENCH_REQUESTS      (100U)      /**< requests per client */
+#endif
+
+#ifndef BENCH_SLOW_DELAY
+#define BENCH_SLOW_DELAY    (20000U)    /**< duration of the slow handler in us */
+#endif
+
+#define BENCH_CLIENTS       (3U)
+#define BENCH_RETRANSMITS   (3U)
+#define BUF_SIZE            (64U)
+
+typedef struct {
+    const char *path;
+    unsigned requests;
+    unsigned copies;        /**< transmissions of every request at once */
+    uint16_t id;
+    unsigned errors;
+    uint32_t usec;
+} client_t;
+
+static char _server_stack[THREAD_STACKSIZE_DEFAULT];
+static char _stacks[BENCH_CLIENTS][THREAD_STACKSIZE_DEFAULT];
+static client_t _clients[BENCH_CLIENTS];
+static kernel_pid_t _main_pid;
+static msg_t _main_msg_queue[BENCH_CLIENTS];
+static sock_udp_ep_t _server = { .family = AF_INET6, .port = COAP_PORT };
+static volatile unsigned _executions;
+
+static ssize_t _fast_handler(coap_pkt_t *pkt, uint8_t *buf, size_t len)
+{
+    _executions++;
+    return coap_reply_simple(pkt, COAP_CODE_205, buf, len, COAP_FORMAT_TEXT,
+                             (uint8_t *)"ok", 2);
+}
+
+static ssize_t _slow_handler(coap_pkt_t *pkt, uint8_t *buf, size_t len)
+{
+    xtimer_usleep(BENCH_SLOW_DELAY);
+    return _fast_handler(pkt, buf, len);
+}
+
+/* must be sorted by path (alphabetically) */
+const coap_resource_t coap_resources[] = {
+    { "/fast", COAP_GET, _fast_handler },
+    { "/slow", COAP_GET, _slow_handler },
+};
+
+const unsigned coap_resources_numof = sizeof(coap_resources) / sizeof(coap_resources[0]);
+
+static void *_server_thread(void *arg)
+{
+    sock_udp_ep_t local = { .family = AF_INET6, .port = COAP_PORT };
+
+    (void)arg;
+    nanocoap_server_mt(&local);
+    puts("error: nanocoap server exited");
+    return NULL;
+}
+
+static void *_client_thread(void *arg)
+{
+    client_t *client = arg;
+    uint8_t buf[BUF_SIZE];
+    sock_udp_t sock;
+    uint32_t start = xtimer_now_usec();
+    msg_t msg;
+
+    sock_udp_create(&sock, NULL, &_server, 0);
+    for (unsigned i = 0; i < client->requests; i++) {
+        uint16_t id = client->id + i;
+        uint8_t *pos = buf;
+
+        pos += coap_build_hdr((coap_hdr_t *)pos, COAP_TYPE_CON, NULL, 0,
+                              COAP_METHOD_GET, id);
+        pos += coap_put_option_uri(pos, 0, client->path, COAP_OPT_URI_PATH);
+        size_t len = pos - buf;
+        unsigned replies = (client->copies > 1) ? 2 : 1;
+
+        /* copies sent while the request is handled are dropped, one sent
+         * afterwards is answered from the duplicate cache */
+        for (unsigned n = 0; n < client->copies; n++) {
+            sock_udp_send(&sock, buf, len, NULL);
+        }
+        for (unsigned n = 0; n < replies; n++) {
+            uint8_t resp[BUF_SIZE];
+            coap_pkt_t pkt;
+            ssize_t res = sock_udp_recv(&sock, resp, sizeof(resp), US_PER_SEC, NULL);
+
+            if ((res <= 0) || (coap_parse(&pkt, resp, res) < 0) ||
+                (coap_get_id(&pkt) != id) ||
+                (coap_get_code(&pkt) != 205)) {
+                client->errors++;
+                break;
+            }
+            if (n + 1 < replies) {
+                sock_udp_send(&sock, buf, len, NULL);
+            }
+        }
+    }
+    sock_udp_close(&sock);
+    client->usec = xtimer_now_usec() - start;
+    msg_send(&msg, _main_pid);
+    return NULL;
+}
+
+static void _run(unsigned num)
+{
+    for (unsigned i = 0; i < num; i++) {
+        _clients[i].id = (i + 1) * 1000U;
+        _clients[i].errors = 0;
+        /* clients run below main, so all of them are created before any one
+         * of them sends its first request */
+        thread_create(_stacks[i], sizeof(_stacks[i]), THREAD_PRIORITY_MAIN + 1,
+                      THREAD_CREATE_WOUT_YIELD | THREAD_CREATE_STACKTEST,
+                      _client_thread, &_clients[i], "client");
+    }
+    for (unsigned i = 0; i < num; i++) {
+        msg_t msg;
+        msg_receive(&msg);
+    }
+}
+
+static void _print_result(const char *name, const client_t *client,
+                          unsigned clients)
+{
+    unsigned errors = 0;
+
+    for (unsigned i = 0; i < clients; i++) {
+        errors += _clients[i].errors;
+    }
+    printf("{\"bench\": \"%s\", \"workers\": %u, \"clients\": %u, "
+           "\"requests\": %u, \"executions\": %u, \"errors\": %u, "
+           "\"duration_us\": %" PRIu32 ", \"us_per_request\": %" PRIu32 "}\n",
+           name, NANOCOAP_SERVER_WORKERS, clients, client->requests,
+           _executions, errors, client->usec, client->usec / client->requests);
+}
+
+static void _bench_fast(void)
+{
+    for (unsigned i = 0; i < BENCH_CLIENTS; i++) {
+        _clients[i] = (client_t){ .path = "/fast", .requests = BENCH_REQUESTS,
+                                  .copies = 1 };
+    }
+    _executions = 0;
+    _run(BENCH_CLIENTS);
+    _print_result("fast", &_clients[0], BENCH_CLIENTS);
+}
+
+static void _bench_fast_with_slow(void)
+{
+    _clients[0] = (client_t){ .path = "/fast", .requests = BENCH_REQUESTS,
+                              .copies = 1 };
+    _clients[1] = (client_t){ .path = "/slow", .requests = 10, .copies = 1 };
+    _executions = 0;
+    _run(2);
+    /* reports the latency seen by the client of the fast resource */
+    _print_result("fast_with_slow", &_clients[0], 2);
+}
+
+static void _bench_retransmit(void)
+{
+    /* every request arrives BENCH_RETRANSMITS times while it is handled and
+     * once more after it was answered */
+    _clients[0] = (client_t){ .path = "/slow", .requests = 10,
+                              .copies = BENCH_RETRANSMITS };
+    _executions = 0;
+    _run(1);
+    _print_result("retransmit", &_clients[0], 1);
+}
+
+int main(void)
+{
+    _main_pid = thread_getpid();
+    msg_init_queue(_main_msg_queue, BENCH_CLIENTS);
+    ipv6_addr_set_loopback((ipv6_addr_t *)&_server.addr.ipv6);
+
+    /* receives above the workers, so requests are queued right away */
+    thread_create(_server_stack, sizeof(_server_stack), NANOCOAP_SERVER_PRIO - 1,
+                  THREAD_CREATE_STACKTEST, _server_thread, NULL, "coap server");
+
+    puts("Start.");
+
+    _bench_fast();
+    _bench_fast_with_slow();
+    _bench_retransmit();
+
+    puts("Done.");
+
+    return 0;
+}
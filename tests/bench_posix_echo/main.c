@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Multi-client UDP echo over POSIX sockets and poll()
+ *
+ * A single server thread serves @ref BENCH_CLIENTS UDP sockets with poll(),
+ * the main thread drives the same number of clients over the loopback
+ * address. Every benchmark runs for @ref BENCH_DURATION seconds and prints
+ * its result as one JSON object per line. Before that, "poll_bound" checks
+ * that a socket which was only bound becomes readable in poll().
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/ipv6/addr.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#ifndef BENCH_DURATION
+#define BENCH_DURATION      (2U)    /**< duration of each benchmark in seconds */
+#endif
+
+#ifndef BENCH_CLIENTS
+#define BENCH_CLIENTS       (4U)    /**< maximum number of echo clients */
+#endif
+
+#define BENCH_PORT          (4000U)
+#define BENCH_PAYLOAD_LEN   (32U)
+
+static char _server_stack[THREAD_STACKSIZE_MAIN];
+static int _server_fds[BENCH_CLIENTS];
+static int _client_fds[BENCH_CLIENTS];
+static struct sockaddr_in6 _server_addrs[BENCH_CLIENTS];
+
+static void _done_cb(void *done)
+{
+    *((volatile int *)done) = 1;
+}
+
+static void _print_result(const char *name, unsigned clients, uint32_t ops,
+                          uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"clients\": %u, \"ops\": %" PRIu32
+           ", \"duration_us\": %" PRIu32 ", \"ops_per_sec\": %" PRIu32
+           ", \"ns_per_op\": %" PRIu32 "}\n", name, clients, ops, usec,
+           (uint32_t)(((uint64_t)ops * US_PER_SEC) / usec),
+           (uint32_t)(((uint64_t)usec * 1000U) / ops));
+}
+
+#define RUN_BENCH(name, clients, body) \
+    do { \
+        volatile int done = 0; \
+        uint32_t ops = 0, start; \
+        xtimer_t timer = { .callback = _done_cb, .arg = (void *)&done }; \
+        start = xtimer_now_usec(); \
+        xtimer_set(&timer, BENCH_DURATION * US_PER_SEC); \
+        while (!done) { \
+            body; \
+        } \
+        _print_result(name, clients, ops, xtimer_now_usec() - start); \
+    } while (0)
+
+/* echoes every datagram on any of the server sockets back to its sender */
+static void *_server(void *arg)
+{
+    struct pollfd fds[BENCH_CLIENTS];
+    uint8_t buf[BENCH_PAYLOAD_LEN];
+
+    (void)arg;
+    for (unsigned i = 0; i < BENCH_CLIENTS; i++) {
+        fds[i].fd = _server_fds[i];
+        fds[i].events = POLLIN;
+    }
+    while (1) {
+        if (poll(fds, BENCH_CLIENTS, -1) < 0) {
+            printf("error: server poll() failed (errno: %d)\n", errno);
+            return NULL;
+        }
+        for (unsigned i = 0; i < BENCH_CLIENTS; i++) {
+            if (fds[i].revents & POLLIN) {
+                struct sockaddr_in6 remote;
+                socklen_t remote_len = sizeof(remote);
+                ssize_t res = recvfrom(fds[i].fd, buf, sizeof(buf), 0,
+                                       (struct sockaddr *)&remote,
+                                       &remote_len);
+
+                if (res > 0) {
+                    sendto(fds[i].fd, buf, res, 0,
+                           (struct sockaddr *)&remote, remote_len);
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static int _udp_socket(uint16_t port)
+{
+    struct sockaddr_in6 addr = { .sin6_family = AF_INET6,
+                                 .sin6_port = htons(port) };
+    int fd = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (fd < 0) {
+        return fd;
+    }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* polls a socket that was bound, but not used for receiving yet */
+static unsigned _poll_bound(void)
+{
+    struct sockaddr_in6 addr = { .sin6_family = AF_INET6,
+                                 .sin6_port = htons(BENCH_PORT + 2 * BENCH_CLIENTS) };
+    struct pollfd fds = { .fd = _udp_socket(BENCH_PORT + 2 * BENCH_CLIENTS),
+                          .events = POLLIN };
+    uint8_t buf[BENCH_PAYLOAD_LEN];
+    unsigned errors = 0;
+
+    if (fds.fd < 0) {
+        return 1;
+    }
+    memcpy(&addr.sin6_addr, &ipv6_addr_loopback, sizeof(ipv6_addr_loopback));
+    memset(buf, 0x5a, sizeof(buf));
+    if (poll(&fds, 1, 0) != 0) {
+        errors++;
+    }
+    if (sendto(_client_fds[0], buf, sizeof(buf), 0, (struct sockaddr *)&addr,
+               sizeof(addr)) < 0) {
+        errors++;
+    }
+    if ((poll(&fds, 1, 1000) != 1) || !(fds.revents & POLLIN) ||
+        (recv(fds.fd, buf, sizeof(buf), 0) != sizeof(buf))) {
+        errors++;
+    }
+    close(fds.fd);
+    return errors;
+}
+
+/* sends one datagram per client and waits for all echoes */
+static int _echo_round(unsigned clients)
+{
+    struct pollfd fds[BENCH_CLIENTS];
+    uint8_t buf[BENCH_PAYLOAD_LEN];
+    unsigned pending = clients;
+
+    memset(buf, 0x5a, sizeof(buf));
+    for (unsigned i = 0; i < clients; i++) {
+        if (sendto(_client_fds[i], buf, sizeof(buf), 0,
+                   (struct sockaddr *)&_server_addrs[i],
+                   sizeof(_server_addrs[i])) < 0) {
+            return -1;
+        }
+        fds[i].fd = _client_fds[i];
+        fds[i].events = POLLIN;
+    }
+    while (pending > 0) {
+        int res = poll(fds, clients, 1000);
+
+        if (res <= 0) {
+            return -1;
+        }
+        for (unsigned i = 0; i < clients; i++) {
+            if ((fds[i].revents & POLLIN) &&
+                (recv(fds[i].fd, buf, sizeof(buf), 0) > 0)) {
+                /* don't wait for this client again */
+                fds[i].fd = -1;
+                pending--;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    puts("Start.");
+
+    for (unsigned i = 0; i < BENCH_CLIENTS; i++) {
+        _server_fds[i] = _udp_socket(BENCH_PORT + i);
+        _client_fds[i] = _udp_socket(BENCH_PORT + BENCH_CLIENTS + i);
+        if ((_server_fds[i] < 0) || (_client_fds[i] < 0)) {
+            printf("error: unable to create sockets (errno: %d)\n", errno);
+            return 1;
+        }
+        memset(&_server_addrs[i], 0, sizeof(_server_addrs[i]));
+        _server_addrs[i].sin6_family = AF_INET6;
+        _server_addrs[i].sin6_port = htons(BENCH_PORT + i);
+        memcpy(&_server_addrs[i].sin6_addr, &ipv6_addr_loopback,
+               sizeof(ipv6_addr_loopback));
+    }
+    printf("{\"bench\": \"poll_bound\", \"errors\": %u}\n", _poll_bound());
+
+    thread_create(_server_stack, sizeof(_server_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _server, NULL, "echo_server");
+
+    /* file descriptor look-up alone */
+    RUN_BENCH("getsockname", BENCH_CLIENTS, {
+        struct sockaddr_in6 addr;
+        socklen_t addr_len = sizeof(addr);
+        getsockname(_client_fds[BENCH_CLIENTS - 1], (struct sockaddr *)&addr,
+                    &addr_len);
+        ops++;
+    });
+
+    for (unsigned clients = 1; clients <= BENCH_CLIENTS; clients <<= 1) {
+        RUN_BENCH("udp_echo", clients, {
+            if (_echo_round(clients) < 0) {
+                puts("error: echo round failed");
+                return 1;
+            }
+            ops += clients;
+        });
+    }
+
+    puts("Done.");
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Reader/writer lock throughput with and without contention
+ *
+ * The uncontended benchmarks lock and unlock from the main thread only. The
+ * contended ones let reader and writer threads of the same priority yield
+ * while holding the lock, so every other thread finds it taken. Each
+ * benchmark prints its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include "msg.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    (10000U)    /**< lock operations per thread */
+#endif
+
+#define MAX_THREADS         (4U)
+
+#if PTHREAD_RWLOCK_POLICY == PTHREAD_RWLOCK_PREFER_READERS
+#define POLICY_NAME         "prefer_readers"
+#elif PTHREAD_RWLOCK_POLICY == PTHREAD_RWLOCK_PREFER_WRITERS
+#define POLICY_NAME         "prefer_writers"
+#else
+#define POLICY_NAME         "priority_fair"
+#endif
+
+static char _stacks[MAX_THREADS][THREAD_STACKSIZE_DEFAULT];
+static pthread_rwlock_t _rwlock;
+static kernel_pid_t _main_pid;
+static msg_t _main_msg_queue[MAX_THREADS];
+
+/* writers keep this odd while they are inside the critical section */
+static volatile unsigned _counter;
+static volatile unsigned _errors;
+
+static void _print_result(const char *name, unsigned readers,
+                          unsigned writers, uint32_t ops, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"policy\": \"" POLICY_NAME "\", "
+           "\"readers\": %u, \"writers\": %u, \"ops\": %" PRIu32
+           ", \"errors\": %u, \"duration_us\": %" PRIu32
+           ", \"ns_per_op\": %" PRIu32 "}\n", name, readers, writers, ops,
+           _errors, usec, (uint32_t)(((uint64_t)usec * 1000U) / ops));
+}
+
+static void _done(void)
+{
+    msg_t msg;
+    msg_send(&msg, _main_pid);
+}
+
+static void *_reader(void *arg)
+{
+    (void)arg;
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        pthread_rwlock_rdlock(&_rwlock);
+        if (_counter & 1) {
+            _errors++;
+        }
+        thread_yield();
+        pthread_rwlock_unlock(&_rwlock);
+        thread_yield();
+    }
+    _done();
+    return NULL;
+}
+
+static void *_writer(void *arg)
+{
+    (void)arg;
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        pthread_rwlock_wrlock(&_rwlock);
+        _counter++;
+        thread_yield();
+        _counter++;
+        pthread_rwlock_unlock(&_rwlock);
+        thread_yield();
+    }
+    _done();
+    return NULL;
+}
+
+static void _bench_uncontended(const char *name, bool is_writer)
+{
+    uint32_t start = xtimer_now_usec();
+
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        if (is_writer) {
+            pthread_rwlock_wrlock(&_rwlock);
+        }
+        else {
+            pthread_rwlock_rdlock(&_rwlock);
+        }
+        pthread_rwlock_unlock(&_rwlock);
+    }
+    _print_result(name, !is_writer, is_writer, BENCH_ITERATIONS,
+                  xtimer_now_usec() - start);
+}
+
+static void _bench_contended(unsigned readers, unsigned writers)
+{
+    uint32_t start = xtimer_now_usec();
+
+    _errors = 0;
+    for (unsigned i = 0; i < readers + writers; i++) {
+        /* all workers share one priority above main, so main only resumes
+         * once they all exited and the stacks can be reused */
+        thread_create(_stacks[i], sizeof(_stacks[i]), THREAD_PRIORITY_MAIN - 1,
+                      THREAD_CREATE_WOUT_YIELD | THREAD_CREATE_STACKTEST,
+                      (i < readers) ? _reader : _writer, NULL,
+                      (i < readers) ? "reader" : "writer");
+    }
+    for (unsigned i = 0; i < readers + writers; i++) {
+        msg_t msg;
+        msg_receive(&msg);
+    }
+    _print_result("contended", readers, writers,
+                  (readers + writers) * BENCH_ITERATIONS,
+                  xtimer_now_usec() - start);
+}
+
+int main(void)
+{
+    _main_pid = thread_getpid();
+    msg_init_queue(_main_msg_queue, MAX_THREADS);
+    pthread_rwlock_init(&_rwlock, NULL);
+
+    puts("Start.");
+
+    _bench_uncontended("rdlock", false);
+    _bench_uncontended("wrlock", true);
+
+    /* read-mostly, mixed and write-heavy */
+    _bench_contended(3, 1);
+    _bench_contended(2, 2);
+    _bench_contended(1, 3);
+
+    puts("Done.");
+
+    return 0;
+}
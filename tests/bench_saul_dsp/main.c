@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Sampling and processing throughput of the SAUL sample pipeline
+ *
+ * A synthetic vibration sensor, a triangle wave with an offset and noise, is
+ * sampled periodically. The samples are run through a DC blocker, a FIR
+ * low-pass and a decimator, then reduced to features. Each benchmark prints
+ * its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "saul_dsp.h"
+#include "xtimer.h"
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    (100U)      /**< processed blocks per bench */
+#endif
+
+#ifndef BENCH_PERIOD
+#define BENCH_PERIOD        (100U)      /**< sampling period in us */
+#endif
+
+#define FFT_LOG2            (7U)
+#define DECIMATION          (2U)
+#define BLOCK_SIZE          ((1U << FFT_LOG2) * DECIMATION)
+#define RING_SIZE           (1024U)
+
+/* the triangle's period in samples, its fundamental ends up in this bin */
+#define WAVE_PERIOD         (32U)
+#define WAVE_BIN            ((1U << FFT_LOG2) * DECIMATION / WAVE_PERIOD)
+
+static unsigned _errors;
+static uint32_t _noise = 1;
+static unsigned _phase;
+
+static int16_t _ring_buf[RING_SIZE];
+static saul_dsp_ring_t _ring;
+static int16_t _block[BLOCK_SIZE];
+static int16_t _scratch[BLOCK_SIZE];
+
+static const int16_t _lowpass[] = {
+    SAUL_DSP_Q15(0.125), SAUL_DSP_Q15(0.125), SAUL_DSP_Q15(0.125),
+    SAUL_DSP_Q15(0.125), SAUL_DSP_Q15(0.125), SAUL_DSP_Q15(0.125),
+    SAUL_DSP_Q15(0.125), SAUL_DSP_Q15(0.125),
+};
+
+static int _sensor_read(const void *dev, phydat_t *res)
+{
+    (void)dev;
+    unsigned pos = _phase++ % WAVE_PERIOD;
+    int32_t tri = (pos < WAVE_PERIOD / 2)
+                  ? (int32_t)pos * 500 - 4000 : 12000 - (int32_t)pos * 500;
+
+    _noise = _noise * 1103515245U + 12345U;
+    res->val[0] = 500 + tri + (int16_t)((_noise >> 16) % 201) - 100;
+    res->unit = UNIT_G;
+    res->scale = -3;
+    return 1;
+}
+
+static const saul_driver_t _sensor_driver = {
+    _sensor_read, saul_notsup, SAUL_SENSE_ACCEL, NULL
+};
+
+static saul_reg_t _sensor = { NULL, NULL, "vibration", &_sensor_driver };
+
+static void _print_result(const char *name, unsigned samples, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"samples\": %u, \"errors\": %u, "
+           "\"duration_us\": %" PRIu32 ", \"ns_per_sample\": %" PRIu32 "}\n",
+           name, samples, _errors, usec,
+           (uint32_t)(((uint64_t)usec * 1000U) / samples));
+}
+
+static void _bench_acquire(void)
+{
+    saul_dsp_acq_t acq;
+    uint32_t start = xtimer_now_usec();
+
+    _errors = 0;
+    saul_dsp_acq_init(&acq, &_sensor, 0, &_ring, BENCH_PERIOD);
+    if (saul_dsp_acquire(&acq, RING_SIZE) != (int)RING_SIZE) {
+        _errors++;
+    }
+    _errors += acq.overruns;
+    _print_result("acquire", RING_SIZE, xtimer_now_usec() - start);
+}
+
+static void _bench_pipeline(void)
+{
+    saul_dsp_acq_t acq;
+    saul_dsp_dc_t dc;
+    saul_dsp_fir_t fir;
+    saul_dsp_decim_t decim;
+    saul_dsp_features_t features;
+    uint32_t usec = 0;
+
+    saul_dsp_acq_init(&acq, &_sensor, 0, &_ring, 0);
+    saul_dsp_dc_init(&dc, SAUL_DSP_Q15(0.99));
+    saul_dsp_fir_init(&fir, _lowpass, sizeof(_lowpass) / sizeof(_lowpass[0]));
+    saul_dsp_decim_init(&decim, DECIMATION);
+    dc.stage.next = &fir.stage;
+    fir.stage.next = &decim.stage;
+
+    _errors = 0;
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        /* only processing is measured */
+        saul_dsp_acquire(&acq, BLOCK_SIZE);
+
+        uint32_t start = xtimer_now_usec();
+        size_t len = saul_dsp_ring_get(&_ring, _block, BLOCK_SIZE);
+        len = saul_dsp_process(&dc.stage, _block, len);
+        saul_dsp_features(_block, len, &features);
+        saul_dsp_spectrum_peak(_block, _scratch, FFT_LOG2, &features);
+        usec += xtimer_now_usec() - start;
+
+        /* the DC blocker needs some blocks to settle */
+        if ((len != (BLOCK_SIZE / DECIMATION)) ||
+            (features.peak_bin != WAVE_BIN) ||
+            ((i > 4) && ((features.mean > 100) || (features.mean < -100)))) {
+            _errors++;
+        }
+    }
+    _print_result("pipeline", BENCH_ITERATIONS * BLOCK_SIZE, usec);
+
+    printf("{\"bench\": \"features\", \"errors\": %u, \"mean\": %d, "
+           "\"rms\": %u, \"peak\": %u, \"peak_bin\": %u, \"peak_mag\": %u, "
+           "\"raw_bytes\": %u, \"feature_bytes\": %u}\n", _errors,
+           features.mean, features.rms, features.peak, features.peak_bin,
+           features.peak_mag, (unsigned)(BLOCK_SIZE * sizeof(int16_t)),
+           (unsigned)sizeof(features));
+}
+
+static inline int _abs(int val)
+{
+    return (val < 0) ? -val : val;
+}
+
+static void _bench_fft(void)
+{
+    uint32_t usec = 0;
+
+    _errors = 0;
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        for (unsigned j = 0; j < (1U << FFT_LOG2); j++) {
+            _block[j] = (j & 8) ? 1000 : -1000;
+            _scratch[j] = 0;
+        }
+
+        uint32_t start = xtimer_now_usec();
+        saul_dsp_fft(_block, _scratch, FFT_LOG2);
+        usec += xtimer_now_usec() - start;
+
+        /* the square wave has no DC and no even harmonics */
+        if ((_abs(_block[0]) > 2) || (_abs(_block[16]) > 2) ||
+            (_abs(_scratch[16]) > 2)) {
+            _errors++;
+        }
+    }
+    _print_result("fft", BENCH_ITERATIONS << FFT_LOG2, usec);
+}
+
+int main(void)
+{
+    saul_reg_add(&_sensor);
+    saul_dsp_ring_init(&_ring, _ring_buf, RING_SIZE);
+
+    puts("Start.");
+
+    _bench_acquire();
+    while (saul_dsp_ring_get(&_ring, _block, BLOCK_SIZE)) {}
+    _bench_pipeline();
+    _bench_fft();
+
+    puts("Done.");
+
+    return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Lookup and read throughput of the SAUL registry
+ *
+ * Registers a board config of synthetic devices: I2C temperature and humidity
+ * sensors that need a conversion time between triggering and reading a
+ * measurement, buttons and ADC lines. Lookups with a linear search are
+ * compared to the registry's index, and reading every device on its own to
+ * reading them all in one batch. Each benchmark prints its result as one
+ * JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "saul_reg.h"
+#include "xtimer.h"
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    (1000U)     /**< lookups of every device */
+#endif
+
+#ifndef BENCH_READS
+#define BENCH_READS         (10U)       /**< reads of every device */
+#endif
+
+#define I2C_NUMOF           (4U)        /**< sensors per I2C driver */
+#define BTN_NUMOF           (16U)
+#define ADC_NUMOF           (8U)
+#define DEV_NUMOF           (2 * I2C_NUMOF + BTN_NUMOF + ADC_NUMOF)
+
+#define I2C_XFER_US         (50U)       /**< duration of a bus transaction */
+#define I2C_CONV_US         (2000U)     /**< conversion time */
+
+static unsigned _errors;
+static saul_reg_t _devs[DEV_NUMOF];
+static saul_reg_t *_batch[DEV_NUMOF];
+static char _names[DEV_NUMOF][8];
+static int16_t _vals[DEV_NUMOF];
+static phydat_t _res[DEV_NUMOF];
+
+static void _print_result(const char *name, unsigned ops, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"devices\": %u, \"ops\": %u, \"errors\": %u, "
+           "\"duration_us\": %" PRIu32 ", \"ns_per_op\": %" PRIu32 "}\n",
+           name, DEV_NUMOF, ops, _errors, usec,
+           (uint32_t)(((uint64_t)usec * 1000U) / ops));
+}
+
+static void _i2c_xfer(void)
+{
+    uint32_t start = xtimer_now_usec();
+
+    while ((xtimer_now_usec() - start) < I2C_XFER_US) {}
+}
+
+static int _read_simple(const void *dev, phydat_t *res)
+{
+    memset(res, 0, sizeof(*res));
+    res->val[0] = *((const int16_t *)dev);
+    return 1;
+}
+
+static int _read_i2c(const void *dev, phydat_t *res)
+{
+    /* trigger, wait for the conversion, fetch */
+    _i2c_xfer();
+    xtimer_usleep(I2C_CONV_US);
+    _i2c_xfer();
+    return _read_simple(dev, res);
+}
+
+static int _read_i2c_multi(const void *const *devs, phydat_t *res,
+                           unsigned num)
+{
+    for (unsigned i = 0; i < num; i++) {
+        _i2c_xfer();
+    }
+    xtimer_usleep(I2C_CONV_US);
+    for (unsigned i = 0; i < num; i++) {
+        _i2c_xfer();
+        _read_simple(devs[i], &res[i]);
+    }
+    return 1;
+}
+
+static const saul_driver_t _temp_driver = {
+    .read = _read_i2c,
+    .write = saul_notsup,
+    .type = SAUL_SENSE_TEMP,
+    .read_multi = _read_i2c_multi,
+};
+
+static const saul_driver_t _hum_driver = {
+    .read = _read_i2c,
+    .write = saul_notsup,
+    .type = SAUL_SENSE_HUM,
+    .read_multi = _read_i2c_multi,
+};
+
+static const saul_driver_t _btn_driver = {
+    .read = _read_simple,
+    .write = saul_notsup,
+    .type = SAUL_SENSE_BTN,
+};
+
+static const saul_driver_t _adc_driver = {
+    .read = _read_simple,
+    .write = saul_notsup,
+    .type = SAUL_SENSE_ANALOG,
+};
+
+static void _add(unsigned *pos, const saul_driver_t *driver,
+                 const char *prefix, unsigned num)
+{
+    for (unsigned i = 0; i < num; i++, (*pos)++) {
+        saul_reg_t *dev = &_devs[*pos];
+
+        snprintf(_names[*pos], sizeof(_names[*pos]), "%s%u", prefix, i);
+        _vals[*pos] = *pos;
+        dev->dev = &_vals[*pos];
+        dev->name = _names[*pos];
+        dev->driver = driver;
+        saul_reg_add(dev);
+        _batch[*pos] = dev;
+    }
+}
+
+/* what the registry did before it was indexed */
+static saul_reg_t *_find_name_linear(const char *name)
+{
+    for (saul_reg_t *tmp = saul_reg; tmp; tmp = tmp->next) {
+        if (strcmp(tmp->name, name) == 0) {
+            return tmp;
+        }
+    }
+    return NULL;
+}
+
+static saul_reg_t *_find_nth_linear(int pos)
+{
+    saul_reg_t *tmp = saul_reg;
+
+    for (int i = 0; (i < pos) && tmp; i++) {
+        tmp = tmp->next;
+    }
+    return tmp;
+}
+
+static void _bench_find_name(const char *name, bool indexed)
+{
+    uint32_t start = xtimer_now_usec();
+
+    _errors = 0;
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        for (unsigned j = 0; j < DEV_NUMOF; j++) {
+            saul_reg_t *dev = indexed ? saul_reg_find_name(_names[j])
+                                      : _find_name_linear(_names[j]);
+            if (dev != &_devs[j]) {
+                _errors++;
+            }
+        }
+    }
+    _print_result(name, BENCH_ITERATIONS * DEV_NUMOF,
+                  xtimer_now_usec() - start);
+}
+
+static void _bench_find_nth(const char *name, bool indexed)
+{
+    uint32_t start = xtimer_now_usec();
+
+    _errors = 0;
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        for (unsigned j = 0; j < DEV_NUMOF; j++) {
+            saul_reg_t *dev = indexed ? saul_reg_find_nth(j)
+                                      : _find_nth_linear(j);
+            if (dev != &_devs[j]) {
+                _errors++;
+            }
+        }
+    }
+    _print_result(name, BENCH_ITERATIONS * DEV_NUMOF,
+                  xtimer_now_usec() - start);
+}
+
+static void _check_results(void)
+{
+    for (unsigned j = 0; j < DEV_NUMOF; j++) {
+        if (_res[j].val[0] != (int16_t)j) {
+            _errors++;
+        }
+    }
+}
+
+static void _bench_read(const char *name, bool batch)
+{
+    uint32_t start = xtimer_now_usec();
+
+    _errors = 0;
+    for (unsigned i = 0; i < BENCH_READS; i++) {
+        memset(_res, 0xff, sizeof(_res));
+        if (batch) {
+            if (saul_reg_read_batch(_batch, _res, NULL, DEV_NUMOF) !=
+                (int)DEV_NUMOF) {
+                _errors++;
+            }
+        }
+        else {
+            for (unsigned j = 0; j < DEV_NUMOF; j++) {
+                if (saul_reg_read(_batch[j], &_res[j]) != 1) {
+                    _errors++;
+                }
+            }
+        }
+        _check_results();
+    }
+    _print_result(name, BENCH_READS * DEV_NUMOF, xtimer_now_usec() - start);
+}
+
+int main(void)
+{
+    unsigned pos = 0;
+
+    _add(&pos, &_temp_driver, "temp", I2C_NUMOF);
+    _add(&pos, &_hum_driver, "hum", I2C_NUMOF);
+    _add(&pos, &_btn_driver, "btn", BTN_NUMOF);
+    _add(&pos, &_adc_driver, "adc", ADC_NUMOF);
+
+    puts("Start.");
+
+    _bench_find_name("find_name_linear", false);
+    _bench_find_name("find_name", true);
+    _bench_find_nth("find_nth_linear", false);
+    _bench_find_nth("find_nth", true);
+    _bench_read("read", false);
+    _bench_read("read_batch", true);
+
+    puts("Done.");
+
+    return 0;
+}
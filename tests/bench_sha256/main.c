@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Measure SHA-256, HMAC-SHA256 and hash chain throughput
+ *
+ * Results are printed as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hashes/sha256.h"
+#include "xtimer.h"
+
+#ifndef BENCH_LEN
+#define BENCH_LEN           (1024U)
+#endif
+
+#ifndef BENCH_ROUNDS
+#define BENCH_ROUNDS        (256U)
+#endif
+
+#ifndef BENCH_MSG_LEN
+#define BENCH_MSG_LEN       (32U)       /**< message size for HMAC */
+#endif
+
+#ifndef BENCH_CHAIN_LEN
+#define BENCH_CHAIN_LEN     (4096U)
+#endif
+
+static const uint8_t _key[] = "benchmark key of 32 bytes length";
+static uint8_t _data[BENCH_LEN];
+static uint8_t _digest[SHA256_DIGEST_LENGTH];
+
+static void _print_result(const char *name, uint32_t ops, uint32_t bytes,
+                          uint32_t usec)
+{
+    if (usec == 0) {
+        usec = 1;
+    }
+    printf("{\"bench\": \"%s\", \"ops\": %" PRIu32 ", \"bytes\": %" PRIu32
+           ", \"duration_us\": %" PRIu32 ", \"ops_per_sec\": %" PRIu32
+           ", \"kib_per_sec\": %" PRIu32 "}\n", name, ops, bytes, usec,
+           (uint32_t)(((uint64_t)ops * US_PER_SEC) / usec),
+           (uint32_t)(((uint64_t)bytes * US_PER_SEC) / (1024U * usec)));
+}
+
+int main(void)
+{
+    hmac_context_t ctx;
+    hmac_sha256_key_t hkey;
+    uint32_t start;
+
+    puts("Start.");
+
+    for (unsigned i = 0; i < BENCH_LEN; i++) {
+        _data[i] = (uint8_t)i;
+    }
+
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+        sha256(_data, BENCH_LEN, _digest);
+    }
+    _print_result("sha256", BENCH_ROUNDS, BENCH_ROUNDS * BENCH_LEN,
+                  xtimer_now_usec() - start);
+
+    /* short messages are dominated by the key setup */
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+        hmac_sha256(_key, sizeof(_key) - 1, _data, BENCH_MSG_LEN, _digest);
+    }
+    _print_result("hmac_sha256", BENCH_ROUNDS, BENCH_ROUNDS * BENCH_MSG_LEN,
+                  xtimer_now_usec() - start);
+
+    start = xtimer_now_usec();
+    hmac_sha256_key_init(&hkey, _key, sizeof(_key) - 1);
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+        hmac_sha256_init_key(&ctx, &hkey);
+        hmac_sha256_update(&ctx, _data, BENCH_MSG_LEN);
+        hmac_sha256_final(&ctx, _digest);
+    }
+    _print_result("hmac_sha256_key", BENCH_ROUNDS, BENCH_ROUNDS * BENCH_MSG_LEN,
+                  xtimer_now_usec() - start);
+
+    start = xtimer_now_usec();
+    sha256_chain(_key, sizeof(_key) - 1, BENCH_CHAIN_LEN, _digest);
+    _print_result("sha256_chain", BENCH_CHAIN_LEN,
+                  BENCH_CHAIN_LEN * SHA256_DIGEST_LENGTH,
+                  xtimer_now_usec() - start);
+
+    puts("Done.");
+    return 0;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Throughput of scripted shell sessions
+ *
+ * Compares looking up commands with a linear search to the shell's index and
+ * feeds a script of command lines to sessions, as a whole, byte by byte like
+ * an UART would, and interleaved to several sessions at once. Each benchmark
+ * prints its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "shell.h"
+#include "shell_commands.h"
+#include "xtimer.h"
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    (100U)      /**< script runs per bench */
+#endif
+
+#define SESSIONS_NUMOF      (4U)
+#define CHUNK_SIZE          (16U)
+#define SCRIPT_SIZE         (1024U)
+
+static unsigned _calls;
+static unsigned _errors;
+static size_t _written;
+
+static int _cmd(int argc, char **argv)
+{
+    (void)argv;
+    if (argc != 3) {
+        _errors++;
+    }
+    _calls++;
+    return 0;
+}
+
+static const shell_command_t _commands[] = {
+    { "led_on", "", _cmd },
+    { "led_off", "", _cmd },
+    { "sensor_read", "", _cmd },
+    { "sensor_config", "", _cmd },
+    { "net_send", "", _cmd },
+    { "net_stats", "", _cmd },
+    { "fw_version", "", _cmd },
+    { "fw_update", "", _cmd },
+    { "cfg_get", "", _cmd },
+    { "cfg_set", "", _cmd },
+    { "cfg_commit", "", _cmd },
+    { "log_level", "", _cmd },
+    { "log_dump", "", _cmd },
+    { "time_get", "", _cmd },
+    { "time_set", "", _cmd },
+    { "power_mode", "", _cmd },
+    { NULL, NULL, NULL }
+};
+
+#define COMMANDS_NUMOF      (sizeof(_commands) / sizeof(_commands[0]) - 1)
+
+static shell_index_t _index;
+static shell_session_t _sessions[SESSIONS_NUMOF];
+static char _line_bufs[SESSIONS_NUMOF][SHELL_DEFAULT_BUFSIZE];
+static char _script[SCRIPT_SIZE];
+static size_t _script_len;
+static unsigned _script_lines;
+
+static void _print_result(const char *name, unsigned lines, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"lines\": %u, \"errors\": %u, "
+           "\"duration_us\": %" PRIu32 ", \"ns_per_line\": %" PRIu32 "}\n",
+           name, lines, _errors, usec,
+           (uint32_t)(((uint64_t)usec * 1000U) / lines));
+}
+
+static void _write(shell_session_t *session, const char *buf, size_t len)
+{
+    (void)session;
+    (void)buf;
+    _written += len;
+}
+
+/* what the shell did before it was indexed */
+static const shell_command_t *_find_linear(const char *name)
+{
+    const shell_command_t *command_lists[] = {
+        _commands,
+        _shell_command_list,
+    };
+
+    for (unsigned i = 0; i < 2; i++) {
+        for (const shell_command_t *entry = command_lists[i]; entry->name;
+             entry++) {
+            if (strcmp(entry->name, name) == 0) {
+                return entry;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void _bench_lookup(const char *name, bool indexed)
+{
+    uint32_t start = xtimer_now_usec();
+
+    _errors = 0;
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        for (unsigned j = 0; j < COMMANDS_NUMOF; j++) {
+            const shell_command_t *command;
+
+            command = indexed ? shell_index_find(&_index, _commands[j].name)
+                              : _find_linear(_commands[j].name);
+            if (command != &_commands[j]) {
+                _errors++;
+            }
+        }
+    }
+    _print_result(name, BENCH_ITERATIONS * COMMANDS_NUMOF,
+                  xtimer_now_usec() - start);
+}
+
+static void _check_calls(unsigned expected)
+{
+    /* the shell only writes error messages with echo and prompt disabled */
+    if ((_calls != expected) || _written) {
+        _errors++;
+    }
+    _calls = 0;
+}
+
+static void _bench_script(const char *name, size_t chunk_size,
+                          unsigned sessions)
+{
+    uint32_t start = xtimer_now_usec();
+
+    _errors = 0;
+    _calls = 0;
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        for (size_t pos = 0; pos < _script_len; pos += chunk_size) {
+            size_t len = ((_script_len - pos) < chunk_size)
+                         ? (_script_len - pos) : chunk_size;
+
+            for (unsigned s = 0; s < sessions; s++) {
+                shell_session_input(&_sessions[s], &_script[pos], len);
+            }
+        }
+    }
+    _check_calls(BENCH_ITERATIONS * sessions * _script_lines);
+    _print_result(name, BENCH_ITERATIONS * sessions * _script_lines,
+                  xtimer_now_usec() - start);
+}
+
+int main(void)
+{
+    shell_index_init(&_index, _commands);
+    for (unsigned i = 0; i < SESSIONS_NUMOF; i++) {
+        shell_session_init(&_sessions[i], &_index, _line_bufs[i],
+                           sizeof(_line_bufs[i]), _write, NULL);
+        _sessions[i].flags = 0;
+    }
+
+    /* commands from the end of the list are the slowest to find linearly */
+    while (1) {
+        const char *name = _commands[COMMANDS_NUMOF - 1 -
+                                     (_script_lines % COMMANDS_NUMOF)].name;
+        int len = snprintf(&_script[_script_len],
+                           sizeof(_script) - _script_len,
+                           "%s %u \"arg %u\"\n", name, _script_lines,
+                           _script_lines);
+
+        if ((size_t)len >= (sizeof(_script) - _script_len)) {
+            break;
+        }
+        _script_len += len;
+        _script_lines++;
+    }
+
+    puts("Start.");
+
+    _bench_lookup("lookup_linear", false);
+    _bench_lookup("lookup_index", true);
+    _bench_script("script", _script_len, 1);
+    _bench_script("script_bytewise", 1, 1);
+    _bench_script("sessions", CHUNK_SIZE, SESSIONS_NUMOF);
+
+    puts("Done.");
+
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       sock DNS resolver latency against a local stub DNS server
+ *
+ * The stub server answers A and AAAA queries for `host<n>.example`, only A
+ * queries for `v4only.example` and NXDOMAIN for everything else. It delays
+ * every reply by @ref BENCH_DNS_DELAY to simulate the round trip time to a
+ * real server. Each benchmark prints its result as one JSON object per line.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "msg.h"
+#include "net/ipv6/addr.h"
+#include "net/sock/dns.h"
+#include "net/sock/udp.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#ifndef BENCH_QUERIES
+#define BENCH_QUERIES       (32U)       /**< lookups per benchmark */
+#endif
+
+#ifndef BENCH_DNS_DELAY
+#define BENCH_DNS_DELAY     (5000U)     /**< reply delay in us */
+#endif
+
+#define BENCH_THREADS       (4U)
+#define BENCH_TTL           (300U)
+
+#define DNS_PORT            (5353U)
+#define DNS_PENDING         (2 * BENCH_THREADS)
+#define DNS_HDR_LEN         (sizeof(sock_dns_hdr_t))
+#define DNS_REPLY_LEN       (128U)
+
+typedef struct {
+    uint32_t due;
+    sock_udp_ep_t remote;
+    uint8_t len;
+    uint8_t buf[DNS_REPLY_LEN];
+} dns_reply_t;
+
+static char _server_stack[THREAD_STACKSIZE_DEFAULT];
+static char _stacks[BENCH_THREADS][THREAD_STACKSIZE_DEFAULT];
+static sock_udp_t _server_sock;
+static dns_reply_t _pending[DNS_PENDING];
+static uint8_t _server_buf[DNS_REPLY_LEN];
+static kernel_pid_t _main_pid;
+static msg_t _main_msg_queue[BENCH_THREADS];
+static volatile unsigned _server_queries;
+static volatile unsigned _errors;
+
+/* global DNS server UDP endpoint */
+sock_udp_ep_t sock_dns_server;
+
+static const uint8_t _v4_addr[] = { 192, 0, 2, 1 };
+static const uint8_t _v6_addr[] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+                                    0, 0, 0, 0, 0, 0, 0, 1 };
+
+/* builds the reply to the query in _server_buf of length @p len */
+static uint8_t _server_reply(uint8_t *out, size_t len)
+{
+    sock_dns_hdr_t *hdr = (sock_dns_hdr_t *)out;
+    uint8_t *name = out + DNS_HDR_LEN;
+    uint8_t *pos = name;
+    uint16_t type;
+    bool v4only, exists;
+
+    /* copy header and question, the stub only supports one question */
+    memcpy(out, _server_buf, len);
+    while (*pos && (pos < (out + len))) {
+        pos += *pos + 1;
+    }
+    pos++;
+    type = (pos[0] << 8) | pos[1];
+    pos += 4;
+
+    v4only = (name[0] == 6) && (memcmp(name + 1, "v4only", 6) == 0);
+    exists = v4only || ((name[0] > 4) && (memcmp(name + 1, "host", 4) == 0));
+
+    hdr->flags = htons(0x8180);
+    hdr->ancount = 0;
+    if (!exists) {
+        hdr->flags |= htons(3);
+    }
+    else if ((type == DNS_TYPE_A) || ((type == DNS_TYPE_AAAA) && !v4only)) {
+        uint16_t addrlen = (type == DNS_TYPE_A) ? 4 : 16;
+
+        hdr->ancount = htons(1);
+        *pos++ = 0xc0;      /* name is compressed to the question */
+        *pos++ = DNS_HDR_LEN;
+        *pos++ = type >> 8;
+        *pos++ = type & 0xff;
+        *pos++ = 0;
+        *pos++ = DNS_CLASS_IN;
+        *pos++ = 0;
+        *pos++ = 0;
+        *pos++ = BENCH_TTL >> 8;
+        *pos++ = BENCH_TTL & 0xff;
+        *pos++ = 0;
+        *pos++ = addrlen;
+        memcpy(pos, (addrlen == 4) ? _v4_addr : _v6_addr, addrlen);
+        pos += addrlen;
+    }
+    return pos - out;
+}
+
+/* sends due replies, returns the time until the next one is due */
+static uint32_t _server_flush(void)
+{
+    uint32_t now = xtimer_now_usec();
+    uint32_t next = SOCK_NO_TIMEOUT;
+
+    for (unsigned i = 0; i < DNS_PENDING; i++) {
+        dns_reply_t *reply = &_pending[i];
+        int32_t left = (int32_t)(reply->due - now);
+
+        if (reply->len == 0) {
+            continue;
+        }
+        if (left <= 0) {
+            sock_udp_send(&_server_sock, reply->buf, reply->len, &reply->remote);
+            reply->len = 0;
+        }
+        else if ((uint32_t)left < next) {
+            next = left;
+        }
+    }
+    return next;
+}
+
+static void *_server(void *arg)
+{
+    sock_udp_ep_t local = SOCK_IPV6_EP_ANY;
+    uint32_t timeout = SOCK_NO_TIMEOUT;
+
+    (void)arg;
+    local.port = DNS_PORT;
+    sock_udp_create(&_server_sock, &local, NULL, 0);
+
+    while (1) {
+        sock_udp_ep_t remote;
+        ssize_t len = sock_udp_recv(&_server_sock, _server_buf,
+                                    sizeof(_server_buf) - 32, timeout, &remote);
+
+        if (len > (ssize_t)DNS_HDR_LEN) {
+            _server_queries++;
+            for (unsigned i = 0; i < DNS_PENDING; i++) {
+                if (_pending[i].len == 0) {
+                    _pending[i].due = xtimer_now_usec() + BENCH_DNS_DELAY;
+                    _pending[i].remote = remote;
+                    _pending[i].len = _server_reply(_pending[i].buf, len);
+                    break;
+                }
+            }
+        }
+        timeout = _server_flush();
+    }
+
+    return NULL;
+}
+
+static void _print_result(const char *name, unsigned lookups, uint32_t usec)
+{
+    printf("{\"bench\": \"%s\", \"lookups\": %u, \"server_queries\": %u, "
+           "\"errors\": %u, \"dns_delay_us\": %u, \"cache_size\": %u, "
+           "\"duration_us\": %" PRIu32 ", \"us_per_lookup\": %" PRIu32 "}\n",
+           name, lookups, _server_queries, _errors, BENCH_DNS_DELAY,
+           SOCK_DNS_CACHE_SIZE, usec, usec / lookups);
+}
+
+static void _reset(void)
+{
+    sock_dns_cache_flush();
+    _server_queries = 0;
+    _errors = 0;
+}
+
+static void _lookup(const char *name, int family, int expected)
+{
+    uint8_t addr[16];
+
+    if (sock_dns_query(name, addr, family) != expected) {
+        _errors++;
+    }
+}
+
+static void _bench_cold(void)
+{
+    char name[16];
+    uint32_t start;
+
+    _reset();
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_QUERIES; i++) {
+        sprintf(name, "host%u.example", i);
+        _lookup(name, AF_UNSPEC, 16);
+    }
+    _print_result("cold", BENCH_QUERIES, xtimer_now_usec() - start);
+}
+
+static void _bench_repeated(const char *bench, const char *name, int family,
+                            int expected)
+{
+    uint32_t start;
+
+    _reset();
+    start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_QUERIES; i++) {
+        _lookup(name, family, expected);
+    }
+    _print_result(bench, BENCH_QUERIES, xtimer_now_usec() - start);
+}
+
+static void *_worker(void *arg)
+{
+    char name[16];
+    msg_t msg;
+
+    sprintf(name, "host%u.example", (unsigned)(uintptr_t)arg);
+    _lookup(name, AF_INET6, 16);
+    msg_send(&msg, _main_pid);
+    return NULL;
+}
+
+static void _bench_parallel(void)
+{
+    uint32_t start;
+
+    _reset();
+    start = xtimer_now_usec();
+    /* workers run below main, so all of them are created before any one of
+     * them sends its query */
+    for (unsigned i = 0; i < BENCH_THREADS; i++) {
+        thread_create(_stacks[i], sizeof(_stacks[i]), THREAD_PRIORITY_MAIN + 1,
+                      THREAD_CREATE_WOUT_YIELD | THREAD_CREATE_STACKTEST,
+                      _worker, (void *)(uintptr_t)i, "resolver");
+    }
+    for (unsigned i = 0; i < BENCH_THREADS; i++) {
+        msg_t msg;
+        msg_receive(&msg);
+    }
+    _print_result("parallel", BENCH_THREADS, xtimer_now_usec() - start);
+}
+
+int main(void)
+{
+    _main_pid = thread_getpid();
+    msg_init_queue(_main_msg_queue, BENCH_THREADS);
+
+    sock_dns_server.family = AF_INET6;
+    sock_dns_server.port = DNS_PORT;
+    ipv6_addr_set_loopback((ipv6_addr_t *)&sock_dns_server.addr.ipv6);
+
+    thread_create(_server_stack, sizeof(_server_stack), THREAD_PRIORITY_MAIN - 1,
+                  0, _server, NULL, "dns server");
+
+    puts("Start.");
+
+    _bench_cold();
+    _bench_repeated("cached", "host0.example", AF_UNSPEC, 16);
+    _bench_repeated("negative", "missing.example", AF_UNSPEC, -EHOSTUNREACH);
+    _bench_repeated("v4only", "v4only.example", AF_UNSPEC, 4);
+    _bench_parallel();
+
+    puts("Done.");
+
+    return 0;
+}
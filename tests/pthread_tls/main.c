@@ -18,10 +18,13 @@
  * @}
  */
 
+#include <inttypes.h>
 #include <stdio.h>
 #include "pthread.h"
+#include "xtimer.h"
 
 #define NUMBER_OF_TLS (20)
+#define BENCH_ROUNDS  (100000UL)
 
 void *run(void *parameter)
 {
@@ -129,6 +132,23 @@ void *run(void *parameter)
     void* test_7_val = pthread_getspecific(new_key);
     printf("test_7_val: %p\n", test_7_val);
 
+    puts("");
+    puts("-= TEST 8 - benchmark setspecific/getspecific =-");
+    uintptr_t sum = 0;
+    uint32_t start = xtimer_now_usec();
+    for (unsigned long i = 0; i < BENCH_ROUNDS; ++i) {
+        pthread_setspecific(new_key, (void *)i);
+        sum += (uintptr_t)pthread_getspecific(new_key);
+    }
+    uint32_t duration = xtimer_now_usec() - start;
+    printf("{\"bench\": \"tls_set_get\", \"ops\": %lu, \"duration_us\": %"
+           PRIu32 ", \"ns_per_op\": %" PRIu32 "}\n", BENCH_ROUNDS, duration,
+           (uint32_t)(((uint64_t)duration * 1000U) / BENCH_ROUNDS));
+    if (sum != (BENCH_ROUNDS * (BENCH_ROUNDS - 1)) / 2) {
+        puts("benchmark values mismatch");
+        return (void *)1;
+    }
+
 
     return NULL;
 }
@@ -31,6 +31,9 @@ def testfunc(child):
     child.expect('-= TEST 7 - add key without tls =-')
     child.expect('created key: \d+')
     child.expect('test_7_val: (0|\(nil\))')
+    child.expect('-= TEST 8 - benchmark setspecific/getspecific =-')
+    child.expect('\{"bench": "tls_set_get", "ops": \d+, "duration_us": \d+, '
+                 '"ns_per_op": \d+\}')
     child.expect('tls tests finished.')
     child.expect('SUCCESS')
 
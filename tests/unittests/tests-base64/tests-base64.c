@@ -383,6 +383,129 @@ static void test_base64_09_encode_size_determination(void)
     TEST_ASSERT_EQUAL_INT(required_out_size, expected_out_size);
 }
 
+static void test_base64_10_url_safe(void)
+{
+    unsigned char data_in[] = { 0xfb, 0xff, 0xbf, 0xfb, 0xff };
+    unsigned char expected_std[] = "+/+/+/8=";
+    unsigned char expected_url[] = "-_-_-_8";
+    unsigned char base64_out[8];
+    /* the decoders reserve space for whole groups */
+    unsigned char data_out[6];
+
+    size_t base64_out_size = 0;
+    int ret = base64url_encode(data_in, sizeof(data_in),
+                               base64_out, &base64_out_size);
+
+    TEST_ASSERT_EQUAL_INT(BASE64_ERROR_BUFFER_OUT_SIZE, ret);
+    TEST_ASSERT_EQUAL_INT(7, base64_out_size);
+
+    ret = base64url_encode(data_in, sizeof(data_in),
+                           base64_out, &base64_out_size);
+
+    TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_INT(7, base64_out_size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(expected_url, base64_out, 7));
+
+    base64_out_size = sizeof(base64_out);
+    ret = base64_encode(data_in, sizeof(data_in),
+                        base64_out, &base64_out_size);
+
+    TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_INT(8, base64_out_size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(expected_std, base64_out, 8));
+
+    /* both decoders accept both alphabets */
+    size_t data_out_size = sizeof(data_out);
+    ret = base64url_decode(expected_url, 7, data_out, &data_out_size);
+
+    TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_INT(sizeof(data_in), data_out_size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(data_in, data_out, sizeof(data_in)));
+
+    data_out_size = sizeof(data_out);
+    ret = base64_decode(expected_url, 7, data_out, &data_out_size);
+
+    TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_INT(sizeof(data_in), data_out_size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(data_in, data_out, sizeof(data_in)));
+
+    data_out_size = sizeof(data_out);
+    ret = base64url_decode(expected_std, 8, data_out, &data_out_size);
+
+    TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_INT(sizeof(data_in), data_out_size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(data_in, data_out, sizeof(data_in)));
+}
+
+static void test_base64_11_decode_line_breaks(void)
+{
+    unsigned char base64_in[] = "SGVs\r\nbG8g\nUklP VA==\n";
+    unsigned char expected[] = "Hello RIOT";
+    unsigned char data_out[sizeof(base64_in)];
+
+    size_t data_out_size = sizeof(data_out);
+    int ret = base64_decode(base64_in, strlen((char *)base64_in),
+                            data_out, &data_out_size);
+
+    TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_INT(strlen((char *)expected), data_out_size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(expected, data_out, data_out_size));
+}
+
+static void test_base64_12_decode_in_place(void)
+{
+    unsigned char buffer[] = "SGVsbG8gUklPVCE=";
+    unsigned char expected[] = "Hello RIOT!";
+
+    size_t data_out_size = sizeof(buffer);
+    int ret = base64_decode(buffer, strlen((char *)buffer),
+                            buffer, &data_out_size);
+
+    TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_INT(strlen((char *)expected), data_out_size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(expected, buffer, data_out_size));
+}
+
+static void test_base64_13_roundtrip_all_lengths(void)
+{
+    enum { max_size = 50 };
+    unsigned char data_in[max_size];
+    unsigned char base64[((max_size + 2) / 3) * 4];
+    unsigned char data_out[max_size + 2];
+
+    for (int i = 0; i < max_size; ++i) {
+        data_in[i] = (unsigned char)(i * 37 + 11);
+    }
+
+    for (size_t len = 1; len <= max_size; ++len) {
+        size_t base64_size = sizeof(base64);
+        int ret = base64_encode(data_in, len, base64, &base64_size);
+
+        TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+        TEST_ASSERT_EQUAL_INT(((len + 2) / 3) * 4, base64_size);
+
+        size_t data_out_size = sizeof(data_out);
+        ret = base64_decode(base64, base64_size, data_out, &data_out_size);
+
+        TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+        TEST_ASSERT_EQUAL_INT(len, data_out_size);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(data_in, data_out, len));
+
+        base64_size = sizeof(base64);
+        ret = base64url_encode(data_in, len, base64, &base64_size);
+
+        TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+        TEST_ASSERT_EQUAL_INT((4 * len + 2) / 3, base64_size);
+
+        data_out_size = sizeof(data_out);
+        ret = base64url_decode(base64, base64_size, data_out, &data_out_size);
+
+        TEST_ASSERT_EQUAL_INT(BASE64_SUCCESS, ret);
+        TEST_ASSERT_EQUAL_INT(len, data_out_size);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(data_in, data_out, len));
+    }
+}
+
 Test *tests_base64_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -395,6 +518,10 @@ Test *tests_base64_tests(void)
         new_TestFixture(test_base64_07_stream_decode),
         new_TestFixture(test_base64_08_encode_16_bytes),
         new_TestFixture(test_base64_09_encode_size_determination),
+        new_TestFixture(test_base64_10_url_safe),
+        new_TestFixture(test_base64_11_decode_line_breaks),
+        new_TestFixture(test_base64_12_decode_in_place),
+        new_TestFixture(test_base64_13_roundtrip_all_lengths),
     };
 
     EMB_UNIT_TESTCALLER(base64_tests, NULL, NULL, fixtures);
@@ -18,6 +18,7 @@
 #include "bitarithm.h"
 #include "cbor.h"
 
+#include <errno.h>
 #include <float.h>
 #include <math.h>
 #include <stdio.h>
@@ -756,6 +757,241 @@ static void test_double_invalid(void)
 }
 #endif /* MODULE_CBOR_FLOAT */
 
+static unsigned char sink_data[64];
+static size_t sink_len;
+
+static int sink_flush(void *arg, const uint8_t *data, size_t len)
+{
+    (void)arg;
+    if (sink_len + len > sizeof(sink_data)) {
+        return -ENOSPC;
+    }
+    memcpy(sink_data + sink_len, data, len);
+    sink_len += len;
+    return 0;
+}
+
+static void test_writer(void)
+{
+    uint8_t buf[32];
+    cbor_writer_t writer;
+    const char bytes[] = { 0x01, 0x02 };
+
+    /* same encoding as the cbor_stream_t functions */
+    cbor_serialize_array(&stream, 6);
+    cbor_serialize_int64_t(&stream, -1000);
+    cbor_serialize_uint64_t(&stream, 0x100000000ULL);
+    cbor_serialize_unicode_string(&stream, "temp");
+    cbor_serialize_byte_stringl(&stream, bytes, sizeof(bytes));
+    cbor_serialize_map(&stream, 1);
+    cbor_serialize_int(&stream, 1);
+    cbor_serialize_bool(&stream, true);
+    cbor_serialize_array_indefinite(&stream);
+    cbor_write_break(&stream);
+
+    cbor_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+    cbor_writer_array(&writer, 6);
+    cbor_writer_int(&writer, -1000);
+    cbor_writer_uint(&writer, 0x100000000ULL);
+    cbor_writer_text(&writer, "temp", 4);
+    cbor_writer_bytes(&writer, bytes, sizeof(bytes));
+    cbor_writer_map(&writer, 1);
+    cbor_writer_int(&writer, 1);
+    cbor_writer_bool(&writer, true);
+    cbor_writer_array(&writer, CBOR_INDEFINITE);
+    cbor_writer_break(&writer);
+
+    TEST_ASSERT_EQUAL_INT(stream.pos, cbor_writer_finish(&writer));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(stream.data, buf, stream.pos));
+}
+
+static void test_writer_flush(void)
+{
+    uint8_t buf[9];
+    uint8_t expected[] = {
+        0x82, 0x78, 0x18, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j',
+        'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x',
+        0x1a, 0x00, 0x01, 0x00, 0x00
+    };
+    cbor_writer_t writer;
+
+    /* the string does not fit into the buffer and is passed on directly */
+    sink_len = 0;
+    cbor_writer_init(&writer, buf, sizeof(buf), sink_flush, NULL);
+    cbor_writer_array(&writer, 2);
+    cbor_writer_text(&writer, "abcdefghijklmnopqrstuvwx", 24);
+    TEST_ASSERT_EQUAL_INT(0, cbor_writer_uint(&writer, 0x10000));
+    TEST_ASSERT_EQUAL_INT(sizeof(expected), cbor_writer_finish(&writer));
+    TEST_ASSERT_EQUAL_INT(sizeof(expected), sink_len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(expected, sink_data, sizeof(expected)));
+}
+
+static void test_writer_invalid(void)
+{
+    uint8_t buf[9];
+    cbor_writer_t writer;
+
+    /* full buffer without callback */
+    cbor_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+    TEST_ASSERT_EQUAL_INT(0, cbor_writer_uint(&writer, 1));
+    TEST_ASSERT_EQUAL_INT(-ENOBUFS, cbor_writer_text(&writer, "too long", 8));
+    /* errors stick */
+    TEST_ASSERT_EQUAL_INT(-ENOBUFS, cbor_writer_uint(&writer, 1));
+    TEST_ASSERT_EQUAL_INT(-ENOBUFS, cbor_writer_finish(&writer));
+
+    /* errors of the callback are passed on */
+    sink_len = sizeof(sink_data) - 4;
+    cbor_writer_init(&writer, buf, sizeof(buf), sink_flush, NULL);
+    cbor_writer_uint(&writer, 0x100000000ULL);
+    TEST_ASSERT_EQUAL_INT(-ENOSPC, cbor_writer_finish(&writer));
+}
+
+static void test_reader(void)
+{
+    /* [1, [2, 3], {"a": -2}, "IETF", h'0102'] */
+    const uint8_t data[] = {
+        0x85, 0x01, 0x82, 0x02, 0x03, 0xa1, 0x61, 0x61, 0x21,
+        0x64, 'I', 'E', 'T', 'F', 0x42, 0x01, 0x02
+    };
+    cbor_reader_t reader;
+    cbor_item_t item;
+    int64_t val;
+
+    cbor_reader_init(&reader, data, sizeof(data));
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_ARRAY, item.type);
+    TEST_ASSERT_EQUAL_INT(5, item.val.u);
+
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_UINT, item.type);
+    TEST_ASSERT_EQUAL_INT(1, item.val.u);
+
+    /* skip the nested array */
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_ARRAY, item.type);
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_skip(&reader, &item));
+
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_MAP, item.type);
+    TEST_ASSERT_EQUAL_INT(1, item.val.u);
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_TEXT, item.type);
+    TEST_ASSERT_EQUAL_INT(1, item.val.u);
+    TEST_ASSERT(item.data == &data[7]);
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(0, cbor_item_get_int(&item, &val));
+    TEST_ASSERT_EQUAL_INT(-2, (int)val);
+
+    /* strings are not copied */
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_TEXT, item.type);
+    TEST_ASSERT_EQUAL_INT(4, item.val.u);
+    TEST_ASSERT(item.data == &data[10]);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, cbor_item_get_int(&item, &val));
+
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_BYTES, item.type);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(item.data, &data[15], 2));
+
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_remaining(&reader));
+    TEST_ASSERT_EQUAL_INT(-ENODATA, cbor_reader_next(&reader, &item));
+}
+
+static void test_reader_indefinite(void)
+{
+    /* [_ (_ h'0102', h'03'), {_ 1: true}] */
+    const uint8_t data[] = {
+        0x9f, 0x5f, 0x42, 0x01, 0x02, 0x41, 0x03, 0xff,
+        0xbf, 0x01, 0xf5, 0xff, 0xff
+    };
+    cbor_reader_t reader;
+    cbor_item_t item;
+
+    cbor_reader_init(&reader, data, sizeof(data));
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_ARRAY, item.type);
+    TEST_ASSERT(item.indefinite);
+
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_BYTES, item.type);
+    TEST_ASSERT(item.indefinite);
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_skip(&reader, &item));
+
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_MAP, item.type);
+    TEST_ASSERT(item.indefinite);
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_SIMPLE, item.type);
+    TEST_ASSERT_EQUAL_INT(21, item.val.u);
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_BREAK, item.type);
+
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_BREAK, item.type);
+    TEST_ASSERT_EQUAL_INT(-ENODATA, cbor_reader_next(&reader, &item));
+}
+
+static void test_reader_invalid(void)
+{
+    const uint8_t data[] = { 0x82, 0x19, 0x01, 0x00, 0x64, 'I', 'E' };
+    const uint8_t reserved[] = { 0x1c };
+    cbor_reader_t reader;
+    cbor_item_t item;
+
+    /* truncated input leaves the reader where it was */
+    cbor_reader_init(&reader, data, 2);
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(-EAGAIN, cbor_reader_next(&reader, &item));
+    TEST_ASSERT(reader.pos == &data[1]);
+
+    cbor_reader_init(&reader, data, sizeof(data));
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(-EAGAIN, cbor_reader_skip(&reader, &item));
+    TEST_ASSERT(reader.pos == &data[1]);
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(0x100, item.val.u);
+    TEST_ASSERT_EQUAL_INT(-EAGAIN, cbor_reader_next(&reader, &item));
+    TEST_ASSERT(reader.pos == &data[4]);
+
+    cbor_reader_init(&reader, reserved, sizeof(reserved));
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, cbor_reader_next(&reader, &item));
+}
+
+#ifdef MODULE_CBOR_FLOAT
+static void test_reader_writer_float(void)
+{
+    uint8_t buf[16];
+    const uint8_t half[] = { 0xf9, 0x3c, 0x00 };
+    cbor_writer_t writer;
+    cbor_reader_t reader;
+    cbor_item_t item;
+    double val;
+
+    /* single precision is used where it is exact */
+    cbor_writer_init(&writer, buf, sizeof(buf), NULL, NULL);
+    cbor_writer_double(&writer, 21.5);
+    cbor_writer_double(&writer, 1.1);
+    TEST_ASSERT_EQUAL_INT(5 + 9, cbor_writer_finish(&writer));
+    TEST_ASSERT_EQUAL_INT(0xfa, buf[0]);
+    TEST_ASSERT_EQUAL_INT(0xfb, buf[5]);
+
+    cbor_reader_init(&reader, buf, 5 + 9);
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(CBOR_ITEM_FLOAT, item.type);
+    TEST_ASSERT_EQUAL_INT(0, cbor_item_get_double(&item, &val));
+    TEST_ASSERT(EQUAL_FLOAT(21.5, val));
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(0, cbor_item_get_double(&item, &val));
+    TEST_ASSERT(EQUAL_FLOAT(1.1, val));
+
+    cbor_reader_init(&reader, half, sizeof(half));
+    TEST_ASSERT_EQUAL_INT(0, cbor_reader_next(&reader, &item));
+    TEST_ASSERT_EQUAL_INT(0, cbor_item_get_double(&item, &val));
+    TEST_ASSERT(EQUAL_FLOAT(1.0, val));
+}
+#endif /* MODULE_CBOR_FLOAT */
+
 /**
  * See examples from CBOR RFC (cf. Appendix A. Examples)
  */
@@ -796,6 +1032,15 @@ TestRef tests_cbor_all(void)
                         new_TestFixture(test_float_invalid),
                         new_TestFixture(test_double),
                         new_TestFixture(test_double_invalid),
+#endif /* MODULE_CBOR_FLOAT */
+                        new_TestFixture(test_writer),
+                        new_TestFixture(test_writer_flush),
+                        new_TestFixture(test_writer_invalid),
+                        new_TestFixture(test_reader),
+                        new_TestFixture(test_reader_indefinite),
+                        new_TestFixture(test_reader_invalid),
+#ifdef MODULE_CBOR_FLOAT
+                        new_TestFixture(test_reader_writer_float),
 #endif /* MODULE_CBOR_FLOAT */
     };
 
@@ -7,6 +7,7 @@
  */
 
 #include <limits.h>
+#include <string.h>
 
 #include "embUnit.h"
 #include "crypto/ciphers.h"
@@ -59,11 +60,41 @@ static void test_crypto_cipher_aes_decrypt(void)
     TEST_ASSERT_MESSAGE(1 == cmp , "wrong plaintext");
 }
 
+static void test_crypto_cipher_aes_blocks(void)
+{
+    cipher_t cipher;
+    int err, cmp;
+    /* covers both the batched and the single block path */
+    uint8_t data[5 * 16];
+
+    err = cipher_init(&cipher, CIPHER_AES_128, TEST_KEY, 16);
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    for (unsigned i = 0; i < sizeof(data); i += 16) {
+        memcpy(data + i, TEST_INP, 16);
+    }
+
+    err = cipher_encrypt_blocks(&cipher, data, data, sizeof(data) / 16);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    for (unsigned i = 0; i < sizeof(data); i += 16) {
+        cmp = compare(TEST_ENC_AES, data + i, 16);
+        TEST_ASSERT_MESSAGE(1 == cmp , "wrong ciphertext");
+    }
+
+    err = cipher_decrypt_blocks(&cipher, data, data, sizeof(data) / 16);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    for (unsigned i = 0; i < sizeof(data); i += 16) {
+        cmp = compare(TEST_INP, data + i, 16);
+        TEST_ASSERT_MESSAGE(1 == cmp , "wrong plaintext");
+    }
+}
+
 Test* tests_crypto_cipher_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(test_crypto_cipher_aes_encrypt),
-        new_TestFixture(test_crypto_cipher_aes_decrypt)
+        new_TestFixture(test_crypto_cipher_aes_decrypt),
+        new_TestFixture(test_crypto_cipher_aes_blocks)
     };
 
     EMB_UNIT_TESTCALLER(crypto_cipher_tests, NULL, NULL, fixtures);
@@ -147,12 +147,93 @@ static void test_crypto_modes_ccm_decrypt(void)
                     TEST_2_INPUT_LEN);
 }
 
+static void test_crypto_modes_ccm_stream(void)
+{
+    cipher_t cipher;
+    cipher_ccm_t ctx;
+    int len, err, cmp;
+    uint8_t data[32], mac[8];
+    size_t offset;
+
+    err = cipher_init(&cipher, CIPHER_AES_128, TEST_2_KEY, TEST_2_KEY_LEN);
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    /* encrypt in chunks as they would come from a packet snip chain */
+    err = cipher_ccm_init(&ctx, &cipher, 8, 2, TEST_2_NONCE, TEST_2_NONCE_LEN,
+                          TEST_2_ADATA_LEN, TEST_2_INPUT_LEN);
+    TEST_ASSERT_EQUAL_INT(0, err);
+    err = cipher_ccm_update_auth_data(&ctx, TEST_2_INPUT, 3);
+    TEST_ASSERT_EQUAL_INT(0, err);
+    err = cipher_ccm_update_auth_data(&ctx, TEST_2_INPUT + 3,
+                                      TEST_2_ADATA_LEN - 3);
+    TEST_ASSERT_EQUAL_INT(0, err);
+    for (offset = 0; offset < TEST_2_INPUT_LEN; offset += len) {
+        len = (TEST_2_INPUT_LEN - offset > 7) ? 7 : TEST_2_INPUT_LEN - offset;
+        len = cipher_ccm_encrypt_update(&ctx, TEST_2_INPUT + TEST_2_ADATA_LEN +
+                                        offset, len, data + offset);
+        TEST_ASSERT_MESSAGE(len > 0, "Encryption failed");
+    }
+    TEST_ASSERT_EQUAL_INT(8, cipher_ccm_encrypt_final(&ctx, mac));
+
+    cmp = compare(TEST_2_EXPECTED + TEST_2_ADATA_LEN, data, TEST_2_INPUT_LEN);
+    TEST_ASSERT_MESSAGE(1 == cmp , "wrong ciphertext");
+    cmp = compare(TEST_2_EXPECTED + TEST_2_ADATA_LEN + TEST_2_INPUT_LEN, mac, 8);
+    TEST_ASSERT_MESSAGE(1 == cmp , "wrong MAC");
+
+    /* decrypt in place, a modified MAC must be detected */
+    err = cipher_ccm_init(&ctx, &cipher, 8, 2, TEST_2_NONCE, TEST_2_NONCE_LEN,
+                          TEST_2_ADATA_LEN, TEST_2_INPUT_LEN);
+    TEST_ASSERT_EQUAL_INT(0, err);
+    err = cipher_ccm_update_auth_data(&ctx, TEST_2_INPUT, TEST_2_ADATA_LEN);
+    TEST_ASSERT_EQUAL_INT(0, err);
+    len = cipher_ccm_decrypt_update(&ctx, data, TEST_2_INPUT_LEN, data);
+    TEST_ASSERT_EQUAL_INT(TEST_2_INPUT_LEN, len);
+    mac[0] ^= 1;
+    err = cipher_ccm_decrypt_final(&ctx, mac);
+    TEST_ASSERT_EQUAL_INT(CCM_ERR_INVALID_CBC_MAC, err);
+
+    cmp = compare(TEST_2_INPUT + TEST_2_ADATA_LEN, data, TEST_2_INPUT_LEN);
+    TEST_ASSERT_MESSAGE(1 == cmp , "wrong plaintext");
+}
+
+static void test_crypto_modes_ccm_stream_length(void)
+{
+    cipher_t cipher;
+    cipher_ccm_t ctx;
+    uint8_t data[4] = {0};
+    int err;
+
+    err = cipher_init(&cipher, CIPHER_AES_128, TEST_1_KEY, TEST_1_KEY_LEN);
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    err = cipher_ccm_init(&ctx, &cipher, 8, 2, TEST_1_NONCE, TEST_1_NONCE_LEN,
+                          2, sizeof(data));
+    TEST_ASSERT_EQUAL_INT(0, err);
+    /* payload before the additional data is complete */
+    err = cipher_ccm_encrypt_update(&ctx, data, 1, data);
+    TEST_ASSERT_EQUAL_INT(CCM_ERR_INVALID_DATA_LENGTH, err);
+    err = cipher_ccm_update_auth_data(&ctx, data, 2);
+    TEST_ASSERT_EQUAL_INT(0, err);
+    /* more payload than announced */
+    err = cipher_ccm_encrypt_update(&ctx, data, sizeof(data) + 1, data);
+    TEST_ASSERT_EQUAL_INT(CCM_ERR_INVALID_DATA_LENGTH, err);
+    /* less payload than announced */
+    err = cipher_ccm_encrypt_final(&ctx, data);
+    TEST_ASSERT_EQUAL_INT(CCM_ERR_INVALID_DATA_LENGTH, err);
+
+    /* length does not fit into length_encoding octets */
+    err = cipher_ccm_init(&ctx, &cipher, 8, 2, TEST_1_NONCE, TEST_1_NONCE_LEN,
+                          0, 0x10000);
+    TEST_ASSERT_EQUAL_INT(CCM_ERR_INVALID_DATA_LENGTH, err);
+}
 
 Test* tests_crypto_modes_ccm_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(test_crypto_modes_ccm_encrypt),
-                        new_TestFixture(test_crypto_modes_ccm_decrypt)
+                        new_TestFixture(test_crypto_modes_ccm_decrypt),
+                        new_TestFixture(test_crypto_modes_ccm_stream),
+                        new_TestFixture(test_crypto_modes_ccm_stream_length)
     };
 
     EMB_UNIT_TESTCALLER(crypto_modes_ccm_tests, NULL, NULL, fixtures);
@@ -119,12 +119,38 @@ static void test_crypto_modes_ctr_decrypt(void)
                     TEST_1_CIPHER_LEN, TEST_1_PLAIN, TEST_1_PLAIN_LEN);
 }
 
+static void test_crypto_modes_ctr_stream(void)
+{
+    cipher_t cipher;
+    cipher_ctr_t ctx;
+    int len, err, cmp;
+    uint8_t data[64];
+    /* chunks not aligned to the block size */
+    static const uint8_t chunks[] = { 5, 11, 20, 1, 27 };
+    size_t offset = 0;
+
+    err = cipher_init(&cipher, CIPHER_AES_128, TEST_1_KEY, TEST_1_KEY_LEN);
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    cipher_ctr_init(&ctx, &cipher, TEST_1_COUNTER, 0);
+    for (unsigned i = 0; i < sizeof(chunks); i++) {
+        len = cipher_ctr_update(&ctx, TEST_1_PLAIN + offset, chunks[i],
+                                data + offset);
+        TEST_ASSERT_EQUAL_INT(chunks[i], len);
+        offset += chunks[i];
+    }
+
+    TEST_ASSERT_EQUAL_INT(TEST_1_CIPHER_LEN, offset);
+    cmp = compare(TEST_1_CIPHER, data, TEST_1_CIPHER_LEN);
+    TEST_ASSERT_MESSAGE(1 == cmp , "wrong ciphertext");
+}
 
 Test* tests_crypto_modes_ctr_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(test_crypto_modes_ctr_encrypt),
-                        new_TestFixture(test_crypto_modes_ctr_decrypt)
+                        new_TestFixture(test_crypto_modes_ctr_decrypt),
+                        new_TestFixture(test_crypto_modes_ctr_stream)
     };
 
     EMB_UNIT_TESTCALLER(crypto_modes_ctr_tests, NULL, NULL, fixtures);
@@ -328,6 +328,31 @@ static void test_hashes_hmac_sha256_ite_hash_PRF6_split(void)
                  "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2", hmac));
 }
 
+static void test_hashes_hmac_sha256_precomputed_key(void)
+{
+    /* Test Case PRF-6 with a key precomputed once and used twice */
+    hmac_context_t ctx;
+    hmac_sha256_key_t hkey;
+    const unsigned char strPRF6[] = "This is a test using a larger than block-size key and a "
+                           "larger than block-size data. The key needs to be hashed "
+                           "before being used by the HMAC algorithm.";
+    unsigned char longKey[131];
+    static unsigned char hmac[SHA256_DIGEST_LENGTH];
+    memset(longKey, 0xaa, sizeof(longKey));
+
+    hmac_sha256_key_init(&hkey, longKey, sizeof(longKey));
+
+    for (unsigned i = 0; i < 2; i++) {
+        memset(hmac, 0, sizeof(hmac));
+        hmac_sha256_init_key(&ctx, &hkey);
+        hmac_sha256_update(&ctx, strPRF6, strlen((char*)strPRF6));
+        hmac_sha256_final(&ctx, hmac);
+
+        TEST_ASSERT(compare_str_vs_digest(
+                     "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2", hmac));
+    }
+}
+
 Test *tests_hashes_sha256_hmac_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -346,6 +371,7 @@ Test *tests_hashes_sha256_hmac_tests(void)
         new_TestFixture(test_hashes_hmac_sha256_ite_hash_PRF5),
         new_TestFixture(test_hashes_hmac_sha256_ite_hash_PRF6),
         new_TestFixture(test_hashes_hmac_sha256_ite_hash_PRF6_split),
+        new_TestFixture(test_hashes_hmac_sha256_precomputed_key),
     };
 
     EMB_UNIT_TESTCALLER(hashes_sha256_tests, NULL, NULL,
@@ -11,6 +11,7 @@
  *
  * @file
  */
+#include <stdbool.h>
 #include <string.h>
 #include <errno.h>
 
@@ -19,6 +20,10 @@
 #include "mtd.h"
 #include "board.h"
 
+#ifdef MODULE_MTD_NATIVE
+#include "mtd_native.h"
+#endif
+
 #if MODULE_VFS
 #include <fcntl.h>
 #include <stdio.h>
@@ -214,6 +219,25 @@ static void test_mtd_write_read(void)
     TEST_ASSERT_EQUAL_INT(-EOVERFLOW, ret);
 }
 
+static void test_mtd_flush(void)
+{
+    const char buf[] = "ABCDEFGH";
+    char buf_read[sizeof(buf)];
+
+    int ret = mtd_write(dev, buf, 0, sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(sizeof(buf), ret);
+
+    /* flushing succeeds whether or not the driver buffers data */
+    ret = mtd_flush(dev);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    ret = mtd_flush(dev);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+
+    ret = mtd_read(dev, buf_read, 0, sizeof(buf_read));
+    TEST_ASSERT_EQUAL_INT(sizeof(buf_read), ret);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, buf_read, sizeof(buf)));
+}
+
 #ifdef MTD_0
 static void test_mtd_write_read_flash(void)
 {
@@ -239,6 +263,57 @@ static void test_mtd_write_read_flash(void)
 }
 #endif
 
+#ifdef MODULE_MTD_NATIVE
+static bool _native_dirty(mtd_native_dev_t *native, uint32_t sector)
+{
+    return native->dirty[sector / 8] & (1 << (sector % 8));
+}
+
+static void test_mtd_native_flush(void)
+{
+    mtd_native_dev_t *native = (mtd_native_dev_t *)dev;
+    uint32_t sector_size = dev->pages_per_sector * dev->page_size;
+    const char buf[] = "ABCDEFGH";
+    char buf_read[sizeof(buf)];
+
+    int ret = mtd_flush(dev);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    TEST_ASSERT(!_native_dirty(native, 1));
+
+    /* only the written sector is marked for write-back */
+    ret = mtd_erase(dev, sector_size, sector_size);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    ret = mtd_write(dev, buf, sector_size + 3, sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(sizeof(buf), ret);
+    TEST_ASSERT(!_native_dirty(native, 0));
+    TEST_ASSERT(_native_dirty(native, 1));
+    TEST_ASSERT(!_native_dirty(native, 2));
+
+    ret = mtd_flush(dev);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    TEST_ASSERT(!_native_dirty(native, 1));
+
+    ret = mtd_read(dev, buf_read, sector_size + 3, sizeof(buf_read));
+    TEST_ASSERT_EQUAL_INT(sizeof(buf_read), ret);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, buf_read, sizeof(buf)));
+
+    /* powering down writes back, too */
+    ret = mtd_erase(dev, sector_size, sector_size);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    TEST_ASSERT(_native_dirty(native, 1));
+    ret = mtd_power(dev, MTD_POWER_DOWN);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+    TEST_ASSERT(!_native_dirty(native, 1));
+    mtd_power(dev, MTD_POWER_UP);
+
+    ret = mtd_read(dev, buf_read, sector_size + 3, sizeof(buf_read));
+    TEST_ASSERT_EQUAL_INT(sizeof(buf_read), ret);
+    for (unsigned i = 0; i < sizeof(buf_read); i++) {
+        TEST_ASSERT_EQUAL_INT(0xff, (uint8_t)buf_read[i]);
+    }
+}
+#endif
+
 #if MODULE_VFS
 static void test_mtd_vfs(void)
 {
@@ -275,6 +350,10 @@ Test *tests_mtd_tests(void)
         new_TestFixture(test_mtd_erase),
         new_TestFixture(test_mtd_write_erase),
         new_TestFixture(test_mtd_write_read),
+        new_TestFixture(test_mtd_flush),
+#ifdef MODULE_MTD_NATIVE
+        new_TestFixture(test_mtd_native_flush),
+#endif
 #ifdef MTD_0
         new_TestFixture(test_mtd_write_read_flash),
 #endif
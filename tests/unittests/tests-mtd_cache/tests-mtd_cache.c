@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "mtd.h"
+#include "mtd_cache.h"
+
+#include "tests-mtd_cache.h"
+
+#define SECTOR_COUNT    (4)
+#define PAGE_PER_SECTOR (4)
+#define PAGE_SIZE       (64)
+#define SECTOR_SIZE     (PAGE_PER_SECTOR * PAGE_SIZE)
+
+/* RAM-based parent device counting the accesses it gets */
+static uint8_t dummy_memory[PAGE_PER_SECTOR * PAGE_SIZE * SECTOR_COUNT];
+static unsigned parent_reads, parent_writes, parent_flushes;
+
+static int _init(mtd_dev_t *dev)
+{
+    (void)dev;
+    return 0;
+}
+
+static int _read(mtd_dev_t *dev, void *buff, uint32_t addr, uint32_t size)
+{
+    (void)dev;
+
+    if (addr + size > sizeof(dummy_memory)) {
+        return -EOVERFLOW;
+    }
+    parent_reads++;
+    memcpy(buff, dummy_memory + addr, size);
+
+    return size;
+}
+
+static int _write(mtd_dev_t *dev, const void *buff, uint32_t addr, uint32_t size)
+{
+    (void)dev;
+
+    if (addr + size > sizeof(dummy_memory)) {
+        return -EOVERFLOW;
+    }
+    parent_writes++;
+    memcpy(dummy_memory + addr, buff, size);
+
+    return size;
+}
+
+static int _erase(mtd_dev_t *dev, uint32_t addr, uint32_t size)
+{
+    (void)dev;
+
+    if ((addr % SECTOR_SIZE) || (size % SECTOR_SIZE) ||
+        (addr + size > sizeof(dummy_memory))) {
+        return -EOVERFLOW;
+    }
+    memset(dummy_memory + addr, 0xff, size);
+
+    return 0;
+}
+
+static int _flush(mtd_dev_t *dev)
+{
+    (void)dev;
+    parent_flushes++;
+    return 0;
+}
+
+static const mtd_desc_t driver = {
+    .init = _init,
+    .read = _read,
+    .write = _write,
+    .erase = _erase,
+    .flush = _flush,
+};
+
+static mtd_dev_t parent = {
+    .driver = &driver,
+    .sector_count = SECTOR_COUNT,
+    .pages_per_sector = PAGE_PER_SECTOR,
+    .page_size = PAGE_SIZE,
+};
+
+static mtd_cache_t cache;
+static mtd_dev_t *dev = (mtd_dev_t *)&cache;
+
+static void setup(void)
+{
+    memset(dummy_memory, 0xff, sizeof(dummy_memory));
+    parent_reads = 0;
+    parent_writes = 0;
+    parent_flushes = 0;
+    mtd_cache_setup(&cache, &parent);
+    mtd_init(dev);
+}
+
+static void test_mtd_cache_setup(void)
+{
+    TEST_ASSERT_EQUAL_INT(SECTOR_COUNT, dev->sector_count);
+    TEST_ASSERT_EQUAL_INT(PAGE_PER_SECTOR, dev->pages_per_sector);
+    TEST_ASSERT_EQUAL_INT(PAGE_SIZE, dev->page_size);
+}
+
+static void test_mtd_cache_page_too_large(void)
+{
+    mtd_dev_t large = {
+        .driver = &driver,
+        .sector_count = 1,
+        .pages_per_sector = 1,
+        .page_size = MTD_CACHE_LINE_SIZE * 2,
+    };
+
+    mtd_cache_setup(&cache, &large);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, mtd_init(dev));
+}
+
+static void test_mtd_cache_read_hit(void)
+{
+    uint8_t buf[8];
+
+    memcpy(dummy_memory + PAGE_SIZE + 4, "ABCDEFGH", sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(sizeof(buf), mtd_read(dev, buf, PAGE_SIZE + 4, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, "ABCDEFGH", sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(1, parent_reads);
+
+    /* same page again is served from the cache */
+    TEST_ASSERT_EQUAL_INT(2, mtd_read(dev, buf, PAGE_SIZE + 6, 2));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, "CD", 2));
+    TEST_ASSERT_EQUAL_INT(1, parent_reads);
+    TEST_ASSERT_EQUAL_INT(1, cache.stats.hits);
+    TEST_ASSERT_EQUAL_INT(1, cache.stats.misses);
+}
+
+static void test_mtd_cache_read_across_pages(void)
+{
+    uint8_t buf[PAGE_SIZE];
+
+    memset(dummy_memory + PAGE_SIZE, 0x11, PAGE_SIZE);
+    TEST_ASSERT_EQUAL_INT(sizeof(buf),
+                          mtd_read(dev, buf, PAGE_SIZE / 2, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0xff, buf[0]);
+    TEST_ASSERT_EQUAL_INT(0x11, buf[PAGE_SIZE - 1]);
+    TEST_ASSERT_EQUAL_INT(2, parent_reads);
+    TEST_ASSERT_EQUAL_INT(2, cache.stats.misses);
+}
+
+static void test_mtd_cache_write_back(void)
+{
+    const char data[] = "write back";
+    char buf[sizeof(data)];
+
+    TEST_ASSERT_EQUAL_INT(sizeof(data), mtd_write(dev, data, 8, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(0, parent_writes);
+    /* read sees the buffered data */
+    TEST_ASSERT_EQUAL_INT(sizeof(buf), mtd_read(dev, buf, 8, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(data, buf, sizeof(data)));
+
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(dev));
+    TEST_ASSERT_EQUAL_INT(1, parent_writes);
+    TEST_ASSERT_EQUAL_INT(1, parent_flushes);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(data, dummy_memory + 8, sizeof(data)));
+
+    /* nothing left to write back */
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(dev));
+    TEST_ASSERT_EQUAL_INT(1, parent_writes);
+}
+
+static void test_mtd_cache_full_page_write(void)
+{
+    uint8_t page[PAGE_SIZE];
+
+    memset(page, 0x42, sizeof(page));
+    TEST_ASSERT_EQUAL_INT(sizeof(page), mtd_write(dev, page, 0, sizeof(page)));
+    /* page was not read before being overwritten */
+    TEST_ASSERT_EQUAL_INT(0, parent_reads);
+}
+
+static void test_mtd_cache_evict(void)
+{
+    const uint8_t val = 0x5a;
+    uint8_t buf;
+
+    /* dirty the first page, then access more pages than fit the cache */
+    TEST_ASSERT_EQUAL_INT(1, mtd_write(dev, &val, 0, 1));
+    for (unsigned i = 1; i <= MTD_CACHE_LINES; i++) {
+        TEST_ASSERT_EQUAL_INT(1, mtd_read(dev, &buf, (i % (SECTOR_COUNT * PAGE_PER_SECTOR)) * PAGE_SIZE, 1));
+    }
+    TEST_ASSERT_EQUAL_INT(1, cache.stats.writebacks);
+    TEST_ASSERT_EQUAL_INT(val, dummy_memory[0]);
+}
+
+static void test_mtd_cache_erase(void)
+{
+    const uint8_t val = 0x00;
+    uint8_t buf;
+
+    TEST_ASSERT_EQUAL_INT(1, mtd_write(dev, &val, SECTOR_SIZE, 1));
+    TEST_ASSERT_EQUAL_INT(0, mtd_erase(dev, SECTOR_SIZE, SECTOR_SIZE));
+    TEST_ASSERT_EQUAL_INT(1, mtd_read(dev, &buf, SECTOR_SIZE, 1));
+    TEST_ASSERT_EQUAL_INT(0xff, buf);
+    /* the pending write was dropped */
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(dev));
+    TEST_ASSERT_EQUAL_INT(0, parent_writes);
+
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, mtd_erase(dev, PAGE_SIZE, SECTOR_SIZE));
+}
+
+static void test_mtd_cache_overflow(void)
+{
+    uint8_t buf[4];
+
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, mtd_read(dev, buf, sizeof(dummy_memory) - 2,
+                                               sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, mtd_write(dev, buf, sizeof(dummy_memory) - 2,
+                                                sizeof(buf)));
+}
+
+Test *tests_mtd_cache_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_mtd_cache_setup),
+        new_TestFixture(test_mtd_cache_page_too_large),
+        new_TestFixture(test_mtd_cache_read_hit),
+        new_TestFixture(test_mtd_cache_read_across_pages),
+        new_TestFixture(test_mtd_cache_write_back),
+        new_TestFixture(test_mtd_cache_full_page_write),
+        new_TestFixture(test_mtd_cache_evict),
+        new_TestFixture(test_mtd_cache_erase),
+        new_TestFixture(test_mtd_cache_overflow),
+    };
+
+    EMB_UNIT_TESTCALLER(mtd_cache_tests, setup, NULL, fixtures);
+
+    return (Test *)&mtd_cache_tests;
+}
+
+void tests_mtd_cache(void)
+{
+    TESTS_RUN(tests_mtd_cache_tests());
+}
+/** @} */
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "saul_dsp.h"
+
+#include "tests-saul_dsp.h"
+
+#define RING_SIZE       (8U)
+
+static int16_t _ring_buf[RING_SIZE];
+static saul_dsp_ring_t _ring;
+
+/* sensor counting its reads */
+static int16_t _sensor_count;
+
+static int _sensor_read(const void *dev, phydat_t *res)
+{
+    (void)dev;
+    res->val[0] = _sensor_count;
+    res->val[1] = -_sensor_count;
+    res->unit = UNIT_G;
+    res->scale = -3;
+    _sensor_count++;
+    return 2;
+}
+
+static const saul_driver_t _sensor_driver = {
+    _sensor_read, saul_notsup, SAUL_SENSE_ACCEL, NULL
+};
+
+static saul_reg_t _sensor = { NULL, NULL, "sensor", &_sensor_driver };
+
+static void setup(void)
+{
+    saul_dsp_ring_init(&_ring, _ring_buf, RING_SIZE);
+    _sensor_count = 0;
+}
+
+static void test_saul_dsp_ring(void)
+{
+    int16_t buf[RING_SIZE];
+
+    for (unsigned i = 0; i < RING_SIZE; i++) {
+        TEST_ASSERT_EQUAL_INT(0, saul_dsp_ring_put(&_ring, i));
+    }
+    TEST_ASSERT_EQUAL_INT(-ENOBUFS, saul_dsp_ring_put(&_ring, 42));
+    TEST_ASSERT_EQUAL_INT(RING_SIZE, saul_dsp_ring_avail(&_ring));
+
+    TEST_ASSERT_EQUAL_INT(5, saul_dsp_ring_get(&_ring, buf, 5));
+    TEST_ASSERT_EQUAL_INT(4, buf[4]);
+    for (unsigned i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(0, saul_dsp_ring_put(&_ring, 10 + i));
+    }
+
+    /* wraps around */
+    TEST_ASSERT_EQUAL_INT(RING_SIZE, saul_dsp_ring_get(&_ring, buf, 20));
+    TEST_ASSERT_EQUAL_INT(5, buf[0]);
+    TEST_ASSERT_EQUAL_INT(7, buf[2]);
+    TEST_ASSERT_EQUAL_INT(10, buf[3]);
+    TEST_ASSERT_EQUAL_INT(14, buf[7]);
+    TEST_ASSERT_EQUAL_INT(0, saul_dsp_ring_get(&_ring, buf, 1));
+}
+
+static void test_saul_dsp_ring_write_ptr(void)
+{
+    int16_t buf[RING_SIZE];
+    size_t len;
+
+    for (unsigned i = 0; i < 6; i++) {
+        saul_dsp_ring_put(&_ring, i);
+    }
+    saul_dsp_ring_get(&_ring, buf, 4);
+
+    /* only up to the end of the buffer is contiguous */
+    int16_t *dst = saul_dsp_ring_write_ptr(&_ring, &len);
+    TEST_ASSERT_EQUAL_INT(2, len);
+    TEST_ASSERT(dst == &_ring_buf[6]);
+    dst[0] = 6;
+    dst[1] = 7;
+    saul_dsp_ring_commit(&_ring, 2);
+
+    dst = saul_dsp_ring_write_ptr(&_ring, &len);
+    TEST_ASSERT_EQUAL_INT(4, len);
+    TEST_ASSERT(dst == &_ring_buf[0]);
+    dst[0] = 8;
+    saul_dsp_ring_commit(&_ring, 1);
+
+    TEST_ASSERT_EQUAL_INT(5, saul_dsp_ring_get(&_ring, buf, RING_SIZE));
+    for (unsigned i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(4 + i, buf[i]);
+    }
+}
+
+static void test_saul_dsp_acquire(void)
+{
+    saul_dsp_acq_t acq;
+    int16_t buf[RING_SIZE];
+
+    saul_dsp_acq_init(&acq, &_sensor, 1, &_ring, 0);
+    TEST_ASSERT_EQUAL_INT(RING_SIZE + 2, saul_dsp_acquire(&acq, RING_SIZE + 2));
+    TEST_ASSERT_EQUAL_INT(2, acq.overruns);
+    TEST_ASSERT_EQUAL_INT(UNIT_G, acq.unit);
+    TEST_ASSERT_EQUAL_INT(-3, acq.scale);
+
+    TEST_ASSERT_EQUAL_INT(RING_SIZE, saul_dsp_ring_get(&_ring, buf, RING_SIZE));
+    TEST_ASSERT_EQUAL_INT(0, buf[0]);
+    TEST_ASSERT_EQUAL_INT(-7, buf[7]);
+
+    saul_dsp_acq_init(&acq, &_sensor, 2, &_ring, 0);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, saul_dsp_acquire(&acq, 1));
+}
+
+static void test_saul_dsp_fir(void)
+{
+    static const int16_t coeffs[] = { SAUL_DSP_Q15(0.5), SAUL_DSP_Q15(0.5) };
+    int16_t block[] = { 0, 100, 100, 300 };
+    saul_dsp_fir_t fir;
+
+    saul_dsp_fir_init(&fir, coeffs, 2);
+    TEST_ASSERT_EQUAL_INT(4, saul_dsp_process(&fir.stage, block, 4));
+    TEST_ASSERT_EQUAL_INT(0, block[0]);
+    TEST_ASSERT_EQUAL_INT(50, block[1]);
+    TEST_ASSERT_EQUAL_INT(100, block[2]);
+    TEST_ASSERT_EQUAL_INT(200, block[3]);
+
+    /* the state is kept across blocks */
+    block[0] = -300;
+    saul_dsp_process(&fir.stage, block, 1);
+    TEST_ASSERT_EQUAL_INT(0, block[0]);
+}
+
+static void test_saul_dsp_dc(void)
+{
+    int16_t block[200];
+    saul_dsp_dc_t dc;
+
+    for (unsigned i = 0; i < 200; i++) {
+        block[i] = 1000;
+    }
+    saul_dsp_dc_init(&dc, SAUL_DSP_Q15(0.9));
+    saul_dsp_process(&dc.stage, block, 200);
+    TEST_ASSERT_EQUAL_INT(1000, block[0]);
+    TEST_ASSERT(block[1] < 1000);
+    TEST_ASSERT(block[199] < 2);
+}
+
+static void test_saul_dsp_chain(void)
+{
+    int16_t block[] = { 1, 2, 3, 4, 5, 6 };
+    saul_dsp_decim_t decim;
+    saul_dsp_decim_t decim2;
+
+    saul_dsp_decim_init(&decim, 2);
+    saul_dsp_decim_init(&decim2, 2);
+    decim.stage.next = &decim2.stage;
+
+    /* (1 + 2 + 3 + 4) / 4, 5 and 6 are carried over */
+    TEST_ASSERT_EQUAL_INT(1, saul_dsp_process(&decim.stage, block, 6));
+    TEST_ASSERT_EQUAL_INT(2, block[0]);
+
+    block[0] = 7;
+    block[1] = 8;
+    TEST_ASSERT_EQUAL_INT(1, saul_dsp_process(&decim.stage, block, 2));
+    TEST_ASSERT_EQUAL_INT(6, block[0]);
+}
+
+static void test_saul_dsp_features(void)
+{
+    int16_t block[] = { 3, -4, 3, -4 };
+    saul_dsp_features_t features;
+
+    saul_dsp_features(block, 4, &features);
+    TEST_ASSERT_EQUAL_INT(0, features.mean);
+    TEST_ASSERT_EQUAL_INT(3, features.rms);
+    TEST_ASSERT_EQUAL_INT(4, features.peak);
+    TEST_ASSERT_EQUAL_INT(0, features.peak_bin);
+}
+
+static void test_saul_dsp_spectrum_peak(void)
+{
+    int16_t block[64];
+    int16_t scratch[64];
+    saul_dsp_features_t features;
+
+    /* square wave with a period of 16 samples, its fundamental is in bin 4
+     * with a magnitude of 2 / pi of the amplitude */
+    for (unsigned i = 0; i < 64; i++) {
+        block[i] = ((i % 16) < 8) ? 8000 : -8000;
+    }
+    saul_dsp_spectrum_peak(block, scratch, 6, &features);
+    TEST_ASSERT_EQUAL_INT(4, features.peak_bin);
+    TEST_ASSERT(features.peak_mag > 5000);
+    TEST_ASSERT(features.peak_mag < 5200);
+}
+
+Test *tests_saul_dsp_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_saul_dsp_ring),
+        new_TestFixture(test_saul_dsp_ring_write_ptr),
+        new_TestFixture(test_saul_dsp_acquire),
+        new_TestFixture(test_saul_dsp_fir),
+        new_TestFixture(test_saul_dsp_dc),
+        new_TestFixture(test_saul_dsp_chain),
+        new_TestFixture(test_saul_dsp_features),
+        new_TestFixture(test_saul_dsp_spectrum_peak),
+    };
+
+    EMB_UNIT_TESTCALLER(saul_dsp_tests, setup, NULL, fixtures);
+
+    return (Test *)&saul_dsp_tests;
+}
+
+void tests_saul_dsp(void)
+{
+    TESTS_RUN(tests_saul_dsp_tests());
+}
+/** @} */
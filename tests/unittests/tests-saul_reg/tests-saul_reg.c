@@ -25,16 +25,64 @@
 #include "saul_reg.h"
 #include "tests-saul_reg.h"
 
-static const saul_driver_t s0_dri = { NULL, NULL, SAUL_ACT_SERVO };
-static const saul_driver_t s1_dri = { NULL, NULL, SAUL_SENSE_TEMP };
-static const saul_driver_t s2_dri = { NULL, NULL, SAUL_SENSE_LIGHT };
-static const saul_driver_t s3_dri = { NULL, NULL, SAUL_ACT_LED_RGB };
+static const saul_driver_t s0_dri = { NULL, NULL, SAUL_ACT_SERVO, NULL };
+static const saul_driver_t s1_dri = { NULL, NULL, SAUL_SENSE_TEMP, NULL };
+static const saul_driver_t s2_dri = { NULL, NULL, SAUL_SENSE_LIGHT, NULL };
+static const saul_driver_t s3_dri = { NULL, NULL, SAUL_ACT_LED_RGB, NULL };
 
 static saul_reg_t s0 = { NULL, NULL, "S0", &s0_dri };
 static saul_reg_t s1 = { NULL, NULL, "S1", &s1_dri };
 static saul_reg_t s2 = { NULL, NULL, "S2", &s2_dri };
 static saul_reg_t s3 = { NULL, NULL, "S3", &s3_dri };
 
+static unsigned reads, multi_reads;
+
+static int read_single(const void *dev, phydat_t *res)
+{
+    res->val[0] = *((const int16_t *)dev);
+    reads++;
+    return 1;
+}
+
+static int read_multi(const void *const *devs, phydat_t *res, unsigned num)
+{
+    for (unsigned i = 0; i < num; i++) {
+        res[i].val[0] = *((const int16_t *)devs[i]);
+    }
+    multi_reads++;
+    return 1;
+}
+
+static const saul_driver_t m_dri = {
+    read_single, NULL, SAUL_SENSE_TEMP, read_multi
+};
+
+static int16_t m_vals[] = { 10, 11, 12 };
+static saul_reg_t m0 = { NULL, &m_vals[0], "M0", &m_dri };
+static saul_reg_t m1 = { NULL, &m_vals[1], "M1", &m_dri };
+static saul_reg_t m2 = { NULL, &m_vals[2], "M2", &m_dri };
+static const saul_driver_t n_dri = {
+    read_single, NULL, SAUL_SENSE_HUM, NULL
+};
+static int16_t n_val = 20;
+static saul_reg_t n0 = { NULL, &n_val, "M0", &n_dri };
+
+static int read_multi_notsup(const void *const *devs, phydat_t *res,
+                             unsigned num)
+{
+    (void)devs;
+    (void)res;
+    (void)num;
+    multi_reads++;
+    return -ENOTSUP;
+}
+
+static const saul_driver_t u_dri = {
+    read_single, NULL, SAUL_SENSE_TEMP, read_multi_notsup
+};
+static saul_reg_t u0 = { NULL, &m_vals[0], "U0", &u_dri };
+static saul_reg_t u1 = { NULL, &m_vals[1], "U1", &u_dri };
+
 
 static int count(void)
 {
@@ -173,6 +221,68 @@ static void test_reg_rm(void)
     TEST_ASSERT_EQUAL_INT(2, count());
 }
 
+static void test_reg_find_after_change(void)
+{
+    /* S0, S2 are left, lookups must see the changes */
+    TEST_ASSERT_NULL(saul_reg_find_name("S1"));
+    TEST_ASSERT_NULL(saul_reg_find_type(SAUL_SENSE_TEMP));
+
+    TEST_ASSERT_EQUAL_INT(0, saul_reg_add(&m0));
+    TEST_ASSERT_EQUAL_INT(0, saul_reg_add(&s1));
+    TEST_ASSERT_EQUAL_INT(0, saul_reg_add(&n0));
+
+    TEST_ASSERT(saul_reg_find_name("S1") == &s1);
+    TEST_ASSERT(saul_reg_find_nth(3) == &s1);
+    /* the first registered device wins */
+    TEST_ASSERT(saul_reg_find_type(SAUL_SENSE_TEMP) == &m0);
+    TEST_ASSERT(saul_reg_find_name("M0") == &m0);
+    TEST_ASSERT(saul_reg_find_type(SAUL_SENSE_HUM) == &n0);
+    TEST_ASSERT_NULL(saul_reg_find_nth(5));
+
+    TEST_ASSERT_EQUAL_INT(0, saul_reg_rm(&m0));
+    TEST_ASSERT(saul_reg_find_type(SAUL_SENSE_TEMP) == &s1);
+    TEST_ASSERT(saul_reg_find_name("M0") == &n0);
+}
+
+static void test_reg_read_batch(void)
+{
+    saul_reg_t *devs[] = { &m0, &m1, &n0, &m2, NULL, &m1 };
+    phydat_t res[6];
+    int dims[6];
+
+    reads = 0;
+    multi_reads = 0;
+    TEST_ASSERT_EQUAL_INT(5, saul_reg_read_batch(devs, res, dims, 6));
+    /* m0 and m1 at once, a lone m2 or m1 is read on its own */
+    TEST_ASSERT_EQUAL_INT(1, multi_reads);
+    TEST_ASSERT_EQUAL_INT(3, reads);
+    TEST_ASSERT_EQUAL_INT(10, res[0].val[0]);
+    TEST_ASSERT_EQUAL_INT(11, res[1].val[0]);
+    TEST_ASSERT_EQUAL_INT(20, res[2].val[0]);
+    TEST_ASSERT_EQUAL_INT(12, res[3].val[0]);
+    TEST_ASSERT_EQUAL_INT(11, res[5].val[0]);
+    TEST_ASSERT_EQUAL_INT(1, dims[0]);
+    TEST_ASSERT_EQUAL_INT(-ENODEV, dims[4]);
+}
+
+static void test_reg_read_batch_notsup(void)
+{
+    saul_reg_t *devs[] = { &u0, &u1 };
+    phydat_t res[2];
+    int dims[2];
+
+    reads = 0;
+    multi_reads = 0;
+    /* falls back to reading the devices one by one */
+    TEST_ASSERT_EQUAL_INT(2, saul_reg_read_batch(devs, res, dims, 2));
+    TEST_ASSERT_EQUAL_INT(1, multi_reads);
+    TEST_ASSERT_EQUAL_INT(2, reads);
+    TEST_ASSERT_EQUAL_INT(10, res[0].val[0]);
+    TEST_ASSERT_EQUAL_INT(11, res[1].val[0]);
+    TEST_ASSERT_EQUAL_INT(1, dims[0]);
+    TEST_ASSERT_EQUAL_INT(1, dims[1]);
+}
+
 Test *tests_saul_reg_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -181,7 +291,10 @@ Test *tests_saul_reg_tests(void)
         new_TestFixture(test_reg_find_nth),
         new_TestFixture(test_reg_find_type),
         new_TestFixture(test_reg_find_name),
-        new_TestFixture(test_reg_rm)
+        new_TestFixture(test_reg_rm),
+        new_TestFixture(test_reg_find_after_change),
+        new_TestFixture(test_reg_read_batch),
+        new_TestFixture(test_reg_read_batch_notsup),
     };
 
     EMB_UNIT_TESTCALLER(pkt_tests, NULL, NULL, fixtures);
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2017 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "universal_address.h"
+
+#include "tests-universal_address.h"
+
+#define ADDR_SIZE       (8U)
+
+/* more entries than hash buckets, so some of them share a chain */
+#define NUMOF           (UNIVERSAL_ADDRESS_MAX_ENTRIES)
+
+static universal_address_container_t *entries[NUMOF];
+
+static void _addr(uint8_t *addr, unsigned i)
+{
+    memset(addr, 0, ADDR_SIZE);
+    addr[0] = 0xfe;
+    addr[ADDR_SIZE - 2] = i >> 8;
+    addr[ADDR_SIZE - 1] = i;
+}
+
+static universal_address_container_t *_add(unsigned i)
+{
+    uint8_t addr[ADDR_SIZE];
+
+    _addr(addr, i);
+    return universal_address_add(addr, sizeof(addr));
+}
+
+static void _assert_stored(universal_address_container_t *entry, unsigned i)
+{
+    uint8_t expected[ADDR_SIZE], addr[ADDR_SIZE];
+    size_t addr_size = sizeof(addr);
+
+    _addr(expected, i);
+    TEST_ASSERT_NOT_NULL(universal_address_get_address(entry, addr,
+                                                       &addr_size));
+    TEST_ASSERT_EQUAL_INT(ADDR_SIZE, addr_size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(expected, addr, sizeof(addr)));
+}
+
+static void setup(void)
+{
+    universal_address_init();
+}
+
+static void teardown(void)
+{
+    universal_address_reset();
+}
+
+static void test_universal_address_refcount(void)
+{
+    universal_address_container_t *entry = _add(1);
+
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_INT(1, universal_address_get_num_used_entries());
+
+    /* adding the same address again only takes another reference */
+    TEST_ASSERT(entry == _add(1));
+    TEST_ASSERT_EQUAL_INT(2, entry->use_count);
+    TEST_ASSERT_EQUAL_INT(1, universal_address_get_num_used_entries());
+
+    universal_address_rem(entry);
+    TEST_ASSERT_EQUAL_INT(1, entry->use_count);
+    TEST_ASSERT_EQUAL_INT(1, universal_address_get_num_used_entries());
+    TEST_ASSERT(entry == _add(1));
+    universal_address_rem(entry);
+
+    universal_address_rem(entry);
+    TEST_ASSERT_EQUAL_INT(0, entry->use_count);
+    TEST_ASSERT_EQUAL_INT(0, universal_address_get_num_used_entries());
+
+    /* removing an unused entry has no effect */
+    universal_address_rem(entry);
+    TEST_ASSERT_EQUAL_INT(0, entry->use_count);
+    TEST_ASSERT_EQUAL_INT(0, universal_address_get_num_used_entries());
+}
+
+static void test_universal_address_reuse_slot(void)
+{
+    for (unsigned i = 0; i < NUMOF; i++) {
+        entries[i] = _add(i);
+        TEST_ASSERT_NOT_NULL(entries[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(NUMOF, universal_address_get_num_used_entries());
+    TEST_ASSERT_NULL(_add(NUMOF));
+
+    /* a new address takes over the slot of a removed one */
+    universal_address_rem(entries[NUMOF / 2]);
+    TEST_ASSERT_EQUAL_INT(NUMOF - 1, universal_address_get_num_used_entries());
+    TEST_ASSERT(entries[NUMOF / 2] == _add(NUMOF));
+    _assert_stored(entries[NUMOF / 2], NUMOF);
+    TEST_ASSERT_EQUAL_INT(1, entries[NUMOF / 2]->use_count);
+    TEST_ASSERT_NULL(_add(NUMOF + 1));
+
+    /* the removed address is gone */
+    universal_address_rem(entries[0]);
+    TEST_ASSERT(entries[0] == _add(NUMOF / 2));
+    _assert_stored(entries[0], NUMOF / 2);
+}
+
+static void test_universal_address_collisions(void)
+{
+    for (unsigned i = 0; i < NUMOF; i++) {
+        entries[i] = _add(i);
+        TEST_ASSERT_NOT_NULL(entries[i]);
+    }
+
+    /* unlink every other entry from the middle of the hash chains */
+    for (unsigned i = 0; i < NUMOF; i += 2) {
+        universal_address_rem(entries[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(NUMOF / 2, universal_address_get_num_used_entries());
+
+    /* the remaining ones are still found */
+    for (unsigned i = 1; i < NUMOF; i += 2) {
+        TEST_ASSERT(entries[i] == _add(i));
+        TEST_ASSERT_EQUAL_INT(2, entries[i]->use_count);
+        _assert_stored(entries[i], i);
+    }
+    TEST_ASSERT_EQUAL_INT(NUMOF / 2, universal_address_get_num_used_entries());
+
+    /* and the removed ones come back into free slots */
+    for (unsigned i = 0; i < NUMOF; i += 2) {
+        universal_address_container_t *entry = _add(i);
+
+        TEST_ASSERT_NOT_NULL(entry);
+        TEST_ASSERT_EQUAL_INT(1, entry->use_count);
+        _assert_stored(entry, i);
+    }
+    TEST_ASSERT_EQUAL_INT(NUMOF, universal_address_get_num_used_entries());
+}
+
+static void test_universal_address_size(void)
+{
+    uint8_t addr[ADDR_SIZE];
+
+    /* equal bytes of a different length are a different address */
+    _addr(addr, 1);
+    universal_address_container_t *entry = universal_address_add(addr,
+                                                                 sizeof(addr));
+    universal_address_container_t *shorter = universal_address_add(addr,
+                                                                   sizeof(addr) - 1);
+
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_NOT_NULL(shorter);
+    TEST_ASSERT(entry != shorter);
+    TEST_ASSERT_EQUAL_INT(2, universal_address_get_num_used_entries());
+}
+
+Test *tests_universal_address_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_universal_address_refcount),
+        new_TestFixture(test_universal_address_reuse_slot),
+        new_TestFixture(test_universal_address_collisions),
+        new_TestFixture(test_universal_address_size),
+    };
+
+    EMB_UNIT_TESTCALLER(universal_address_tests, setup, teardown, fixtures);
+
+    return (Test *)&universal_address_tests;
+}
+
+void tests_universal_address(void)
+{
+    TESTS_RUN(tests_universal_address_tests());
+}
+/** @} */